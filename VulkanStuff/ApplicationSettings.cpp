@@ -0,0 +1,605 @@
+#include "pch.h"
+#include "ApplicationSettings.h"
+
+static std::optional<std::string> getEnvironmentVariable(const char* name)
+{
+    const char* value = std::getenv(name);
+    if(value == nullptr || *value == '\0')
+    {
+        return std::nullopt;
+    }
+
+    return std::string(value);
+}
+
+/// <summary>
+/// Accepted values:
+///     max-performance     - prefer discrete GPUs with most device local memory (default)
+///     low-power           - prefer integrated GPUs
+///     name:<substring>    - pick the first device whose name contains the substring (case insensitive)
+///     uuid:<hex>          - pick the device with matching deviceUUID, dashes are ignored
+/// Any other value is treated as a device name substring.
+/// </summary>
+void ApplicationSettings::setDevice(const std::string& value)
+{
+    if(value == "max-performance")
+    {
+        deviceSelectionPolicy = DeviceSelectionPolicy::MaxPerformance;
+        deviceSelector.clear();
+    }
+    else if(value == "low-power")
+    {
+        deviceSelectionPolicy = DeviceSelectionPolicy::LowPower;
+        deviceSelector.clear();
+    }
+    else if(value.rfind("uuid:", 0) == 0)
+    {
+        deviceSelectionPolicy = DeviceSelectionPolicy::ByUUID;
+        deviceSelector = value.substr(5);
+    }
+    else if(value.rfind("name:", 0) == 0)
+    {
+        deviceSelectionPolicy = DeviceSelectionPolicy::ByName;
+        deviceSelector = value.substr(5);
+    }
+    else
+    {
+        deviceSelectionPolicy = DeviceSelectionPolicy::ByName;
+        deviceSelector = value;
+    }
+}
+
+void ApplicationSettings::setDebugMessageSeverity(const std::string& value)
+{
+    if(value == "verbose")
+    {
+        debugMessageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT;
+    }
+    else if(value == "info")
+    {
+        debugMessageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT;
+    }
+    else if(value == "warning")
+    {
+        debugMessageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
+    }
+    else if(value == "error")
+    {
+        debugMessageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+    }
+    else
+    {
+        throw std::runtime_error("Settings: Unknown debug message severity " + value + "!");
+    }
+}
+
+void ApplicationSettings::setHostAllocator(const std::string& value)
+{
+    if(value == "tracking")
+    {
+        trackHostAllocations = true;
+    }
+    else if(value == "system")
+    {
+        trackHostAllocations = false;
+    }
+    else
+    {
+        throw std::runtime_error("Settings: Unknown host allocator " + value + "!");
+    }
+}
+
+void ApplicationSettings::setMemoryBudgetThreshold(const std::string& value)
+{
+    const double threshold = std::stod(value);
+    if(threshold <= 0.0 || threshold > 1.0)
+    {
+        throw std::runtime_error("Settings: Memory budget threshold " + value + " is not in (0, 1]!");
+    }
+
+    memoryBudgetThreshold = threshold;
+}
+
+void ApplicationSettings::setCaptureFormat(const std::string& value)
+{
+    if(value == "png")
+    {
+        captureFormat = CaptureFormat::PNG;
+    }
+    else if(value == "ppm")
+    {
+        captureFormat = CaptureFormat::PPM;
+    }
+    else if(value == "raw")
+    {
+        captureFormat = CaptureFormat::Raw;
+    }
+    else
+    {
+        throw std::runtime_error("Settings: Unknown capture format " + value + "!");
+    }
+}
+
+void ApplicationSettings::setPresentPolicy(const std::string& value)
+{
+    if(value == "low-latency")
+    {
+        presentPolicy = PresentPolicy::LowLatency;
+    }
+    else if(value == "vsync")
+    {
+        presentPolicy = PresentPolicy::VSync;
+    }
+    else if(value == "uncapped")
+    {
+        presentPolicy = PresentPolicy::Uncapped;
+    }
+    else if(value == "target-fps")
+    {
+        presentPolicy = PresentPolicy::TargetFrameRate;
+    }
+    else
+    {
+        throw std::runtime_error("Settings: Unknown present policy " + value + "!");
+    }
+}
+
+/// <summary>
+/// Setting a target frame rate selects the target-fps present policy.
+/// </summary>
+void ApplicationSettings::setTargetFrameRate(const std::string& value)
+{
+    const double frameRate = std::stod(value);
+    if(frameRate <= 0.0)
+    {
+        throw std::runtime_error("Settings: Target frame rate " + value + " is not positive!");
+    }
+
+    targetFrameRate = frameRate;
+    presentPolicy = PresentPolicy::TargetFrameRate;
+}
+
+void ApplicationSettings::setMipmaps(const std::string& value)
+{
+    if(value == "gpu")
+    {
+        generateMipmaps = true;
+    }
+    else if(value == "off")
+    {
+        generateMipmaps = false;
+    }
+    else
+    {
+        throw std::runtime_error("Settings: Unknown mipmap mode " + value + "!");
+    }
+}
+
+void ApplicationSettings::setLodPixelError(const std::string& value)
+{
+    const float pixelError = std::stof(value);
+    if(!std::isfinite(pixelError) || pixelError <= 0.0f)
+    {
+        throw std::runtime_error("Settings: LOD pixel error " + value + " is not positive!");
+    }
+
+    lodPixelError = pixelError;
+}
+
+void ApplicationSettings::setLodHysteresis(const std::string& value)
+{
+    const float hysteresis = std::stof(value);
+    if(!(hysteresis >= 0.0f && hysteresis < 1.0f))
+    {
+        throw std::runtime_error("Settings: LOD hysteresis " + value + " is not in [0, 1)!");
+    }
+
+    lodHysteresis = hysteresis;
+}
+
+void ApplicationSettings::setDrawSort(const std::string& value)
+{
+    if(value == "on")
+    {
+        drawSort = true;
+    }
+    else if(value == "off")
+    {
+        drawSort = false;
+    }
+    else
+    {
+        throw std::runtime_error("Settings: Unknown draw sort mode " + value + "!");
+    }
+}
+
+void ApplicationSettings::setComputeBatchExtent(const std::string& value)
+{
+    const size_t separator = value.find('x');
+    if(separator == std::string::npos)
+    {
+        throw std::runtime_error("Settings: Compute batch size " + value + " is not of the form WIDTHxHEIGHT!");
+    }
+
+    computeBatchExtent.width = static_cast<uint32_t>(std::stoul(value.substr(0, separator)));
+    computeBatchExtent.height = static_cast<uint32_t>(std::stoul(value.substr(separator + 1)));
+    if(computeBatchExtent.width == 0 || computeBatchExtent.height == 0)
+    {
+        throw std::runtime_error("Settings: Compute batch size " + value + " is empty!");
+    }
+}
+
+ApplicationSettings ApplicationSettings::parse(int argc, char** argv)
+{
+    ApplicationSettings settings = {};
+
+    //Environment
+    if(auto device = getEnvironmentVariable("VULKANSTUFF_DEVICE"))
+    {
+        settings.setDevice(*device);
+    }
+
+    if(auto severity = getEnvironmentVariable("VULKANSTUFF_DEBUG_SEVERITY"))
+    {
+        settings.setDebugMessageSeverity(*severity);
+    }
+
+    if(auto hostAllocator = getEnvironmentVariable("VULKANSTUFF_HOST_ALLOCATOR"))
+    {
+        settings.setHostAllocator(*hostAllocator);
+    }
+
+    if(auto memoryBudgetThreshold = getEnvironmentVariable("VULKANSTUFF_MEMORY_BUDGET_THRESHOLD"))
+    {
+        settings.setMemoryBudgetThreshold(*memoryBudgetThreshold);
+    }
+
+    if(auto captureDirectory = getEnvironmentVariable("VULKANSTUFF_CAPTURE_DIR"))
+    {
+        settings.captureDirectory = *captureDirectory;
+    }
+
+    if(auto presentPolicy = getEnvironmentVariable("VULKANSTUFF_PRESENT_POLICY"))
+    {
+        settings.setPresentPolicy(*presentPolicy);
+    }
+
+    if(auto allowTearing = getEnvironmentVariable("VULKANSTUFF_ALLOW_TEARING"))
+    {
+        settings.allowTearing = *allowTearing != "0";
+    }
+
+    if(auto separatePresentQueue = getEnvironmentVariable("VULKANSTUFF_SEPARATE_PRESENT_QUEUE"))
+    {
+        settings.separatePresentQueue = *separatePresentQueue != "0";
+    }
+
+    if(auto workers = getEnvironmentVariable("VULKANSTUFF_WORKERS"))
+    {
+        settings.workerCount = static_cast<uint32_t>(std::stoul(*workers));
+    }
+
+    if(auto assetDirectory = getEnvironmentVariable("VULKANSTUFF_ASSET_DIR"))
+    {
+        settings.assetDirectory = *assetDirectory;
+    }
+
+    if(auto mipmaps = getEnvironmentVariable("VULKANSTUFF_MIPMAPS"))
+    {
+        settings.setMipmaps(*mipmaps);
+    }
+
+    if(auto hotReload = getEnvironmentVariable("VULKANSTUFF_HOT_RELOAD"))
+    {
+        settings.shaderHotReload = *hotReload != "0";
+    }
+
+    if(auto meshlets = getEnvironmentVariable("VULKANSTUFF_MESHLETS"))
+    {
+        settings.meshletPath = MeshletRenderer::parsePath(*meshlets);
+    }
+
+    if(auto lod = getEnvironmentVariable("VULKANSTUFF_LOD"))
+    {
+        settings.lodMode = LodRenderer::parseMode(*lod);
+    }
+
+    if(auto lodError = getEnvironmentVariable("VULKANSTUFF_LOD_ERROR"))
+    {
+        settings.setLodPixelError(*lodError);
+    }
+
+    if(auto drawSort = getEnvironmentVariable("VULKANSTUFF_DRAW_SORT"))
+    {
+        settings.setDrawSort(*drawSort);
+    }
+
+    if(auto computeBatch = getEnvironmentVariable("VULKANSTUFF_COMPUTE_BATCH"))
+    {
+        settings.computeBatchImages = static_cast<uint32_t>(std::stoul(*computeBatch));
+    }
+
+    if(auto headless = getEnvironmentVariable("VULKANSTUFF_HEADLESS"))
+    {
+        settings.headless = *headless != "0";
+    }
+
+    //Command Line
+    for(int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+        const size_t separator = argument.find('=');
+        const std::string option = argument.substr(0, separator);
+        const std::string value = separator != std::string::npos ? argument.substr(separator + 1) : std::string();
+
+        if(option == "--help" || option == "-h")
+        {
+            settings.showUsage = true;
+        }
+        else if(option == "--device")
+        {
+            settings.setDevice(value);
+        }
+        else if(option == "--debug-severity")
+        {
+            settings.setDebugMessageSeverity(value);
+        }
+        else if(option == "--host-allocator")
+        {
+            settings.setHostAllocator(value);
+        }
+        else if(option == "--memory-budget-threshold")
+        {
+            settings.setMemoryBudgetThreshold(value);
+        }
+        else if(option == "--present-policy")
+        {
+            settings.setPresentPolicy(value);
+        }
+        else if(option == "--target-fps")
+        {
+            settings.setTargetFrameRate(value);
+        }
+        else if(option == "--allow-tearing")
+        {
+            settings.allowTearing = true;
+        }
+        else if(option == "--swapchain-images")
+        {
+            settings.swapchainImageCount = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if(option == "--separate-present-queue")
+        {
+            settings.separatePresentQueue = true;
+        }
+        else if(option == "--workers")
+        {
+            settings.workerCount = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if(option == "--job-benchmark")
+        {
+            settings.jobBenchmark = true;
+        }
+        else if(option == "--assets")
+        {
+            settings.assetDirectory = value;
+        }
+        else if(option == "--streaming-budget")
+        {
+            settings.streamingBudget = std::max(static_cast<uint32_t>(std::stoul(value)), 1u);
+        }
+        else if(option == "--io-threads")
+        {
+            settings.ioThreadCount = std::max(static_cast<uint32_t>(std::stoul(value)), 1u);
+        }
+        else if(option == "--mipmaps")
+        {
+            settings.setMipmaps(value);
+        }
+        else if(option == "--convert-mesh")
+        {
+            settings.meshConversionPath = value;
+        }
+        else if(option == "--mesh-benchmark")
+        {
+            settings.meshBenchmarkPath = value;
+        }
+        else if(option == "--hot-reload")
+        {
+            settings.shaderHotReload = true;
+        }
+        else if(option == "--headless")
+        {
+            settings.headless = true;
+        }
+        else if(option == "--frames")
+        {
+            settings.frameCount = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if(option == "--golden")
+        {
+            settings.goldenDirectory = value;
+        }
+        else if(option == "--update-golden")
+        {
+            settings.updateGoldenImages = true;
+        }
+        else if(option == "--golden-tolerance")
+        {
+            settings.goldenTolerance = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if(option == "--golden-max-failing")
+        {
+            settings.goldenMaxFailingPixels = std::stod(value);
+        }
+        else if(option == "--warmup")
+        {
+            settings.warmupFrames = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if(option == "--benchmark")
+        {
+            settings.benchmarkScenario = BenchmarkRecorder::parseScenario(value);
+        }
+        else if(option == "--benchmark-scale")
+        {
+            settings.benchmarkScale = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if(option == "--benchmark-output")
+        {
+            settings.benchmarkOutput = value;
+        }
+        else if(option == "--benchmark-label")
+        {
+            settings.benchmarkLabel = value;
+        }
+        else if(option == "--meshlets")
+        {
+            settings.meshletPath = MeshletRenderer::parsePath(value);
+        }
+        else if(option == "--lod")
+        {
+            settings.lodMode = LodRenderer::parseMode(value);
+        }
+        else if(option == "--lod-error")
+        {
+            settings.setLodPixelError(value);
+        }
+        else if(option == "--lod-hysteresis")
+        {
+            settings.setLodHysteresis(value);
+        }
+        else if(option == "--draw-sort")
+        {
+            settings.setDrawSort(value);
+        }
+        else if(option == "--scene-benchmark")
+        {
+            settings.sceneBenchmark = true;
+        }
+        else if(option == "--compute-batch")
+        {
+            settings.computeBatchImages = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if(option == "--compute-batch-input")
+        {
+            settings.computeBatchInput = value;
+        }
+        else if(option == "--compute-batch-output")
+        {
+            settings.computeBatchOutput = value;
+        }
+        else if(option == "--compute-batch-size")
+        {
+            settings.setComputeBatchExtent(value);
+        }
+        else if(option == "--frame-times")
+        {
+            settings.frameTimesFile = value;
+        }
+        else if(option == "--frame-time-budget")
+        {
+            settings.frameTimeBudget = std::stod(value);
+        }
+        else if(option == "--capture")
+        {
+            settings.captureDirectory = value;
+        }
+        else if(option == "--capture-format")
+        {
+            settings.setCaptureFormat(value);
+        }
+        else if(option == "--capture-interval")
+        {
+            settings.captureInterval = std::max(1u, static_cast<uint32_t>(std::stoul(value)));
+        }
+        else if(option == "--debug-rate-limit")
+        {
+            settings.debugMessagesPerSecond = static_cast<uint32_t>(std::stoul(value));
+        }
+        else
+        {
+            throw std::runtime_error("Settings: Unknown option " + argument + "!");
+        }
+    }
+
+    if(settings.benchmarkScenario != BenchmarkScenario::None)
+    {
+        if(settings.benchmarkScale == 0)
+        {
+            settings.benchmarkScale = BenchmarkRecorder::getDefaultScale(settings.benchmarkScenario);
+        }
+
+        if(settings.frameCount == 0)
+        {
+            settings.frameCount = DEFAULT_BENCHMARK_FRAME_COUNT;
+        }
+    }
+
+    // Compute batches never present, they take the windowless paths of instance and device creation.
+    if(settings.computeBatchImages > 0)
+    {
+        settings.headless = true;
+    }
+
+    // Without a window nothing ends the render loop, so headless runs always have a frame count.
+    if(settings.headless && settings.frameCount == 0)
+    {
+        settings.frameCount = DEFAULT_HEADLESS_FRAME_COUNT;
+    }
+
+    return settings;
+}
+
+void ApplicationSettings::printUsage(std::ostream& stream)
+{
+    stream << "Usage: VulkanStuff [options]\n"
+           << "    --device=<policy>     max-performance | low-power | name:<substring> | uuid:<hex>   (env VULKANSTUFF_DEVICE)\n"
+           << "    --debug-severity=<s>  verbose | info | warning | error, default warning            (env VULKANSTUFF_DEBUG_SEVERITY)\n"
+           << "    --debug-rate-limit=N  validation messages written per message id and second, default 10\n"
+           << "    --host-allocator=<a>  tracking | system, default tracking                            (env VULKANSTUFF_HOST_ALLOCATOR)\n"
+           << "    --memory-budget-threshold=F  evict resources above this fraction of a heap budget, default 0.9 (env VULKANSTUFF_MEMORY_BUDGET_THRESHOLD)\n"
+           << "    --present-policy=<p>  low-latency | vsync | uncapped | target-fps, default uncapped  (env VULKANSTUFF_PRESENT_POLICY)\n"
+           << "    --target-fps=N        pace frames to N per second, selects the target-fps policy, default 60\n"
+           << "    --allow-tearing       uncapped and target-fps present immediately, with tearing, on surfaces without mailbox\n"
+           << "                          instead of falling back to fifo                                  (env VULKANSTUFF_ALLOW_TEARING)\n"
+           << "    --swapchain-images=N  swapchain image count, default derived from the frames in flight\n"
+           << "    --separate-present-queue  present from another queue family than graphics if the device has one, which transfers\n"
+           << "                          image ownership between the families every frame (env VULKANSTUFF_SEPARATE_PRESENT_QUEUE)\n"
+           << "    --workers=N           job system workers including the main thread, default one per hardware thread (env VULKANSTUFF_WORKERS)\n"
+           << "    --job-benchmark       measure job scheduling overhead and parallel-for scaling up to --workers, then exit\n"
+           << "    --assets=<dir>        stream the .obj and .vsmesh meshes and .ppm and .ktx2 textures of the directory (env VULKANSTUFF_ASSET_DIR)\n"
+           << "    --streaming-budget=N  MiB of staging memory for asset uploads, default 32\n"
+           << "    --io-threads=N        threads reading asset files, default 2\n"
+           << "    --mipmaps=<m>         gpu | off, generate the mip chain of uncompressed textures on the GPU, default gpu (env VULKANSTUFF_MIPMAPS)\n"
+           << "    --convert-mesh=<path> convert the .obj file, or every .obj file of the directory, to .vsmesh next to it, then exit\n"
+           << "    --mesh-benchmark=<file>  compare load times of the .obj file and its .vsmesh conversion, then exit\n"
+           << "    --hot-reload          recompile Shaders/*.vert and *.frag with glslc when they change and swap the pipeline (env VULKANSTUFF_HOT_RELOAD)\n"
+           << "    --headless            render offscreen without a window                               (env VULKANSTUFF_HEADLESS)\n"
+           << "    --frames=N            exit after N frames, default 0 (unlimited) or 100 when headless\n"
+           << "    --capture=<dir>       write rendered frames to the directory                           (env VULKANSTUFF_CAPTURE_DIR)\n"
+           << "    --capture-format=<f>  png | ppm | raw, default png\n"
+           << "    --capture-interval=N  capture every Nth frame, default 1\n"
+           << "    --golden=<dir>        compare captured frames with the golden images in the directory, exit with failure on mismatch\n"
+           << "    --update-golden       write captured frames as new golden images instead of comparing\n"
+           << "    --golden-tolerance=N  maximum per channel difference of a matching pixel, default 2\n"
+           << "    --golden-max-failing=F  fraction of pixels allowed outside the tolerance, default 0.001\n"
+           << "    --warmup=N            frames excluded from frame time statistics, default 10\n"
+           << "    --frame-times=<file>  write frame times as CSV\n"
+           << "    --frame-time-budget=MS  exit with failure when the p95 frame time exceeds the budget\n"
+           << "    --benchmark=<s>       run a benchmark scenario for N measured frames (--frames, default 500) after the warm-up:\n"
+           << "                          triangle | instanced | draw-calls | upload | pipeline-compile | meshlets | lod | sorted-draws | particles\n"
+           << "    --benchmark-scale=N   instances, draw calls, KiB uploaded, pipelines created per frame, spheres, objects or particles, depending on the scenario\n"
+           << "    --benchmark-output=<file>  write the JSON report to the file instead of stdout\n"
+           << "    --benchmark-label=<text>   label stored in the JSON report, e.g. the commit being measured\n"
+           << "    --meshlets=<p>        auto | mesh-shader | compute | vertex, how the meshlets scenario culls and draws, default auto (env VULKANSTUFF_MESHLETS)\n"
+           << "    --lod=<m>             auto | off | cpu | gpu, where the lod scenario selects levels of detail, default auto (env VULKANSTUFF_LOD)\n"
+           << "    --lod-error=PX        largest simplification error on screen in pixels, default 1 (env VULKANSTUFF_LOD_ERROR)\n"
+           << "    --lod-hysteresis=F    fraction of the error budget an object has to undercut to switch to a coarser level, default 0.2\n"
+           << "    --draw-sort=<m>       on | off, whether the sorted-draws scenario sorts its draws by state, default on (env VULKANSTUFF_DRAW_SORT)\n"
+           << "    --scene-benchmark     measure incremental scene graph updates against the number of changed nodes, then exit\n"
+           << "    --compute-batch=N     filter N images with compute kernels only, without window or graphics queue, report the throughput and exit (env VULKANSTUFF_COMPUTE_BATCH)\n"
+           << "    --compute-batch-input=<dir>   .ppm images cycled through the batch, default generated test images\n"
+           << "    --compute-batch-output=<dir>  write the results in the --capture-format, default discard them\n"
+           << "    --compute-batch-size=WxH      size the images are resized to, default 1280x720\n"
+           << "    --help                show this message\n";
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include "FrameWriter.h"
+#include "Benchmark.h"
+#include "FramePacer.h"
+#include "SwapchainPolicy.h"
+#include "LodRenderer.h"
+#include "MeshletRenderer.h"
+
+enum class DeviceSelectionPolicy
+{
+    MaxPerformance,
+    LowPower,
+    ByName,
+    ByUUID
+};
+
+/// <summary>
+/// Runtime configuration of the application.
+///
+/// Values are read from environment variables first and can be overridden on the command line,
+/// so CI hosts can pin their configuration through the environment while developers use options.
+/// </summary>
+struct ApplicationSettings
+{
+    //General
+    bool                                showUsage                   = false;
+
+    //Headless - render offscreen without a window, for CI hosts without a display or GPU
+    bool                                headless                    = false;
+    uint32_t                            frameCount                  = 0;    // frames to render before exiting, 0 renders until the window is closed
+
+    //Presentation
+    PresentPolicy                       presentPolicy               = PresentPolicy::Uncapped;
+    double                              targetFrameRate             = 60.0; // frames per second of PresentPolicy::TargetFrameRate
+    bool                                allowTearing                = false; // uncapped and target-fps present immediately without mailbox
+    uint32_t                            swapchainImageCount         = 0;    // 0 derives the count from the frames in flight
+    bool                                separatePresentQueue        = false; // present from another family than graphics when one can
+
+    //Jobs
+    uint32_t                            workerCount                 = 0;    // job system workers including the main thread, 0 uses one per hardware thread
+    bool                                jobBenchmark                = false;
+
+    //Asset Streaming - disabled while assetDirectory is empty
+    std::string                         assetDirectory              = {};
+    uint32_t                            streamingBudget             = 32;   // MiB of the staging ring between disk and GPU
+    uint32_t                            ioThreadCount               = 2;
+    bool                                generateMipmaps             = true; // blit the mip chain of uncompressed textures on the GPU
+    std::string                         meshConversionPath          = {};   // convert text meshes to .vsmesh files and exit
+    std::string                         meshBenchmarkPath           = {};   // compare text and .vsmesh load times of the mesh and exit
+
+    //Shaders
+    bool                                shaderHotReload             = false; // recompile changed shaders and swap the pipelines while running
+
+    //Physical Device
+    DeviceSelectionPolicy               deviceSelectionPolicy       = DeviceSelectionPolicy::MaxPerformance;
+    std::string                         deviceSelector              = {};
+
+    //Debug Messages
+    VkDebugUtilsMessageSeverityFlagBitsEXT debugMessageSeverity     = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
+    uint32_t                            debugMessagesPerSecond      = 10;
+
+    //Host Memory
+    bool                                trackHostAllocations        = true;
+
+    //Device Memory - fraction of the heap budget above which resources are evicted
+    double                              memoryBudgetThreshold       = 0.9;
+
+    //Frame Capture - disabled while captureDirectory is empty
+    std::string                         captureDirectory            = {};
+    CaptureFormat                       captureFormat               = CaptureFormat::PNG;
+    uint32_t                            captureInterval             = 1;
+
+    //Golden Images - captured frames are compared against the images in goldenDirectory when it is set
+    std::string                         goldenDirectory             = {};
+    bool                                updateGoldenImages          = false;
+    uint32_t                            goldenTolerance             = 2;
+    double                              goldenMaxFailingPixels      = 0.001;
+
+    //Frame Times
+    uint32_t                            warmupFrames                = 10;   // frames excluded from frame time statistics
+    std::string                         frameTimesFile              = {};
+    double                              frameTimeBudget             = 0.0;  // p95 frame time in ms above which the run fails, 0 disables the check
+
+    //Benchmark - frameCount counts the measured frames after the warm-up
+    BenchmarkScenario                   benchmarkScenario           = BenchmarkScenario::None;
+    uint32_t                            benchmarkScale              = 0;    // 0 uses the default scale of the scenario
+    std::string                         benchmarkOutput             = {};   // JSON report file, written to stdout when empty
+    std::string                         benchmarkLabel              = {};
+    MeshletPath                         meshletPath                 = MeshletPath::Auto;    // how the meshlets scenario renders
+    LodMode                             lodMode                     = LodMode::Auto;        // where the lod scenario selects levels of detail
+    float                               lodPixelError               = 1.0f; // largest simplification error on screen in pixels
+    float                               lodHysteresis               = 0.2f; // fraction of the budget an object has to undercut to coarsen
+    bool                                sceneBenchmark              = false; // measure scene graph updates on the CPU and exit
+    bool                                drawSort                    = true; // sort the draws of the sorted-draws scenario by state
+
+    //Compute Batch - filter images with compute kernels only, without window, surface or graphics queue; disabled while computeBatchImages is 0
+    uint32_t                            computeBatchImages          = 0;
+    std::string                         computeBatchInput           = {};   // .ppm images cycled through the batch, generated images when empty
+    std::string                         computeBatchOutput          = {};   // results are written in captureFormat when set
+    VkExtent2D                          computeBatchExtent          = { 1280, 720 };    // size the images are resized to
+
+    static constexpr uint32_t           DEFAULT_HEADLESS_FRAME_COUNT = 100;
+    static constexpr uint32_t           DEFAULT_BENCHMARK_FRAME_COUNT = 500;
+
+    static ApplicationSettings          parse(int argc, char** argv);
+    static void                         printUsage(std::ostream& stream);
+
+private:
+    void                                setDevice(const std::string& value);
+    void                                setDebugMessageSeverity(const std::string& value);
+    void                                setHostAllocator(const std::string& value);
+    void                                setMemoryBudgetThreshold(const std::string& value);
+    void                                setCaptureFormat(const std::string& value);
+    void                                setPresentPolicy(const std::string& value);
+    void                                setTargetFrameRate(const std::string& value);
+    void                                setMipmaps(const std::string& value);
+    void                                setLodPixelError(const std::string& value);
+    void                                setLodHysteresis(const std::string& value);
+    void                                setDrawSort(const std::string& value);
+    void                                setComputeBatchExtent(const std::string& value);
+};
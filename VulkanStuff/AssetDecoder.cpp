@@ -0,0 +1,430 @@
+#include "pch.h"
+#include "AssetDecoder.h"
+#include "MeshletBuilder.h"
+#include "MeshSimplifier.h"
+
+MeshBounds MeshBounds::compute(const MeshVertex* vertices, size_t vertexCount)
+{
+    MeshBounds bounds = {};
+    if(vertexCount == 0)
+    {
+        return bounds;
+    }
+
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        bounds.minimum[axis] = std::numeric_limits<float>::max();
+        bounds.maximum[axis] = std::numeric_limits<float>::lowest();
+    }
+
+    for(size_t i = 0; i < vertexCount; ++i)
+    {
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            bounds.minimum[axis] = std::min(bounds.minimum[axis], vertices[i].position[axis]);
+            bounds.maximum[axis] = std::max(bounds.maximum[axis], vertices[i].position[axis]);
+        }
+    }
+
+    // Centered on the box, not minimal but never larger than the half diagonal
+    float radiusSquared = 0.0f;
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        bounds.center[axis] = (bounds.minimum[axis] + bounds.maximum[axis]) * 0.5f;
+    }
+    for(size_t i = 0; i < vertexCount; ++i)
+    {
+        float distanceSquared = 0.0f;
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            const float delta = vertices[i].position[axis] - bounds.center[axis];
+            distanceSquared += delta * delta;
+        }
+        radiusSquared = std::max(radiusSquared, distanceSquared);
+    }
+    bounds.radius = std::sqrt(radiusSquared);
+
+    return bounds;
+}
+
+const uint8_t* DecodedAsset::getData() const
+{
+    return mapping ? mappedData : data.data();
+}
+
+size_t DecodedAsset::getSize() const
+{
+    return mapping ? mappedSize : data.size();
+}
+
+/// <summary>
+/// Frees the bulk data once it was copied to the GPU. Counts, offsets, bounds and tables stay valid.
+/// </summary>
+void DecodedAsset::releaseData()
+{
+    data = {};
+    mapping.reset();
+    mappedData = nullptr;
+    mappedSize = 0;
+}
+
+std::optional<AssetType> AssetDecoder::getType(const std::filesystem::path& path)
+{
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    if(extension == ".obj" || extension == ".vsmesh")
+    {
+        return AssetType::Mesh;
+    }
+    if(extension == ".ppm" || extension == ".ktx2")
+    {
+        return AssetType::Texture;
+    }
+
+    return std::nullopt;
+}
+
+DecodedAsset AssetDecoder::decode(AssetType type, const uint8_t* data, size_t size)
+{
+    switch(type)
+    {
+    case AssetType::Mesh:       return decodeOBJ(data, size);
+    case AssetType::Texture:    return decodePPM(data, size);
+    default:                    throw std::runtime_error("AssetDecoder: Unknown asset type!");
+    }
+}
+
+static std::string_view nextToken(std::string_view& line)
+{
+    const size_t begin = line.find_first_not_of(" \t\r");
+    if(begin == std::string_view::npos)
+    {
+        line = {};
+        return {};
+    }
+
+    const size_t end = line.find_first_of(" \t\r", begin);
+    const std::string_view token = line.substr(begin, end == std::string_view::npos ? std::string_view::npos : end - begin);
+    line = end == std::string_view::npos ? std::string_view() : line.substr(end);
+
+    return token;
+}
+
+static float parseFloat(std::string_view token)
+{
+    float value = 0.0f;
+    const auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+    if(result.ec != std::errc())
+    {
+        throw std::runtime_error("AssetDecoder: Invalid number " + std::string(token) + " in OBJ file!");
+    }
+
+    return value;
+}
+
+/// <summary>
+/// Resolves a 1 based OBJ index, negative indices count back from the last element read so far. 0 means absent.
+/// </summary>
+static int32_t parseIndex(std::string_view token, size_t elementCount)
+{
+    if(token.empty())
+    {
+        return 0;
+    }
+
+    int64_t index = 0;
+    const auto result = std::from_chars(token.data(), token.data() + token.size(), index);
+    if(result.ec != std::errc() || index == 0)
+    {
+        throw std::runtime_error("AssetDecoder: Invalid index " + std::string(token) + " in OBJ file!");
+    }
+
+    if(index < 0)
+    {
+        index += static_cast<int64_t>(elementCount) + 1;
+    }
+
+    if(index < 1 || index > static_cast<int64_t>(elementCount))
+    {
+        throw std::runtime_error("AssetDecoder: Index " + std::string(token) + " out of range in OBJ file!");
+    }
+
+    return static_cast<int32_t>(index);
+}
+
+DecodedAsset AssetDecoder::decodeOBJ(const uint8_t* data, size_t size)
+{
+    struct VertexKey
+    {
+        int32_t position;
+        int32_t texCoord;
+        int32_t normal;
+
+        bool operator==(const VertexKey& other) const
+        {
+            return position == other.position && texCoord == other.texCoord && normal == other.normal;
+        }
+    };
+
+    struct VertexKeyHash
+    {
+        size_t operator()(const VertexKey& key) const
+        {
+            return static_cast<size_t>(key.position) * 73856093u ^ static_cast<size_t>(key.texCoord) * 19349663u ^ static_cast<size_t>(key.normal) * 83492791u;
+        }
+    };
+
+    std::vector<std::array<float, 3>> positions;
+    std::vector<std::array<float, 3>> normals;
+    std::vector<std::array<float, 2>> texCoords;
+
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::unordered_map<VertexKey, uint32_t, VertexKeyHash> vertexLookup;
+    std::vector<uint32_t> polygon;
+
+    std::string_view text(reinterpret_cast<const char*>(data), size);
+
+    while(!text.empty())
+    {
+        const size_t lineEnd = text.find('\n');
+        std::string_view line = text.substr(0, lineEnd);
+        text = lineEnd == std::string_view::npos ? std::string_view() : text.substr(lineEnd + 1);
+
+        const std::string_view keyword = nextToken(line);
+
+        if(keyword == "v")
+        {
+            const float x = parseFloat(nextToken(line));
+            const float y = parseFloat(nextToken(line));
+            const float z = parseFloat(nextToken(line));
+            positions.push_back({ x, y, z });
+        }
+        else if(keyword == "vn")
+        {
+            const float x = parseFloat(nextToken(line));
+            const float y = parseFloat(nextToken(line));
+            const float z = parseFloat(nextToken(line));
+            normals.push_back({ x, y, z });
+        }
+        else if(keyword == "vt")
+        {
+            const float u = parseFloat(nextToken(line));
+            const float v = parseFloat(nextToken(line));
+            texCoords.push_back({ u, v });
+        }
+        else if(keyword == "f")
+        {
+            polygon.clear();
+
+            for(std::string_view corner = nextToken(line); !corner.empty(); corner = nextToken(line))
+            {
+                // v, v/vt, v//vn or v/vt/vn
+                const size_t firstSlash = corner.find('/');
+                const size_t secondSlash = firstSlash == std::string_view::npos ? std::string_view::npos : corner.find('/', firstSlash + 1);
+
+                VertexKey key = {};
+                key.position = parseIndex(corner.substr(0, firstSlash), positions.size());
+                if(firstSlash != std::string_view::npos)
+                {
+                    key.texCoord = parseIndex(corner.substr(firstSlash + 1, secondSlash == std::string_view::npos ? std::string_view::npos : secondSlash - firstSlash - 1), texCoords.size());
+                }
+                if(secondSlash != std::string_view::npos)
+                {
+                    key.normal = parseIndex(corner.substr(secondSlash + 1), normals.size());
+                }
+
+                if(key.position == 0)
+                {
+                    throw std::runtime_error("AssetDecoder: Face without position index in OBJ file!");
+                }
+
+                const auto lookup = vertexLookup.try_emplace(key, static_cast<uint32_t>(vertices.size()));
+                if(lookup.second)
+                {
+                    MeshVertex vertex = {};
+                    std::copy_n(positions[key.position - 1].data(), 3, vertex.position);
+                    if(key.normal != 0)
+                    {
+                        std::copy_n(normals[key.normal - 1].data(), 3, vertex.normal);
+                    }
+                    if(key.texCoord != 0)
+                    {
+                        std::copy_n(texCoords[key.texCoord - 1].data(), 2, vertex.texCoord);
+                    }
+                    vertices.push_back(vertex);
+                }
+
+                polygon.push_back(lookup.first->second);
+            }
+
+            for(size_t i = 2; i < polygon.size(); ++i)
+            {
+                indices.push_back(polygon[0]);
+                indices.push_back(polygon[i - 1]);
+                indices.push_back(polygon[i]);
+            }
+        }
+        // Groups, objects, materials and smoothing groups don't change the geometry
+    }
+
+    if(indices.empty())
+    {
+        throw std::runtime_error("AssetDecoder: OBJ file contains no faces!");
+    }
+
+    return createMesh(vertices, indices);
+}
+
+/// <summary>
+/// Lays out an indexed triangle list as a mesh asset with up to lodCount levels of detail and builds the meshlets of
+/// every level. Each level is simplified from the one before to about half its triangles, until the mesh gets too
+/// small or stops shrinking.
+/// </summary>
+DecodedAsset AssetDecoder::createMesh(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, uint32_t lodCount)
+{
+    std::vector<uint32_t> lodIndices = indices;
+    std::vector<MeshLod> lods;
+    lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0, 0, 0.0f, 0 });
+
+    std::vector<uint32_t> level = indices;
+    float error = 0.0f;
+    while(lods.size() < lodCount && level.size() / 6 >= MIN_LOD_TRIANGLES)
+    {
+        float stepError = 0.0f;
+        std::vector<uint32_t> simplified = MeshSimplifier::simplify(vertices.data(), vertices.size(), level, level.size() / 2, stepError);
+
+        // Locked borders can stop the reduction early, a level barely smaller than the last isn't worth drawing
+        if(simplified.size() > level.size() * 3 / 4)
+        {
+            break;
+        }
+
+        // Levels are simplified from each other, so their errors relative to the full detail mesh add up
+        error += stepError;
+        lods.push_back({ static_cast<uint32_t>(lodIndices.size()), static_cast<uint32_t>(simplified.size()), 0, 0, error, 0 });
+        lodIndices.insert(lodIndices.end(), simplified.begin(), simplified.end());
+        level = std::move(simplified);
+    }
+
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint8_t> meshletTriangles;
+    for(MeshLod& lod : lods)
+    {
+        lod.firstMeshlet = static_cast<uint32_t>(meshlets.size());
+        lod.meshletCount = MeshletBuilder::build(vertices.data(), vertices.size(), lodIndices.data() + lod.firstIndex, lod.indexCount,
+                                                 meshlets, meshletVertices, meshletTriangles);
+    }
+
+    // Shaders read the triangle bytes as words, so the array is padded to a whole word
+    meshletTriangles.resize((meshletTriangles.size() + 3) / 4 * 4, 0);
+
+    DecodedAsset asset = {};
+    asset.type = AssetType::Mesh;
+    asset.vertexCount = static_cast<uint32_t>(vertices.size());
+    asset.indexCount = static_cast<uint32_t>(lodIndices.size());
+    asset.indexOffset = vertices.size() * sizeof(MeshVertex);
+    asset.meshletVertexOffset = asset.indexOffset + lodIndices.size() * sizeof(uint32_t);
+    asset.meshletTriangleOffset = asset.meshletVertexOffset + meshletVertices.size() * sizeof(uint32_t);
+    asset.bounds = MeshBounds::compute(vertices.data(), vertices.size());
+    asset.meshlets = std::move(meshlets);
+    asset.lods = std::move(lods);
+    asset.data.resize(static_cast<size_t>(asset.meshletTriangleOffset + meshletTriangles.size()));
+
+    std::memcpy(asset.data.data(), vertices.data(), vertices.size() * sizeof(MeshVertex));
+    std::memcpy(asset.data.data() + asset.indexOffset, lodIndices.data(), lodIndices.size() * sizeof(uint32_t));
+    std::memcpy(asset.data.data() + asset.meshletVertexOffset, meshletVertices.data(), meshletVertices.size() * sizeof(uint32_t));
+    std::memcpy(asset.data.data() + asset.meshletTriangleOffset, meshletTriangles.data(), meshletTriangles.size());
+
+    return asset;
+}
+
+DecodedAsset AssetDecoder::decodePPM(const uint8_t* data, size_t size)
+{
+    size_t position = 0;
+
+    // Header fields are separated by whitespace, comments run from # to the end of the line
+    const auto readField = [&]() -> std::string_view
+    {
+        while(position < size)
+        {
+            if(data[position] == '#')
+            {
+                while(position < size && data[position] != '\n')
+                {
+                    ++position;
+                }
+            }
+            else if(std::isspace(data[position]))
+            {
+                ++position;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        const size_t begin = position;
+        while(position < size && !std::isspace(data[position]))
+        {
+            ++position;
+        }
+
+        return std::string_view(reinterpret_cast<const char*>(data) + begin, position - begin);
+    };
+
+    const auto readNumber = [&]() -> uint32_t
+    {
+        const std::string_view field = readField();
+        uint32_t value = 0;
+        const auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+        if(result.ec != std::errc() || value == 0)
+        {
+            throw std::runtime_error("AssetDecoder: Invalid PPM header!");
+        }
+        return value;
+    };
+
+    if(readField() != "P6")
+    {
+        throw std::runtime_error("AssetDecoder: Only binary PPM (P6) textures are supported!");
+    }
+
+    const uint32_t width = readNumber();
+    const uint32_t height = readNumber();
+    if(readNumber() != 255)
+    {
+        throw std::runtime_error("AssetDecoder: Only 8 bit PPM textures are supported!");
+    }
+
+    // A single whitespace character separates the header from the pixels
+    ++position;
+
+    const size_t pixelCount = static_cast<size_t>(width) * height;
+    if(position > size || size - position < pixelCount * 3)
+    {
+        throw std::runtime_error("AssetDecoder: PPM file is truncated!");
+    }
+
+    DecodedAsset asset = {};
+    asset.type = AssetType::Texture;
+    asset.width = width;
+    asset.height = height;
+    asset.format = VK_FORMAT_R8G8B8A8_SRGB;
+    asset.levels.push_back({ 0, pixelCount * 4, width, height });
+    asset.data.resize(pixelCount * 4);
+
+    const uint8_t* rgb = data + position;
+    for(size_t i = 0; i < pixelCount; ++i)
+    {
+        asset.data[i * 4 + 0] = rgb[i * 3 + 0];
+        asset.data[i * 4 + 1] = rgb[i * 3 + 1];
+        asset.data[i * 4 + 2] = rgb[i * 3 + 2];
+        asset.data[i * 4 + 3] = 255;
+    }
+
+    return asset;
+}
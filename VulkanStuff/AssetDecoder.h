@@ -0,0 +1,142 @@
+#pragma once
+#include "MappedFile.h"
+
+enum class AssetType
+{
+    Mesh,
+    Texture
+};
+
+struct MeshVertex
+{
+    float                               position[3]                 = {};
+    float                               normal[3]                   = {};
+    float                               texCoord[2]                 = {};
+};
+
+/// <summary>
+/// Axis aligned box and bounding sphere of a mesh in object space.
+/// </summary>
+struct MeshBounds
+{
+    float                               minimum[3]                  = {};
+    float                               maximum[3]                  = {};
+    float                               center[3]                   = {};
+    float                               radius                      = 0.0f;
+
+    static MeshBounds                   compute(const MeshVertex* vertices, size_t vertexCount);
+};
+
+/// <summary>
+/// A small cluster of triangles. Its vertices are vertexCount entries of the meshlet vertex array starting at
+/// vertexOffset, its triangles triangleCount triples of bytes indexing those vertices, starting at triangleOffset
+/// of the meshlet triangle array. The cone bounds all triangle normals for backface culling of whole meshlets.
+/// </summary>
+struct Meshlet
+{
+    uint32_t                            vertexOffset                = 0;
+    uint32_t                            triangleOffset              = 0;
+    uint32_t                            vertexCount                 = 0;
+    uint32_t                            triangleCount               = 0;
+    float                               center[3]                   = {};
+    float                               radius                      = 0.0f;
+    float                               coneAxis[3]                 = {};
+    float                               coneCutoff                  = 1.0f;
+};
+
+/// <summary>
+/// One level of detail: a range of the index buffer and the meshlets built from it, with the object space error
+/// of the simplification relative to the full detail mesh.
+/// </summary>
+struct MeshLod
+{
+    uint32_t                            firstIndex                  = 0;
+    uint32_t                            indexCount                  = 0;
+    uint32_t                            firstMeshlet                = 0;
+    uint32_t                            meshletCount                = 0;
+    float                               error                       = 0.0f;
+    uint32_t                            reserved                    = 0;
+};
+
+/// <summary>
+/// One mip level of a texture, offset relative to the data of the DecodedAsset.
+/// </summary>
+struct TextureLevel
+{
+    VkDeviceSize                        offset                      = 0;
+    VkDeviceSize                        size                        = 0;
+    uint32_t                            width                       = 0;
+    uint32_t                            height                      = 0;
+};
+
+/// <summary>
+/// CPU side result of decoding an asset file, laid out as it is copied to the GPU.
+///
+///     Mesh    - vertexCount MeshVertex, then indexCount uint32_t indices at indexOffset, the uint32_t meshlet
+///               vertex array at meshletVertexOffset and the uint8_t meshlet triangle array at meshletTriangleOffset.
+///               The indices and meshlets hold every level of detail one after the other, as listed in lods; the
+///               full detail mesh is lods[0]
+///     Texture - the mip levels listed in levels, tightly packed rows of blocks of the format. When levels holds only
+///               level 0 of an uncompressed format, the other levels may be generated on the GPU
+///
+/// Decoded data is owned by data. Assets loaded from a memory mapped file leave data empty and point into the
+/// mapping instead, which they keep alive.
+/// </summary>
+struct DecodedAsset
+{
+    AssetType                           type                        = AssetType::Mesh;
+    std::vector<uint8_t>                data                        = {};
+
+    //Mapped files
+    std::shared_ptr<const MappedFile>   mapping                     = nullptr;
+    const uint8_t*                      mappedData                  = nullptr;
+    size_t                              mappedSize                  = 0;
+
+    //Mesh
+    uint32_t                            vertexCount                 = 0;
+    uint32_t                            indexCount                  = 0;
+    VkDeviceSize                        indexOffset                 = 0;
+    VkDeviceSize                        meshletVertexOffset         = 0;
+    VkDeviceSize                        meshletTriangleOffset       = 0;
+    MeshBounds                          bounds                      = {};
+    std::vector<Meshlet>                meshlets                    = {};
+    std::vector<MeshLod>                lods                        = {};
+
+    //Texture
+    uint32_t                            width                       = 0;
+    uint32_t                            height                      = 0;
+    VkFormat                            format                      = VK_FORMAT_UNDEFINED;
+    uint32_t                            mipLevels                   = 1;
+    std::vector<TextureLevel>           levels                      = {};
+
+    const uint8_t*                      getData()                                                                               const;
+    size_t                              getSize()                                                                               const;
+    void                                releaseData();
+};
+
+/// <summary>
+/// Decodes asset files already read into memory. Runs on job system workers, so decoders only touch their input.
+///
+///     .obj    - Wavefront OBJ meshes, polygons are triangulated as fans and identical position, texture coordinate
+///               and normal combinations share one vertex. Levels of detail are simplified by MeshSimplifier and
+///               meshlets built by MeshletBuilder
+///     .ppm    - binary PPM (P6) textures with 8 bit channels, expanded to RGBA8
+///
+/// Binary .vsmesh meshes and .ktx2 textures need no decoding, they are memory mapped and validated by MeshFile::load
+/// and Ktx2File::load.
+/// </summary>
+class AssetDecoder
+{
+public:
+    static std::optional<AssetType>     getType(const std::filesystem::path& path);
+    static DecodedAsset                 decode(AssetType type, const uint8_t* data, size_t size);
+
+    static DecodedAsset                 decodeOBJ(const uint8_t* data, size_t size);
+    static DecodedAsset                 decodePPM(const uint8_t* data, size_t size);
+
+    static constexpr uint32_t           MAX_LOD_COUNT               = 8;
+    static constexpr uint32_t           MIN_LOD_TRIANGLES           = 32;   // no level is simplified below this
+
+    static DecodedAsset                 createMesh(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices,
+                                                   uint32_t lodCount = MAX_LOD_COUNT);
+};
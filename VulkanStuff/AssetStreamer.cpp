@@ -0,0 +1,1002 @@
+#include "pch.h"
+#include "AssetStreamer.h"
+#include "FrameTimeRecorder.h"
+#include "JobSystem.h"
+#include "MeshFile.h"
+#include "Ktx2File.h"
+#include "TextureFormat.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static uint64_t elapsedNanoseconds(std::chrono::steady_clock::time_point start)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+/// <summary>
+/// Reads the file past the OS file cache into data, which has to be aligned and hold size rounded up to the alignment.
+/// Every read asks for a multiple of the alignment at an aligned offset, only the last one comes back short at the
+/// end of the file. Returns the number of bytes read, or nothing when the file can't be opened.
+/// </summary>
+static std::optional<size_t> readUnbuffered(const std::filesystem::path& path, uint8_t* data, size_t size, size_t alignment, size_t chunkSize)
+{
+    size_t offset = 0;
+
+#ifdef _WIN32
+    const HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                    FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        return std::nullopt;
+    }
+
+    while(offset < size)
+    {
+        const size_t request = std::min(chunkSize, (size - offset + alignment - 1) / alignment * alignment);
+
+        DWORD read = 0;
+        if(!ReadFile(file, data + offset, static_cast<DWORD>(request), &read, nullptr) || read == 0)
+        {
+            break;
+        }
+        offset += read;
+    }
+    CloseHandle(file);
+#else
+#ifdef O_DIRECT
+    int file = open(path.c_str(), O_RDONLY | O_DIRECT);
+    // File systems without direct I/O, like tmpfs, refuse the flag
+    if(file < 0 && errno == EINVAL)
+    {
+        file = open(path.c_str(), O_RDONLY);
+    }
+#else
+    const int file = open(path.c_str(), O_RDONLY);
+#ifdef F_NOCACHE
+    if(file >= 0)
+    {
+        fcntl(file, F_NOCACHE, 1);
+    }
+#endif
+#endif
+    if(file < 0)
+    {
+        return std::nullopt;
+    }
+
+    while(offset < size)
+    {
+        const size_t request = std::min(chunkSize, (size - offset + alignment - 1) / alignment * alignment);
+
+        const ssize_t read = ::read(file, data + offset, request);
+        if(read <= 0)
+        {
+            break;
+        }
+        offset += static_cast<size_t>(read);
+    }
+    close(file);
+#endif
+
+    return std::min(offset, size);
+}
+
+AssetStreamer::AssetStreamer(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                             const VkPhysicalDeviceFeatures& enabledFeatures, JobSystem& jobSystem, MemoryBudgetMonitor* budgetMonitor,
+                             ResidencyManager& residencyManager, VkDeviceSize stagingCapacity, uint32_t ioThreadCount, bool generateMipmaps)
+    : vkDevice(device)
+    , capabilities(capabilities)
+    , vkAllocator(allocator)
+    , enabledFeatures(enabledFeatures)
+    , jobSystem(jobSystem)
+    , budgetMonitor(budgetMonitor)
+    , residencyManager(residencyManager)
+    , stagingRing(device, capabilities, allocator, budgetMonitor, stagingCapacity)
+    , maxHostBytesInFlight(stagingCapacity * HOST_BYTES_IN_FLIGHT_FACTOR)
+    , generateMipmaps(generateMipmaps)
+    , decodeCounter(std::make_unique<JobCounter>())
+{
+    // One sampler for every streamed texture: trilinear, anisotropic when the device supports it.
+    const bool anisotropyEnabled = enabledFeatures.samplerAnisotropy == VK_TRUE;
+
+    VkSamplerCreateInfo samplerCreateInfo
+    {
+        VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        nullptr,
+        NULL,
+        VK_FILTER_LINEAR,
+        VK_FILTER_LINEAR,
+        VK_SAMPLER_MIPMAP_MODE_LINEAR,
+        VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        0.0f,
+        anisotropyEnabled ? VK_TRUE : VK_FALSE,
+        anisotropyEnabled ? std::min(MAX_ANISOTROPY, capabilities.properties.limits.maxSamplerAnisotropy) : 1.0f,
+        VK_FALSE,
+        VK_COMPARE_OP_ALWAYS,
+        0.0f,
+        VK_LOD_CLAMP_NONE,
+        VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+        VK_FALSE
+    };
+
+    VkSampler textureSampler = nullptr;
+    if(vkCreateSampler(vkDevice, &samplerCreateInfo, vkAllocator, &textureSampler) != VK_SUCCESS)
+    {
+        throw std::runtime_error("AssetStreamer: Failed to create texture sampler!");
+    }
+    sampler = UniqueSampler(vkDevice, textureSampler, vkAllocator);
+
+    for(uint32_t i = 0; i < std::max(ioThreadCount, 1u); ++i)
+    {
+        ioThreads.emplace_back(&AssetStreamer::ioThreadLoop, this);
+    }
+}
+
+AssetStreamer::~AssetStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(readMutex);
+        stopping = true;
+    }
+    readCondition.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(throttleMutex);
+    }
+    throttleCondition.notify_all();
+
+    for(std::thread& thread : ioThreads)
+    {
+        thread.join();
+    }
+
+    // Decode jobs reference the assets, they have to finish before anything is released.
+    jobSystem.wait(*decodeCounter);
+
+    for(const auto& asset : assets)
+    {
+        if(asset->residencyId != 0)
+        {
+            residencyManager.unregisterResource(asset->residencyId);
+        }
+        releaseResource(*asset);
+    }
+}
+
+/// <summary>
+/// Queues the file for streaming and returns its handle. Requesting the same path again returns the same handle
+/// and queues the file again only if it was evicted.
+/// </summary>
+AssetHandle AssetStreamer::request(const std::filesystem::path& path)
+{
+    const auto lookup = assetLookup.find(path.string());
+    if(lookup != assetLookup.end())
+    {
+        Asset& asset = *assets[lookup->second];
+        if(asset.state.load(std::memory_order_acquire) == AssetState::Evicted)
+        {
+            enqueueRead(&asset);
+        }
+        return lookup->second;
+    }
+
+    const auto type = AssetDecoder::getType(path);
+    if(!type.has_value())
+    {
+        throw std::runtime_error("AssetStreamer: Unknown asset type of " + path.string() + "!");
+    }
+
+    const AssetHandle handle = static_cast<AssetHandle>(assets.size());
+
+    auto asset = std::make_unique<Asset>();
+    asset->path = path;
+    asset->type = type.value();
+    assets.push_back(std::move(asset));
+    assetLookup.emplace(path.string(), handle);
+
+    enqueueRead(assets.back().get());
+
+    return handle;
+}
+
+void AssetStreamer::enqueueRead(Asset* asset)
+{
+    asset->state.store(AssetState::Queued, std::memory_order_release);
+    asset->requestTime = Clock::now();
+    if(!firstRequestTime.has_value())
+    {
+        firstRequestTime = asset->requestTime;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(readMutex);
+        readQueue.push_back(asset);
+    }
+    readCondition.notify_one();
+}
+
+void AssetStreamer::ioThreadLoop()
+{
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(readMutex);
+            readCondition.wait(lock, [this] { return stopping || !readQueue.empty(); });
+        }
+
+        // Throttled before taking an asset, so the other readers still see the queue as it is.
+        if(hostBytesInFlight.load() > maxHostBytesInFlight)
+        {
+            ioThrottles.fetch_add(1, std::memory_order_relaxed);
+
+            std::unique_lock<std::mutex> lock(throttleMutex);
+            throttledReaders.fetch_add(1);
+            throttleCondition.wait(lock, [this] { return stopping || hostBytesInFlight.load() <= maxHostBytesInFlight; });
+            throttledReaders.fetch_sub(1);
+        }
+
+        Asset* asset = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(readMutex);
+
+            if(stopping)
+            {
+                return;
+            }
+            if(readQueue.empty())
+            {
+                continue;
+            }
+
+            asset = readQueue.front();
+            readQueue.pop_front();
+        }
+
+        readAsset(asset);
+    }
+}
+
+/// <summary>
+/// Reads the whole file with unbuffered I/O into a sector aligned buffer, which is handed to the decoder. Streamed
+/// files are read once, going past the file cache saves a copy and keeps them from evicting more useful pages.
+/// </summary>
+void AssetStreamer::readAsset(Asset* asset)
+{
+    asset->state.store(AssetState::Reading, std::memory_order_release);
+
+    const Clock::time_point start = Clock::now();
+
+    if(MeshFile::isMeshFile(asset->path) || Ktx2File::isKtx2File(asset->path))
+    {
+        readMappedAsset(asset, start);
+        return;
+    }
+
+    std::error_code error;
+    const uintmax_t fileSize = std::filesystem::file_size(asset->path, error);
+
+    const size_t size = error ? 0 : static_cast<size_t>(fileSize);
+    const size_t capacity = std::max<size_t>((size + READ_ALIGNMENT - 1) / READ_ALIGNMENT * READ_ALIGNMENT, READ_ALIGNMENT);
+
+    std::shared_ptr<uint8_t> data(static_cast<uint8_t*>(::operator new(capacity, std::align_val_t(READ_ALIGNMENT))),
+                                  [](uint8_t* pointer) { ::operator delete(pointer, std::align_val_t(READ_ALIGNMENT)); });
+
+    const std::optional<size_t> read = error ? std::nullopt : readUnbuffered(asset->path, data.get(), size, READ_ALIGNMENT, READ_CHUNK_SIZE);
+    if(!read.has_value())
+    {
+        std::cerr << "AssetStreamer: Failed to open " << asset->path.string() << std::endl;
+        asset->state.store(AssetState::Failed, std::memory_order_release);
+        failedAssets.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    bytesRead.fetch_add(read.value(), std::memory_order_relaxed);
+    readNanoseconds.fetch_add(elapsedNanoseconds(start), std::memory_order_relaxed);
+
+    if(read.value() != size)
+    {
+        std::cerr << "AssetStreamer: Failed to read " << asset->path.string() << std::endl;
+        asset->state.store(AssetState::Failed, std::memory_order_release);
+        failedAssets.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    hostBytesInFlight.fetch_add(size, std::memory_order_relaxed);
+    asset->state.store(AssetState::Decoding, std::memory_order_release);
+
+    jobSystem.schedule([this, asset, data, size] { decodeAsset(asset, data, size); }, decodeCounter.get());
+}
+
+/// <summary>
+/// Binary meshes and KTX2 textures need no decoding. The file is mapped and the upload copies straight from the
+/// mapping, the read ahead requested here keeps the page faults off the render thread.
+/// </summary>
+void AssetStreamer::readMappedAsset(Asset* asset, Clock::time_point start)
+{
+    DecodedResult result = {};
+    result.asset = asset;
+
+    try
+    {
+        result.decoded = MeshFile::isMeshFile(asset->path) ? MeshFile::load(asset->path) : Ktx2File::load(asset->path);
+        result.decoded.mapping->prefetch();
+    }
+    catch(const std::exception& exception)
+    {
+        std::cerr << "AssetStreamer: Failed to load " << asset->path.string() << ": " << exception.what() << std::endl;
+        asset->state.store(AssetState::Failed, std::memory_order_release);
+        failedAssets.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    bytesMapped.fetch_add(result.decoded.getSize(), std::memory_order_relaxed);
+    readNanoseconds.fetch_add(elapsedNanoseconds(start), std::memory_order_relaxed);
+    hostBytesInFlight.fetch_add(result.decoded.getSize(), std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(readyMutex);
+    readyQueue.push_back(std::move(result));
+}
+
+void AssetStreamer::decodeAsset(Asset* asset, std::shared_ptr<uint8_t> fileData, size_t fileSize)
+{
+    const Clock::time_point start = Clock::now();
+
+    DecodedResult result = {};
+    result.asset = asset;
+
+    try
+    {
+        result.decoded = AssetDecoder::decode(asset->type, fileData.get(), fileSize);
+    }
+    catch(const std::exception& exception)
+    {
+        std::cerr << "AssetStreamer: Failed to decode " << asset->path.string() << ": " << exception.what() << std::endl;
+        asset->state.store(AssetState::Failed, std::memory_order_release);
+        failedAssets.fetch_add(1, std::memory_order_relaxed);
+
+        releaseHostBytes(fileSize);
+        return;
+    }
+
+    bytesDecoded.fetch_add(fileSize, std::memory_order_relaxed);
+    decodeNanoseconds.fetch_add(elapsedNanoseconds(start), std::memory_order_relaxed);
+
+    // The file data is released with the job, the decoded data stays in flight until it was copied to the staging ring.
+    hostBytesInFlight.fetch_add(result.decoded.getSize(), std::memory_order_relaxed);
+    hostBytesInFlight.fetch_sub(fileSize, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(readyMutex);
+    readyQueue.push_back(std::move(result));
+}
+
+/// <summary>
+/// Called by the render thread once per frame after waiting for the frame fence. Never blocks: the ready queue is
+/// only taken when no decode job is pushing to it, otherwise the assets are picked up in the next frame.
+/// </summary>
+void AssetStreamer::update(uint64_t completedFrameNumber)
+{
+    stagingRing.release(completedFrameNumber);
+
+    std::vector<DecodedResult> ready;
+    {
+        std::unique_lock<std::mutex> lock(readyMutex, std::try_to_lock);
+        if(lock.owns_lock())
+        {
+            ready.swap(readyQueue);
+        }
+        else
+        {
+            ++readyQueueContentions;
+        }
+    }
+
+    for(DecodedResult& result : ready)
+    {
+        result.asset->decoded = std::move(result.decoded);
+        result.asset->uploadedBytes = 0;
+        result.asset->uploadLevel = 0;
+        result.asset->uploadStartTime.reset();
+        result.asset->state.store(AssetState::Uploading, std::memory_order_release);
+        uploadQueue.push_back(result.asset);
+    }
+
+    auto asset = pendingResidency.begin();
+    while(asset != pendingResidency.end())
+    {
+        if((*asset)->lastUploadFrame <= completedFrameNumber)
+        {
+            makeResident(**asset);
+            asset = pendingResidency.erase(asset);
+        }
+        else
+        {
+            ++asset;
+        }
+    }
+}
+
+/// <summary>
+/// Recorded outside of the render pass, before it. Copies as much of the queued uploads as fits into the staging ring.
+/// </summary>
+void AssetStreamer::recordUploads(VkCommandBuffer commandBuffer, uint64_t frameNumber)
+{
+    while(!uploadQueue.empty())
+    {
+        Asset& asset = *uploadQueue.front();
+
+        if(asset.memory.get() == VK_NULL_HANDLE && !createResource(asset))
+        {
+            releaseDecodedData(asset);
+            asset.state.store(AssetState::Failed, std::memory_order_release);
+            failedAssets.fetch_add(1, std::memory_order_relaxed);
+            uploadQueue.pop_front();
+            continue;
+        }
+
+        if(!asset.uploadStartTime.has_value())
+        {
+            asset.uploadStartTime = Clock::now();
+        }
+
+        if(!recordAssetUpload(commandBuffer, asset))
+        {
+            ++stagingStalls;
+            break;
+        }
+
+        asset.lastUploadFrame = frameNumber;
+        releaseDecodedData(asset);
+        pendingResidency.push_back(&asset);
+        uploadQueue.pop_front();
+    }
+
+    stagingRing.commit(frameNumber);
+}
+
+/// <summary>
+/// Creates the device local buffer or image of a decoded asset. Failure to allocate fails the asset, not the frame.
+/// </summary>
+bool AssetStreamer::createResource(Asset& asset)
+{
+    const DecodedAsset& decoded = asset.decoded;
+
+    VkMemoryRequirements memoryRequirements = {};
+
+    if(decoded.type == AssetType::Mesh)
+    {
+        VkBufferCreateInfo bufferCreateInfo
+        {
+            VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            nullptr,
+            NULL,
+            static_cast<VkDeviceSize>(decoded.getSize()),
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_SHARING_MODE_EXCLUSIVE,
+            0,
+            nullptr
+        };
+
+        VkBuffer buffer = nullptr;
+        if(vkCreateBuffer(vkDevice, &bufferCreateInfo, vkAllocator, &buffer) != VK_SUCCESS)
+        {
+            return false;
+        }
+        asset.buffer = UniqueBuffer(vkDevice, buffer, vkAllocator);
+
+        vkGetBufferMemoryRequirements(vkDevice, buffer, &memoryRequirements);
+    }
+    else
+    {
+        const auto formatInfo = TextureFormat::getInfo(decoded.format);
+        if(!formatInfo.has_value() || !TextureFormat::isEnabled(decoded.format, enabledFeatures))
+        {
+            std::cerr << "AssetStreamer: " << asset.path.string() << " has format " << TextureFormat::getName(decoded.format)
+                      << ", which the device doesn't support" << std::endl;
+            return false;
+        }
+
+        VkFormatProperties formatProperties = {};
+        vkGetPhysicalDeviceFormatProperties(capabilities.vkPhysicalDevice, decoded.format, &formatProperties);
+        if(!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+        {
+            std::cerr << "AssetStreamer: " << TextureFormat::getName(decoded.format) << " of " << asset.path.string() << " can't be sampled" << std::endl;
+            return false;
+        }
+
+        // Texture copies are split into whole rows of blocks, a row has to fit into one chunk.
+        if(TextureFormat::getRowSize(formatInfo.value(), decoded.width) > stagingRing.getCapacity() / 2)
+        {
+            std::cerr << "AssetStreamer: Rows of " << asset.path.string() << " don't fit into the staging ring" << std::endl;
+            return false;
+        }
+
+        // Levels missing from the file are blitted from level 0 on the GPU, which needs linear filtering of the format.
+        const VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        asset.generateMips = generateMipmaps && decoded.levels.size() == 1 && !formatInfo->compressed
+                          && (formatProperties.optimalTilingFeatures & blitFeatures) == blitFeatures;
+        asset.mipLevels = asset.generateMips ? TextureFormat::getMipLevelCount(decoded.width, decoded.height) : static_cast<uint32_t>(decoded.levels.size());
+
+        VkImageUsageFlags imageUsage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        if(asset.generateMips)
+        {
+            imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
+
+        VkImageCreateInfo imageCreateInfo
+        {
+            VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            nullptr,
+            NULL,
+            VK_IMAGE_TYPE_2D,
+            decoded.format,
+            { decoded.width, decoded.height, 1 },
+            asset.mipLevels,
+            1,
+            VK_SAMPLE_COUNT_1_BIT,
+            VK_IMAGE_TILING_OPTIMAL,
+            imageUsage,
+            VK_SHARING_MODE_EXCLUSIVE,
+            0,
+            nullptr,
+            VK_IMAGE_LAYOUT_UNDEFINED
+        };
+
+        VkImage image = nullptr;
+        if(vkCreateImage(vkDevice, &imageCreateInfo, vkAllocator, &image) != VK_SUCCESS)
+        {
+            return false;
+        }
+        asset.image = UniqueImage(vkDevice, image, vkAllocator);
+
+        vkGetImageMemoryRequirements(vkDevice, image, &memoryRequirements);
+    }
+
+    const auto memoryTypeIndex = capabilities.findMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if(!memoryTypeIndex.has_value())
+    {
+        releaseResource(asset);
+        return false;
+    }
+
+    VkMemoryAllocateInfo memoryAllocateInfo
+    {
+        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        nullptr,
+        memoryRequirements.size,
+        memoryTypeIndex.value()
+    };
+
+    VkDeviceMemory memory = nullptr;
+    if(vkAllocateMemory(vkDevice, &memoryAllocateInfo, vkAllocator, &memory) != VK_SUCCESS)
+    {
+        releaseResource(asset);
+        return false;
+    }
+    asset.memory = UniqueDeviceMemory(vkDevice, memory, vkAllocator);
+    asset.memoryTypeIndex = memoryTypeIndex.value();
+    asset.memorySize = memoryRequirements.size;
+
+    if(budgetMonitor != nullptr)
+    {
+        budgetMonitor->trackAllocation(asset.memoryTypeIndex, asset.memorySize);
+    }
+
+    if(decoded.type == AssetType::Mesh)
+    {
+        vkBindBufferMemory(vkDevice, asset.buffer, memory, 0);
+        return true;
+    }
+
+    vkBindImageMemory(vkDevice, asset.image, memory, 0);
+
+    VkImageViewCreateInfo imageViewCreateInfo = {
+        VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        nullptr,
+        NULL,
+        asset.image,
+        VK_IMAGE_VIEW_TYPE_2D,
+        decoded.format,
+        {VK_COMPONENT_SWIZZLE_IDENTITY,VK_COMPONENT_SWIZZLE_IDENTITY,VK_COMPONENT_SWIZZLE_IDENTITY,VK_COMPONENT_SWIZZLE_IDENTITY},
+        {VK_IMAGE_ASPECT_COLOR_BIT, 0,asset.mipLevels,0,1}
+    };
+
+    VkImageView imageView = nullptr;
+    if(vkCreateImageView(vkDevice, &imageViewCreateInfo, vkAllocator, &imageView) != VK_SUCCESS)
+    {
+        releaseResource(asset);
+        return false;
+    }
+    asset.imageView = UniqueImageView(vkDevice, imageView, vkAllocator);
+
+    return true;
+}
+
+/// <summary>
+/// Copies the rest of the asset chunk by chunk and returns true once the last chunk was recorded, or false when
+/// the staging ring ran full first. A chunk is at most half the ring, so large assets don't starve the queue.
+/// </summary>
+bool AssetStreamer::recordAssetUpload(VkCommandBuffer commandBuffer, Asset& asset)
+{
+    return asset.decoded.type == AssetType::Mesh ? recordMeshUpload(commandBuffer, asset) : recordTextureUpload(commandBuffer, asset);
+}
+
+bool AssetStreamer::recordMeshUpload(VkCommandBuffer commandBuffer, Asset& asset)
+{
+    const DecodedAsset& decoded = asset.decoded;
+    const VkDeviceSize totalBytes = static_cast<VkDeviceSize>(decoded.getSize());
+    const VkDeviceSize maxChunkSize = stagingRing.getCapacity() / 2;
+
+    while(asset.uploadedBytes < totalBytes)
+    {
+        const VkDeviceSize chunkSize = std::min(totalBytes - asset.uploadedBytes, maxChunkSize);
+
+        const auto stagingOffset = stagingRing.allocate(chunkSize, COPY_ALIGNMENT);
+        if(!stagingOffset.has_value())
+        {
+            return false;
+        }
+
+        std::memcpy(stagingRing.getMapped() + stagingOffset.value(), decoded.getData() + asset.uploadedBytes, static_cast<size_t>(chunkSize));
+
+        const VkBufferCopy region = { stagingOffset.value(), asset.uploadedBytes, chunkSize };
+        vkCmdCopyBuffer(commandBuffer, stagingRing.getBuffer(), asset.buffer, 1, &region);
+
+        asset.uploadedBytes += chunkSize;
+        bytesUploaded += chunkSize;
+    }
+
+    VkBufferMemoryBarrier readBarrier
+    {
+        VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        nullptr,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        asset.buffer,
+        0,
+        VK_WHOLE_SIZE
+    };
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0,
+                         0, nullptr, 1, &readBarrier, 0, nullptr);
+
+    return true;
+}
+
+/// <summary>
+/// Copies the mip levels of the texture level by level, each in chunks of whole rows of blocks.
+/// </summary>
+bool AssetStreamer::recordTextureUpload(VkCommandBuffer commandBuffer, Asset& asset)
+{
+    const DecodedAsset& decoded = asset.decoded;
+    const TextureFormatInfo formatInfo = TextureFormat::getInfo(decoded.format).value();
+    const VkDeviceSize maxChunkSize = stagingRing.getCapacity() / 2;
+
+    if(asset.uploadLevel == 0 && asset.uploadedBytes == 0)
+    {
+        VkImageMemoryBarrier transferBarrier
+        {
+            VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            nullptr,
+            0,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED,
+            asset.image,
+            { VK_IMAGE_ASPECT_COLOR_BIT, 0, asset.mipLevels, 0, 1 }
+        };
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &transferBarrier);
+    }
+
+    while(asset.uploadLevel < decoded.levels.size())
+    {
+        const TextureLevel& level = decoded.levels[asset.uploadLevel];
+        const VkDeviceSize rowSize = TextureFormat::getRowSize(formatInfo, level.width);
+        const uint32_t rowCount = TextureFormat::getRowCount(formatInfo, level.height);
+
+        while(asset.uploadedBytes < level.size)
+        {
+            const uint32_t firstRow = static_cast<uint32_t>(asset.uploadedBytes / rowSize);
+            const uint32_t chunkRows = std::min(rowCount - firstRow, static_cast<uint32_t>(std::max<VkDeviceSize>(maxChunkSize / rowSize, 1)));
+            const VkDeviceSize chunkSize = chunkRows * rowSize;
+
+            const auto stagingOffset = stagingRing.allocate(chunkSize, COPY_ALIGNMENT);
+            if(!stagingOffset.has_value())
+            {
+                return false;
+            }
+
+            std::memcpy(stagingRing.getMapped() + stagingOffset.value(), decoded.getData() + level.offset + asset.uploadedBytes, static_cast<size_t>(chunkSize));
+
+            // The extent of the last row of blocks may end inside a block, at the edge of the level.
+            const uint32_t firstTexelRow = firstRow * formatInfo.blockHeight;
+            const VkBufferImageCopy region
+            {
+                stagingOffset.value(),
+                0,
+                0,
+                { VK_IMAGE_ASPECT_COLOR_BIT, asset.uploadLevel, 0, 1 },
+                { 0, static_cast<int32_t>(firstTexelRow), 0 },
+                { level.width, std::min(chunkRows * formatInfo.blockHeight, level.height - firstTexelRow), 1 }
+            };
+            vkCmdCopyBufferToImage(commandBuffer, stagingRing.getBuffer(), asset.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+            asset.uploadedBytes += chunkSize;
+            bytesUploaded += chunkSize;
+        }
+
+        ++asset.uploadLevel;
+        asset.uploadedBytes = 0;
+    }
+
+    if(asset.generateMips)
+    {
+        recordMipGeneration(commandBuffer, asset);
+        return true;
+    }
+
+    VkImageMemoryBarrier readBarrier
+    {
+        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        nullptr,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        asset.image,
+        { VK_IMAGE_ASPECT_COLOR_BIT, 0, asset.mipLevels, 0, 1 }
+    };
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                         0, nullptr, 0, nullptr, 1, &readBarrier);
+
+    return true;
+}
+
+/// <summary>
+/// Generates the mip chain from level 0, each level is a linear blit of the one above it. The levels end up in
+/// SHADER_READ_ONLY_OPTIMAL like uploaded ones.
+/// </summary>
+void AssetStreamer::recordMipGeneration(VkCommandBuffer commandBuffer, Asset& asset)
+{
+    VkImageMemoryBarrier sourceBarrier
+    {
+        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        nullptr,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_ACCESS_TRANSFER_READ_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        asset.image,
+        { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+    };
+
+    for(uint32_t level = 1; level < asset.mipLevels; ++level)
+    {
+        // The level above was written by the copy or the previous blit
+        sourceBarrier.subresourceRange.baseMipLevel = level - 1;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &sourceBarrier);
+
+        const VkImageBlit blit
+        {
+            { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1 },
+            { { 0, 0, 0 }, { static_cast<int32_t>(std::max(asset.decoded.width >> (level - 1), 1u)), static_cast<int32_t>(std::max(asset.decoded.height >> (level - 1), 1u)), 1 } },
+            { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 },
+            { { 0, 0, 0 }, { static_cast<int32_t>(std::max(asset.decoded.width >> level, 1u)), static_cast<int32_t>(std::max(asset.decoded.height >> level, 1u)), 1 } }
+        };
+        vkCmdBlitImage(commandBuffer, asset.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, asset.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+    }
+
+    // Every level but the last was a blit source
+    const VkImageMemoryBarrier readBarriers[]
+    {
+        {
+            VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            nullptr,
+            VK_ACCESS_TRANSFER_READ_BIT,
+            VK_ACCESS_SHADER_READ_BIT,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED,
+            asset.image,
+            { VK_IMAGE_ASPECT_COLOR_BIT, 0, asset.mipLevels - 1, 0, 1 }
+        },
+        {
+            VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            nullptr,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED,
+            asset.image,
+            { VK_IMAGE_ASPECT_COLOR_BIT, asset.mipLevels - 1, 1, 0, 1 }
+        }
+    };
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                         0, nullptr, 0, nullptr, static_cast<uint32_t>(std::size(readBarriers)), readBarriers);
+}
+
+/// <summary>
+/// The frame with the last copy of the asset completed, it can be used from now on.
+/// </summary>
+void AssetStreamer::makeResident(Asset& asset)
+{
+    Asset* const resident = &asset;
+    asset.residencyId = residencyManager.registerResource(budgetMonitor != nullptr ? budgetMonitor->getHeapIndex(asset.memoryTypeIndex) : 0,
+                                                          asset.memorySize, false,
+                                                          [this, resident](EvictionAction)
+                                                          {
+                                                              const VkDeviceSize freedBytes = releaseResource(*resident);
+                                                              resident->residencyId = 0;
+                                                              resident->state.store(AssetState::Evicted, std::memory_order_release);
+                                                              ++evictedAssets;
+                                                              return freedBytes;
+                                                          });
+
+    asset.state.store(AssetState::Resident, std::memory_order_release);
+
+    lastResidentTime = Clock::now();
+    residentLatencies.push_back(std::chrono::duration<double, std::milli>(lastResidentTime - asset.requestTime).count());
+    ++residentAssets;
+
+    if(asset.decoded.type == AssetType::Texture)
+    {
+        // Upload time includes the frames in flight, it is compared between runs with and without generated mips.
+        const double uploadTime = std::chrono::duration<double, std::milli>(lastResidentTime - asset.uploadStartTime.value()).count();
+        (asset.generateMips ? generatedMipUploadTimes : textureUploadTimes).push_back(uploadTime);
+
+        VkDeviceSize uncompressedSize = 0;
+        for(uint32_t level = 0; level < asset.mipLevels; ++level)
+        {
+            uncompressedSize += static_cast<VkDeviceSize>(std::max(asset.decoded.width >> level, 1u)) * std::max(asset.decoded.height >> level, 1u) * 4;
+        }
+
+        ++textureCount;
+        textureMemory += asset.memorySize;
+        textureUncompressedMemory += uncompressedSize;
+    }
+}
+
+VkDeviceSize AssetStreamer::releaseResource(Asset& asset)
+{
+    const VkDeviceSize freedBytes = asset.memorySize;
+
+    if(asset.memory.get() != VK_NULL_HANDLE && budgetMonitor != nullptr)
+    {
+        budgetMonitor->trackFree(asset.memoryTypeIndex, asset.memorySize);
+    }
+
+    asset.imageView.reset();
+    asset.image.reset();
+    asset.buffer.reset();
+    asset.memory.reset();
+    asset.memorySize = 0;
+
+    return freedBytes;
+}
+
+void AssetStreamer::releaseDecodedData(Asset& asset)
+{
+    const VkDeviceSize size = asset.decoded.getSize();
+    asset.decoded.releaseData();
+
+    releaseHostBytes(size);
+}
+
+/// <summary>
+/// The decrement and the check of throttledReaders are sequentially consistent, like the increment and the check of
+/// hostBytesInFlight by a reader going to sleep. Either the reader sees the released bytes, or this sees the reader
+/// and takes the mutex after it started waiting, so no wake-up is lost and nobody waits when no reader is throttled.
+/// </summary>
+void AssetStreamer::releaseHostBytes(VkDeviceSize size)
+{
+    hostBytesInFlight.fetch_sub(size);
+
+    if(throttledReaders.load() > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(throttleMutex);
+        }
+        throttleCondition.notify_all();
+    }
+}
+
+AssetState AssetStreamer::getState(AssetHandle handle) const
+{
+    return assets.at(handle)->state.load(std::memory_order_acquire);
+}
+
+/// <summary>
+/// Returns the mesh if it is resident and marks it as used by the frame. An evicted mesh is streamed in again.
+/// </summary>
+std::optional<ResidentMesh> AssetStreamer::getMesh(AssetHandle handle, uint64_t frameNumber)
+{
+    Asset& asset = *assets.at(handle);
+
+    switch(asset.state.load(std::memory_order_acquire))
+    {
+    case AssetState::Resident:
+        residencyManager.touch(asset.residencyId, frameNumber);
+        return ResidentMesh{ asset.buffer, asset.decoded.indexOffset, asset.decoded.vertexCount, asset.decoded.lods[0].indexCount,
+                             asset.decoded.lods.data(), static_cast<uint32_t>(asset.decoded.lods.size()) };
+    case AssetState::Evicted:
+        enqueueRead(&asset);
+        return std::nullopt;
+    default:
+        return std::nullopt;
+    }
+}
+
+/// <summary>
+/// Returns the texture if it is resident and marks it as used by the frame. An evicted texture is streamed in again.
+/// </summary>
+std::optional<ResidentTexture> AssetStreamer::getTexture(AssetHandle handle, uint64_t frameNumber)
+{
+    Asset& asset = *assets.at(handle);
+
+    switch(asset.state.load(std::memory_order_acquire))
+    {
+    case AssetState::Resident:
+        residencyManager.touch(asset.residencyId, frameNumber);
+        return ResidentTexture{ asset.image, asset.imageView, sampler, { asset.decoded.width, asset.decoded.height }, asset.decoded.format, asset.mipLevels };
+    case AssetState::Evicted:
+        enqueueRead(&asset);
+        return std::nullopt;
+    default:
+        return std::nullopt;
+    }
+}
+
+void AssetStreamer::printStatistics(std::ostream& stream) const
+{
+    const auto toMiB = [](uint64_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+    const auto throughput = [&](uint64_t bytes, uint64_t nanoseconds) { return nanoseconds > 0 ? toMiB(bytes) / (static_cast<double>(nanoseconds) * 1e-9) : 0.0; };
+
+    const double streamingSeconds = firstRequestTime.has_value() && residentAssets > 0
+                                  ? std::chrono::duration<double>(lastResidentTime - firstRequestTime.value()).count() : 0.0;
+    const FrameTimeRecorder::Summary latency = FrameTimeRecorder::summarize(residentLatencies);
+    const FrameTimeRecorder::Summary textureUpload = FrameTimeRecorder::summarize(textureUploadTimes);
+    const FrameTimeRecorder::Summary generatedMipUpload = FrameTimeRecorder::summarize(generatedMipUploadTimes);
+
+    stream << "AssetStreamer: " << assets.size() << " assets, " << residentAssets << " made resident, " << evictedAssets << " evicted, "
+           << failedAssets.load() << " failed\n"
+           << "    read " << toMiB(bytesRead.load()) << " MiB and mapped " << toMiB(bytesMapped.load()) << " MiB at "
+           << throughput(bytesRead.load() + bytesMapped.load(), readNanoseconds.load()) << " MiB/s per I/O thread (" << ioThreads.size() << " threads), decoded at "
+           << throughput(bytesDecoded.load(), decodeNanoseconds.load()) << " MiB/s per worker\n"
+           << "    uploaded " << toMiB(bytesUploaded) << " MiB through a " << toMiB(stagingRing.getCapacity()) << " MiB staging ring, "
+           << (streamingSeconds > 0.0 ? toMiB(bytesUploaded) / streamingSeconds : 0.0) << " MiB/s from first request to last resident\n"
+           << "    request to resident mean " << latency.mean << " ms, p95 " << latency.p95 << " ms, max " << latency.maximum << " ms\n"
+           << "    stalls: " << stagingStalls << " staging ring full, " << readyQueueContentions << " ready queue contended, "
+           << ioThrottles.load() << " I/O throttled\n";
+
+    if(textureCount > 0)
+    {
+        stream << "    textures: " << textureCount << " resident, " << toMiB(textureMemory) / static_cast<double>(textureCount) << " MiB VRAM per texture ("
+               << toMiB(textureUncompressedMemory) / static_cast<double>(textureCount) << " MiB as RGBA8), GPU mip generation " << (generateMipmaps ? "on" : "off") << "\n"
+               << "    texture upload mean " << textureUpload.mean << " ms, p95 " << textureUpload.p95 << " ms (" << textureUpload.frameCount << " with stored mips), mean "
+               << generatedMipUpload.mean << " ms, p95 " << generatedMipUpload.p95 << " ms (" << generatedMipUpload.frameCount << " with generated mips)\n";
+    }
+}
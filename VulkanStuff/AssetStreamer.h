@@ -0,0 +1,208 @@
+#pragma once
+#include "AssetDecoder.h"
+#include "DeviceCapabilities.h"
+#include "MemoryBudget.h"
+#include "ResidencyManager.h"
+#include "StagingRing.h"
+#include "TextureFormat.h"
+#include "VkHandle.h"
+
+class JobSystem;
+class JobCounter;
+
+using AssetHandle = uint32_t;
+
+enum class AssetState
+{
+    Queued,
+    Reading,
+    Decoding,
+    Uploading,
+    Resident,
+    Evicted,
+    Failed
+};
+
+struct ResidentMesh
+{
+    VkBuffer                            buffer                      = VK_NULL_HANDLE;   // vertices at offset 0, followed by the indices
+    VkDeviceSize                        indexOffset                 = 0;
+    uint32_t                            vertexCount                 = 0;
+    uint32_t                            indexCount                  = 0;    // full detail
+    const MeshLod*                      lods                        = nullptr;  // valid while the mesh is resident
+    uint32_t                            lodCount                    = 0;
+};
+
+struct ResidentTexture
+{
+    VkImage                             image                       = VK_NULL_HANDLE;
+    VkImageView                         imageView                   = VK_NULL_HANDLE;   // SHADER_READ_ONLY_OPTIMAL, every mip level
+    VkSampler                           sampler                     = VK_NULL_HANDLE;
+    VkExtent2D                          extent                      = {};
+    VkFormat                            format                      = VK_FORMAT_UNDEFINED;
+    uint32_t                            mipLevels                   = 1;
+};
+
+/// <summary>
+/// Loads meshes and textures from disk without blocking the render thread.
+///
+/// Every asset goes through a pipeline of three stages which overlap across assets:
+///
+///     read    - a small pool of I/O threads reads whole files with unbuffered, sector aligned reads which bypass
+///               the OS file cache (FILE_FLAG_NO_BUFFERING on Windows, O_DIRECT elsewhere)
+///     decode  - a job on the JobSystem turns the file into the layout copied to the GPU. Binary .vsmesh files
+///               skip it, they are memory mapped and uploaded straight from the mapping
+///     upload  - the render thread copies decoded data through a StagingRing into device local memory,
+///               recorded into the frame command buffer before the render pass
+///
+/// request() only queues the path. update() collects decoded assets and marks uploads resident once the frame
+/// that finished them completed on the GPU. The staging ring bounds the bytes in flight to the GPU: assets larger
+/// than the ring are copied in chunks over several frames and uploads resume in the next frame when it is full.
+/// The I/O threads stop reading while the decoded data waiting for upload exceeds a multiple of the ring, so a
+/// slow GPU can't make host memory grow without bound.
+///
+/// Textures keep the mip levels stored in their file. Uncompressed textures with a single level get their mip chain
+/// blitted on the GPU when generateMipmaps is set and the format supports linear filtering. BC and ASTC textures
+/// from KTX2 files are only uploaded when the device feature of their format was enabled.
+///
+/// Resident assets are registered with the ResidencyManager and dropped under memory pressure. Requesting a
+/// dropped asset through getMesh or getTexture streams it in again.
+/// </summary>
+class AssetStreamer
+{
+public:
+                                        AssetStreamer(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                                                      const VkPhysicalDeviceFeatures& enabledFeatures, JobSystem& jobSystem, MemoryBudgetMonitor* budgetMonitor,
+                                                      ResidencyManager& residencyManager, VkDeviceSize stagingCapacity, uint32_t ioThreadCount, bool generateMipmaps);
+                                        ~AssetStreamer();
+
+                                        AssetStreamer(const AssetStreamer&) = delete;
+    AssetStreamer&                      operator=(const AssetStreamer&) = delete;
+
+    AssetHandle                         request(const std::filesystem::path& path);
+    void                                update(uint64_t completedFrameNumber);
+    void                                recordUploads(VkCommandBuffer commandBuffer, uint64_t frameNumber);
+
+    AssetState                          getState(AssetHandle handle)                                                            const;
+    std::optional<ResidentMesh>         getMesh(AssetHandle handle, uint64_t frameNumber);
+    std::optional<ResidentTexture>      getTexture(AssetHandle handle, uint64_t frameNumber);
+
+    void                                printStatistics(std::ostream& stream)                                                   const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t             READ_ALIGNMENT              = 4096;         // sector size, unbuffered reads need aligned buffers, offsets and sizes
+    static constexpr size_t             READ_CHUNK_SIZE             = 1 << 20;
+    static constexpr VkDeviceSize       HOST_BYTES_IN_FLIGHT_FACTOR = 4;            // decoded bytes waiting for upload, in multiples of the staging capacity
+    static constexpr VkDeviceSize       COPY_ALIGNMENT              = 16;           // multiple of every texel and block size copied
+    static constexpr float              MAX_ANISOTROPY              = 16.0f;
+
+    struct Asset
+    {
+        std::filesystem::path           path                        = {};
+        AssetType                       type                        = AssetType::Mesh;
+        std::atomic<AssetState>         state                       = AssetState::Queued;
+        Clock::time_point               requestTime                 = {};
+
+        //Render thread only
+        DecodedAsset                    decoded                     = {};
+        VkDeviceSize                    uploadedBytes               = 0;            // of the current level for textures
+        uint32_t                        uploadLevel                 = 0;
+        std::optional<Clock::time_point> uploadStartTime            = {};
+        uint64_t                        lastUploadFrame             = 0;
+
+        UniqueDeviceMemory              memory                      = {};
+        UniqueBuffer                    buffer                      = {};
+        UniqueImage                     image                       = {};
+        UniqueImageView                 imageView                   = {};
+        uint32_t                        memoryTypeIndex             = 0;
+        VkDeviceSize                    memorySize                  = 0;
+        uint32_t                        mipLevels                   = 1;
+        bool                            generateMips                = false;
+        ResidencyManager::ResourceId    residencyId                 = 0;
+    };
+
+    struct DecodedResult
+    {
+        Asset*                          asset                       = nullptr;
+        DecodedAsset                    decoded                     = {};
+    };
+
+    VkDevice                            vkDevice;
+    const PhysicalDeviceCapabilities&   capabilities;
+    const VkAllocationCallbacks*        vkAllocator;
+    const VkPhysicalDeviceFeatures      enabledFeatures;
+    JobSystem&                          jobSystem;
+    MemoryBudgetMonitor*                budgetMonitor;
+    ResidencyManager&                   residencyManager;
+
+    StagingRing                         stagingRing;
+    const VkDeviceSize                  maxHostBytesInFlight;
+    const bool                          generateMipmaps;
+    UniqueSampler                       sampler                     = {};
+
+    std::vector<std::unique_ptr<Asset>> assets                      = {};
+    std::unordered_map<std::string, AssetHandle> assetLookup        = {};
+
+    // Read queue, shared with the I/O threads
+    mutable std::mutex                  readMutex;
+    std::condition_variable             readCondition;
+    std::deque<Asset*>                  readQueue                   = {};
+    std::atomic<bool>                   stopping                    = false;
+    std::vector<std::thread>            ioThreads                   = {};
+
+    // I/O threads wait here while too much decoded data waits for upload. The render thread only takes the mutex
+    // when a reader is throttled, it never waits behind the read queue.
+    std::mutex                          throttleMutex;
+    std::condition_variable             throttleCondition;
+    std::atomic<uint32_t>               throttledReaders            = 0;
+    std::atomic<VkDeviceSize>           hostBytesInFlight           = 0;
+
+    // Decoded assets, filled by decode jobs and emptied by update()
+    std::mutex                          readyMutex;
+    std::vector<DecodedResult>          readyQueue                  = {};
+    std::unique_ptr<JobCounter>         decodeCounter;
+
+    //Render thread only
+    std::deque<Asset*>                  uploadQueue                 = {};
+    std::vector<Asset*>                 pendingResidency            = {};
+
+    //Statistics
+    std::atomic<uint64_t>               bytesRead                   = 0;
+    std::atomic<uint64_t>               bytesMapped                 = 0;
+    std::atomic<uint64_t>               readNanoseconds             = 0;
+    std::atomic<uint64_t>               bytesDecoded                = 0;
+    std::atomic<uint64_t>               decodeNanoseconds           = 0;
+    std::atomic<uint64_t>               ioThrottles                 = 0;
+    std::atomic<uint64_t>               failedAssets                = 0;
+    uint64_t                            bytesUploaded               = 0;
+    uint64_t                            stagingStalls               = 0;
+    uint64_t                            readyQueueContentions       = 0;
+    uint64_t                            residentAssets              = 0;
+    uint64_t                            evictedAssets               = 0;
+    std::vector<double>                 residentLatencies           = {};   // ms from request to resident
+    std::vector<double>                 textureUploadTimes          = {};   // ms from first copy to resident
+    std::vector<double>                 generatedMipUploadTimes     = {};
+    uint64_t                            textureCount                = 0;
+    VkDeviceSize                        textureMemory               = 0;
+    VkDeviceSize                        textureUncompressedMemory   = 0;    // the same textures as RGBA8 with the same mip levels
+    std::optional<Clock::time_point>    firstRequestTime            = {};
+    Clock::time_point                   lastResidentTime            = {};
+
+    void                                enqueueRead(Asset* asset);
+    void                                ioThreadLoop();
+    void                                readAsset(Asset* asset);
+    void                                readMappedAsset(Asset* asset, Clock::time_point start);
+    void                                decodeAsset(Asset* asset, std::shared_ptr<uint8_t> fileData, size_t fileSize);
+
+    bool                                createResource(Asset& asset);
+    bool                                recordAssetUpload(VkCommandBuffer commandBuffer, Asset& asset);
+    bool                                recordMeshUpload(VkCommandBuffer commandBuffer, Asset& asset);
+    bool                                recordTextureUpload(VkCommandBuffer commandBuffer, Asset& asset);
+    void                                recordMipGeneration(VkCommandBuffer commandBuffer, Asset& asset);
+    void                                makeResident(Asset& asset);
+    VkDeviceSize                        releaseResource(Asset& asset);
+    void                                releaseDecodedData(Asset& asset);
+    void                                releaseHostBytes(VkDeviceSize size);
+};
@@ -0,0 +1,292 @@
+#include "pch.h"
+#include "Benchmark.h"
+
+static void writeJSONString(std::ostream& stream, const std::string& value)
+{
+    stream << '"';
+    for(const char c : value)
+    {
+        switch(c)
+        {
+        case '"':   stream << "\\\"";   break;
+        case '\\':  stream << "\\\\";   break;
+        case '\n':  stream << "\\n";    break;
+        case '\t':  stream << "\\t";    break;
+        default:
+            if(static_cast<unsigned char>(c) < 0x20)
+            {
+                stream << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+            }
+            else
+            {
+                stream << c;
+            }
+        }
+    }
+    stream << '"';
+}
+
+static void writeJSONSummary(std::ostream& stream, const FrameTimeRecorder::Summary& summary)
+{
+    stream << "{ \"samples\": " << summary.frameCount
+           << ", \"mean\": " << summary.mean
+           << ", \"min\": " << summary.minimum
+           << ", \"median\": " << summary.median
+           << ", \"p95\": " << summary.p95
+           << ", \"p99\": " << summary.p99
+           << ", \"max\": " << summary.maximum << " }";
+}
+
+static const char* getDeviceTypeName(VkPhysicalDeviceType type)
+{
+    switch(type)
+    {
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:    return "integrated";
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:      return "discrete";
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:       return "virtual";
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:               return "cpu";
+    default:                                        return "other";
+    }
+}
+
+BenchmarkRecorder::BenchmarkRecorder(BenchmarkScenario scenario, uint32_t scale, uint32_t warmupFrames, uint32_t measuredFrames)
+    : scenario(scenario)
+    , scale(scale)
+    , warmupFrames(warmupFrames)
+    , measuredFrames(measuredFrames)
+{
+    for(auto& times : phaseTimes)
+    {
+        times.resize(measuredFrames, 0.0);
+    }
+
+    gpuTimes.reserve(measuredFrames);
+}
+
+BenchmarkScenario BenchmarkRecorder::parseScenario(const std::string& name)
+{
+    for(BenchmarkScenario scenario : { BenchmarkScenario::Triangle, BenchmarkScenario::InstancedMeshes, BenchmarkScenario::ManyDrawCalls,
+                                       BenchmarkScenario::UploadStreaming, BenchmarkScenario::PipelineCompileStorm, BenchmarkScenario::Meshlets,
+                                       BenchmarkScenario::Lod, BenchmarkScenario::SortedDraws, BenchmarkScenario::Particles })
+    {
+        if(name == getScenarioName(scenario))
+        {
+            return scenario;
+        }
+    }
+
+    throw std::runtime_error("Benchmark: Unknown scenario " + name + "!");
+}
+
+const char* BenchmarkRecorder::getScenarioName(BenchmarkScenario scenario)
+{
+    switch(scenario)
+    {
+    case BenchmarkScenario::Triangle:               return "triangle";
+    case BenchmarkScenario::InstancedMeshes:        return "instanced";
+    case BenchmarkScenario::ManyDrawCalls:          return "draw-calls";
+    case BenchmarkScenario::UploadStreaming:        return "upload";
+    case BenchmarkScenario::PipelineCompileStorm:   return "pipeline-compile";
+    case BenchmarkScenario::Meshlets:               return "meshlets";
+    case BenchmarkScenario::Lod:                    return "lod";
+    case BenchmarkScenario::SortedDraws:            return "sorted-draws";
+    case BenchmarkScenario::Particles:              return "particles";
+    default:                                        return "none";
+    }
+}
+
+const char* BenchmarkRecorder::getScaleUnit(BenchmarkScenario scenario)
+{
+    switch(scenario)
+    {
+    case BenchmarkScenario::InstancedMeshes:        return "instances";
+    case BenchmarkScenario::ManyDrawCalls:          return "draw calls";
+    case BenchmarkScenario::UploadStreaming:        return "KiB per frame";
+    case BenchmarkScenario::PipelineCompileStorm:   return "pipelines per frame";
+    case BenchmarkScenario::Meshlets:               return "spheres";
+    case BenchmarkScenario::Lod:                    return "objects";
+    case BenchmarkScenario::SortedDraws:            return "draw calls";
+    case BenchmarkScenario::Particles:              return "particles";
+    default:                                        return "";
+    }
+}
+
+uint32_t BenchmarkRecorder::getDefaultScale(BenchmarkScenario scenario)
+{
+    switch(scenario)
+    {
+    case BenchmarkScenario::InstancedMeshes:        return 10000;
+    case BenchmarkScenario::ManyDrawCalls:          return 10000;
+    case BenchmarkScenario::UploadStreaming:        return 16 * 1024;
+    case BenchmarkScenario::PipelineCompileStorm:   return 8;
+    case BenchmarkScenario::Meshlets:               return 1024;
+    case BenchmarkScenario::Lod:                    return 1024;
+    case BenchmarkScenario::SortedDraws:            return 100000;
+    case BenchmarkScenario::Particles:              return 1024 * 1024;
+    default:                                        return 1;
+    }
+}
+
+const char* BenchmarkRecorder::getPhaseName(FramePhase phase)
+{
+    switch(phase)
+    {
+    case FramePhase::Wait:      return "wait";
+    case FramePhase::Acquire:   return "acquire";
+    case FramePhase::Update:    return "update";
+    case FramePhase::Record:    return "record";
+    case FramePhase::Submit:    return "submit";
+    case FramePhase::Present:   return "present";
+    default:                    return "unknown";
+    }
+}
+
+bool BenchmarkRecorder::isMeasured(uint64_t frameNumber) const
+{
+    return frameNumber > warmupFrames && frameNumber <= static_cast<uint64_t>(warmupFrames) + measuredFrames;
+}
+
+bool BenchmarkRecorder::isFinished(uint64_t submittedFrameNumber) const
+{
+    return submittedFrameNumber >= static_cast<uint64_t>(warmupFrames) + measuredFrames;
+}
+
+void BenchmarkRecorder::recordPhase(uint64_t frameNumber, FramePhase phase, std::chrono::duration<double, std::milli> time)
+{
+    if(isMeasured(frameNumber))
+    {
+        phaseTimes[static_cast<size_t>(phase)][frameNumber - warmupFrames - 1] += time.count();
+    }
+}
+
+void BenchmarkRecorder::recordDrawCalls(uint64_t frameNumber, uint32_t frameDrawCalls)
+{
+    if(isMeasured(frameNumber))
+    {
+        drawCalls += frameDrawCalls;
+    }
+}
+
+void BenchmarkRecorder::recordGpuTime(uint64_t frameNumber, double milliseconds)
+{
+    if(isMeasured(frameNumber))
+    {
+        gpuTimes.push_back(milliseconds);
+    }
+}
+
+void BenchmarkRecorder::setConfiguration(const std::string& key, const std::string& value)
+{
+    for(auto& entry : configuration)
+    {
+        if(entry.first == key)
+        {
+            entry.second = value;
+            return;
+        }
+    }
+
+    configuration.emplace_back(key, value);
+}
+
+double BenchmarkRecorder::getDrawCallsPerFrame() const
+{
+    return measuredFrames > 0 ? static_cast<double>(drawCalls) / measuredFrames : 0.0;
+}
+
+void BenchmarkRecorder::printSummary(std::ostream& stream, const FrameTimeRecorder::Summary& frameTimes) const
+{
+    const double drawCallsPerFrame = getDrawCallsPerFrame();
+
+    stream << "Benchmark: " << getScenarioName(scenario) << " x" << scale << " " << getScaleUnit(scenario) << ", "
+           << warmupFrames << " warm-up + " << measuredFrames << " measured frames\n";
+    stream << "    frame       mean " << frameTimes.mean << " ms, p95 " << frameTimes.p95 << " ms, p99 " << frameTimes.p99 << " ms\n";
+
+    for(size_t phase = 0; phase < PHASE_COUNT; ++phase)
+    {
+        const FrameTimeRecorder::Summary summary = FrameTimeRecorder::summarize(phaseTimes[phase]);
+        stream << "    " << std::left << std::setw(12) << getPhaseName(static_cast<FramePhase>(phase)) << std::right
+               << "mean " << summary.mean << " ms, p95 " << summary.p95 << " ms\n";
+    }
+
+    if(!gpuTimes.empty())
+    {
+        const FrameTimeRecorder::Summary gpu = FrameTimeRecorder::summarize(gpuTimes);
+        stream << "    gpu         mean " << gpu.mean << " ms, p95 " << gpu.p95 << " ms\n";
+    }
+    else
+    {
+        stream << "    gpu         no timestamps\n";
+    }
+
+    stream << "    " << drawCallsPerFrame << " draw calls per frame, "
+           << (frameTimes.mean > 0.0 ? drawCallsPerFrame * 1000.0 / frameTimes.mean : 0.0) << " per second\n";
+}
+
+/// <summary>
+/// The report carries the device, driver and run parameters next to the results, so reports of different commits
+/// can be checked for being comparable before their numbers are.
+/// </summary>
+void BenchmarkRecorder::writeJSON(std::ostream& stream, const VkPhysicalDeviceProperties& deviceProperties, VkExtent2D extent,
+                                  bool headless, const std::string& label, const FrameTimeRecorder::Summary& frameTimes) const
+{
+    const double drawCallsPerFrame = getDrawCallsPerFrame();
+
+    stream << "{\n";
+    stream << "  \"label\": ";
+    writeJSONString(stream, label);
+    stream << ",\n";
+    stream << "  \"scenario\": \"" << getScenarioName(scenario) << "\",\n";
+    stream << "  \"scale\": " << scale << ",\n";
+    stream << "  \"warmupFrames\": " << warmupFrames << ",\n";
+    stream << "  \"measuredFrames\": " << measuredFrames << ",\n";
+    stream << "  \"headless\": " << (headless ? "true" : "false") << ",\n";
+    stream << "  \"extent\": [" << extent.width << ", " << extent.height << "],\n";
+
+    stream << "  \"configuration\": {";
+    for(size_t i = 0; i < configuration.size(); ++i)
+    {
+        stream << (i > 0 ? ", " : " ");
+        writeJSONString(stream, configuration[i].first);
+        stream << ": ";
+        writeJSONString(stream, configuration[i].second);
+    }
+    stream << (configuration.empty() ? "},\n" : " },\n");
+
+    stream << "  \"device\": { \"name\": ";
+    writeJSONString(stream, deviceProperties.deviceName);
+    stream << ", \"type\": \"" << getDeviceTypeName(deviceProperties.deviceType) << "\""
+           << ", \"vendorID\": " << deviceProperties.vendorID
+           << ", \"deviceID\": " << deviceProperties.deviceID
+           << ", \"driverVersion\": " << deviceProperties.driverVersion
+           << ", \"apiVersion\": \"" << VK_VERSION_MAJOR(deviceProperties.apiVersion) << "." << VK_VERSION_MINOR(deviceProperties.apiVersion)
+           << "." << VK_VERSION_PATCH(deviceProperties.apiVersion) << "\" },\n";
+
+    stream << "  \"frameTimeMs\": ";
+    writeJSONSummary(stream, frameTimes);
+    stream << ",\n";
+
+    stream << "  \"cpuPhaseMs\": {\n";
+    for(size_t phase = 0; phase < PHASE_COUNT; ++phase)
+    {
+        stream << "    \"" << getPhaseName(static_cast<FramePhase>(phase)) << "\": ";
+        writeJSONSummary(stream, FrameTimeRecorder::summarize(phaseTimes[phase]));
+        stream << (phase + 1 < PHASE_COUNT ? ",\n" : "\n");
+    }
+    stream << "  },\n";
+
+    stream << "  \"gpuTimeMs\": ";
+    if(!gpuTimes.empty())
+    {
+        writeJSONSummary(stream, FrameTimeRecorder::summarize(gpuTimes));
+    }
+    else
+    {
+        stream << "null";
+    }
+    stream << ",\n";
+
+    stream << "  \"drawCallsPerFrame\": " << drawCallsPerFrame << ",\n";
+    stream << "  \"drawCallsPerSecond\": " << (frameTimes.mean > 0.0 ? drawCallsPerFrame * 1000.0 / frameTimes.mean : 0.0) << "\n";
+    stream << "}\n";
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "FrameTimeRecorder.h"
+
+enum class BenchmarkScenario
+{
+    None,
+    Triangle,
+    InstancedMeshes,
+    ManyDrawCalls,
+    UploadStreaming,
+    PipelineCompileStorm,
+    Meshlets,
+    Lod,
+    SortedDraws,
+    Particles
+};
+
+/// <summary>
+/// CPU side steps of a frame, measured separately so a regression can be attributed to one of them.
+/// </summary>
+enum class FramePhase
+{
+    Wait,       // waiting for the frame context fence
+    Acquire,    // acquiring the swapchain image
+    Update,     // scenario work on the CPU: filling upload buffers, creating pipelines
+    Record,     // recording the command buffer
+    Submit,
+    Present,
+    Count
+};
+
+/// <summary>
+/// Collects the measurements of a benchmark run and reports them as text and JSON.
+///
+/// Frame numbers 1..warmupFrames are warm-up and ignored, the following measuredFrames frames are measured.
+/// GPU times arrive FRAMES_IN_FLIGHT frames after the CPU measurements of the same frame, every sample is
+/// therefore recorded with the number of the frame it belongs to.
+/// </summary>
+class BenchmarkRecorder
+{
+public:
+                                        BenchmarkRecorder(BenchmarkScenario scenario, uint32_t scale, uint32_t warmupFrames, uint32_t measuredFrames);
+
+    bool                                isMeasured(uint64_t frameNumber)                                                        const;
+    bool                                isFinished(uint64_t submittedFrameNumber)                                               const;
+
+    void                                recordPhase(uint64_t frameNumber, FramePhase phase, std::chrono::duration<double, std::milli> time);
+    void                                recordDrawCalls(uint64_t frameNumber, uint32_t drawCalls);
+    void                                recordGpuTime(uint64_t frameNumber, double milliseconds);
+    void                                setConfiguration(const std::string& key, const std::string& value);
+
+    void                                printSummary(std::ostream& stream, const FrameTimeRecorder::Summary& frameTimes)       const;
+    void                                writeJSON(std::ostream& stream, const VkPhysicalDeviceProperties& deviceProperties, VkExtent2D extent,
+                                                  bool headless, const std::string& label, const FrameTimeRecorder::Summary& frameTimes) const;
+
+    static BenchmarkScenario            parseScenario(const std::string& name);
+    static const char*                  getScenarioName(BenchmarkScenario scenario);
+    static const char*                  getScaleUnit(BenchmarkScenario scenario);
+    static uint32_t                     getDefaultScale(BenchmarkScenario scenario);
+    static const char*                  getPhaseName(FramePhase phase);
+
+private:
+    static constexpr size_t             PHASE_COUNT                 = static_cast<size_t>(FramePhase::Count);
+
+    const BenchmarkScenario             scenario;
+    const uint32_t                      scale;
+    const uint32_t                      warmupFrames;
+    const uint32_t                      measuredFrames;
+
+    // Indexed by measured frame, a phase may be entered more than once per frame
+    std::array<std::vector<double>, PHASE_COUNT> phaseTimes         = {};
+    std::vector<double>                 gpuTimes                    = {};
+    uint64_t                            drawCalls                   = 0;
+
+    // Settings which change the results without changing the scenario, e.g. the present mode
+    std::vector<std::pair<std::string, std::string>> configuration  = {};
+
+    double                              getDrawCallsPerFrame()                                                                  const;
+};
@@ -0,0 +1,122 @@
+#include "pch.h"
+#include "BenchmarkWorkload.h"
+
+BenchmarkWorkload::BenchmarkWorkload(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                                     uint32_t slotCount, MemoryBudgetMonitor* budgetMonitor, BenchmarkScenario scenario, uint32_t scale,
+                                     PipelineFactory pipelineFactory)
+    : resources(device, capabilities, allocator, budgetMonitor, "Benchmark")
+    , scenario(scenario)
+    , scale(scale)
+    , pipelineFactory(std::move(pipelineFactory))
+    , slots(slotCount)
+{
+    if(scenario != BenchmarkScenario::UploadStreaming)
+    {
+        return;
+    }
+
+    const VkDeviceSize uploadSize = static_cast<VkDeviceSize>(scale) * 1024;
+
+    for(Slot& slot : slots)
+    {
+        // Coherent staging memory needs no flush, the host writes are made visible by the queue submission.
+        resources.allocateBuffer(slot.staging, uploadSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        resources.allocateBuffer(slot.destination, uploadSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        resources.mapBuffer(slot.staging, &slot.mapped);
+    }
+}
+
+BenchmarkWorkload::~BenchmarkWorkload()
+{
+    for(Slot& slot : slots)
+    {
+        resources.releaseBuffer(slot.staging);
+        resources.releaseBuffer(slot.destination);
+    }
+}
+
+/// <summary>
+/// CPU side work of the frame, called after the fence of the slot was waited for.
+/// </summary>
+void BenchmarkWorkload::update(uint32_t slotIndex, uint64_t frameNumber)
+{
+    Slot& slot = slots[slotIndex];
+
+    switch(scenario)
+    {
+    case BenchmarkScenario::UploadStreaming:
+    {
+        // Different data every frame, written sequentially as it would be into write combined memory.
+        uint32_t* words = static_cast<uint32_t*>(slot.mapped);
+        const size_t wordCount = static_cast<size_t>(scale) * 1024 / sizeof(uint32_t);
+        const uint32_t seed = static_cast<uint32_t>(frameNumber) * 2654435761u;
+
+        for(size_t i = 0; i < wordCount; ++i)
+        {
+            words[i] = seed + static_cast<uint32_t>(i);
+        }
+        break;
+    }
+    case BenchmarkScenario::PipelineCompileStorm:
+        // The pipelines of the last frame of this slot are no longer used by the GPU.
+        slot.pipelines.clear();
+
+        for(uint32_t i = 0; i < scale; ++i)
+        {
+            slot.pipelines.push_back(pipelineFactory(nextPipelineVariant++));
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/// <summary>
+/// Recorded outside of the render pass, before it.
+/// </summary>
+void BenchmarkWorkload::recordTransfers(VkCommandBuffer commandBuffer, uint32_t slotIndex)
+{
+    if(scenario != BenchmarkScenario::UploadStreaming)
+    {
+        return;
+    }
+
+    Slot& slot = slots[slotIndex];
+
+    // The destination of a slot is only written by frames of that slot, which never overlap on the GPU.
+    const VkBufferCopy region = { 0, 0, static_cast<VkDeviceSize>(scale) * 1024 };
+    vkCmdCopyBuffer(commandBuffer, slot.staging.buffer, slot.destination.buffer, 1, &region);
+}
+
+/// <summary>
+/// Recorded inside the render pass with the regular graphics pipeline, viewport and scissor already bound.
+/// Returns the number of draw calls recorded.
+/// </summary>
+uint32_t BenchmarkWorkload::recordDraws(VkCommandBuffer commandBuffer, uint32_t slotIndex)
+{
+    switch(scenario)
+    {
+    case BenchmarkScenario::InstancedMeshes:
+        vkCmdDraw(commandBuffer, 3, scale, 0, 0);
+        return 1;
+
+    case BenchmarkScenario::ManyDrawCalls:
+        for(uint32_t i = 0; i < scale; ++i)
+        {
+            vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+        }
+        return scale;
+
+    case BenchmarkScenario::PipelineCompileStorm:
+        for(const UniquePipeline& pipeline : slots[slotIndex].pipelines)
+        {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+        }
+        return static_cast<uint32_t>(slots[slotIndex].pipelines.size());
+
+    default:
+        vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+        return 1;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "Benchmark.h"
+#include "GpuResources.h"
+
+/// <summary>
+/// The GPU work of a benchmark scenario, recorded into the frame command buffer in place of the single triangle.
+///
+///     triangle            - the regular frame, one draw call
+///     instanced           - one draw call of scale instances of the triangle
+///     draw-calls          - scale draw calls of one triangle each
+///     upload              - the triangle plus scale KiB written by the CPU and copied to a device local buffer every frame
+///     pipeline-compile    - scale graphics pipelines created every frame and used for one draw each
+///     meshlets            - drawn by MeshletRenderer instead, scale spheres of 2304 triangles each
+///     lod                 - drawn by LodRenderer instead, scale objects of 16128 triangles at full detail
+///     sorted-draws        - drawn by SortedDrawRenderer instead, scale draw calls of small polygons in random state order
+///     particles           - simulated and drawn by ParticleSystem instead, scale particles at most, drawn as camera facing quads
+///
+/// Like FrameReadback every frame in flight owns a slot, so nothing is touched while the GPU may still use it.
+/// Workloads are deterministic, the same scenario and scale record the same commands on every run.
+/// </summary>
+class BenchmarkWorkload
+{
+public:
+    using PipelineFactory = std::function<UniquePipeline(uint32_t variant)>;
+
+                                        BenchmarkWorkload(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                                                          uint32_t slotCount, MemoryBudgetMonitor* budgetMonitor, BenchmarkScenario scenario, uint32_t scale,
+                                                          PipelineFactory pipelineFactory);
+                                        ~BenchmarkWorkload();
+
+                                        BenchmarkWorkload(const BenchmarkWorkload&) = delete;
+    BenchmarkWorkload&                  operator=(const BenchmarkWorkload&) = delete;
+
+    void                                update(uint32_t slot, uint64_t frameNumber);
+    void                                recordTransfers(VkCommandBuffer commandBuffer, uint32_t slot);
+    uint32_t                            recordDraws(VkCommandBuffer commandBuffer, uint32_t slot);
+
+private:
+    struct Slot
+    {
+        BufferAllocation                staging                     = {};
+        BufferAllocation                destination                 = {};
+        void*                           mapped                      = nullptr;
+        std::vector<UniquePipeline>     pipelines                   = {};
+    };
+
+    const GpuResources                  resources;
+    const BenchmarkScenario             scenario;
+    const uint32_t                      scale;
+    PipelineFactory                     pipelineFactory;
+
+    std::vector<Slot>                   slots;
+    uint32_t                            nextPipelineVariant         = 0;
+};
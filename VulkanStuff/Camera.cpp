@@ -0,0 +1,138 @@
+#include "pch.h"
+#include "Camera.h"
+
+// Column major 4x4 matrices as GLSL expects them, for a right handed world looked at by a camera facing -z.
+static void multiply(const float a[16], const float b[16], float result[16])
+{
+    for(int column = 0; column < 4; ++column)
+    {
+        for(int row = 0; row < 4; ++row)
+        {
+            float sum = 0.0f;
+            for(int k = 0; k < 4; ++k)
+            {
+                sum += a[k * 4 + row] * b[column * 4 + k];
+            }
+            result[column * 4 + row] = sum;
+        }
+    }
+}
+
+static void lookAt(const float eye[3], const float target[3], float result[16])
+{
+    float forward[3] = { target[0] - eye[0], target[1] - eye[1], target[2] - eye[2] };
+    const float forwardLength = std::sqrt(forward[0] * forward[0] + forward[1] * forward[1] + forward[2] * forward[2]);
+    for(float& component : forward)
+    {
+        component /= forwardLength;
+    }
+
+    // right = forward x up with up = +y, the camera never looks straight up or down
+    float right[3] = { -forward[2], 0.0f, forward[0] };
+    const float rightLength = std::sqrt(right[0] * right[0] + right[2] * right[2]);
+    right[0] /= rightLength;
+    right[2] /= rightLength;
+
+    const float up[3] = { right[1] * forward[2] - right[2] * forward[1], right[2] * forward[0] - right[0] * forward[2], right[0] * forward[1] - right[1] * forward[0] };
+
+    const float view[16] =
+    {
+        right[0],   up[0],  -forward[0],    0.0f,
+        right[1],   up[1],  -forward[1],    0.0f,
+        right[2],   up[2],  -forward[2],    0.0f,
+        -(right[0] * eye[0] + right[1] * eye[1] + right[2] * eye[2]),
+        -(up[0] * eye[0] + up[1] * eye[1] + up[2] * eye[2]),
+        forward[0] * eye[0] + forward[1] * eye[1] + forward[2] * eye[2],
+        1.0f
+    };
+    std::copy_n(view, 16, result);
+}
+
+/// <summary>
+/// Perspective projection to Vulkan clip space: depth 0..1 and y pointing down, which turns counter clockwise
+/// triangles of the world into counter clockwise triangles in framebuffer coordinates.
+/// </summary>
+static void perspective(float verticalFov, float aspect, float nearPlane, float farPlane, float result[16])
+{
+    const float focalLength = 1.0f / std::tan(verticalFov * 0.5f);
+
+    std::fill_n(result, 16, 0.0f);
+    result[0] = focalLength / aspect;
+    result[5] = -focalLength;
+    result[10] = farPlane / (nearPlane - farPlane);
+    result[11] = -1.0f;
+    result[14] = nearPlane * farPlane / (nearPlane - farPlane);
+}
+
+void Camera::getViewProjection(float aspect, float result[16]) const
+{
+    float view[16] = {};
+    float projection[16] = {};
+    lookAt(position, target, view);
+    perspective(verticalFov, aspect, nearPlane, farPlane, projection);
+    multiply(projection, view, result);
+}
+
+/// <summary>
+/// Pixels covered by one unit of object space seen from a distance of one unit, divide by the distance for the size
+/// on screen.
+/// </summary>
+float Camera::getProjectionScale(float viewportHeight) const
+{
+    return viewportHeight / (2.0f * std::tan(verticalFov * 0.5f));
+}
+
+/// <summary>
+/// A camera above the near edge of the bounds looking across them to the far edge, so part of the scene is behind
+/// the camera or outside the field of view and the rest spans a wide range of distances.
+/// </summary>
+Camera Camera::lookAcross(const MeshBounds& bounds)
+{
+    const float depth = bounds.maximum[2] - bounds.minimum[2];
+
+    Camera camera = {};
+    camera.position[0] = bounds.center[0];
+    camera.position[1] = bounds.maximum[1] + 0.1f * depth;
+    camera.position[2] = bounds.minimum[2] + 0.3f * depth;
+    camera.target[0] = bounds.center[0];
+    camera.target[1] = bounds.center[1];
+    camera.target[2] = bounds.maximum[2];
+    camera.farPlane = std::max(4.0f * bounds.radius, 1.0f);
+
+    return camera;
+}
+
+/// <summary>
+/// Left, right, bottom, top and far plane from the rows of the view projection matrix, pointing inwards and not
+/// normalized. The near plane is left out, spheres behind the camera are already outside the side planes.
+/// </summary>
+void Camera::getFrustumPlanes(const float viewProjection[16], float planes[5][4])
+{
+    for(int component = 0; component < 4; ++component)
+    {
+        const float row0 = viewProjection[component * 4 + 0];
+        const float row1 = viewProjection[component * 4 + 1];
+        const float row2 = viewProjection[component * 4 + 2];
+        const float row3 = viewProjection[component * 4 + 3];
+
+        planes[0][component] = row3 + row0;
+        planes[1][component] = row3 - row0;
+        planes[2][component] = row3 + row1;
+        planes[3][component] = row3 - row1;
+        planes[4][component] = row3 - row2;
+    }
+}
+
+bool Camera::isSphereVisible(const float planes[5][4], const float center[3], float radius)
+{
+    for(int i = 0; i < 5; ++i)
+    {
+        const float* plane = planes[i];
+        const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if(plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3] < -radius * length)
+        {
+            return false;
+        }
+    }
+    return true;
+}
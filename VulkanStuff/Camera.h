@@ -0,0 +1,24 @@
+#pragma once
+#include "AssetDecoder.h"
+
+/// <summary>
+/// Perspective camera of the benchmark scenes, producing column major matrices as GLSL expects them.
+///
+/// The world is right handed and the camera looks along -z of its view space. The projection maps depth to 0..1 and
+/// flips y for Vulkan's framebuffer coordinates, so triangles counter clockwise in the world stay counter clockwise.
+/// </summary>
+struct Camera
+{
+    float                               position[3]                 = {};
+    float                               target[3]                   = { 0.0f, 0.0f, -1.0f };
+    float                               verticalFov                 = 1.0f;     // radians
+    float                               nearPlane                   = 0.1f;
+    float                               farPlane                    = 1000.0f;
+
+    void                                getViewProjection(float aspect, float result[16])                                       const;
+    float                               getProjectionScale(float viewportHeight)                                                const;
+
+    static Camera                       lookAcross(const MeshBounds& bounds);
+    static void                         getFrustumPlanes(const float viewProjection[16], float planes[5][4]);
+    static bool                         isSphereVisible(const float planes[5][4], const float center[3], float radius);
+};
@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "Debug.h"
+#include "DebugMessageSink.h"
 
 static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
     VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
@@ -7,7 +8,15 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
     const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
     void* pUserData)
 {
-    std::cerr << "Validation Layer: " << pCallbackData->pMessage << std::endl;
+    // Messages are handed over to the sink without blocking the calling thread on console output.
+    if(pUserData != nullptr)
+    {
+        static_cast<DebugMessageSink*>(pUserData)->push(messageSeverity, messageType, pCallbackData);
+    }
+    else
+    {
+        std::cerr << "Validation Layer: " << pCallbackData->pMessage << "\n";
+    }
 
     return VK_FALSE;
 }
@@ -34,16 +43,20 @@ void destroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT
     }
 }
 
-void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo)
+void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo, DebugMessageSink* debugMessageSink)
 {
+    const VkDebugUtilsMessageSeverityFlagsEXT messageSeverity = debugMessageSink != nullptr
+        ? debugMessageSink->getSubscribedSeverities()
+        : VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+
     createInfo =
     {
         VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT,
         nullptr,
         NULL,
-        VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT,
+        messageSeverity,
         VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT,
         debugCallback,
-        nullptr
+        debugMessageSink
     };
 }
\ No newline at end of file
@@ -0,0 +1,294 @@
+#include "pch.h"
+#include "DebugMessageSink.h"
+
+static const char* getSeverityName(VkDebugUtilsMessageSeverityFlagBitsEXT severity)
+{
+    switch(severity)
+    {
+    case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT:   return "VERBOSE";
+    case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT:      return "INFO";
+    case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:   return "WARNING";
+    case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:     return "ERROR";
+    default:                                                return "UNKNOWN";
+    }
+}
+
+static const char* getTypeName(VkDebugUtilsMessageTypeFlagsEXT type)
+{
+    if(type & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT)
+    {
+        return "PERFORMANCE";
+    }
+
+    if(type & VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT)
+    {
+        return "VALIDATION";
+    }
+
+    return "GENERAL";
+}
+
+DebugMessageSink::DebugMessageSink(VkDebugUtilsMessageSeverityFlagBitsEXT minimumSeverity, uint32_t messagesPerSecondPerId)
+    : ring(new Slot[RING_CAPACITY])
+    , subscribedMinimumSeverity(minimumSeverity)
+    , minimumSeverity(minimumSeverity)
+    , messagesPerSecondPerId(messagesPerSecondPerId)
+{
+    static_assert((RING_CAPACITY & (RING_CAPACITY - 1)) == 0, "Ring capacity has to be a power of two");
+
+    for(size_t i = 0; i < RING_CAPACITY; ++i)
+    {
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    drainThread = std::thread(&DebugMessageSink::drain, this);
+}
+
+DebugMessageSink::~DebugMessageSink()
+{
+    stop();
+}
+
+/// <summary>
+/// Called from the debug callback on any thread. Claims a slot with a CAS on the enqueue position and publishes the
+/// message by advancing the slot sequence, the consumer never blocks producers. Messages are truncated to fit the slot.
+/// </summary>
+void DebugMessageSink::push(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type, const VkDebugUtilsMessengerCallbackDataEXT* callbackData)
+{
+    if(static_cast<uint32_t>(severity) < minimumSeverity.load(std::memory_order_relaxed))
+    {
+        filteredMessages.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint64_t position = enqueuePosition.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+
+    while(true)
+    {
+        slot = &ring[position & (RING_CAPACITY - 1)];
+        const uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+
+        if(difference == 0)
+        {
+            if(enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if(difference < 0)
+        {
+            droppedMessages.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    Message& message = slot->message;
+    message.severity = severity;
+    message.type = type;
+    message.messageIdNumber = callbackData->messageIdNumber;
+
+    const char* messageIdName = callbackData->pMessageIdName != nullptr ? callbackData->pMessageIdName : "";
+    std::strncpy(message.messageIdName, messageIdName, MAX_MESSAGE_ID_LENGTH - 1);
+    message.messageIdName[MAX_MESSAGE_ID_LENGTH - 1] = '\0';
+
+    const char* text = callbackData->pMessage != nullptr ? callbackData->pMessage : "";
+    std::strncpy(message.text, text, MAX_MESSAGE_LENGTH - 1);
+    message.text[MAX_MESSAGE_LENGTH - 1] = '\0';
+
+    slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+bool DebugMessageSink::pop(Message& message)
+{
+    Slot& slot = ring[dequeuePosition & (RING_CAPACITY - 1)];
+
+    if(slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1)
+    {
+        return false;
+    }
+
+    message = slot.message;
+    slot.sequence.store(dequeuePosition + RING_CAPACITY, std::memory_order_release);
+    ++dequeuePosition;
+
+    return true;
+}
+
+void DebugMessageSink::drain()
+{
+    Message message;
+    std::ostringstream output;
+
+    while(true)
+    {
+        // Read the flag before draining, so messages pushed before stop() are never lost.
+        const bool keepRunning = running.load(std::memory_order_acquire);
+
+        while(pop(message))
+        {
+            process(message, output);
+        }
+
+        if(output.tellp() > 0)
+        {
+            std::cerr << output.str() << std::flush;
+            output.str({});
+        }
+
+        if(!keepRunning)
+        {
+            break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+/// <summary>
+/// Updates the counters of the message id and writes the message unless it is an exact repeat of the last message
+/// with the same id or the id already emitted messagesPerSecondPerId messages in the current one second window.
+/// PERFORMANCE messages are written as structured key=value warnings so they can be collected by tooling.
+/// </summary>
+void DebugMessageSink::process(const Message& message, std::ostream& stream)
+{
+    const auto now = std::chrono::steady_clock::now();
+    const size_t textHash = std::hash<std::string_view>{}(std::string_view(message.text));
+
+    std::lock_guard<std::mutex> lock(statisticsMutex);
+
+    MessageIdStatistics& idStatistics = statistics[message.messageIdNumber];
+    if(idStatistics.count == 0)
+    {
+        idStatistics.messageIdName = message.messageIdName;
+        idStatistics.severity = message.severity;
+        idStatistics.type = message.type;
+    }
+
+    ++idStatistics.count;
+
+    if(now - idStatistics.windowStart >= std::chrono::seconds(1))
+    {
+        if(idStatistics.windowSuppressed > 0)
+        {
+            stream << "Validation Layer: [" << idStatistics.messageIdName << "] suppressed "
+                   << idStatistics.windowSuppressed << " repeated messages\n";
+        }
+
+        idStatistics.windowStart = now;
+        idStatistics.windowCount = 0;
+        idStatistics.windowSuppressed = 0;
+    }
+
+    if(idStatistics.count > 1 && textHash == idStatistics.lastTextHash)
+    {
+        ++idStatistics.duplicates;
+        ++idStatistics.windowSuppressed;
+        return;
+    }
+
+    if(idStatistics.windowCount >= messagesPerSecondPerId)
+    {
+        ++idStatistics.rateLimited;
+        ++idStatistics.windowSuppressed;
+        return;
+    }
+
+    ++idStatistics.windowCount;
+    idStatistics.lastTextHash = textHash;
+
+    if(message.type & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT)
+    {
+        stream << "PerformanceWarning:"
+               << " severity=" << getSeverityName(message.severity)
+               << " id=" << message.messageIdName
+               << " number=0x" << std::hex << static_cast<uint32_t>(message.messageIdNumber) << std::dec
+               << " count=" << idStatistics.count
+               << " message=\"" << message.text << "\"\n";
+    }
+    else
+    {
+        stream << "Validation Layer: " << message.text << "\n";
+    }
+}
+
+/// <summary>
+/// Stops the drain thread after it wrote out every message pushed so far.
+/// </summary>
+void DebugMessageSink::stop()
+{
+    if(!drainThread.joinable())
+    {
+        return;
+    }
+
+    running.store(false, std::memory_order_release);
+    drainThread.join();
+}
+
+void DebugMessageSink::setMinimumSeverity(VkDebugUtilsMessageSeverityFlagBitsEXT severity)
+{
+    minimumSeverity.store(static_cast<uint32_t>(severity), std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Severity bits are ordered, so every severity from the minimum one up to ERROR is subscribed.
+/// </summary>
+VkDebugUtilsMessageSeverityFlagsEXT DebugMessageSink::getSubscribedSeverities() const
+{
+    const VkDebugUtilsMessageSeverityFlagBitsEXT allSeverities[] =
+    {
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT,
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT,
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT,
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT
+    };
+
+    VkDebugUtilsMessageSeverityFlagsEXT severities = 0;
+    for(const auto severity : allSeverities)
+    {
+        if(severity >= subscribedMinimumSeverity)
+        {
+            severities |= severity;
+        }
+    }
+
+    return severities;
+}
+
+void DebugMessageSink::printStatistics(std::ostream& stream) const
+{
+    std::lock_guard<std::mutex> lock(statisticsMutex);
+
+    stream << "DebugMessageSink: " << statistics.size() << " message ids, "
+           << filteredMessages.load() << " filtered by severity, "
+           << droppedMessages.load() << " dropped on full ring\n";
+
+    std::vector<std::pair<int32_t, const MessageIdStatistics*>> sortedStatistics;
+    for(const auto& entry : statistics)
+    {
+        sortedStatistics.emplace_back(entry.first, &entry.second);
+    }
+
+    std::sort(sortedStatistics.begin(), sortedStatistics.end(), [](const auto& a, const auto& b)
+    {
+        return a.second->count > b.second->count;
+    });
+
+    for(const auto& entry : sortedStatistics)
+    {
+        const MessageIdStatistics& idStatistics = *entry.second;
+
+        stream << "    " << std::left << std::setw(8) << getSeverityName(idStatistics.severity)
+               << std::setw(12) << getTypeName(idStatistics.type) << std::right
+               << " count " << std::setw(6) << idStatistics.count
+               << " duplicates " << std::setw(6) << idStatistics.duplicates
+               << " rate limited " << std::setw(6) << idStatistics.rateLimited
+               << "  " << idStatistics.messageIdName << "\n";
+    }
+}
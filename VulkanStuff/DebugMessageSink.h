@@ -0,0 +1,87 @@
+#pragma once
+
+/// <summary>
+/// Asynchronous sink for debug utils messages.
+///
+/// The debug callback runs on whatever thread made the Vulkan call, so it must not block on console I/O.
+/// Messages are copied into a bounded lock-free multi-producer/single-consumer ring and written out by a
+/// background thread, which also deduplicates and rate-limits messages per message id and keeps counters.
+/// When the ring is full new messages are dropped and counted instead of stalling the producer.
+/// </summary>
+class DebugMessageSink
+{
+public:
+    static constexpr size_t             RING_CAPACITY               = 256;
+    static constexpr size_t             MAX_MESSAGE_LENGTH          = 2048;
+    static constexpr size_t             MAX_MESSAGE_ID_LENGTH       = 64;
+
+                                        DebugMessageSink(VkDebugUtilsMessageSeverityFlagBitsEXT minimumSeverity, uint32_t messagesPerSecondPerId);
+                                        ~DebugMessageSink();
+
+                                        DebugMessageSink(const DebugMessageSink&) = delete;
+    DebugMessageSink&                   operator=(const DebugMessageSink&) = delete;
+
+    void                                push(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type, const VkDebugUtilsMessengerCallbackDataEXT* callbackData);
+    void                                stop();
+
+    // Severities below the minimum are dropped in the callback. Only severities subscribed when the messenger
+    // was created can be reported, so lowering the minimum below the initial value has no effect.
+    void                                setMinimumSeverity(VkDebugUtilsMessageSeverityFlagBitsEXT severity);
+    VkDebugUtilsMessageSeverityFlagsEXT getSubscribedSeverities()                                                               const;
+
+    void                                printStatistics(std::ostream& stream)                                                   const;
+
+private:
+    struct Message
+    {
+        VkDebugUtilsMessageSeverityFlagBitsEXT  severity;
+        VkDebugUtilsMessageTypeFlagsEXT         type;
+        int32_t                                 messageIdNumber;
+        char                                    messageIdName[MAX_MESSAGE_ID_LENGTH];
+        char                                    text[MAX_MESSAGE_LENGTH];
+    };
+
+    struct Slot
+    {
+        std::atomic<uint64_t>                   sequence;
+        Message                                 message;
+    };
+
+    struct MessageIdStatistics
+    {
+        std::string                             messageIdName           = {};
+        VkDebugUtilsMessageSeverityFlagBitsEXT  severity                = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT;
+        VkDebugUtilsMessageTypeFlagsEXT         type                    = 0;
+        uint64_t                                count                   = 0;
+        uint64_t                                duplicates              = 0;
+        uint64_t                                rateLimited             = 0;
+
+        std::chrono::steady_clock::time_point   windowStart             = {};
+        uint32_t                                windowCount             = 0;
+        uint64_t                                windowSuppressed        = 0;
+        size_t                                  lastTextHash            = 0;
+    };
+
+    //Ring
+    std::unique_ptr<Slot[]>             ring;
+    alignas(64) std::atomic<uint64_t>   enqueuePosition             = 0;
+    alignas(64) uint64_t                dequeuePosition             = 0;
+    std::atomic<uint64_t>               droppedMessages             = 0;
+    std::atomic<uint64_t>               filteredMessages            = 0;
+
+    //Filtering
+    const VkDebugUtilsMessageSeverityFlagBitsEXT subscribedMinimumSeverity;
+    std::atomic<uint32_t>               minimumSeverity;
+    const uint32_t                      messagesPerSecondPerId;
+
+    //Drain Thread
+    std::thread                         drainThread;
+    std::atomic<bool>                   running                     = true;
+
+    mutable std::mutex                  statisticsMutex;
+    std::unordered_map<int32_t, MessageIdStatistics> statistics;
+
+    bool                                pop(Message& message);
+    void                                drain();
+    void                                process(const Message& message, std::ostream& stream);
+};
@@ -0,0 +1,63 @@
+#include "pch.h"
+#include "DeletionQueue.h"
+
+DeletionQueue::~DeletionQueue()
+{
+    flush();
+}
+
+void DeletionQueue::pushFunction(uint64_t retireValue, std::function<void()> function)
+{
+    push(retireValue, std::unique_ptr<Entry>(new FunctionEntry(std::move(function))));
+}
+
+/// <summary>
+/// Entries are kept sorted by retire value. Values only grow in practice, so insertion is an append.
+/// </summary>
+void DeletionQueue::push(uint64_t retireValue, std::unique_ptr<Entry> entry)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto position = entries.end();
+    while(position != entries.begin() && std::prev(position)->first > retireValue)
+    {
+        --position;
+    }
+
+    entries.emplace(position, retireValue, std::move(entry));
+}
+
+/// <summary>
+/// Destroys every object retired at or before completedValue and returns how many were destroyed.
+/// Objects are destroyed outside of the lock, so their destructors may push new entries.
+/// </summary>
+size_t DeletionQueue::collect(uint64_t completedValue)
+{
+    std::vector<std::unique_ptr<Entry>> retired;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        while(!entries.empty() && entries.front().first <= completedValue)
+        {
+            retired.push_back(std::move(entries.front().second));
+            entries.pop_front();
+        }
+    }
+
+    return retired.size();
+}
+
+/// <summary>
+/// Destroys every queued object. Only valid once the device is idle.
+/// </summary>
+size_t DeletionQueue::flush()
+{
+    return collect(std::numeric_limits<uint64_t>::max());
+}
+
+size_t DeletionQueue::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+/// <summary>
+/// Defers destruction of Vulkan objects until the GPU no longer uses them.
+///
+/// Objects are pushed together with a retire value, the number of the last submitted frame which may still
+/// reference them. collect() destroys every object whose retire value is not greater than the number of the
+/// last frame the GPU completed, so replacing resources at run time never needs vkDeviceWaitIdle.
+/// Entries own the pushed objects, any move-only RAII wrapper (like UniqueHandle) can be queued.
+/// </summary>
+class DeletionQueue
+{
+public:
+                                        DeletionQueue() = default;
+                                        ~DeletionQueue();
+
+                                        DeletionQueue(const DeletionQueue&) = delete;
+    DeletionQueue&                      operator=(const DeletionQueue&) = delete;
+
+    template<typename Object>
+    void                                push(uint64_t retireValue, Object&& object)
+    {
+        push(retireValue, std::unique_ptr<Entry>(new ObjectEntry<std::decay_t<Object>>(std::forward<Object>(object))));
+    }
+
+    void                                pushFunction(uint64_t retireValue, std::function<void()> function);
+
+    size_t                              collect(uint64_t completedValue);
+    size_t                              flush();
+    size_t                              size()                                                                                  const;
+
+private:
+    struct Entry
+    {
+        virtual                         ~Entry() = default;
+    };
+
+    template<typename Object>
+    struct ObjectEntry : Entry
+    {
+        explicit ObjectEntry(Object&& object) : object(std::move(object)) {}
+        Object                          object;
+    };
+
+    struct FunctionEntry : Entry
+    {
+        explicit FunctionEntry(std::function<void()> function) : function(std::move(function)) {}
+        ~FunctionEntry() override { function(); }
+        std::function<void()>           function;
+    };
+
+    mutable std::mutex                  mutex;
+    std::deque<std::pair<uint64_t, std::unique_ptr<Entry>>> entries;
+
+    void                                push(uint64_t retireValue, std::unique_ptr<Entry> entry);
+};
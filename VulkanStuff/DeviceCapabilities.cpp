@@ -0,0 +1,283 @@
+#include "pch.h"
+#include "DeviceCapabilities.h"
+
+/// <summary>
+/// Queries properties, features, memory properties, queue families, extensions and surface support of a physical device.
+/// Vulkan 1.1/1.2 structures are only chained when the device reports the matching API version.
+/// </summary>
+PhysicalDeviceCapabilities PhysicalDeviceCapabilities::query(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface)
+{
+    const auto queryStart = std::chrono::steady_clock::now();
+
+    PhysicalDeviceCapabilities capabilities = {};
+    capabilities.vkPhysicalDevice = physicalDevice;
+
+    //Properties
+    vkGetPhysicalDeviceProperties(physicalDevice, &capabilities.properties);
+
+    const uint32_t apiVersion = capabilities.properties.apiVersion;
+
+    capabilities.subgroupProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+    capabilities.idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+    VkPhysicalDeviceProperties2 properties2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, nullptr, {} };
+    if(apiVersion >= VK_API_VERSION_1_1)
+    {
+        capabilities.subgroupProperties.pNext = &capabilities.idProperties;
+        properties2.pNext = &capabilities.subgroupProperties;
+        vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+    }
+    capabilities.subgroupProperties.pNext = nullptr;
+    capabilities.idProperties.pNext = nullptr;
+
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &capabilities.memoryProperties);
+
+    //Features
+    capabilities.features11.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
+    capabilities.features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+    if(apiVersion >= VK_API_VERSION_1_2)
+    {
+        capabilities.features11.pNext = &capabilities.features12;
+
+        VkPhysicalDeviceFeatures2 features2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &capabilities.features11, {} };
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+
+        capabilities.features = features2.features;
+    }
+    else
+    {
+        vkGetPhysicalDeviceFeatures(physicalDevice, &capabilities.features);
+    }
+    capabilities.features11.pNext = nullptr;
+    capabilities.features12.pNext = nullptr;
+
+    //Queues
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    capabilities.queueFamilies.resize(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, capabilities.queueFamilies.data());
+
+    capabilities.queueFamilyPresentSupport.resize(queueFamilyCount, VK_FALSE);
+    if(surface != VK_NULL_HANDLE)
+    {
+        for(uint32_t i = 0; i < queueFamilyCount; ++i)
+        {
+            vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &capabilities.queueFamilyPresentSupport[i]);
+        }
+    }
+
+    // Prefer a single family supporting both graphics and presentation, fall back to the first family of each kind.
+    for(uint32_t i = 0; i < queueFamilyCount; ++i)
+    {
+        if((capabilities.queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) && capabilities.queueFamilyPresentSupport[i])
+        {
+            capabilities.queueFamilyIndices.graphicsFamily = i;
+            capabilities.queueFamilyIndices.presentFamily = i;
+            break;
+        }
+    }
+
+    for(uint32_t i = 0; i < queueFamilyCount && !capabilities.queueFamilyIndices.IsComplete(); ++i)
+    {
+        if(!capabilities.queueFamilyIndices.graphicsFamily.has_value() && (capabilities.queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+        {
+            capabilities.queueFamilyIndices.graphicsFamily = i;
+        }
+
+        if(!capabilities.queueFamilyIndices.presentFamily.has_value() && capabilities.queueFamilyPresentSupport[i])
+        {
+            capabilities.queueFamilyIndices.presentFamily = i;
+        }
+    }
+
+    // Compute-only work prefers a family without graphics and copies a family with transfers only, usually backed
+    // by the DMA engines. Every compute family also supports transfers and stands in when there is none.
+    std::optional<uint32_t> anyComputeFamily;
+    for(uint32_t i = 0; i < queueFamilyCount; ++i)
+    {
+        const VkQueueFlags flags = capabilities.queueFamilies[i].queueFlags;
+
+        if((flags & VK_QUEUE_COMPUTE_BIT) && !anyComputeFamily.has_value())
+        {
+            anyComputeFamily = i;
+        }
+        if((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT) && !capabilities.queueFamilyIndices.computeFamily.has_value())
+        {
+            capabilities.queueFamilyIndices.computeFamily = i;
+        }
+        if((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) && !capabilities.queueFamilyIndices.transferFamily.has_value())
+        {
+            capabilities.queueFamilyIndices.transferFamily = i;
+        }
+    }
+    if(!capabilities.queueFamilyIndices.computeFamily.has_value())
+    {
+        capabilities.queueFamilyIndices.computeFamily = anyComputeFamily;
+    }
+    if(!capabilities.queueFamilyIndices.transferFamily.has_value())
+    {
+        capabilities.queueFamilyIndices.transferFamily = capabilities.queueFamilyIndices.computeFamily;
+    }
+
+    //Extensions
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+    capabilities.extensions.reserve(extensionCount);
+    for(const auto& availableExtension : availableExtensions)
+    {
+        capabilities.extensions.insert(availableExtension.extensionName);
+    }
+
+    // Present id and wait features are only chained when the device has the extensions, unknown structures are not allowed.
+    capabilities.presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    capabilities.presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+
+    if(apiVersion >= VK_API_VERSION_1_1 && capabilities.hasExtension(VK_KHR_PRESENT_ID_EXTENSION_NAME)
+                                        && capabilities.hasExtension(VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+    {
+        capabilities.presentIdFeatures.pNext = &capabilities.presentWaitFeatures;
+
+        VkPhysicalDeviceFeatures2 features2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &capabilities.presentIdFeatures, {} };
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+    }
+    capabilities.presentIdFeatures.pNext = nullptr;
+    capabilities.presentWaitFeatures.pNext = nullptr;
+
+    // Mesh shaders need SPIR-V 1.4, which is core in Vulkan 1.2.
+    capabilities.meshShaderFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
+
+    if(apiVersion >= VK_API_VERSION_1_2 && capabilities.hasExtension(VK_EXT_MESH_SHADER_EXTENSION_NAME))
+    {
+        VkPhysicalDeviceFeatures2 features2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &capabilities.meshShaderFeatures, {} };
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+    }
+    capabilities.meshShaderFeatures.pNext = nullptr;
+
+    // Synchronization2 is core in Vulkan 1.3, a Vulkan 1.2 device offers it as an extension.
+    capabilities.synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+
+    if(apiVersion >= VK_API_VERSION_1_1 && capabilities.hasExtension(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME))
+    {
+        VkPhysicalDeviceFeatures2 features2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &capabilities.synchronization2Features, {} };
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+    }
+    capabilities.synchronization2Features.pNext = nullptr;
+
+    //Surface
+    if(surface != VK_NULL_HANDLE && capabilities.hasExtension(VK_KHR_SWAPCHAIN_EXTENSION_NAME))
+    {
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &capabilities.surfaceCapabilities);
+
+        uint32_t formatCount = 0;
+        vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, nullptr);
+        capabilities.surfaceFormats.resize(formatCount);
+        vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, capabilities.surfaceFormats.data());
+
+        uint32_t presentModeCount = 0;
+        vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &presentModeCount, nullptr);
+        capabilities.surfacePresentModes.resize(presentModeCount);
+        vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &presentModeCount, capabilities.surfacePresentModes.data());
+    }
+
+    capabilities.queryTime = std::chrono::steady_clock::now() - queryStart;
+
+    return capabilities;
+}
+
+bool PhysicalDeviceCapabilities::hasExtension(const char* extensionName) const
+{
+    return extensions.find(extensionName) != extensions.end();
+}
+
+bool PhysicalDeviceCapabilities::supportsPresentation(uint32_t queueFamilyIndex) const
+{
+    return queueFamilyIndex < queueFamilyPresentSupport.size() && queueFamilyPresentSupport[queueFamilyIndex] == VK_TRUE;
+}
+
+/// <summary>
+/// VkPhysicalDeviceFeatures consists only of VkBool32 members, so the required and supported
+/// features can be compared member by member.
+/// </summary>
+bool PhysicalDeviceCapabilities::hasFeatures(const VkPhysicalDeviceFeatures& requiredFeatures) const
+{
+    constexpr size_t featureCount = sizeof(VkPhysicalDeviceFeatures) / sizeof(VkBool32);
+
+    const VkBool32* required = reinterpret_cast<const VkBool32*>(&requiredFeatures);
+    const VkBool32* supported = reinterpret_cast<const VkBool32*>(&features);
+
+    for(size_t i = 0; i < featureCount; ++i)
+    {
+        if(required[i] && !supported[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool PhysicalDeviceCapabilities::hasDedicatedQueueFamily(VkQueueFlags flags, VkQueueFlags excludedFlags) const
+{
+    for(const auto& queueFamily : queueFamilies)
+    {
+        if((queueFamily.queueFlags & flags) == flags && (queueFamily.queueFlags & excludedFlags) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// <summary>
+/// Returns the size of the largest device local heap. On integrated GPUs and software drivers this is system memory.
+/// </summary>
+VkDeviceSize PhysicalDeviceCapabilities::getDeviceLocalMemorySize() const
+{
+    VkDeviceSize deviceLocalSize = 0;
+
+    for(uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i)
+    {
+        if(memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+        {
+            deviceLocalSize = std::max(deviceLocalSize, memoryProperties.memoryHeaps[i].size);
+        }
+    }
+
+    return deviceLocalSize;
+}
+
+/// <summary>
+/// Returns the first memory type allowed by memoryTypeBits which has all required flags, preferring types which also
+/// have all preferred flags.
+/// </summary>
+std::optional<uint32_t> PhysicalDeviceCapabilities::findMemoryType(uint32_t memoryTypeBits, VkMemoryPropertyFlags requiredFlags, VkMemoryPropertyFlags preferredFlags) const
+{
+    std::optional<uint32_t> memoryType;
+
+    for(uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+    {
+        const VkMemoryPropertyFlags flags = memoryProperties.memoryTypes[i].propertyFlags;
+
+        if(!(memoryTypeBits & (1u << i)) || (flags & requiredFlags) != requiredFlags)
+        {
+            continue;
+        }
+
+        if((flags & preferredFlags) == preferredFlags)
+        {
+            return i;
+        }
+
+        if(!memoryType.has_value())
+        {
+            memoryType = i;
+        }
+    }
+
+    return memoryType;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+struct QueueFamilyIndices
+{
+    std::optional<uint32_t>         graphicsFamily;
+    std::optional<uint32_t>         presentFamily;
+    std::optional<uint32_t>         computeFamily;      // preferably without graphics
+    std::optional<uint32_t>         transferFamily;     // preferably transfer only, else the compute family
+
+    const bool IsComplete() const
+    {
+        return (graphicsFamily.has_value() && presentFamily.has_value());
+    }
+};
+
+/// <summary>
+/// Snapshot of everything the application needs to know about a physical device.
+///
+/// Capabilities are queried from the driver exactly once per physical device, every later decision
+/// (scoring, requirement checks, logical device and swapchain creation) reads from the snapshot.
+/// The structures filled through pNext chains are stored as separate members and their pNext pointers
+/// are cleared after the query, so the snapshot can be freely copied and moved.
+/// </summary>
+struct PhysicalDeviceCapabilities
+{
+    VkPhysicalDevice                            vkPhysicalDevice            = VK_NULL_HANDLE;
+
+    //Properties
+    VkPhysicalDeviceProperties                  properties                  = {};
+    VkPhysicalDeviceSubgroupProperties          subgroupProperties          = {};
+    VkPhysicalDeviceIDProperties                idProperties                = {};
+    VkPhysicalDeviceMemoryProperties            memoryProperties            = {};
+
+    //Features
+    VkPhysicalDeviceFeatures                    features                    = {};
+    VkPhysicalDeviceVulkan11Features            features11                  = {};
+    VkPhysicalDeviceVulkan12Features            features12                  = {};
+    VkPhysicalDevicePresentIdFeaturesKHR        presentIdFeatures           = {};
+    VkPhysicalDevicePresentWaitFeaturesKHR      presentWaitFeatures         = {};
+    VkPhysicalDeviceMeshShaderFeaturesEXT       meshShaderFeatures          = {};
+    VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features    = {};
+
+    //Queues
+    std::vector<VkQueueFamilyProperties>        queueFamilies               = {};
+    std::vector<VkBool32>                       queueFamilyPresentSupport   = {};
+    QueueFamilyIndices                          queueFamilyIndices          = {};
+
+    //Extensions
+    std::unordered_set<std::string>             extensions                  = {};
+
+    //Surface
+    VkSurfaceCapabilitiesKHR                    surfaceCapabilities         = {};
+    std::vector<VkSurfaceFormatKHR>             surfaceFormats              = {};
+    std::vector<VkPresentModeKHR>               surfacePresentModes         = {};
+
+    //Query cost
+    std::chrono::duration<double, std::milli>   queryTime                   = {};
+
+    static PhysicalDeviceCapabilities           query(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface);
+
+    bool                                        hasExtension(const char* extensionName)                             const;
+    bool                                        hasFeatures(const VkPhysicalDeviceFeatures& requiredFeatures)       const;
+    bool                                        hasDedicatedQueueFamily(VkQueueFlags flags, VkQueueFlags excludedFlags) const;
+    VkDeviceSize                                getDeviceLocalMemorySize()                                          const;
+    std::optional<uint32_t>                     findMemoryType(uint32_t memoryTypeBits, VkMemoryPropertyFlags requiredFlags,
+                                                               VkMemoryPropertyFlags preferredFlags = 0)            const;
+    bool                                        supportsPresentation(uint32_t queueFamilyIndex)                     const;
+};
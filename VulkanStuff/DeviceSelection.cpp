@@ -0,0 +1,207 @@
+#include "pch.h"
+#include "DeviceSelection.h"
+
+static const char* getPolicyName(DeviceSelectionPolicy policy)
+{
+    switch(policy)
+    {
+    case DeviceSelectionPolicy::MaxPerformance: return "max-performance";
+    case DeviceSelectionPolicy::LowPower:       return "low-power";
+    case DeviceSelectionPolicy::ByName:         return "name";
+    case DeviceSelectionPolicy::ByUUID:         return "uuid";
+    }
+
+    return "unknown";
+}
+
+static const char* getDeviceTypeName(VkPhysicalDeviceType deviceType)
+{
+    switch(deviceType)
+    {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:      return "discrete";
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:    return "integrated";
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:       return "virtual";
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:               return "cpu";
+    default:                                        return "other";
+    }
+}
+
+static std::string toLower(std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+DeviceSelector::DeviceSelector(DeviceSelectionPolicy policy, std::string selector)
+    : policy(policy)
+    , selector(std::move(selector))
+{
+}
+
+std::string DeviceSelector::uuidToString(const uint8_t (&uuid)[VK_UUID_SIZE])
+{
+    static const char hexDigits[] = "0123456789abcdef";
+
+    std::string text;
+    text.reserve(VK_UUID_SIZE * 2);
+    for(uint8_t byte : uuid)
+    {
+        text.push_back(hexDigits[byte >> 4]);
+        text.push_back(hexDigits[byte & 0xF]);
+    }
+
+    return text;
+}
+
+bool DeviceSelector::matchesSelector(const PhysicalDeviceCapabilities& capabilities) const
+{
+    switch(policy)
+    {
+    case DeviceSelectionPolicy::ByName:
+        return toLower(capabilities.properties.deviceName).find(toLower(selector)) != std::string::npos;
+
+    case DeviceSelectionPolicy::ByUUID:
+    {
+        std::string requestedUUID = toLower(selector);
+        requestedUUID.erase(std::remove(requestedUUID.begin(), requestedUUID.end(), '-'), requestedUUID.end());
+        return uuidToString(capabilities.idProperties.deviceUUID) == requestedUUID;
+    }
+
+    default:
+        return true;
+    }
+}
+
+/// <summary>
+/// Scores are sums of weighted terms. The device type dominates, so the policy decides between discrete and
+/// integrated GPUs, the remaining terms order devices of the same type.
+/// </summary>
+uint64_t DeviceSelector::getScore(const PhysicalDeviceCapabilities& capabilities) const
+{
+    const VkPhysicalDeviceProperties& properties = capabilities.properties;
+    const bool lowPower = policy == DeviceSelectionPolicy::LowPower;
+
+    uint64_t score = 0;
+
+    //Device Type
+    switch(properties.deviceType)
+    {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:      score += lowPower ? 20000 : 100000; break;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:    score += lowPower ? 100000 : 50000; break;
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:       score += 30000; break;
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:               score += 10000; break;
+    default:                                        break;
+    }
+
+    //Device Local Memory - 100 points per GiB, capped at 64 GiB
+    const uint64_t deviceLocalGiB = std::min<uint64_t>(capabilities.getDeviceLocalMemorySize() >> 30, 64);
+    score += deviceLocalGiB * (lowPower ? 10 : 100);
+
+    //Dedicated Queues - allow asynchronous compute and transfers next to graphics work
+    if(capabilities.hasDedicatedQueueFamily(VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT))
+    {
+        score += 2000;
+    }
+
+    if(capabilities.hasDedicatedQueueFamily(VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))
+    {
+        score += 2000;
+    }
+
+    //Subgroup Size - wider subgroups process more invocations per instruction
+    score += std::min<uint64_t>(capabilities.subgroupProperties.subgroupSize, 128) * 10;
+
+    //Timestamps - required for GPU timing
+    if(properties.limits.timestampComputeAndGraphics)
+    {
+        score += 1000;
+    }
+
+    //Image Limits
+    score += properties.limits.maxImageDimension2D / 16;
+
+    return score;
+}
+
+std::vector<DeviceRating> DeviceSelector::rank(const std::vector<PhysicalDeviceCapabilities>& devices, const RequirementCheck& requirements) const
+{
+    std::vector<DeviceRating> ratings;
+    ratings.reserve(devices.size());
+
+    for(size_t i = 0; i < devices.size(); ++i)
+    {
+        DeviceRating rating = {};
+        rating.capabilities = &devices[i];
+        rating.enumerationIndex = i;
+        rating.score = getScore(devices[i]);
+        rating.suitable = requirements(devices[i], rating.rejectReason);
+
+        if(rating.suitable && !matchesSelector(devices[i]))
+        {
+            rating.suitable = false;
+            rating.rejectReason = std::string("does not match ") + getPolicyName(policy) + " '" + selector + "'";
+        }
+
+        ratings.push_back(std::move(rating));
+    }
+
+    std::sort(ratings.begin(), ratings.end(), [](const DeviceRating& a, const DeviceRating& b)
+    {
+        const VkPhysicalDeviceProperties& propertiesA = a.capabilities->properties;
+        const VkPhysicalDeviceProperties& propertiesB = b.capabilities->properties;
+
+        return std::make_tuple(!a.suitable, ~a.score, propertiesA.vendorID, propertiesA.deviceID, a.enumerationIndex)
+             < std::make_tuple(!b.suitable, ~b.score, propertiesB.vendorID, propertiesB.deviceID, b.enumerationIndex);
+    });
+
+    return ratings;
+}
+
+void DeviceSelector::printRanking(std::ostream& stream, const std::vector<DeviceRating>& ratings) const
+{
+    stream << "PhysicalDevice: Ranking with policy " << getPolicyName(policy);
+    if(!selector.empty())
+    {
+        stream << " '" << selector << "'";
+    }
+    stream << "\n";
+
+    stream << "    " << std::left
+           << std::setw(4)  << "#"
+           << std::setw(10) << "Score"
+           << std::setw(12) << "Type"
+           << std::setw(12) << "Local MiB"
+           << std::setw(9)  << "Compute"
+           << std::setw(10) << "Transfer"
+           << std::setw(10) << "Subgroup"
+           << std::setw(12) << "Timestamps"
+           << std::setw(34) << "UUID"
+           << "Name\n";
+
+    size_t position = 1;
+    for(const auto& rating : ratings)
+    {
+        const PhysicalDeviceCapabilities& capabilities = *rating.capabilities;
+
+        stream << "    "
+               << std::setw(4)  << (rating.suitable ? std::to_string(position++) : std::string("-"))
+               << std::setw(10) << rating.score
+               << std::setw(12) << getDeviceTypeName(capabilities.properties.deviceType)
+               << std::setw(12) << (capabilities.getDeviceLocalMemorySize() >> 20)
+               << std::setw(9)  << (capabilities.hasDedicatedQueueFamily(VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT) ? "yes" : "no")
+               << std::setw(10) << (capabilities.hasDedicatedQueueFamily(VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT) ? "yes" : "no")
+               << std::setw(10) << capabilities.subgroupProperties.subgroupSize
+               << std::setw(12) << (capabilities.properties.limits.timestampComputeAndGraphics ? "yes" : "no")
+               << std::setw(34) << uuidToString(capabilities.idProperties.deviceUUID)
+               << capabilities.properties.deviceName;
+
+        if(!rating.suitable)
+        {
+            stream << " (rejected: " << rating.rejectReason << ")";
+        }
+
+        stream << "\n";
+    }
+
+    stream << std::right;
+}
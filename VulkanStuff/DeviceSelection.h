@@ -0,0 +1,40 @@
+#pragma once
+#include "ApplicationSettings.h"
+#include "DeviceCapabilities.h"
+
+struct DeviceRating
+{
+    const PhysicalDeviceCapabilities*   capabilities                = nullptr;
+    size_t                              enumerationIndex            = 0;
+    bool                                suitable                    = false;
+    std::string                         rejectReason                = {};
+    uint64_t                            score                       = 0;
+};
+
+/// <summary>
+/// Ranks physical devices according to a selection policy.
+///
+/// Every device gets a score built from its type, device local memory, dedicated compute and transfer queues,
+/// subgroup size, timestamp support and image limits; the weight of each term depends on the policy.
+/// Devices which fail the application requirements or do not match the requested name/UUID are rejected.
+/// Ties are broken by vendor id, device id and enumeration order, so the result is deterministic.
+/// </summary>
+class DeviceSelector
+{
+public:
+    using RequirementCheck = std::function<bool(const PhysicalDeviceCapabilities& capabilities, std::string& rejectReason)>;
+
+                                        DeviceSelector(DeviceSelectionPolicy policy, std::string selector);
+
+    std::vector<DeviceRating>           rank(const std::vector<PhysicalDeviceCapabilities>& devices, const RequirementCheck& requirements) const;
+    void                                printRanking(std::ostream& stream, const std::vector<DeviceRating>& ratings)          const;
+
+    static std::string                  uuidToString(const uint8_t (&uuid)[VK_UUID_SIZE]);
+
+private:
+    DeviceSelectionPolicy               policy;
+    std::string                         selector;
+
+    uint64_t                            getScore(const PhysicalDeviceCapabilities& capabilities)                            const;
+    bool                                matchesSelector(const PhysicalDeviceCapabilities& capabilities)                     const;
+};
@@ -0,0 +1,493 @@
+#include "pch.h"
+#include "DrawQueue.h"
+
+static constexpr uint32_t DEPTH_SHIFT       = 0;
+static constexpr uint32_t MESH_SHIFT        = DEPTH_SHIFT + DrawQueue::DEPTH_BITS;
+static constexpr uint32_t MATERIAL_SHIFT    = MESH_SHIFT + DrawQueue::MESH_BITS;
+static constexpr uint32_t PIPELINE_SHIFT    = MATERIAL_SHIFT + DrawQueue::MATERIAL_BITS;
+static constexpr uint32_t PASS_SHIFT        = PIPELINE_SHIFT + DrawQueue::PIPELINE_BITS;
+
+static_assert(PASS_SHIFT + DrawQueue::PASS_BITS == 64, "DrawQueue: Key fields have to fill 64 bits!");
+
+static uint32_t getField(uint64_t key, uint32_t shift, uint32_t bits)
+{
+    return static_cast<uint32_t>((key >> shift) & ((uint64_t(1) << bits) - 1));
+}
+
+uint32_t DrawQueue::addPipeline(const Pipeline& pipeline)
+{
+    if(pipelines.size() >= (size_t(1) << PIPELINE_BITS))
+    {
+        throw std::runtime_error("DrawQueue: Too many pipelines for the sort key!");
+    }
+
+    pipelines.push_back(pipeline);
+    return static_cast<uint32_t>(pipelines.size() - 1);
+}
+
+uint32_t DrawQueue::addMaterial(VkDescriptorSet descriptorSet)
+{
+    if(materials.size() >= (size_t(1) << MATERIAL_BITS))
+    {
+        throw std::runtime_error("DrawQueue: Too many materials for the sort key!");
+    }
+
+    materials.push_back(descriptorSet);
+    return static_cast<uint32_t>(materials.size() - 1);
+}
+
+uint32_t DrawQueue::addMesh(const Mesh& mesh)
+{
+    if(meshes.size() >= (size_t(1) << MESH_BITS))
+    {
+        throw std::runtime_error("DrawQueue: Too many meshes for the sort key!");
+    }
+
+    meshes.push_back(mesh);
+    return static_cast<uint32_t>(meshes.size() - 1);
+}
+
+/// <summary>
+/// Builds a key from registered ids and a depth within [0, 1], which is clamped. Fields wider than their bits are
+/// cut, registration keeps the ids in range.
+/// </summary>
+uint64_t DrawQueue::makeKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+{
+    constexpr float DEPTH_SCALE = static_cast<float>((1u << DEPTH_BITS) - 1);
+    const uint64_t quantizedDepth = static_cast<uint64_t>(std::min(std::max(depth, 0.0f), 1.0f) * DEPTH_SCALE);
+
+    return (static_cast<uint64_t>(pass & ((1u << PASS_BITS) - 1)) << PASS_SHIFT)
+         | (static_cast<uint64_t>(pipeline & ((1u << PIPELINE_BITS) - 1)) << PIPELINE_SHIFT)
+         | (static_cast<uint64_t>(material & ((1u << MATERIAL_BITS) - 1)) << MATERIAL_SHIFT)
+         | (static_cast<uint64_t>(mesh & ((1u << MESH_BITS) - 1)) << MESH_SHIFT)
+         | (quantizedDepth << DEPTH_SHIFT);
+}
+
+/// <summary>
+/// Starts the packets of a new frame. The arrays keep their capacity, a steady frame allocates nothing.
+/// </summary>
+void DrawQueue::clear()
+{
+    keys.clear();
+    packets.clear();
+    order.clear();
+    counts = {};
+    submissionOrderCounts = {};
+    sortTime = 0.0;
+    sorted = false;
+}
+
+void DrawQueue::submit(uint64_t key, const Packet& packet)
+{
+    keys.push_back(key);
+    packets.push_back(packet);
+}
+
+/// <summary>
+/// Sorts the packets of the frame by key, counting the binds of the submission order first. With a job system, every
+/// step of the sort is split into one range of packets per worker, frames too small to split sort on the calling
+/// thread.
+/// </summary>
+void DrawQueue::sort(JobSystem* jobSystem)
+{
+    submissionOrderCounts = countBinds();
+
+    const auto start = std::chrono::steady_clock::now();
+
+    const size_t count = keys.size();
+    sortValues.resize(count);
+    order.resize(count);
+
+    uint64_t varying = 0;
+    for(const uint64_t key : keys)
+    {
+        varying |= key ^ keys.front();
+    }
+
+    // Runs of differing bits, packed from bit 0 upwards in their order
+    runs.clear();
+    uint32_t keyBits = 0;
+    for(uint32_t bit = 0; bit < 64;)
+    {
+        if(((varying >> bit) & 1) == 0)
+        {
+            ++bit;
+            continue;
+        }
+
+        BitRun run = {};
+        run.shift = bit;
+        run.destination = keyBits;
+        while(bit < 64 && ((varying >> bit) & 1) != 0)
+        {
+            run.mask = (run.mask << 1) | 1;
+            ++bit;
+            ++keyBits;
+        }
+        runs.push_back(run);
+    }
+
+    uint32_t indexBits = 0;
+    while(indexBits < 32 && (uint64_t(1) << indexBits) < count)
+    {
+        ++indexBits;
+    }
+
+    // Too many packets and differing bits for one word, the compacted key is sorted with the index in its own array
+    const bool packed = keyBits + indexBits <= 64;
+    const uint32_t firstBit = packed ? indexBits : 0;
+
+    // As few passes as digits of MAX_DIGIT_BITS need, with the bits spread evenly over them
+    const uint32_t passCount = (keyBits + MAX_DIGIT_BITS - 1) / MAX_DIGIT_BITS;
+    const uint32_t digitBits = passCount > 0 ? (keyBits + passCount - 1) / passCount : 1;
+    const uint32_t digitMask = (1u << digitBits) - 1;
+
+    uint32_t chunkCount = 1;
+    if(jobSystem != nullptr)
+    {
+        chunkCount = static_cast<uint32_t>(std::min<size_t>(std::max<size_t>(count / MIN_CHUNK_SIZE, 1), jobSystem->getWorkerCount()));
+    }
+    histograms.assign(static_cast<size_t>(chunkCount) << digitBits, 0);
+    mostSortWorkers = std::max(mostSortWorkers, chunkCount);
+
+    // The packet index goes below the compacted key
+    if(packed)
+    {
+        for(BitRun& run : runs)
+        {
+            run.destination += indexBits;
+        }
+    }
+
+    // Every chunk works on its own range of the arrays and its own histogram
+    const uint64_t* keyData = keys.data();
+    const BitRun* runData = runs.data();
+    const size_t runCount = runs.size();
+    uint64_t* values = sortValues.data();
+    uint32_t* indices = order.data();
+    uint32_t* histogramData = histograms.data();
+
+    // The digits of the first pass are counted while the values are written
+    forEachChunk(jobSystem, chunkCount, [=](uint32_t chunk, size_t begin, size_t end)
+    {
+        uint32_t* histogram = histogramData + (static_cast<size_t>(chunk) << digitBits);
+        for(size_t i = begin; i < end; ++i)
+        {
+            const uint64_t key = keyData[i];
+            uint64_t value = packed ? i : 0;
+            for(size_t run = 0; run < runCount; ++run)
+            {
+                value |= ((key >> runData[run].shift) & runData[run].mask) << runData[run].destination;
+            }
+
+            values[i] = value;
+            ++histogram[(value >> firstBit) & digitMask];
+        }
+
+        if(!packed)
+        {
+            for(size_t i = begin; i < end; ++i)
+            {
+                indices[i] = static_cast<uint32_t>(i);
+            }
+        }
+    });
+
+    radixSort(jobSystem, chunkCount, firstBit, digitBits, passCount, !packed);
+
+    if(packed)
+    {
+        const uint64_t indexMask = (uint64_t(1) << indexBits) - 1;
+        const uint64_t* sortedValues = sortValues.data();
+        forEachChunk(jobSystem, chunkCount, [=](uint32_t, size_t begin, size_t end)
+        {
+            for(size_t i = begin; i < end; ++i)
+            {
+                indices[i] = static_cast<uint32_t>(sortedValues[i] & indexMask);
+            }
+        });
+    }
+
+    sortTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    sorted = true;
+}
+
+/// <summary>
+/// Stable LSD radix sort of sortValues by passCount digits from firstBit, moving order along when withOrder is set.
+///
+/// Every chunk counts the digits of its range and scatters it to the offsets of its histogram: the packets of a digit
+/// go after those of the smaller digits and, within the digit, after those of the earlier chunks, which keeps the sort
+/// stable. The histograms of the first pass were counted when the values were written, a digit equal in every value
+/// is skipped.
+/// </summary>
+void DrawQueue::radixSort(JobSystem* jobSystem, uint32_t chunkCount, uint32_t firstBit, uint32_t digitBits, uint32_t passCount, bool withOrder)
+{
+    const uint32_t digitCount = 1u << digitBits;
+    const uint32_t digitMask = digitCount - 1;
+    const size_t count = sortValues.size();
+
+    scratchValues.resize(count);
+    if(withOrder)
+    {
+        scratchOrder.resize(count);
+    }
+
+    for(uint32_t pass = 0; pass < passCount; ++pass)
+    {
+        const uint32_t shift = firstBit + pass * digitBits;
+        const uint64_t* values = sortValues.data();
+        uint32_t* histogramData = histograms.data();
+
+        if(pass > 0)
+        {
+            std::fill(histograms.begin(), histograms.end(), 0);
+            forEachChunk(jobSystem, chunkCount, [=](uint32_t chunk, size_t begin, size_t end)
+            {
+                uint32_t* histogram = histogramData + chunk * digitCount;
+                for(size_t i = begin; i < end; ++i)
+                {
+                    ++histogram[(values[i] >> shift) & digitMask];
+                }
+            });
+        }
+
+        uint32_t offset = 0;
+        uint32_t largestDigitCount = 0;
+        for(uint32_t digit = 0; digit < digitCount; ++digit)
+        {
+            const uint32_t digitOffset = offset;
+            for(uint32_t chunk = 0; chunk < chunkCount; ++chunk)
+            {
+                const uint32_t chunkDigitCount = histogramData[chunk * digitCount + digit];
+                histogramData[chunk * digitCount + digit] = offset;
+                offset += chunkDigitCount;
+            }
+            largestDigitCount = std::max(largestDigitCount, offset - digitOffset);
+        }
+
+        if(largestDigitCount == count)
+        {
+            continue;
+        }
+
+        const uint32_t* indices = order.data();
+        uint64_t* destinationValues = scratchValues.data();
+        uint32_t* destinationIndices = scratchOrder.data();
+        forEachChunk(jobSystem, chunkCount, [=](uint32_t chunk, size_t begin, size_t end)
+        {
+            uint32_t* offsets = histogramData + chunk * digitCount;
+            for(size_t i = begin; i < end; ++i)
+            {
+                const uint32_t destination = offsets[(values[i] >> shift) & digitMask]++;
+                destinationValues[destination] = values[i];
+                if(withOrder)
+                {
+                    destinationIndices[destination] = indices[i];
+                }
+            }
+        });
+
+        sortValues.swap(scratchValues);
+        if(withOrder)
+        {
+            order.swap(scratchOrder);
+        }
+    }
+}
+
+/// <summary>
+/// Calls function for chunkCount ranges of about the same number of packets, as jobs of the job system when there is
+/// more than one and on the calling thread otherwise.
+/// </summary>
+void DrawQueue::forEachChunk(JobSystem* jobSystem, uint32_t chunkCount, const ChunkFunction& function) const
+{
+    const size_t count = keys.size();
+    const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+    if(jobSystem == nullptr || chunkCount < 2)
+    {
+        function(0, 0, count);
+        return;
+    }
+
+    JobCounter counter;
+    jobSystem->parallelFor(chunkCount, 1, [&function, count, chunkSize](size_t first, size_t last)
+    {
+        for(size_t chunk = first; chunk < last; ++chunk)
+        {
+            function(static_cast<uint32_t>(chunk), chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+        }
+    }, counter);
+    jobSystem->wait(counter);
+}
+
+/// <summary>
+/// Binds needed to record the packets in submission order: a state is bound when it differs from the previous
+/// packet's, and a material again after the pipeline layout changed.
+/// </summary>
+DrawQueue::Counts DrawQueue::countBinds() const
+{
+    Counts result = {};
+    result.packets = static_cast<uint32_t>(keys.size());
+
+    uint64_t previous = 0;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    for(size_t i = 0; i < keys.size(); ++i)
+    {
+        const uint64_t key = keys[i];
+        const uint32_t pipeline = getField(key, PIPELINE_SHIFT, PIPELINE_BITS);
+        const bool first = i == 0;
+        bool layoutChanged = false;
+
+        if(first || pipeline != getField(previous, PIPELINE_SHIFT, PIPELINE_BITS))
+        {
+            ++result.pipelineBinds;
+            layoutChanged = pipelines[pipeline].layout != layout;
+            layout = pipelines[pipeline].layout;
+        }
+        if(first || layoutChanged || getField(key, MATERIAL_SHIFT, MATERIAL_BITS) != getField(previous, MATERIAL_SHIFT, MATERIAL_BITS))
+        {
+            ++result.materialBinds;
+        }
+        if(first || getField(key, MESH_SHIFT, MESH_BITS) != getField(previous, MESH_SHIFT, MESH_BITS))
+        {
+            ++result.meshBinds;
+        }
+
+        previous = key;
+    }
+
+    return result;
+}
+
+/// <summary>
+/// Records the packets in key order, or in submission order when the frame was not sorted, binding only the states
+/// which differ from the previous packet's, and adds the frame to the statistics. Returns the number of draw calls.
+/// </summary>
+uint32_t DrawQueue::record(VkCommandBuffer commandBuffer)
+{
+    constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    uint32_t boundPipeline = NONE;
+    uint32_t boundMaterial = NONE;
+    uint32_t boundMesh = NONE;
+    VkPipelineLayout boundLayout = VK_NULL_HANDLE;
+
+    counts = {};
+    counts.packets = static_cast<uint32_t>(keys.size());
+
+    for(size_t i = 0; i < keys.size(); ++i)
+    {
+        const size_t packetIndex = sorted ? order[i] : i;
+        const uint64_t key = keys[packetIndex];
+        const Packet& packet = packets[packetIndex];
+
+        const uint32_t pipeline = getField(key, PIPELINE_SHIFT, PIPELINE_BITS);
+        if(pipeline != boundPipeline)
+        {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines[pipeline].pipeline);
+            ++counts.pipelineBinds;
+            boundPipeline = pipeline;
+
+            // Sets bound with another layout may be disturbed, the material is bound again
+            if(pipelines[pipeline].layout != boundLayout)
+            {
+                boundLayout = pipelines[pipeline].layout;
+                boundMaterial = NONE;
+            }
+        }
+
+        const uint32_t material = getField(key, MATERIAL_SHIFT, MATERIAL_BITS);
+        if(material != boundMaterial)
+        {
+            if(materials[material] != VK_NULL_HANDLE)
+            {
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, boundLayout, MATERIAL_SET, 1, &materials[material], 0, nullptr);
+            }
+            ++counts.materialBinds;
+            boundMaterial = material;
+        }
+
+        const uint32_t meshIndex = getField(key, MESH_SHIFT, MESH_BITS);
+        const Mesh& mesh = meshes[meshIndex];
+        if(meshIndex != boundMesh)
+        {
+            if(mesh.vertexBuffer != VK_NULL_HANDLE)
+            {
+                vkCmdBindVertexBuffers(commandBuffer, 0, 1, &mesh.vertexBuffer, &mesh.vertexOffset);
+            }
+            if(mesh.indexBuffer != VK_NULL_HANDLE)
+            {
+                vkCmdBindIndexBuffer(commandBuffer, mesh.indexBuffer, mesh.indexOffset, mesh.indexType);
+            }
+            ++counts.meshBinds;
+            boundMesh = meshIndex;
+        }
+
+        if(mesh.indexBuffer != VK_NULL_HANDLE)
+        {
+            vkCmdDrawIndexed(commandBuffer, packet.indexCount, packet.instanceCount, packet.firstIndex, packet.vertexOffset, packet.firstInstance);
+        }
+        else
+        {
+            vkCmdDraw(commandBuffer, packet.indexCount, packet.instanceCount, static_cast<uint32_t>(packet.vertexOffset), packet.firstInstance);
+        }
+    }
+
+    // Recorded without sort(), the packets were in submission order
+    if(!sorted)
+    {
+        submissionOrderCounts = counts;
+    }
+
+    ++frames;
+    totalPackets += counts.packets;
+    totalBinds += counts.pipelineBinds + counts.materialBinds + counts.meshBinds;
+    totalSubmissionOrderBinds += submissionOrderCounts.pipelineBinds + submissionOrderCounts.materialBinds + submissionOrderCounts.meshBinds;
+    totalPipelineBinds += counts.pipelineBinds;
+    totalMaterialBinds += counts.materialBinds;
+    totalMeshBinds += counts.meshBinds;
+    totalSortTime += sortTime;
+    longestSortTime = std::max(longestSortTime, sortTime);
+
+    return counts.packets;
+}
+
+const DrawQueue::Counts& DrawQueue::getCounts() const
+{
+    return counts;
+}
+
+const DrawQueue::Counts& DrawQueue::getSubmissionOrderCounts() const
+{
+    return submissionOrderCounts;
+}
+
+double DrawQueue::getSortTime() const
+{
+    return sortTime;
+}
+
+void DrawQueue::printStatistics(std::ostream& stream) const
+{
+    stream << "DrawQueue: " << pipelines.size() << " pipelines, " << materials.size() << " materials, " << meshes.size() << " meshes\n";
+
+    if(frames == 0)
+    {
+        return;
+    }
+
+    const double frameCount = static_cast<double>(frames);
+    const std::streamsize precision = stream.precision();
+    stream << std::fixed << std::setprecision(1)
+           << "    " << static_cast<double>(totalPackets) / frameCount << " packets per frame, binds per frame: "
+           << static_cast<double>(totalPipelineBinds) / frameCount << " pipeline, "
+           << static_cast<double>(totalMaterialBinds) / frameCount << " material, "
+           << static_cast<double>(totalMeshBinds) / frameCount << " mesh, "
+           << static_cast<double>(totalBinds) / frameCount << " in total, "
+           << static_cast<double>(totalSubmissionOrderBinds) / frameCount << " in submission order\n"
+           << std::setprecision(3)
+           << "    sort " << totalSortTime / frameCount << " ms on average, " << longestSortTime << " ms at most, on up to "
+           << mostSortWorkers << " workers\n"
+           << std::defaultfloat << std::setprecision(precision);
+}
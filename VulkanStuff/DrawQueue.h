@@ -0,0 +1,130 @@
+#pragma once
+#include "JobSystem.h"
+
+/// <summary>
+/// Per frame queue of draw packets, sorted by a 64 bit key and recorded without redundant state changes.
+///
+/// From the most to the least significant bits a key holds:
+///
+///     pass        4 bits  - ordering layer within the render pass, e.g. opaque before transparent
+///     pipeline   12 bits  - registered pipeline
+///     material   16 bits  - registered descriptor set, bound to MATERIAL_SET
+///     mesh       12 bits  - registered vertex and index buffers
+///     depth      20 bits  - quantized view depth, front to back, 1 - depth sorts back to front
+///
+/// Sorting the keys groups packets by state, so consecutive packets share pipeline, material and mesh and record()
+/// only binds what differs from the last packet. Sorting is a stable LSD radix sort with digits of up to
+/// MAX_DIGIT_BITS. Only the bits which differ between the keys of the frame are sorted: a frame with a few pipelines,
+/// materials and meshes and no transparent pass leaves most of the key constant. These bits are compacted and, when
+/// they fit, the packet index is packed below them, so every pass moves a single 64 bit word per packet. Given a job
+/// system, the workers compact, count and scatter a range of the packets each.
+///
+/// Binds are counted per frame, together with the binds recording in submission order would have needed.
+/// </summary>
+class DrawQueue
+{
+public:
+    static constexpr uint32_t           PASS_BITS                   = 4;
+    static constexpr uint32_t           PIPELINE_BITS               = 12;
+    static constexpr uint32_t           MATERIAL_BITS               = 16;
+    static constexpr uint32_t           MESH_BITS                   = 12;
+    static constexpr uint32_t           DEPTH_BITS                  = 20;
+    static constexpr uint32_t           MATERIAL_SET                = 1;    // set 0 is left to the caller, e.g. per frame data
+
+    struct Pipeline
+    {
+        VkPipeline                      pipeline                    = VK_NULL_HANDLE;
+        VkPipelineLayout                layout                      = VK_NULL_HANDLE;
+    };
+
+    struct Mesh
+    {
+        VkBuffer                        vertexBuffer                = VK_NULL_HANDLE;
+        VkDeviceSize                    vertexOffset                = 0;
+        VkBuffer                        indexBuffer                 = VK_NULL_HANDLE;   // draws without indices when null
+        VkDeviceSize                    indexOffset                 = 0;
+        VkIndexType                     indexType                   = VK_INDEX_TYPE_UINT32;
+    };
+
+    // Arguments of the draw, indexCount counts vertices for meshes without indices
+    struct Packet
+    {
+        uint32_t                        indexCount                  = 0;
+        uint32_t                        instanceCount               = 1;
+        uint32_t                        firstIndex                  = 0;
+        int32_t                         vertexOffset                = 0;
+        uint32_t                        firstInstance               = 0;
+    };
+
+    struct Counts
+    {
+        uint32_t                        packets                     = 0;
+        uint32_t                        pipelineBinds               = 0;
+        uint32_t                        materialBinds               = 0;
+        uint32_t                        meshBinds                   = 0;
+    };
+
+    uint32_t                            addPipeline(const Pipeline& pipeline);
+    uint32_t                            addMaterial(VkDescriptorSet descriptorSet);
+    uint32_t                            addMesh(const Mesh& mesh);
+
+    void                                clear();
+    void                                submit(uint64_t key, const Packet& packet);
+    void                                sort(JobSystem* jobSystem = nullptr);
+    uint32_t                            record(VkCommandBuffer commandBuffer);
+
+    const Counts&                       getCounts()                                                                             const;
+    const Counts&                       getSubmissionOrderCounts()                                                              const;
+    double                              getSortTime()                                                                           const;
+    void                                printStatistics(std::ostream& stream)                                                   const;
+
+    static uint64_t                     makeKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+
+private:
+    static constexpr uint32_t           MAX_DIGIT_BITS              = 11;
+    static constexpr size_t             MIN_CHUNK_SIZE              = 16384;    // packets per worker, smaller frames sort on fewer workers
+
+    using ChunkFunction = std::function<void(uint32_t chunk, size_t begin, size_t end)>;
+
+    // Bits of the key which differ within the frame, moved next to each other for sorting
+    struct BitRun
+    {
+        uint32_t                        shift                       = 0;
+        uint32_t                        destination                 = 0;
+        uint64_t                        mask                        = 0;
+    };
+
+    std::vector<Pipeline>               pipelines                   = {};
+    std::vector<VkDescriptorSet>        materials                   = {};
+    std::vector<Mesh>                   meshes                      = {};
+
+    //Frame
+    std::vector<uint64_t>               keys                        = {};   // in submission order
+    std::vector<Packet>                 packets                     = {};   // in submission order
+    std::vector<uint32_t>               order                       = {};   // packets in key order
+    std::vector<uint64_t>               sortValues                  = {};
+    std::vector<uint64_t>               scratchValues               = {};
+    std::vector<uint32_t>               scratchOrder                = {};
+    std::vector<BitRun>                 runs                        = {};
+    std::vector<uint32_t>               histograms                  = {};   // one per chunk, for the digit of the pass
+    Counts                              counts                      = {};
+    Counts                              submissionOrderCounts       = {};
+    double                              sortTime                    = 0.0;  // milliseconds
+    bool                                sorted                      = false;
+
+    //Statistics
+    uint64_t                            frames                      = 0;
+    uint64_t                            totalPackets                = 0;
+    uint64_t                            totalBinds                  = 0;
+    uint64_t                            totalSubmissionOrderBinds   = 0;
+    uint64_t                            totalPipelineBinds          = 0;
+    uint64_t                            totalMaterialBinds          = 0;
+    uint64_t                            totalMeshBinds              = 0;
+    double                              totalSortTime               = 0.0;
+    double                              longestSortTime             = 0.0;
+    uint32_t                            mostSortWorkers             = 0;
+
+    void                                radixSort(JobSystem* jobSystem, uint32_t chunkCount, uint32_t firstBit, uint32_t digitBits, uint32_t passCount, bool withOrder);
+    void                                forEachChunk(JobSystem* jobSystem, uint32_t chunkCount, const ChunkFunction& function)  const;
+    Counts                              countBinds()                                                                            const;
+};
@@ -0,0 +1,196 @@
+#include "pch.h"
+#include "FramePacer.h"
+
+FramePacer::FramePacer(PresentPolicy policy, double targetFrameRate)
+    : policy(policy)
+    , frameInterval(targetFrameRate > 0.0 ? 1000.0 / targetFrameRate : 0.0)
+{
+}
+
+/// <summary>
+/// Present modes in order of preference for every policy. FIFO is the only mode every surface supports.
+/// Unpaced policies only fall back to IMMEDIATE, which tears, when tearing is allowed explicitly.
+/// </summary>
+VkPresentModeKHR FramePacer::choosePresentMode(PresentPolicy policy, bool allowTearing, const std::vector<VkPresentModeKHR>& availablePresentModes)
+{
+    std::vector<VkPresentModeKHR> preferredModes = {};
+
+    switch(policy)
+    {
+    case PresentPolicy::LowLatency:
+        preferredModes = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR };
+        break;
+    case PresentPolicy::VSync:
+        break;
+    case PresentPolicy::Uncapped:
+    case PresentPolicy::TargetFrameRate:
+        preferredModes = { VK_PRESENT_MODE_MAILBOX_KHR };
+        if(allowTearing)
+        {
+            preferredModes.push_back(VK_PRESENT_MODE_IMMEDIATE_KHR);
+        }
+        break;
+    }
+
+    for(VkPresentModeKHR preferredMode : preferredModes)
+    {
+        if(std::find(availablePresentModes.begin(), availablePresentModes.end(), preferredMode) != availablePresentModes.end())
+        {
+            return preferredMode;
+        }
+    }
+
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+const char* FramePacer::getPolicyName(PresentPolicy policy)
+{
+    switch(policy)
+    {
+    case PresentPolicy::LowLatency:         return "low-latency";
+    case PresentPolicy::VSync:              return "vsync";
+    case PresentPolicy::Uncapped:           return "uncapped";
+    case PresentPolicy::TargetFrameRate:    return "target-fps";
+    default:                                return "unknown";
+    }
+}
+
+const char* FramePacer::getPresentModeName(VkPresentModeKHR presentMode)
+{
+    switch(presentMode)
+    {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:     return "immediate";
+    case VK_PRESENT_MODE_MAILBOX_KHR:       return "mailbox";
+    case VK_PRESENT_MODE_FIFO_KHR:          return "fifo";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR:  return "fifo-relaxed";
+    default:                                return "other";
+    }
+}
+
+/// <summary>
+/// Returns the time the frame starts, after any pacing wait. Presents which completed meanwhile are collected by
+/// the monitor first, so their latency is measured even when the policy does not wait for them.
+/// </summary>
+std::chrono::steady_clock::time_point FramePacer::beginFrame(PresentLatencyMonitor* monitor, VkSwapchainKHR swapchain, uint64_t previousPresentId)
+{
+    const auto waitStart = std::chrono::steady_clock::now();
+
+    if(monitor != nullptr && swapchain != VK_NULL_HANDLE)
+    {
+        monitor->poll(swapchain);
+    }
+
+    switch(policy)
+    {
+    case PresentPolicy::TargetFrameRate:
+    {
+        // A frame late by more than an interval restarts the schedule instead of catching up with a burst of frames.
+        const auto now = std::chrono::steady_clock::now();
+        if(nextFrameStart == std::chrono::steady_clock::time_point() || now > nextFrameStart + frameInterval)
+        {
+            nextFrameStart = now;
+        }
+
+        sleepUntil(nextFrameStart);
+        nextFrameStart += std::chrono::duration_cast<std::chrono::steady_clock::duration>(frameInterval);
+        break;
+    }
+    case PresentPolicy::LowLatency:
+    case PresentPolicy::VSync:
+        // Waiting for the previous present keeps at most one frame queued, input is sampled as late as possible.
+        if(monitor != nullptr && swapchain != VK_NULL_HANDLE && previousPresentId > 0)
+        {
+            const auto presentCompletion = monitor->waitForPresent(swapchain, previousPresentId, PRESENT_WAIT_TIMEOUT);
+            if(presentCompletion.has_value() && policy == PresentPolicy::VSync)
+            {
+                paceToRefresh(*monitor, presentCompletion.value());
+            }
+        }
+        break;
+    case PresentPolicy::Uncapped:
+        break;
+    }
+
+    const auto frameStart = std::chrono::steady_clock::now();
+
+    ++pacedFrames;
+    waitTime += frameStart - waitStart;
+
+    return frameStart;
+}
+
+/// <summary>
+/// With FIFO the frame only has to be presented before the next refresh, starting it right after the previous present
+/// adds the unused part of the refresh interval to the latency. The slack after the previous present grows slowly
+/// while frames make their refresh and is halved when one misses it.
+/// </summary>
+void FramePacer::paceToRefresh(const PresentLatencyMonitor& monitor, std::chrono::steady_clock::time_point presentCompletion)
+{
+    const auto refreshInterval = monitor.getRefreshInterval();
+    const bool consecutive = lastPresentCompletion != std::chrono::steady_clock::time_point() && presentCompletion > lastPresentCompletion;
+    const double presentInterval = std::chrono::duration<double, std::milli>(presentCompletion - lastPresentCompletion).count();
+
+    lastPresentCompletion = presentCompletion;
+
+    if(!refreshInterval.has_value() || !consecutive)
+    {
+        return;
+    }
+
+    if(presentInterval > refreshInterval.value() * 1.5)
+    {
+        ++missedRefreshes;
+        presentSlack *= 0.5;
+    }
+    else
+    {
+        presentSlack = std::min(presentSlack + PRESENT_SLACK_STEP, std::max(0.0, refreshInterval.value() - PRESENT_SLACK_MARGIN));
+    }
+
+    sleepUntil(presentCompletion + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(presentSlack)));
+}
+
+/// <summary>
+/// std::this_thread::sleep_for overshoots by the scheduler granularity, a full timer tick of 15.6 ms on Windows unless
+/// the timer resolution was raised. Sleeps in 1 ms steps while the estimated overshoot still fits before the deadline
+/// and spins for the remainder.
+/// </summary>
+void FramePacer::sleepUntil(std::chrono::steady_clock::time_point deadline)
+{
+    while(true)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const double remaining = std::chrono::duration<double, std::milli>(deadline - now).count();
+        const double estimate = sleepMean + std::sqrt(sleepM2 / static_cast<double>(sleepCount));
+
+        if(remaining <= estimate)
+        {
+            break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        const double observed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - now).count();
+        ++sleepCount;
+        const double delta = observed - sleepMean;
+        sleepMean += delta / static_cast<double>(sleepCount);
+        sleepM2 += delta * (observed - sleepMean);
+    }
+
+    while(std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::yield();
+    }
+}
+
+void FramePacer::printStatistics(std::ostream& stream) const
+{
+    const double frames = static_cast<double>(std::max<uint64_t>(pacedFrames, 1));
+
+    stream << "FramePacer: policy " << getPolicyName(policy) << ", " << pacedFrames << " frames, mean wait " << waitTime.count() / frames << " ms";
+    if(policy == PresentPolicy::VSync)
+    {
+        stream << ", slack " << presentSlack << " ms after present, " << missedRefreshes << " missed refreshes";
+    }
+    stream << ", 1 ms sleeps take " << sleepMean << " ms\n";
+}
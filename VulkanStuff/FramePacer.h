@@ -0,0 +1,59 @@
+#pragma once
+#include "PresentLatency.h"
+
+enum class PresentPolicy
+{
+    LowLatency,         // tearing allowed, at most one frame queued for presentation
+    VSync,              // FIFO, frames start just in time for the next refresh
+    Uncapped,           // render as fast as possible, without tearing unless tearing is allowed
+    TargetFrameRate     // render at a fixed rate paced by the CPU
+};
+
+/// <summary>
+/// Chooses the present mode for a policy and delays the start of frames according to it.
+///
+/// beginFrame() is called before input is sampled and the swapchain image is acquired, so time spent waiting
+/// there instead of inside vkAcquireNextImageKHR or the frame fence shortens the time from input to display.
+/// Policies which wait for the previous present need a PresentLatencyMonitor, without one they fall back to the
+/// blocking behavior of their present mode.
+/// </summary>
+class FramePacer
+{
+public:
+                                        FramePacer(PresentPolicy policy, double targetFrameRate);
+
+    std::chrono::steady_clock::time_point beginFrame(PresentLatencyMonitor* monitor, VkSwapchainKHR swapchain, uint64_t previousPresentId);
+    void                                printStatistics(std::ostream& stream)                                                   const;
+
+    static VkPresentModeKHR             choosePresentMode(PresentPolicy policy, bool allowTearing, const std::vector<VkPresentModeKHR>& availablePresentModes);
+    static const char*                  getPolicyName(PresentPolicy policy);
+    static const char*                  getPresentModeName(VkPresentModeKHR presentMode);
+
+private:
+    const PresentPolicy                 policy;
+    const std::chrono::duration<double, std::milli> frameInterval;
+
+    //Target Frame Rate
+    std::chrono::steady_clock::time_point nextFrameStart            = {};
+
+    //VSync - time after the previous present before the next frame starts, grown until a refresh is missed
+    double                              presentSlack                = 0.0;  // milliseconds
+    std::chrono::steady_clock::time_point lastPresentCompletion     = {};
+
+    //Sleep overshoot estimate, running mean and variance of 1 ms sleeps
+    double                              sleepMean                   = 2.0;  // milliseconds
+    double                              sleepM2                     = 0.0;
+    uint64_t                            sleepCount                  = 1;
+
+    //Statistics
+    uint64_t                            pacedFrames                 = 0;
+    uint64_t                            missedRefreshes             = 0;
+    std::chrono::duration<double, std::milli> waitTime              = {};
+
+    static constexpr std::chrono::milliseconds PRESENT_WAIT_TIMEOUT { 100 };
+    static constexpr double             PRESENT_SLACK_STEP          = 0.25; // milliseconds
+    static constexpr double             PRESENT_SLACK_MARGIN        = 2.0;  // milliseconds kept free before the refresh
+
+    void                                paceToRefresh(const PresentLatencyMonitor& monitor, std::chrono::steady_clock::time_point presentCompletion);
+    void                                sleepUntil(std::chrono::steady_clock::time_point deadline);
+};
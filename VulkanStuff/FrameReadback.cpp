@@ -0,0 +1,264 @@
+#include "pch.h"
+#include "FrameReadback.h"
+
+FrameReadback::FrameReadback(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                             uint32_t slotCount, MemoryBudgetMonitor* budgetMonitor, Callback callback, PixelBufferProvider pixelBufferProvider)
+    : vkDevice(device)
+    , capabilities(capabilities)
+    , vkAllocator(allocator)
+    , budgetMonitor(budgetMonitor)
+    , callback(std::move(callback))
+    , pixelBufferProvider(std::move(pixelBufferProvider))
+    , slots(slotCount)
+{
+}
+
+FrameReadback::~FrameReadback()
+{
+    for(auto& slot : slots)
+    {
+        releaseSlot(slot);
+    }
+}
+
+/// <summary>
+/// Captures are copied as they are stored, so only formats with 4 bytes per pixel in RGBA or BGRA order are accepted.
+/// </summary>
+bool FrameReadback::isFormatSupported(VkFormat format)
+{
+    switch(format)
+    {
+    case VK_FORMAT_B8G8R8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_R8G8B8A8_UNORM:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void FrameReadback::releaseSlot(Slot& slot)
+{
+    if(slot.memory.get() != VK_NULL_HANDLE && budgetMonitor != nullptr)
+    {
+        budgetMonitor->trackFree(slot.memoryTypeIndex, slot.size);
+    }
+
+    // Freeing the memory unmaps it
+    slot.buffer.reset();
+    slot.memory.reset();
+    slot.mapped = nullptr;
+    slot.size = 0;
+}
+
+/// <summary>
+/// Staging buffers are only (re)created when the captured image grows, e.g. after a swapchain resize. The slot is
+/// not used by the GPU at this point, its frame was collected before the slot is recorded again.
+/// </summary>
+void FrameReadback::ensureCapacity(Slot& slot, VkDeviceSize size)
+{
+    if(slot.size >= size)
+    {
+        return;
+    }
+
+    releaseSlot(slot);
+
+    VkBufferCreateInfo bufferCreateInfo
+    {
+        VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        nullptr,
+        NULL,
+        size,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_SHARING_MODE_EXCLUSIVE,
+        0,
+        nullptr
+    };
+
+    VkBuffer buffer = nullptr;
+    if(vkCreateBuffer(vkDevice, &bufferCreateInfo, vkAllocator, &buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("FrameReadback: Failed to create staging buffer!");
+    }
+    slot.buffer = UniqueBuffer(vkDevice, buffer, vkAllocator);
+
+    VkMemoryRequirements memoryRequirements = {};
+    vkGetBufferMemoryRequirements(vkDevice, buffer, &memoryRequirements);
+
+    // Host cached memory makes reading the pixels back on the CPU fast, uncached memory is read at a fraction of the speed.
+    const auto memoryTypeIndex = capabilities.findMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+    if(!memoryTypeIndex.has_value())
+    {
+        throw std::runtime_error("FrameReadback: No host visible memory type for staging buffer!");
+    }
+
+    VkMemoryAllocateInfo memoryAllocateInfo
+    {
+        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        nullptr,
+        memoryRequirements.size,
+        memoryTypeIndex.value()
+    };
+
+    VkDeviceMemory memory = nullptr;
+    if(vkAllocateMemory(vkDevice, &memoryAllocateInfo, vkAllocator, &memory) != VK_SUCCESS)
+    {
+        throw std::runtime_error("FrameReadback: Failed to allocate staging memory!");
+    }
+    slot.memory = UniqueDeviceMemory(vkDevice, memory, vkAllocator);
+
+    vkBindBufferMemory(vkDevice, buffer, memory, 0);
+
+    if(vkMapMemory(vkDevice, memory, 0, VK_WHOLE_SIZE, 0, &slot.mapped) != VK_SUCCESS)
+    {
+        throw std::runtime_error("FrameReadback: Failed to map staging memory!");
+    }
+
+    slot.size = memoryRequirements.size;
+    slot.memoryTypeIndex = memoryTypeIndex.value();
+    slot.coherent = (capabilities.memoryProperties.memoryTypes[slot.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+    if(budgetMonitor != nullptr)
+    {
+        budgetMonitor->trackAllocation(slot.memoryTypeIndex, slot.size);
+    }
+}
+
+/// <summary>
+/// Records the copy of a rendered image after the render pass. The image is expected in imageLayout, the final layout
+/// of the render pass, and is returned to it, so the copy fits between the render pass and presentation.
+/// </summary>
+void FrameReadback::record(VkCommandBuffer commandBuffer, uint32_t slotIndex, VkImage image, VkImageLayout imageLayout,
+                           VkFormat format, VkExtent2D extent, uint64_t frameNumber)
+{
+    const auto recordStart = std::chrono::steady_clock::now();
+
+    Slot& slot = slots[slotIndex];
+
+    ensureCapacity(slot, static_cast<VkDeviceSize>(extent.width) * extent.height * 4);
+
+    const VkImageSubresourceRange subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+    VkImageMemoryBarrier toTransferBarrier
+    {
+        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        nullptr,
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        VK_ACCESS_TRANSFER_READ_BIT,
+        imageLayout,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        image,
+        subresourceRange
+    };
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                         0, nullptr, 0, nullptr, 1, &toTransferBarrier);
+
+    VkBufferImageCopy region
+    {
+        0,
+        0,      // bufferRowLength and bufferImageHeight of 0 mean tightly packed
+        0,
+        { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+        { 0, 0, 0 },
+        { extent.width, extent.height, 1 }
+    };
+
+    vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer, 1, &region);
+
+    // Make the copy visible to host reads after the fence, and return the image to its previous layout.
+    VkBufferMemoryBarrier hostBarrier
+    {
+        VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        nullptr,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_ACCESS_HOST_READ_BIT,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        slot.buffer,
+        0,
+        VK_WHOLE_SIZE
+    };
+
+    VkImageMemoryBarrier toPresentBarrier
+    {
+        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        nullptr,
+        VK_ACCESS_TRANSFER_READ_BIT,
+        0,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        imageLayout,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        image,
+        subresourceRange
+    };
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                         0, nullptr, 1, &hostBarrier, 1, &toPresentBarrier);
+
+    slot.pending = true;
+    slot.frameNumber = frameNumber;
+    slot.extent = extent;
+    slot.format = format;
+
+    recordTime += std::chrono::steady_clock::now() - recordStart;
+}
+
+/// <summary>
+/// Hands the pixels of the slot to the callback. Must only be called after the fence of the frame which recorded
+/// the slot was signaled.
+/// </summary>
+void FrameReadback::collect(uint32_t slotIndex)
+{
+    Slot& slot = slots[slotIndex];
+    if(!slot.pending)
+    {
+        return;
+    }
+
+    const auto collectStart = std::chrono::steady_clock::now();
+
+    if(!slot.coherent)
+    {
+        VkMappedMemoryRange range
+        {
+            VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+            nullptr,
+            slot.memory,
+            0,
+            VK_WHOLE_SIZE
+        };
+        vkInvalidateMappedMemoryRanges(vkDevice, 1, &range);
+    }
+
+    const size_t size = static_cast<size_t>(slot.extent.width) * slot.extent.height * 4;
+
+    CapturedFrame frame = {};
+    frame.frameNumber = slot.frameNumber;
+    frame.width = slot.extent.width;
+    frame.height = slot.extent.height;
+    frame.format = slot.format;
+    frame.pixels = pixelBufferProvider ? pixelBufferProvider(size) : std::vector<uint8_t>(size);
+    std::memcpy(frame.pixels.data(), slot.mapped, size);
+
+    slot.pending = false;
+
+    ++capturedFrames;
+    capturedBytes += size;
+    collectTime += std::chrono::steady_clock::now() - collectStart;
+
+    callback(std::move(frame));
+}
+
+void FrameReadback::printStatistics(std::ostream& stream) const
+{
+    const double frames = static_cast<double>(std::max<uint64_t>(capturedFrames, 1));
+
+    stream << "FrameReadback: " << capturedFrames << " frames, " << capturedBytes / (1024 * 1024) << " MiB read back, "
+           << "render thread cost " << recordTime.count() / frames << " us record + " << collectTime.count() / frames << " us collect per frame\n";
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "DeviceCapabilities.h"
+#include "MemoryBudget.h"
+#include "FrameWriter.h"
+#include "VkHandle.h"
+
+/// <summary>
+/// Copies rendered images back to host memory without stalling the render loop.
+///
+/// Every frame in flight owns a slot with a persistently mapped, host cached staging buffer. record() appends the
+/// image to buffer copy to the frame command buffer, collect() is called once the frame fence was waited for by the
+/// render loop anyway, which is FRAMES_IN_FLIGHT frames later, so the result is read without any additional wait.
+/// Collected frames are handed to a callback, usually FrameWriter::submit, which encodes them on another thread.
+/// </summary>
+class FrameReadback
+{
+public:
+    using Callback = std::function<void(CapturedFrame&& frame)>;
+    using PixelBufferProvider = std::function<std::vector<uint8_t>(size_t size)>;
+
+                                        FrameReadback(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                                                      uint32_t slotCount, MemoryBudgetMonitor* budgetMonitor, Callback callback,
+                                                      PixelBufferProvider pixelBufferProvider = {});
+                                        ~FrameReadback();
+
+                                        FrameReadback(const FrameReadback&) = delete;
+    FrameReadback&                      operator=(const FrameReadback&) = delete;
+
+    void                                record(VkCommandBuffer commandBuffer, uint32_t slot, VkImage image, VkImageLayout imageLayout,
+                                               VkFormat format, VkExtent2D extent, uint64_t frameNumber);
+    void                                collect(uint32_t slot);
+    void                                printStatistics(std::ostream& stream)                                                   const;
+
+    static bool                         isFormatSupported(VkFormat format);
+
+private:
+    struct Slot
+    {
+        UniqueDeviceMemory              memory                      = {};
+        UniqueBuffer                    buffer                      = {};
+        VkDeviceSize                    size                        = 0;
+        uint32_t                        memoryTypeIndex             = 0;
+        bool                            coherent                    = false;
+        void*                           mapped                      = nullptr;
+
+        bool                            pending                     = false;
+        uint64_t                        frameNumber                 = 0;
+        VkExtent2D                      extent                      = {0,0};
+        VkFormat                        format                      = VK_FORMAT_UNDEFINED;
+    };
+
+    VkDevice                            vkDevice;
+    const PhysicalDeviceCapabilities&   capabilities;
+    const VkAllocationCallbacks*        vkAllocator;
+    MemoryBudgetMonitor*                budgetMonitor;
+    Callback                            callback;
+    PixelBufferProvider                 pixelBufferProvider;
+
+    std::vector<Slot>                   slots;
+
+    //Statistics
+    uint64_t                            capturedFrames              = 0;
+    uint64_t                            capturedBytes               = 0;
+    std::chrono::duration<double, std::micro> recordTime            = {};
+    std::chrono::duration<double, std::micro> collectTime           = {};
+
+    void                                ensureCapacity(Slot& slot, VkDeviceSize size);
+    void                                releaseSlot(Slot& slot);
+};
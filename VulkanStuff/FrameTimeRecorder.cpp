@@ -0,0 +1,89 @@
+#include "pch.h"
+#include "FrameTimeRecorder.h"
+
+FrameTimeRecorder::FrameTimeRecorder(size_t warmupFrames)
+    : warmupFrames(warmupFrames)
+{
+}
+
+/// <summary>
+/// Called once before the first frame and once after every frame, the time since the previous call is the frame time.
+/// </summary>
+void FrameTimeRecorder::frameBoundary()
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    if(frameCount++ > warmupFrames)
+    {
+        frameTimes.push_back(std::chrono::duration<double, std::milli>(now - lastFrame).count());
+    }
+
+    lastFrame = now;
+}
+
+FrameTimeRecorder::Summary FrameTimeRecorder::getSummary() const
+{
+    return summarize(frameTimes);
+}
+
+/// <summary>
+/// Summarizes any series of millisecond samples. Percentiles use the nearest rank on the sorted samples.
+/// </summary>
+FrameTimeRecorder::Summary FrameTimeRecorder::summarize(std::vector<double> sorted)
+{
+    Summary summary = {};
+    summary.frameCount = sorted.size();
+
+    if(sorted.empty())
+    {
+        return summary;
+    }
+
+    std::sort(sorted.begin(), sorted.end());
+
+    const auto percentile = [&sorted](double fraction)
+    {
+        const size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+        return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+    };
+
+    double total = 0.0;
+    for(double frameTime : sorted)
+    {
+        total += frameTime;
+    }
+
+    summary.mean = total / static_cast<double>(sorted.size());
+    summary.minimum = sorted.front();
+    summary.median = percentile(0.50);
+    summary.p95 = percentile(0.95);
+    summary.p99 = percentile(0.99);
+    summary.maximum = sorted.back();
+
+    return summary;
+}
+
+void FrameTimeRecorder::printSummary(std::ostream& stream) const
+{
+    const Summary summary = getSummary();
+
+    stream << "FrameTimes: " << summary.frameCount << " frames after " << warmupFrames << " warm-up frames, mean " << summary.mean
+           << " ms (" << (summary.mean > 0.0 ? 1000.0 / summary.mean : 0.0) << " fps), min " << summary.minimum
+           << " ms, median " << summary.median << " ms, p95 " << summary.p95 << " ms, p99 " << summary.p99
+           << " ms, max " << summary.maximum << " ms\n";
+}
+
+void FrameTimeRecorder::writeCSV(const std::string& path) const
+{
+    std::ofstream file(path);
+    if(!file.is_open())
+    {
+        throw std::runtime_error("FrameTimes: Failed to open " + path + "!");
+    }
+
+    file << "frame,milliseconds\n";
+    for(size_t i = 0; i < frameTimes.size(); ++i)
+    {
+        file << warmupFrames + 1 + i << "," << frameTimes[i] << "\n";
+    }
+}
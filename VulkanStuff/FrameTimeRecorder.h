@@ -0,0 +1,35 @@
+#pragma once
+
+/// <summary>
+/// Records the CPU time between consecutive frames and summarizes it as mean and percentiles.
+/// The first frames are excluded as warm-up, they include pipeline compilation and driver initialization.
+/// </summary>
+class FrameTimeRecorder
+{
+public:
+    struct Summary
+    {
+        size_t                          frameCount                  = 0;
+        double                          mean                        = 0.0;
+        double                          minimum                     = 0.0;
+        double                          median                      = 0.0;
+        double                          p95                         = 0.0;
+        double                          p99                         = 0.0;
+        double                          maximum                     = 0.0;
+    };
+
+    explicit                            FrameTimeRecorder(size_t warmupFrames = 10);
+
+    void                                frameBoundary();
+    Summary                             getSummary()                                                                            const;
+    void                                printSummary(std::ostream& stream)                                                      const;
+    void                                writeCSV(const std::string& path)                                                       const;
+
+    static Summary                      summarize(std::vector<double> samples);
+
+private:
+    const size_t                        warmupFrames;
+    size_t                              frameCount                  = 0;
+    std::chrono::steady_clock::time_point lastFrame                 = {};
+    std::vector<double>                 frameTimes                  = {};   // milliseconds
+};
@@ -0,0 +1,341 @@
+#include "pch.h"
+#include "FrameWriter.h"
+
+static bool isBGRA(VkFormat format)
+{
+    return format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_B8G8R8A8_UNORM;
+}
+
+/// <summary>
+/// Converts 4 byte pixels to tightly packed RGB rows, each prefixed with filterBytes zero bytes (the PNG filter type).
+/// </summary>
+static std::vector<uint8_t> toRGB(const CapturedFrame& frame, size_t filterBytes)
+{
+    const size_t rowSize = filterBytes + static_cast<size_t>(frame.width) * 3;
+    std::vector<uint8_t> rgb(rowSize * frame.height);
+
+    const size_t red = isBGRA(frame.format) ? 2 : 0;
+    const size_t blue = isBGRA(frame.format) ? 0 : 2;
+
+    for(uint32_t y = 0; y < frame.height; ++y)
+    {
+        const uint8_t* source = frame.pixels.data() + static_cast<size_t>(y) * frame.width * 4;
+        uint8_t* destination = rgb.data() + y * rowSize;
+
+        for(size_t i = 0; i < filterBytes; ++i)
+        {
+            *destination++ = 0;
+        }
+
+        for(uint32_t x = 0; x < frame.width; ++x, source += 4)
+        {
+            *destination++ = source[red];
+            *destination++ = source[1];
+            *destination++ = source[blue];
+        }
+    }
+
+    return rgb;
+}
+
+static uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+{
+    static const auto table = []
+    {
+        std::array<uint32_t, 256> table = {};
+        for(uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t value = i;
+            for(int bit = 0; bit < 8; ++bit)
+            {
+                value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            }
+            table[i] = value;
+        }
+        return table;
+    }();
+
+    crc = ~crc;
+    for(size_t i = 0; i < size; ++i)
+    {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void appendBigEndian(std::vector<uint8_t>& buffer, uint32_t value)
+{
+    buffer.push_back(static_cast<uint8_t>(value >> 24));
+    buffer.push_back(static_cast<uint8_t>(value >> 16));
+    buffer.push_back(static_cast<uint8_t>(value >> 8));
+    buffer.push_back(static_cast<uint8_t>(value));
+}
+
+static void writePNGChunk(std::ofstream& file, const char (&type)[5], const std::vector<uint8_t>& data)
+{
+    std::vector<uint8_t> chunk;
+    chunk.reserve(data.size() + 12);
+
+    appendBigEndian(chunk, static_cast<uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    appendBigEndian(chunk, crc32(chunk.data() + 4, data.size() + 4));
+
+    file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+}
+
+/// <summary>
+/// Writes an 8 bit RGB PNG. Image data is stored in uncompressed deflate blocks: encoding stays cheap and
+/// dependency free, which matters more for captures than file size.
+/// </summary>
+static void writePNG(std::ofstream& file, const CapturedFrame& frame)
+{
+    static const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    std::vector<uint8_t> header;
+    appendBigEndian(header, frame.width);
+    appendBigEndian(header, frame.height);
+    header.insert(header.end(), { 8, 2, 0, 0, 0 });     // bit depth, color type RGB, compression, filter, interlace
+    writePNGChunk(file, "IHDR", header);
+
+    const std::vector<uint8_t> rgb = toRGB(frame, 1);
+
+    const size_t MAX_BLOCK_SIZE = 65535;
+    std::vector<uint8_t> zlib;
+    zlib.reserve(rgb.size() + (rgb.size() / MAX_BLOCK_SIZE + 1) * 5 + 6);
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+
+    uint32_t adlerA = 1;
+    uint32_t adlerB = 0;
+    for(size_t offset = 0; offset < rgb.size() || offset == 0; offset += MAX_BLOCK_SIZE)
+    {
+        const size_t blockSize = std::min(MAX_BLOCK_SIZE, rgb.size() - offset);
+        const bool finalBlock = offset + blockSize == rgb.size();
+
+        zlib.push_back(finalBlock ? 1 : 0);
+        zlib.push_back(static_cast<uint8_t>(blockSize));
+        zlib.push_back(static_cast<uint8_t>(blockSize >> 8));
+        zlib.push_back(static_cast<uint8_t>(~blockSize));
+        zlib.push_back(static_cast<uint8_t>(~blockSize >> 8));
+        zlib.insert(zlib.end(), rgb.begin() + offset, rgb.begin() + offset + blockSize);
+
+        for(size_t i = offset; i < offset + blockSize; ++i)
+        {
+            adlerA = (adlerA + rgb[i]) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+        }
+
+        if(finalBlock)
+        {
+            break;
+        }
+    }
+    appendBigEndian(zlib, (adlerB << 16) | adlerA);
+
+    writePNGChunk(file, "IDAT", zlib);
+    writePNGChunk(file, "IEND", {});
+}
+
+static void writePPM(std::ofstream& file, const CapturedFrame& frame)
+{
+    file << "P6\n" << frame.width << " " << frame.height << "\n255\n";
+
+    const std::vector<uint8_t> rgb = toRGB(frame, 0);
+    file.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+}
+
+FrameWriter::FrameWriter(std::string directory, CaptureFormat format, size_t maxQueuedFrames, std::string namePrefix)
+    : directory(std::move(directory))
+    , format(format)
+    , maxQueuedFrames(maxQueuedFrames)
+    , namePrefix(std::move(namePrefix))
+{
+    std::filesystem::create_directories(this->directory);
+
+    writerThread = std::thread(&FrameWriter::write, this);
+}
+
+FrameWriter::~FrameWriter()
+{
+    stop();
+}
+
+/// <summary>
+/// Queues a frame for writing, returns false if it was dropped because the writer fell behind. With waitForSpace
+/// the caller blocks until the writer made room instead, frames are then only dropped once the writer stopped.
+/// </summary>
+bool FrameWriter::submit(CapturedFrame&& frame, bool waitForSpace)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        if(waitForSpace)
+        {
+            spaceCondition.wait(lock, [this] { return queue.size() < maxQueuedFrames || !running; });
+        }
+
+        if(!running || queue.size() >= maxQueuedFrames)
+        {
+            ++droppedFrames;
+            if(pixelBufferPool.size() < maxQueuedFrames)
+            {
+                pixelBufferPool.push_back(std::move(frame.pixels));
+            }
+            return false;
+        }
+
+        queue.push_back(std::move(frame));
+    }
+
+    queueCondition.notify_one();
+    return true;
+}
+
+std::vector<uint8_t> FrameWriter::acquirePixelBuffer(size_t size)
+{
+    std::vector<uint8_t> pixels;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!pixelBufferPool.empty())
+        {
+            pixels = std::move(pixelBufferPool.back());
+            pixelBufferPool.pop_back();
+        }
+    }
+
+    pixels.resize(size);
+    return pixels;
+}
+
+/// <summary>
+/// Writes every queued frame and joins the writer thread.
+/// </summary>
+void FrameWriter::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!running)
+        {
+            return;
+        }
+        running = false;
+    }
+
+    queueCondition.notify_one();
+    spaceCondition.notify_all();
+    writerThread.join();
+}
+
+void FrameWriter::write()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while(true)
+    {
+        queueCondition.wait(lock, [this] { return !queue.empty() || !running; });
+
+        if(queue.empty())
+        {
+            return;
+        }
+
+        CapturedFrame frame = std::move(queue.front());
+        queue.pop_front();
+
+        lock.unlock();
+        spaceCondition.notify_one();
+
+        std::ostringstream path;
+        path << directory << "/" << namePrefix << std::setw(6) << std::setfill('0') << frame.frameNumber << getExtension(format);
+
+        const auto writeStart = std::chrono::steady_clock::now();
+        bool written = true;
+        try
+        {
+            writeFile(path.str(), format, frame);
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << e.what() << std::endl;
+            written = false;
+        }
+        const auto writeEnd = std::chrono::steady_clock::now();
+
+        lock.lock();
+
+        writeTime += writeEnd - writeStart;
+        if(written)
+        {
+            ++writtenFrames;
+            writtenBytes += frame.pixels.size();
+        }
+        else
+        {
+            ++failedFrames;
+        }
+
+        if(pixelBufferPool.size() < maxQueuedFrames)
+        {
+            pixelBufferPool.push_back(std::move(frame.pixels));
+        }
+    }
+}
+
+void FrameWriter::writeFile(const std::string& path, CaptureFormat format, const CapturedFrame& frame)
+{
+    std::ofstream file(path, std::ios::binary);
+    if(!file.is_open())
+    {
+        throw std::runtime_error("FrameWriter: Failed to open " + path + "!");
+    }
+
+    switch(format)
+    {
+    case CaptureFormat::PNG:
+        writePNG(file, frame);
+        break;
+    case CaptureFormat::PPM:
+        writePPM(file, frame);
+        break;
+    case CaptureFormat::Raw:
+        file.write(reinterpret_cast<const char*>(frame.pixels.data()), frame.pixels.size());
+        break;
+    }
+
+    if(!file)
+    {
+        throw std::runtime_error("FrameWriter: Failed to write " + path + "!");
+    }
+}
+
+/// <summary>
+/// Returns the frame as tightly packed 8 bit RGB rows, the alpha channel is dropped.
+/// </summary>
+std::vector<uint8_t> FrameWriter::convertToRGB(const CapturedFrame& frame)
+{
+    return toRGB(frame, 0);
+}
+
+const char* FrameWriter::getExtension(CaptureFormat format)
+{
+    switch(format)
+    {
+    case CaptureFormat::PNG:    return ".png";
+    case CaptureFormat::PPM:    return ".ppm";
+    case CaptureFormat::Raw:    return ".raw";
+    default:                    return "";
+    }
+}
+
+void FrameWriter::printStatistics(std::ostream& stream) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    stream << "FrameWriter: " << writtenFrames << " frames written to " << directory << ", " << droppedFrames << " dropped, "
+           << failedFrames << " failed, " << (writtenFrames > 0 ? writeTime.count() * 1000.0 / static_cast<double>(writtenFrames) : 0.0)
+           << " ms per frame, " << (writeTime.count() > 0.0 ? static_cast<double>(writtenBytes) / (1024.0 * 1024.0) / writeTime.count() : 0.0)
+           << " MiB/s\n";
+}
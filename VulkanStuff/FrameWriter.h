@@ -0,0 +1,71 @@
+#pragma once
+
+enum class CaptureFormat
+{
+    PNG,
+    PPM,
+    Raw
+};
+
+/// <summary>
+/// Pixels of a frame copied back from the GPU. Rows are tightly packed, 4 bytes per pixel in the layout given by format.
+/// </summary>
+struct CapturedFrame
+{
+    uint64_t                            frameNumber                 = 0;
+    uint32_t                            width                       = 0;
+    uint32_t                            height                      = 0;
+    VkFormat                            format                      = VK_FORMAT_UNDEFINED;
+    std::vector<uint8_t>                pixels                      = {};
+};
+
+/// <summary>
+/// Writes captured frames to disk on a background thread.
+///
+/// The render loop only moves the frame into a bounded queue, encoding and file I/O happen on the writer thread.
+/// When the queue is full the frame is dropped and counted instead of blocking rendering, unless the caller asks to
+/// wait for space. Pixel buffers are recycled once written, so steady state capture does not allocate.
+/// </summary>
+class FrameWriter
+{
+public:
+                                        FrameWriter(std::string directory, CaptureFormat format, size_t maxQueuedFrames = 8,
+                                                    std::string namePrefix = "frame_");
+                                        ~FrameWriter();
+
+                                        FrameWriter(const FrameWriter&) = delete;
+    FrameWriter&                        operator=(const FrameWriter&) = delete;
+
+    bool                                submit(CapturedFrame&& frame, bool waitForSpace = false);
+    std::vector<uint8_t>                acquirePixelBuffer(size_t size);
+    void                                stop();
+    void                                printStatistics(std::ostream& stream)                                                   const;
+
+    static void                         writeFile(const std::string& path, CaptureFormat format, const CapturedFrame& frame);
+    static std::vector<uint8_t>         convertToRGB(const CapturedFrame& frame);
+    static const char*                  getExtension(CaptureFormat format);
+
+private:
+    const std::string                   directory;
+    const CaptureFormat                 format;
+    const size_t                        maxQueuedFrames;
+    const std::string                   namePrefix;                 // files are named prefix, frame number, extension
+
+    mutable std::mutex                  mutex;
+    std::condition_variable             queueCondition;
+    std::condition_variable             spaceCondition;             // signaled when the writer takes a frame
+    std::deque<CapturedFrame>           queue                       = {};
+    std::vector<std::vector<uint8_t>>   pixelBufferPool             = {};
+    bool                                running                     = true;
+
+    std::thread                         writerThread;
+
+    //Statistics
+    uint64_t                            writtenFrames               = 0;
+    uint64_t                            droppedFrames               = 0;
+    uint64_t                            failedFrames                = 0;
+    uint64_t                            writtenBytes                = 0;
+    std::chrono::duration<double>       writeTime                   = {};
+
+    void                                write();
+};
@@ -0,0 +1,168 @@
+#include "pch.h"
+#include "GoldenImage.h"
+
+/// <summary>
+/// Reads a binary (P6) PPM with 8 bit channels into tightly packed RGB rows.
+/// </summary>
+static bool readPPM(const std::string& path, uint32_t& width, uint32_t& height, std::vector<uint8_t>& rgb)
+{
+    std::ifstream file(path, std::ios::binary);
+    if(!file.is_open())
+    {
+        return false;
+    }
+
+    std::string magic;
+    uint32_t maxValue = 0;
+    file >> magic >> width >> height >> maxValue;
+    file.get();     // single whitespace after the header
+
+    if(!file || magic != "P6" || maxValue != 255)
+    {
+        return false;
+    }
+
+    rgb.resize(static_cast<size_t>(width) * height * 3);
+    file.read(reinterpret_cast<char*>(rgb.data()), rgb.size());
+
+    return static_cast<bool>(file);
+}
+
+static void writeRGB(const std::string& path, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgb)
+{
+    std::ofstream file(path, std::ios::binary);
+    file << "P6\n" << width << " " << height << "\n255\n";
+    file.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+}
+
+GoldenImageComparator::GoldenImageComparator(std::string directory, bool update, uint32_t tolerance, double maxFailingPixels)
+    : directory(std::move(directory))
+    , update(update)
+    , tolerance(tolerance)
+    , maxFailingPixels(maxFailingPixels)
+{
+    std::filesystem::create_directories(this->directory);
+}
+
+std::string GoldenImageComparator::getPath(const std::string& directory, uint64_t frameNumber, const char* suffix) const
+{
+    std::ostringstream path;
+    path << directory << "/frame_" << std::setw(6) << std::setfill('0') << frameNumber << suffix;
+    return path.str();
+}
+
+void GoldenImageComparator::compare(const CapturedFrame& frame)
+{
+    Result result = {};
+    result.frameNumber = frame.frameNumber;
+
+    const std::string goldenPath = getPath(directory, frame.frameNumber, ".ppm");
+
+    if(update)
+    {
+        FrameWriter::writeFile(goldenPath, CaptureFormat::PPM, frame);
+
+        result.passed = true;
+        result.reason = "golden image updated";
+
+        std::lock_guard<std::mutex> lock(mutex);
+        results.push_back(result);
+        return;
+    }
+
+    const std::vector<uint8_t> actual = FrameWriter::convertToRGB(frame);
+
+    uint32_t goldenWidth = 0;
+    uint32_t goldenHeight = 0;
+    std::vector<uint8_t> golden;
+
+    if(!readPPM(goldenPath, goldenWidth, goldenHeight, golden))
+    {
+        result.reason = "missing golden image " + goldenPath;
+    }
+    else if(goldenWidth != frame.width || goldenHeight != frame.height)
+    {
+        result.reason = "size mismatch, golden " + std::to_string(goldenWidth) + "x" + std::to_string(goldenHeight);
+    }
+    else
+    {
+        std::vector<uint8_t> difference(actual.size());
+        size_t failingPixelCount = 0;
+        double squaredError = 0.0;
+
+        for(size_t pixel = 0; pixel < actual.size(); pixel += 3)
+        {
+            uint32_t pixelDifference = 0;
+            for(size_t channel = pixel; channel < pixel + 3; ++channel)
+            {
+                const int channelDifference = std::abs(static_cast<int>(actual[channel]) - static_cast<int>(golden[channel]));
+                pixelDifference = std::max(pixelDifference, static_cast<uint32_t>(channelDifference));
+                squaredError += static_cast<double>(channelDifference * channelDifference);
+            }
+
+            if(pixelDifference > tolerance)
+            {
+                ++failingPixelCount;
+            }
+
+            // Failing pixels are red in the difference image, the others show the scaled difference.
+            difference[pixel] = pixelDifference > tolerance ? 255 : static_cast<uint8_t>(std::min(255u, pixelDifference * 16));
+            difference[pixel + 1] = pixelDifference > tolerance ? 0 : difference[pixel];
+            difference[pixel + 2] = difference[pixel + 1];
+
+            result.maxDifference = std::max(result.maxDifference, pixelDifference);
+        }
+
+        const size_t pixelCount = std::max<size_t>(actual.size() / 3, 1);
+        const double meanSquaredError = squaredError / static_cast<double>(actual.size() > 0 ? actual.size() : 1);
+
+        result.failingPixels = static_cast<double>(failingPixelCount) / static_cast<double>(pixelCount);
+        result.psnr = meanSquaredError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) : std::numeric_limits<double>::infinity();
+        result.passed = result.failingPixels <= maxFailingPixels;
+
+        if(!result.passed)
+        {
+            result.reason = "pixels outside tolerance";
+
+            const std::string failedDirectory = directory + "/failed";
+            std::filesystem::create_directories(failedDirectory);
+            writeRGB(getPath(failedDirectory, frame.frameNumber, ".actual.ppm"), frame.width, frame.height, actual);
+            writeRGB(getPath(failedDirectory, frame.frameNumber, ".diff.ppm"), frame.width, frame.height, difference);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    results.push_back(result);
+}
+
+/// <summary>
+/// A run without any compared frame fails, it usually means the frame count or capture interval are wrong.
+/// </summary>
+bool GoldenImageComparator::passed() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return !results.empty() && std::all_of(results.begin(), results.end(), [](const Result& result) { return result.passed; });
+}
+
+void GoldenImageComparator::printResults(std::ostream& stream) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    stream << "GoldenImage: " << results.size() << " frame(s) against " << directory << ", tolerance " << tolerance
+           << ", max failing pixels " << maxFailingPixels * 100.0 << "%\n";
+
+    for(const auto& result : results)
+    {
+        stream << "    frame " << std::setw(6) << result.frameNumber << (result.passed ? "  PASS" : "  FAIL")
+               << "  failing " << result.failingPixels * 100.0 << "%  max difference " << result.maxDifference
+               << "  PSNR " << result.psnr << " dB";
+
+        if(!result.reason.empty())
+        {
+            stream << "  (" << result.reason << ")";
+        }
+
+        stream << "\n";
+    }
+}
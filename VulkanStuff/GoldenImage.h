@@ -0,0 +1,46 @@
+#pragma once
+#include "FrameWriter.h"
+
+/// <summary>
+/// Compares captured frames against golden images stored as binary PPM files named like the captures (frame_000010.ppm).
+///
+/// A pixel fails when any of its channels differs by more than the tolerance, a frame fails when the fraction of
+/// failing pixels exceeds maxFailingPixels. The tolerance absorbs rounding differences between drivers such as
+/// lavapipe and SwiftShader while still catching real rendering changes. The actual frame and a difference image
+/// of every failed comparison are written to the "failed" subdirectory of the golden directory.
+/// In update mode captured frames replace the golden images instead.
+///
+/// Tests/golden.sh on Linux, Tests/golden.bat or the GoldenTest target of the project on Windows render the
+/// deterministic scenes headless and compare them with the references in Tests/golden. References are frames of a
+/// lavapipe run with --update-golden, a missing reference fails the comparison.
+/// </summary>
+class GoldenImageComparator
+{
+public:
+    struct Result
+    {
+        uint64_t                        frameNumber                 = 0;
+        bool                            passed                      = false;
+        std::string                     reason                      = {};
+        double                          failingPixels               = 0.0;  // fraction of pixels outside the tolerance
+        uint32_t                        maxDifference               = 0;
+        double                          psnr                        = 0.0;
+    };
+
+                                        GoldenImageComparator(std::string directory, bool update, uint32_t tolerance, double maxFailingPixels);
+
+    void                                compare(const CapturedFrame& frame);
+    bool                                passed()                                                                                const;
+    void                                printResults(std::ostream& stream)                                                      const;
+
+private:
+    const std::string                   directory;
+    const bool                          update;
+    const uint32_t                      tolerance;
+    const double                        maxFailingPixels;
+
+    mutable std::mutex                  mutex;
+    std::vector<Result>                 results                     = {};
+
+    std::string                         getPath(const std::string& directory, uint64_t frameNumber, const char* suffix)        const;
+};
@@ -0,0 +1,247 @@
+#include "pch.h"
+#include "GpuResources.h"
+
+GpuResources::GpuResources(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                           MemoryBudgetMonitor* budgetMonitor, std::string owner)
+    : vkDevice(device)
+    , capabilities(capabilities)
+    , vkAllocator(allocator)
+    , budgetMonitor(budgetMonitor)
+    , owner(std::move(owner))
+{
+}
+
+void GpuResources::allocateBuffer(BufferAllocation& allocation, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags requiredFlags,
+                                  VkMemoryPropertyFlags preferredFlags) const
+{
+    VkBufferCreateInfo bufferCreateInfo
+    {
+        VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        nullptr,
+        NULL,
+        size,
+        usage,
+        VK_SHARING_MODE_EXCLUSIVE,
+        0,
+        nullptr
+    };
+
+    VkBuffer buffer = nullptr;
+    if(vkCreateBuffer(vkDevice, &bufferCreateInfo, vkAllocator, &buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error(owner + ": Failed to create buffer!");
+    }
+    allocation.buffer = UniqueBuffer(vkDevice, buffer, vkAllocator);
+
+    VkMemoryRequirements memoryRequirements = {};
+    vkGetBufferMemoryRequirements(vkDevice, buffer, &memoryRequirements);
+
+    const auto memoryTypeIndex = capabilities.findMemoryType(memoryRequirements.memoryTypeBits, requiredFlags, preferredFlags);
+    if(!memoryTypeIndex.has_value())
+    {
+        throw std::runtime_error(owner + ": No suitable memory type for buffer!");
+    }
+
+    VkMemoryAllocateInfo memoryAllocateInfo
+    {
+        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        nullptr,
+        memoryRequirements.size,
+        memoryTypeIndex.value()
+    };
+
+    VkDeviceMemory memory = nullptr;
+    if(vkAllocateMemory(vkDevice, &memoryAllocateInfo, vkAllocator, &memory) != VK_SUCCESS)
+    {
+        throw std::runtime_error(owner + ": Failed to allocate buffer memory!");
+    }
+    allocation.memory = UniqueDeviceMemory(vkDevice, memory, vkAllocator);
+    allocation.size = memoryRequirements.size;
+    allocation.memoryTypeIndex = memoryTypeIndex.value();
+
+    vkBindBufferMemory(vkDevice, buffer, memory, 0);
+
+    if(budgetMonitor != nullptr)
+    {
+        budgetMonitor->trackAllocation(allocation.memoryTypeIndex, allocation.size);
+    }
+}
+
+void GpuResources::releaseBuffer(BufferAllocation& allocation) const
+{
+    if(allocation.memory.get() != VK_NULL_HANDLE && budgetMonitor != nullptr)
+    {
+        budgetMonitor->trackFree(allocation.memoryTypeIndex, allocation.size);
+    }
+
+    allocation.buffer.reset();
+    allocation.memory.reset();
+    allocation.size = 0;
+}
+
+void GpuResources::mapBuffer(const BufferAllocation& allocation, void** mapped) const
+{
+    if(vkMapMemory(vkDevice, allocation.memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS)
+    {
+        throw std::runtime_error(owner + ": Failed to map buffer memory!");
+    }
+}
+
+/// <summary>
+/// Layout the cache returns for the reflected stages, the same a pipeline factory gets for them.
+/// </summary>
+const PipelineLayoutInfo& GpuResources::getPipelineLayout(const std::vector<std::vector<char>>& stageCode, PipelineLayoutCache& layoutCache) const
+{
+    std::vector<ShaderReflection> reflections;
+    std::vector<const ShaderReflection*> stages;
+    reflections.reserve(stageCode.size());
+    for(const auto& code : stageCode)
+    {
+        reflections.push_back(ShaderReflection::reflect(code));
+        stages.push_back(&reflections.back());
+    }
+
+    return layoutCache.getPipelineLayout(stages);
+}
+
+/// <summary>
+/// Pairs a pipeline the factory built from stageCode with its layout. The shaders may only use descriptor set 0 and
+/// a push constant block within the pushConstantSize bytes the caller pushes.
+/// </summary>
+ReflectedPipeline GpuResources::createPipeline(UniquePipeline pipeline, const std::vector<std::vector<char>>& stageCode, PipelineLayoutCache& layoutCache,
+                                               size_t pushConstantSize) const
+{
+    ReflectedPipeline result = {};
+    result.pipeline = std::move(pipeline);
+    result.layout = &getPipelineLayout(stageCode, layoutCache);
+
+    if(result.layout->setBindings.size() > 1)
+    {
+        throw std::runtime_error(owner + ": Shaders may only use descriptor set 0!");
+    }
+    for(const VkPushConstantRange& range : result.layout->pushConstantRanges)
+    {
+        if(range.offset + range.size > pushConstantSize)
+        {
+            throw std::runtime_error(owner + ": Push constant block of the shaders is larger than expected!");
+        }
+    }
+
+    return result;
+}
+
+UniqueDescriptorPool GpuResources::createDescriptorPool(uint32_t setCount, uint32_t storageBufferCount) const
+{
+    const VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBufferCount };
+    VkDescriptorPoolCreateInfo poolCreateInfo
+    {
+        VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        nullptr,
+        NULL,
+        setCount,
+        1,
+        &poolSize
+    };
+
+    VkDescriptorPool pool = nullptr;
+    if(vkCreateDescriptorPool(vkDevice, &poolCreateInfo, vkAllocator, &pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error(owner + ": Failed to create descriptor pool!");
+    }
+
+    return UniqueDescriptorPool(vkDevice, pool, vkAllocator);
+}
+
+/// <summary>
+/// Allocates the given set of the layout and points every binding the shaders declare at the buffer range
+/// bufferForBinding returns for it, which throws for bindings the caller does not know.
+/// </summary>
+VkDescriptorSet GpuResources::allocateDescriptorSet(VkDescriptorPool pool, const PipelineLayoutInfo& layout, uint32_t set,
+                                                    const BufferForBinding& bufferForBinding) const
+{
+    VkDescriptorSetAllocateInfo allocateInfo
+    {
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        nullptr,
+        pool,
+        1,
+        &layout.setLayouts[set]
+    };
+
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    if(vkAllocateDescriptorSets(vkDevice, &allocateInfo, &descriptorSet) != VK_SUCCESS)
+    {
+        throw std::runtime_error(owner + ": Failed to allocate descriptor set!");
+    }
+
+    const std::vector<VkDescriptorSetLayoutBinding>& bindings = layout.setBindings[set];
+
+    std::vector<VkDescriptorBufferInfo> bufferInfos;
+    bufferInfos.reserve(bindings.size());
+    std::vector<VkWriteDescriptorSet> writes;
+
+    for(const VkDescriptorSetLayoutBinding& binding : bindings)
+    {
+        if(binding.descriptorType != VK_DESCRIPTOR_TYPE_STORAGE_BUFFER || binding.descriptorCount != 1)
+        {
+            throw std::runtime_error(owner + ": Binding " + std::to_string(binding.binding) + " is not a single storage buffer!");
+        }
+
+        bufferInfos.push_back(bufferForBinding(binding.binding));
+        writes.push_back({ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, descriptorSet, binding.binding, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                           nullptr, &bufferInfos.back(), nullptr });
+    }
+
+    vkUpdateDescriptorSets(vkDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+    return descriptorSet;
+}
+
+/// <summary>
+/// Pushes the ranges the shaders of the pipeline declare from the constants at the same offsets.
+/// </summary>
+void GpuResources::pushConstants(VkCommandBuffer commandBuffer, const ReflectedPipeline& pipeline, const void* constants)
+{
+    for(const VkPushConstantRange& range : pipeline.layout->pushConstantRanges)
+    {
+        vkCmdPushConstants(commandBuffer, pipeline.layout->pipelineLayout, range.stageFlags, range.offset, range.size,
+                           static_cast<const uint8_t*>(constants) + range.offset);
+    }
+}
+
+void GpuResources::recordMemoryBarrier(VkCommandBuffer commandBuffer, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask,
+                                       VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask)
+{
+    VkMemoryBarrier barrier
+    {
+        VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        nullptr,
+        srcAccessMask,
+        dstAccessMask
+    };
+
+    vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+/// <summary>
+/// Barrier on the whole buffer. Queue families other than VK_QUEUE_FAMILY_IGNORED make it the release or acquire
+/// half of an ownership transfer.
+/// </summary>
+void GpuResources::recordBufferBarrier(VkCommandBuffer commandBuffer, VkBuffer buffer, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask,
+                                       VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, uint32_t srcQueueFamily, uint32_t dstQueueFamily)
+{
+    VkBufferMemoryBarrier barrier
+    {
+        VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        nullptr,
+        srcAccessMask,
+        dstAccessMask,
+        srcQueueFamily,
+        dstQueueFamily,
+        buffer,
+        0,
+        VK_WHOLE_SIZE
+    };
+
+    vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
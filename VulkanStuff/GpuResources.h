@@ -0,0 +1,69 @@
+#pragma once
+#include "DeviceCapabilities.h"
+#include "MemoryBudget.h"
+#include "PipelineLayoutCache.h"
+#include "VkHandle.h"
+
+/// <summary>
+/// Buffer with memory of its own, counted by the memory budget monitor from allocateBuffer to releaseBuffer.
+/// </summary>
+struct BufferAllocation
+{
+    UniqueDeviceMemory                  memory                      = {};
+    UniqueBuffer                        buffer                      = {};
+    VkDeviceSize                        size                        = 0;
+    uint32_t                            memoryTypeIndex             = 0;
+};
+
+/// <summary>
+/// Pipeline together with the cached layout the factory built it with.
+/// </summary>
+struct ReflectedPipeline
+{
+    UniquePipeline                      pipeline                    = {};
+    const PipelineLayoutInfo*           layout                      = nullptr;
+};
+
+/// <summary>
+/// Buffers, pipelines and descriptor sets of a component which renders or computes on its own, like the benchmark
+/// renderers and the batch processor.
+///
+/// Buffers get a dedicated allocation each and are reported to the budget monitor, if any. Pipelines come from a
+/// factory of the caller and are paired with the layout PipelineLayoutCache returns for the reflected stages, which
+/// is the one the factory used. Descriptor sets only hold single storage buffers, the caller names the buffer of
+/// every binding the shaders declare. Errors are reported with the name of the owning component.
+/// </summary>
+class GpuResources
+{
+public:
+    using BufferForBinding = std::function<VkDescriptorBufferInfo(uint32_t binding)>;
+
+                                        GpuResources(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                                                     MemoryBudgetMonitor* budgetMonitor, std::string owner);
+
+    void                                allocateBuffer(BufferAllocation& allocation, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags requiredFlags,
+                                                       VkMemoryPropertyFlags preferredFlags = 0)                                const;
+    void                                releaseBuffer(BufferAllocation& allocation)                                             const;
+    void                                mapBuffer(const BufferAllocation& allocation, void** mapped)                            const;
+
+    const PipelineLayoutInfo&           getPipelineLayout(const std::vector<std::vector<char>>& stageCode, PipelineLayoutCache& layoutCache) const;
+    ReflectedPipeline                   createPipeline(UniquePipeline pipeline, const std::vector<std::vector<char>>& stageCode, PipelineLayoutCache& layoutCache,
+                                                       size_t pushConstantSize)                                                 const;
+    UniqueDescriptorPool                createDescriptorPool(uint32_t setCount, uint32_t storageBufferCount)                    const;
+    VkDescriptorSet                     allocateDescriptorSet(VkDescriptorPool pool, const PipelineLayoutInfo& layout, uint32_t set,
+                                                              const BufferForBinding& bufferForBinding)                         const;
+
+    static void                         pushConstants(VkCommandBuffer commandBuffer, const ReflectedPipeline& pipeline, const void* constants);
+    static void                         recordMemoryBarrier(VkCommandBuffer commandBuffer, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask,
+                                                            VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask);
+    static void                         recordBufferBarrier(VkCommandBuffer commandBuffer, VkBuffer buffer, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask,
+                                                            VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask,
+                                                            uint32_t srcQueueFamily = VK_QUEUE_FAMILY_IGNORED, uint32_t dstQueueFamily = VK_QUEUE_FAMILY_IGNORED);
+
+private:
+    VkDevice                            vkDevice;
+    const PhysicalDeviceCapabilities&   capabilities;
+    const VkAllocationCallbacks*        vkAllocator;
+    MemoryBudgetMonitor*                budgetMonitor;
+    const std::string                   owner;
+};
@@ -0,0 +1,87 @@
+#include "pch.h"
+#include "GpuTimer.h"
+
+GpuTimer::GpuTimer(VkDevice device, const PhysicalDeviceCapabilities& capabilities, uint32_t queueFamilyIndex,
+                   const VkAllocationCallbacks* allocator, uint32_t slotCount)
+    : vkDevice(device)
+    , pending(slotCount, false)
+{
+    const uint32_t validBits = capabilities.queueFamilies[queueFamilyIndex].timestampValidBits;
+    if(validBits == 0 || capabilities.properties.limits.timestampPeriod <= 0.0f)
+    {
+        return;
+    }
+
+    VkQueryPoolCreateInfo queryPoolCreateInfo
+    {
+        VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        nullptr,
+        NULL,
+        VK_QUERY_TYPE_TIMESTAMP,
+        slotCount * 2,
+        NULL
+    };
+
+    VkQueryPool queryPool = nullptr;
+    if(vkCreateQueryPool(vkDevice, &queryPoolCreateInfo, allocator, &queryPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("GpuTimer: Failed to create query pool!");
+    }
+    vkQueryPool = UniqueQueryPool(vkDevice, queryPool, allocator);
+
+    timestampPeriod = capabilities.properties.limits.timestampPeriod;
+    timestampMask = validBits >= 64 ? UINT64_MAX : (uint64_t(1) << validBits) - 1;
+}
+
+bool GpuTimer::isSupported() const
+{
+    return vkQueryPool.get() != VK_NULL_HANDLE;
+}
+
+/// <summary>
+/// Must be recorded outside of a render pass, the queries of the slot are reset first.
+/// </summary>
+void GpuTimer::begin(VkCommandBuffer commandBuffer, uint32_t slot)
+{
+    if(!isSupported())
+    {
+        return;
+    }
+
+    vkCmdResetQueryPool(commandBuffer, vkQueryPool, slot * 2, 2);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, vkQueryPool, slot * 2);
+}
+
+void GpuTimer::end(VkCommandBuffer commandBuffer, uint32_t slot)
+{
+    if(!isSupported())
+    {
+        return;
+    }
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, vkQueryPool, slot * 2 + 1);
+    pending[slot] = true;
+}
+
+/// <summary>
+/// Returns the milliseconds between begin and end of the slot. Must only be called after the fence of the frame
+/// which recorded the slot was signaled.
+/// </summary>
+std::optional<double> GpuTimer::collect(uint32_t slot)
+{
+    if(!pending[slot])
+    {
+        return std::nullopt;
+    }
+
+    pending[slot] = false;
+
+    uint64_t timestamps[2] = {};
+    if(vkGetQueryPoolResults(vkDevice, vkQueryPool, slot * 2, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+    {
+        return std::nullopt;
+    }
+
+    const uint64_t ticks = (timestamps[1] - timestamps[0]) & timestampMask;
+    return static_cast<double>(ticks) * timestampPeriod / 1.0e6;
+}
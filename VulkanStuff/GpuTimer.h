@@ -0,0 +1,32 @@
+#pragma once
+#include "DeviceCapabilities.h"
+#include "VkHandle.h"
+
+/// <summary>
+/// Measures the GPU time of command buffers with a pair of timestamp queries per slot.
+///
+/// Like FrameReadback every frame in flight owns a slot, the results are read without waiting once the render
+/// loop waited for the frame fence anyway. Devices or queue families without timestamp support leave the timer
+/// disabled, begin and end then record nothing and collect returns no value.
+/// </summary>
+class GpuTimer
+{
+public:
+                                        GpuTimer(VkDevice device, const PhysicalDeviceCapabilities& capabilities, uint32_t queueFamilyIndex,
+                                                 const VkAllocationCallbacks* allocator, uint32_t slotCount);
+
+                                        GpuTimer(const GpuTimer&) = delete;
+    GpuTimer&                           operator=(const GpuTimer&) = delete;
+
+    bool                                isSupported()                                                                           const;
+    void                                begin(VkCommandBuffer commandBuffer, uint32_t slot);
+    void                                end(VkCommandBuffer commandBuffer, uint32_t slot);
+    std::optional<double>               collect(uint32_t slot);
+
+private:
+    VkDevice                            vkDevice;
+    UniqueQueryPool                     vkQueryPool                 = {};
+    double                              timestampPeriod             = 0.0;  // nanoseconds per tick
+    uint64_t                            timestampMask               = 0;
+    std::vector<bool>                   pending                     = {};
+};
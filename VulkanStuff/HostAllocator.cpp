@@ -0,0 +1,300 @@
+#include "pch.h"
+#include "HostAllocator.h"
+
+static const char* getScopeName(size_t scope)
+{
+    switch(scope)
+    {
+    case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND:     return "command";
+    case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT:      return "object";
+    case VK_SYSTEM_ALLOCATION_SCOPE_CACHE:       return "cache";
+    case VK_SYSTEM_ALLOCATION_SCOPE_DEVICE:      return "device";
+    case VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE:    return "instance";
+    default:                                     return "unknown";
+    }
+}
+
+static uintptr_t alignUp(uintptr_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+}
+
+HostAllocator::HostAllocator(size_t commandArenaBlockSize)
+    : commandArenaBlockSize(commandArenaBlockSize)
+{
+    callbacks =
+    {
+        this,
+        &HostAllocator::allocationCallback,
+        &HostAllocator::reallocationCallback,
+        &HostAllocator::freeCallback,
+        &HostAllocator::internalAllocationCallback,
+        &HostAllocator::internalFreeCallback
+    };
+}
+
+HostAllocator::~HostAllocator()
+{
+    const size_t leakedAllocations = scopeCounters[VK_SYSTEM_ALLOCATION_SCOPE_OBJECT].liveAllocations
+                                   + scopeCounters[VK_SYSTEM_ALLOCATION_SCOPE_CACHE].liveAllocations
+                                   + scopeCounters[VK_SYSTEM_ALLOCATION_SCOPE_DEVICE].liveAllocations
+                                   + scopeCounters[VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE].liveAllocations;
+
+    if(leakedAllocations > 0)
+    {
+        std::cerr << "HostAllocator: " << leakedAllocations << " allocations still alive on destruction" << std::endl;
+    }
+}
+
+const VkAllocationCallbacks* HostAllocator::getCallbacks() const
+{
+    return &callbacks;
+}
+
+HostAllocator::AllocationHeader* HostAllocator::getHeader(void* memory)
+{
+    return reinterpret_cast<AllocationHeader*>(static_cast<uint8_t*>(memory) - sizeof(AllocationHeader));
+}
+
+void HostAllocator::updatePeak(std::atomic<size_t>& peak, size_t value)
+{
+    size_t currentPeak = peak.load(std::memory_order_relaxed);
+    while(value > currentPeak && !peak.compare_exchange_weak(currentPeak, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+void HostAllocator::trackAllocation(VkSystemAllocationScope scope, size_t size)
+{
+    ScopeCounters& counters = scopeCounters[scope];
+
+    updatePeak(counters.peakBytes, counters.currentBytes.fetch_add(size, std::memory_order_relaxed) + size);
+    counters.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+    counters.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    updatePeak(totalPeakBytes, totalCurrentBytes.fetch_add(size, std::memory_order_relaxed) + size);
+}
+
+void HostAllocator::trackFree(VkSystemAllocationScope scope, size_t size)
+{
+    ScopeCounters& counters = scopeCounters[scope];
+
+    counters.currentBytes.fetch_sub(size, std::memory_order_relaxed);
+    counters.liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+
+    totalCurrentBytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Every allocation is preceded by a header storing its size and scope, which are needed by free and realloc.
+/// The header sits right before the aligned pointer handed to the driver.
+/// </summary>
+void* HostAllocator::allocate(size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+    if(size == 0)
+    {
+        return nullptr;
+    }
+
+    alignment = std::max(alignment, alignof(AllocationHeader));
+
+    void* base = nullptr;
+    uint8_t* memory = nullptr;
+
+    // Large command allocations would waste most of an arena block, they go straight to the system allocator.
+    if(scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND && size + alignment + sizeof(AllocationHeader) <= commandArenaBlockSize / 4)
+    {
+        memory = static_cast<uint8_t*>(allocateFromArena(size + sizeof(AllocationHeader), alignment));
+    }
+    else
+    {
+        base = std::malloc(size + alignment + sizeof(AllocationHeader));
+        if(base == nullptr)
+        {
+            return nullptr;
+        }
+
+        memory = reinterpret_cast<uint8_t*>(alignUp(reinterpret_cast<uintptr_t>(base) + sizeof(AllocationHeader), alignment));
+    }
+
+    AllocationHeader* header = getHeader(memory);
+    header->base = base;
+    header->size = size;
+    header->scope = scope;
+
+    trackAllocation(scope, size);
+
+    return memory;
+}
+
+void* HostAllocator::reallocate(void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+    if(original == nullptr)
+    {
+        return allocate(size, alignment, scope);
+    }
+
+    if(size == 0)
+    {
+        free(original);
+        return nullptr;
+    }
+
+    void* memory = allocate(size, alignment, scope);
+    if(memory == nullptr)
+    {
+        // The original allocation stays valid when reallocation fails.
+        return nullptr;
+    }
+
+    std::memcpy(memory, original, std::min(size, getHeader(original)->size));
+    free(original);
+
+    return memory;
+}
+
+void HostAllocator::free(void* memory)
+{
+    if(memory == nullptr)
+    {
+        return;
+    }
+
+    const AllocationHeader header = *getHeader(memory);
+
+    trackFree(header.scope, header.size);
+
+    if(header.base != nullptr)
+    {
+        std::free(header.base);
+    }
+    else
+    {
+        releaseToArena();
+    }
+}
+
+/// <summary>
+/// Returns memory for an allocation of the given size (header included) whose end is aligned, so the user pointer
+/// following the header is aligned as well. New blocks are only created when all existing blocks are exhausted.
+/// </summary>
+void* HostAllocator::allocateFromArena(size_t size, size_t alignment)
+{
+    std::lock_guard<std::mutex> lock(arenaMutex);
+
+    while(true)
+    {
+        if(arenaCurrentBlock == arenaBlocks.size())
+        {
+            arenaBlocks.push_back({ std::make_unique<uint8_t[]>(commandArenaBlockSize), commandArenaBlockSize, 0 });
+        }
+
+        ArenaBlock& block = arenaBlocks[arenaCurrentBlock];
+
+        const uintptr_t blockStart = reinterpret_cast<uintptr_t>(block.memory.get());
+        const uintptr_t userPointer = alignUp(blockStart + block.offset + sizeof(AllocationHeader), alignment);
+        const size_t end = static_cast<size_t>(userPointer - blockStart) + size - sizeof(AllocationHeader);
+
+        if(end <= block.size)
+        {
+            block.offset = end;
+            ++arenaLiveAllocations;
+
+            size_t usedBytes = 0;
+            for(size_t i = 0; i <= arenaCurrentBlock; ++i)
+            {
+                usedBytes += arenaBlocks[i].offset;
+            }
+            arenaPeakBytes = std::max(arenaPeakBytes, usedBytes);
+
+            return reinterpret_cast<void*>(userPointer);
+        }
+
+        ++arenaCurrentBlock;
+    }
+}
+
+/// <summary>
+/// Command scope allocations are not reclaimed one by one. Once the last live allocation of the arena is freed
+/// the whole arena is rewound, keeping its blocks for the next commands.
+/// </summary>
+void HostAllocator::releaseToArena()
+{
+    std::lock_guard<std::mutex> lock(arenaMutex);
+
+    if(--arenaLiveAllocations == 0)
+    {
+        for(auto& block : arenaBlocks)
+        {
+            block.offset = 0;
+        }
+
+        arenaCurrentBlock = 0;
+        ++arenaResets;
+    }
+}
+
+HostAllocator::ScopeStatistics HostAllocator::getStatistics(VkSystemAllocationScope scope) const
+{
+    const ScopeCounters& counters = scopeCounters[scope];
+
+    ScopeStatistics statistics = {};
+    statistics.currentBytes = counters.currentBytes.load();
+    statistics.peakBytes = counters.peakBytes.load();
+    statistics.liveAllocations = counters.liveAllocations.load();
+    statistics.totalAllocations = counters.totalAllocations.load();
+
+    return statistics;
+}
+
+size_t HostAllocator::getPeakBytes() const
+{
+    return totalPeakBytes.load();
+}
+
+void HostAllocator::printStatistics(std::ostream& stream) const
+{
+    stream << "HostAllocator: current " << totalCurrentBytes.load() << " bytes, high-water mark " << totalPeakBytes.load() << " bytes\n";
+
+    for(size_t scope = 0; scope < SCOPE_COUNT; ++scope)
+    {
+        const ScopeStatistics statistics = getStatistics(static_cast<VkSystemAllocationScope>(scope));
+
+        stream << "    " << std::left << std::setw(10) << getScopeName(scope) << std::right
+               << " current " << std::setw(10) << statistics.currentBytes
+               << " peak " << std::setw(10) << statistics.peakBytes
+               << " live " << std::setw(6) << statistics.liveAllocations
+               << " total " << std::setw(8) << statistics.totalAllocations << "\n";
+    }
+
+    std::lock_guard<std::mutex> lock(arenaMutex);
+    stream << "    command arena: " << arenaBlocks.size() << " x " << commandArenaBlockSize << " byte blocks, peak "
+           << arenaPeakBytes << " bytes, " << arenaResets << " bulk releases\n";
+    stream << "    internal (driver reported): current " << internalCurrentBytes.load() << " bytes, peak " << internalPeakBytes.load() << " bytes\n";
+}
+
+VKAPI_ATTR void* VKAPI_CALL HostAllocator::allocationCallback(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope allocationScope)
+{
+    return static_cast<HostAllocator*>(pUserData)->allocate(size, alignment, allocationScope);
+}
+
+VKAPI_ATTR void* VKAPI_CALL HostAllocator::reallocationCallback(void* pUserData, void* pOriginal, size_t size, size_t alignment, VkSystemAllocationScope allocationScope)
+{
+    return static_cast<HostAllocator*>(pUserData)->reallocate(pOriginal, size, alignment, allocationScope);
+}
+
+VKAPI_ATTR void VKAPI_CALL HostAllocator::freeCallback(void* pUserData, void* pMemory)
+{
+    static_cast<HostAllocator*>(pUserData)->free(pMemory);
+}
+
+VKAPI_ATTR void VKAPI_CALL HostAllocator::internalAllocationCallback(void* pUserData, size_t size, VkInternalAllocationType, VkSystemAllocationScope)
+{
+    HostAllocator* allocator = static_cast<HostAllocator*>(pUserData);
+    updatePeak(allocator->internalPeakBytes, allocator->internalCurrentBytes.fetch_add(size, std::memory_order_relaxed) + size);
+}
+
+VKAPI_ATTR void VKAPI_CALL HostAllocator::internalFreeCallback(void* pUserData, size_t size, VkInternalAllocationType, VkSystemAllocationScope)
+{
+    static_cast<HostAllocator*>(pUserData)->internalCurrentBytes.fetch_sub(size, std::memory_order_relaxed);
+}
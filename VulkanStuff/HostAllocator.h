@@ -0,0 +1,94 @@
+#pragma once
+
+/// <summary>
+/// VkAllocationCallbacks implementation which accounts every host allocation made by the driver.
+///
+/// Bytes and allocation counts are tracked per VkSystemAllocationScope together with their high-water marks.
+/// VK_SYSTEM_ALLOCATION_SCOPE_COMMAND allocations only live for the duration of a single Vulkan command, so they
+/// are served from a bump allocated arena which is released in bulk once every command allocation was freed.
+/// All callbacks are thread safe, the driver may call them from any thread that makes Vulkan calls.
+/// </summary>
+class HostAllocator
+{
+public:
+    static constexpr size_t             SCOPE_COUNT                 = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+    struct ScopeStatistics
+    {
+        size_t                          currentBytes                = 0;
+        size_t                          peakBytes                   = 0;
+        size_t                          liveAllocations             = 0;
+        size_t                          totalAllocations            = 0;
+    };
+
+                                        HostAllocator(size_t commandArenaBlockSize = 256 * 1024);
+                                        ~HostAllocator();
+
+                                        HostAllocator(const HostAllocator&) = delete;
+    HostAllocator&                      operator=(const HostAllocator&) = delete;
+
+    const VkAllocationCallbacks*        getCallbacks()                                                                          const;
+    ScopeStatistics                     getStatistics(VkSystemAllocationScope scope)                                            const;
+    size_t                              getPeakBytes()                                                                          const;
+    void                                printStatistics(std::ostream& stream)                                                   const;
+
+private:
+    struct AllocationHeader
+    {
+        void*                           base;       // start of the system allocation, nullptr for arena allocations
+        size_t                          size;
+        VkSystemAllocationScope         scope;
+    };
+
+    struct ScopeCounters
+    {
+        std::atomic<size_t>             currentBytes                = 0;
+        std::atomic<size_t>             peakBytes                   = 0;
+        std::atomic<size_t>             liveAllocations             = 0;
+        std::atomic<size_t>             totalAllocations            = 0;
+    };
+
+    struct ArenaBlock
+    {
+        std::unique_ptr<uint8_t[]>      memory;
+        size_t                          size;
+        size_t                          offset;
+    };
+
+    VkAllocationCallbacks               callbacks                   = {};
+    ScopeCounters                       scopeCounters[SCOPE_COUNT];
+    std::atomic<size_t>                 totalCurrentBytes           = 0;
+    std::atomic<size_t>                 totalPeakBytes              = 0;
+
+    //Internal allocations reported by the driver through notifications
+    std::atomic<size_t>                 internalCurrentBytes        = 0;
+    std::atomic<size_t>                 internalPeakBytes           = 0;
+
+    //Command Arena
+    const size_t                        commandArenaBlockSize;
+    mutable std::mutex                  arenaMutex;
+    std::vector<ArenaBlock>             arenaBlocks                 = {};
+    size_t                              arenaCurrentBlock           = 0;
+    size_t                              arenaLiveAllocations        = 0;
+    size_t                              arenaResets                 = 0;
+    size_t                              arenaPeakBytes              = 0;
+
+    void*                               allocate(size_t size, size_t alignment, VkSystemAllocationScope scope);
+    void*                               reallocate(void* original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+    void                                free(void* memory);
+
+    void*                               allocateFromArena(size_t size, size_t alignment);
+    void                                releaseToArena();
+
+    void                                trackAllocation(VkSystemAllocationScope scope, size_t size);
+    void                                trackFree(VkSystemAllocationScope scope, size_t size);
+
+    static void                         updatePeak(std::atomic<size_t>& peak, size_t value);
+    static AllocationHeader*            getHeader(void* memory);
+
+    static VKAPI_ATTR void* VKAPI_CALL  allocationCallback(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope allocationScope);
+    static VKAPI_ATTR void* VKAPI_CALL  reallocationCallback(void* pUserData, void* pOriginal, size_t size, size_t alignment, VkSystemAllocationScope allocationScope);
+    static VKAPI_ATTR void VKAPI_CALL   freeCallback(void* pUserData, void* pMemory);
+    static VKAPI_ATTR void VKAPI_CALL   internalAllocationCallback(void* pUserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope allocationScope);
+    static VKAPI_ATTR void VKAPI_CALL   internalFreeCallback(void* pUserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope allocationScope);
+};
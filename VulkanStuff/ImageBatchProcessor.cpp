@@ -0,0 +1,566 @@
+#include "pch.h"
+#include "ImageBatchProcessor.h"
+#include "MappedFile.h"
+
+// Descriptor bindings of set 0 declared by the batch shaders
+static constexpr uint32_t BINDING_INPUT             = 0;
+static constexpr uint32_t BINDING_RESIZED           = 1;
+static constexpr uint32_t BINDING_SHARPENED         = 2;
+static constexpr uint32_t BINDING_OUTPUT            = 3;
+
+// Inputs and outputs are RGBA8, the images between the kernels linear RGBA floats
+static constexpr VkDeviceSize PIXEL_SIZE            = 4;
+static constexpr VkDeviceSize FILTERED_PIXEL_SIZE   = 4 * sizeof(float);
+
+static constexpr float EXPOSURE                     = 1.0f;
+static constexpr float SHARPNESS                    = 0.25f;
+
+static void beginCommandBuffer(VkCommandBuffer commandBuffer)
+{
+    VkCommandBufferBeginInfo commandBufferBeginInfo
+    {
+        VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        nullptr,
+        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        nullptr
+    };
+
+    vkResetCommandBuffer(commandBuffer, 0);
+    if(vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo) != VK_SUCCESS)
+    {
+        throw std::runtime_error("ImageBatchProcessor: Failed to begin recording command buffer!");
+    }
+}
+
+static void endCommandBuffer(VkCommandBuffer commandBuffer)
+{
+    if(vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("ImageBatchProcessor: Failed to record command buffer!");
+    }
+}
+
+static bool isRGBA8(VkFormat format)
+{
+    return format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_R8G8B8A8_UNORM;
+}
+
+ImageBatchProcessor::ImageBatchProcessor(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                                         MemoryBudgetMonitor* budgetMonitor, PipelineLayoutCache& layoutCache, QueueSubmitter& queueSubmitter,
+                                         const Queues& queues, std::vector<DecodedAsset> sources, VkExtent2D outputExtent,
+                                         const Shaders& shaders, const ComputePipelineFactory& computePipelineFactory,
+                                         FrameWriter* writer)
+    : vkDevice(device)
+    , capabilities(capabilities)
+    , vkAllocator(allocator)
+    , resources(device, capabilities, allocator, budgetMonitor, "ImageBatchProcessor")
+    , queueSubmitter(queueSubmitter)
+    , queues(queues)
+    , sources(std::move(sources))
+    , outputExtent(outputExtent)
+    , writer(writer)
+{
+    if(this->sources.empty())
+    {
+        throw std::runtime_error("ImageBatchProcessor: No source images!");
+    }
+    if(outputExtent.width == 0 || outputExtent.height == 0)
+    {
+        throw std::runtime_error("ImageBatchProcessor: Output extent is empty!");
+    }
+
+    // Staging and input buffers are sized for the largest source
+    VkDeviceSize inputSize = 0;
+    for(const DecodedAsset& source : this->sources)
+    {
+        if(source.type != AssetType::Texture || !isRGBA8(source.format) || source.levels.empty())
+        {
+            throw std::runtime_error("ImageBatchProcessor: Source images have to be RGBA8 textures!");
+        }
+        inputSize = std::max(inputSize, source.levels[0].size);
+    }
+
+    constants.outputWidth = outputExtent.width;
+    constants.outputHeight = outputExtent.height;
+    constants.exposure = EXPOSURE;
+    constants.sharpness = SHARPNESS;
+
+    resizePipeline = resources.createPipeline(computePipelineFactory(shaders.resize), { shaders.resize }, layoutCache, sizeof(PushConstants));
+    sharpenPipeline = resources.createPipeline(computePipelineFactory(shaders.sharpen), { shaders.sharpen }, layoutCache, sizeof(PushConstants));
+    toneMapPipeline = resources.createPipeline(computePipelineFactory(shaders.toneMap), { shaders.toneMap }, layoutCache, sizeof(PushConstants));
+
+    createCommandPools();
+    createSlots(inputSize);
+    createDescriptorSets();
+}
+
+ImageBatchProcessor::~ImageBatchProcessor()
+{
+    descriptorPool.reset();
+
+    for(Slot& slot : slots)
+    {
+        slot.readbackDone.reset();
+        slot.filteredOutput.reset();
+        slot.uploaded.reset();
+
+        resources.releaseBuffer(slot.output);
+        resources.releaseBuffer(slot.filtered[1]);
+        resources.releaseBuffer(slot.filtered[0]);
+        resources.releaseBuffer(slot.input);
+        resources.releaseBuffer(slot.readback);
+        resources.releaseBuffer(slot.staging);
+    }
+
+    transferCommandPool.reset();
+    computeCommandPool.reset();
+}
+
+/// <summary>
+/// Buffers are exclusive to one queue family at a time, with a separate transfer family they change hands twice per image.
+/// </summary>
+bool ImageBatchProcessor::transfersOwnership() const
+{
+    return queues.computeFamily != queues.transferFamily;
+}
+
+void ImageBatchProcessor::createCommandPools()
+{
+    // Command buffers are rerecorded for every image of their slot
+    VkCommandPoolCreateInfo commandPoolCreateInfo
+    {
+        VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        nullptr,
+        VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        queues.computeFamily
+    };
+
+    VkCommandPool commandPool = nullptr;
+    if(vkCreateCommandPool(vkDevice, &commandPoolCreateInfo, vkAllocator, &commandPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("ImageBatchProcessor: Failed to create compute command pool!");
+    }
+    computeCommandPool = UniqueCommandPool(vkDevice, commandPool, vkAllocator);
+
+    if(transfersOwnership())
+    {
+        commandPoolCreateInfo.queueFamilyIndex = queues.transferFamily;
+
+        if(vkCreateCommandPool(vkDevice, &commandPoolCreateInfo, vkAllocator, &commandPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("ImageBatchProcessor: Failed to create transfer command pool!");
+        }
+        transferCommandPool = UniqueCommandPool(vkDevice, commandPool, vkAllocator);
+    }
+}
+
+void ImageBatchProcessor::createSlots(VkDeviceSize inputSize)
+{
+    const VkDeviceSize outputPixels = static_cast<VkDeviceSize>(outputExtent.width) * outputExtent.height;
+    const VkCommandPool transferPool = transfersOwnership() ? transferCommandPool.get() : computeCommandPool.get();
+
+    const VkSemaphoreCreateInfo semaphoreCreateInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, nullptr, NULL };
+    const VkFenceCreateInfo fenceCreateInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, nullptr, NULL };
+
+    for(Slot& slot : slots)
+    {
+        // Read back results are read by the CPU pixel by pixel, cached memory keeps that fast
+        resources.allocateBuffer(slot.staging, inputSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        resources.allocateBuffer(slot.readback, outputPixels * PIXEL_SIZE, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+        resources.allocateBuffer(slot.input, inputSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        resources.allocateBuffer(slot.filtered[0], outputPixels * FILTERED_PIXEL_SIZE, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        resources.allocateBuffer(slot.filtered[1], outputPixels * FILTERED_PIXEL_SIZE, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        resources.allocateBuffer(slot.output, outputPixels * PIXEL_SIZE, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        void* mapped = nullptr;
+        resources.mapBuffer(slot.staging, &mapped);
+        slot.mappedStaging = static_cast<uint8_t*>(mapped);
+        resources.mapBuffer(slot.readback, &mapped);
+        slot.mappedReadback = static_cast<const uint8_t*>(mapped);
+
+        VkCommandBufferAllocateInfo commandBufferAllocateInfo
+        {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            nullptr,
+            computeCommandPool,
+            VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            1
+        };
+
+        if(vkAllocateCommandBuffers(vkDevice, &commandBufferAllocateInfo, &slot.computeCommandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("ImageBatchProcessor: Failed to allocate command buffers!");
+        }
+
+        VkCommandBuffer transferCommandBuffers[2] = {};
+        commandBufferAllocateInfo.commandPool = transferPool;
+        commandBufferAllocateInfo.commandBufferCount = 2;
+        if(vkAllocateCommandBuffers(vkDevice, &commandBufferAllocateInfo, transferCommandBuffers) != VK_SUCCESS)
+        {
+            throw std::runtime_error("ImageBatchProcessor: Failed to allocate command buffers!");
+        }
+        slot.uploadCommandBuffer = transferCommandBuffers[0];
+        slot.readbackCommandBuffer = transferCommandBuffers[1];
+
+        VkSemaphore semaphore = nullptr;
+        if(vkCreateSemaphore(vkDevice, &semaphoreCreateInfo, vkAllocator, &semaphore) != VK_SUCCESS)
+        {
+            throw std::runtime_error("ImageBatchProcessor: Failed to create semaphore!");
+        }
+        slot.uploaded = UniqueSemaphore(vkDevice, semaphore, vkAllocator);
+
+        if(vkCreateSemaphore(vkDevice, &semaphoreCreateInfo, vkAllocator, &semaphore) != VK_SUCCESS)
+        {
+            throw std::runtime_error("ImageBatchProcessor: Failed to create semaphore!");
+        }
+        slot.filteredOutput = UniqueSemaphore(vkDevice, semaphore, vkAllocator);
+
+        VkFence fence = nullptr;
+        if(vkCreateFence(vkDevice, &fenceCreateInfo, vkAllocator, &fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("ImageBatchProcessor: Failed to create fence!");
+        }
+        slot.readbackDone = UniqueFence(vkDevice, fence, vkAllocator);
+    }
+}
+
+void ImageBatchProcessor::createDescriptorSets()
+{
+    const ReflectedPipeline* pipelines[] = { &resizePipeline, &sharpenPipeline, &toneMapPipeline };
+
+    uint32_t setCount = 0;
+    uint32_t storageBufferCount = 0;
+    for(const ReflectedPipeline* pipeline : pipelines)
+    {
+        if(!pipeline->layout->setBindings.empty())
+        {
+            setCount += SLOT_COUNT;
+            storageBufferCount += SLOT_COUNT * static_cast<uint32_t>(pipeline->layout->setBindings[0].size());
+        }
+    }
+
+    if(setCount == 0)
+    {
+        return;
+    }
+
+    descriptorPool = resources.createDescriptorPool(setCount, storageBufferCount);
+
+    for(Slot& slot : slots)
+    {
+        for(uint32_t i = 0; i < 3; ++i)
+        {
+            slot.descriptorSets[i] = allocateDescriptorSet(*pipelines[i], slot);
+        }
+    }
+}
+
+/// <summary>
+/// Allocates set 0 of the pipeline and points every binding the shader declares at the buffer of the slot.
+/// </summary>
+VkDescriptorSet ImageBatchProcessor::allocateDescriptorSet(const ReflectedPipeline& pipeline, const Slot& slot)
+{
+    if(pipeline.layout->setBindings.empty())
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    return resources.allocateDescriptorSet(descriptorPool, *pipeline.layout, 0, [&slot](uint32_t binding) -> VkDescriptorBufferInfo
+    {
+        switch(binding)
+        {
+        case BINDING_INPUT:         return { slot.input.buffer, 0, VK_WHOLE_SIZE };
+        case BINDING_RESIZED:       return { slot.filtered[0].buffer, 0, VK_WHOLE_SIZE };
+        case BINDING_SHARPENED:     return { slot.filtered[1].buffer, 0, VK_WHOLE_SIZE };
+        case BINDING_OUTPUT:        return { slot.output.buffer, 0, VK_WHOLE_SIZE };
+        default:
+            throw std::runtime_error("ImageBatchProcessor: Shaders use unknown binding " + std::to_string(binding) + "!");
+        }
+    });
+}
+
+/// <summary>
+/// Processes imageCount images and returns once the last one is read back. Image i is source i modulo the number
+/// of sources, results are handed to the writer, if any, as frame i.
+/// </summary>
+void ImageBatchProcessor::process(uint32_t imageCount)
+{
+    const auto batchStart = std::chrono::steady_clock::now();
+
+    for(uint32_t i = 0; i < imageCount; ++i)
+    {
+        Slot& slot = slots[i % SLOT_COUNT];
+
+        // The slot was last used by image i - 2, whose readback was submitted with the upload of image i - 1
+        collect(slot);
+
+        const DecodedAsset& source = sources[i % sources.size()];
+        slot.imageIndex = i;
+        constants.inputWidth = source.levels[0].width;
+        constants.inputHeight = source.levels[0].height;
+
+        recordUpload(slot, source);
+        recordFilters(slot);
+        recordReadback(slot);
+
+        // The transfer queue gets the upload of this image ahead of the readback of the previous one, so the copy
+        // runs while the compute queue is still filtering the previous image.
+        queueSubmitter.addCommandBuffer(queues.transfer, slot.uploadCommandBuffer);
+        queueSubmitter.addSignal(queues.transfer, slot.uploaded);
+        queueSubmitter.addWait(queues.compute, slot.uploaded, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+        queueSubmitter.addCommandBuffer(queues.compute, slot.computeCommandBuffer);
+        queueSubmitter.addSignal(queues.compute, slot.filteredOutput);
+
+        if(i > 0)
+        {
+            Slot& previous = slots[(i - 1) % SLOT_COUNT];
+            queueSubmitter.addWait(queues.transfer, previous.filteredOutput, VK_PIPELINE_STAGE_TRANSFER_BIT);
+            queueSubmitter.addCommandBuffer(queues.transfer, previous.readbackCommandBuffer);
+            queueSubmitter.setFence(queues.transfer, previous.readbackDone);
+            previous.pending = true;
+        }
+
+        queueSubmitter.flush();
+    }
+
+    if(imageCount > 0)
+    {
+        Slot& last = slots[(imageCount - 1) % SLOT_COUNT];
+        queueSubmitter.addWait(queues.transfer, last.filteredOutput, VK_PIPELINE_STAGE_TRANSFER_BIT);
+        queueSubmitter.addCommandBuffer(queues.transfer, last.readbackCommandBuffer);
+        queueSubmitter.setFence(queues.transfer, last.readbackDone);
+        queueSubmitter.flush();
+        last.pending = true;
+    }
+
+    // The slot of the last image finishes last, collect the other one first to keep the results in order
+    for(uint32_t i = 0; i < SLOT_COUNT; ++i)
+    {
+        collect(slots[(imageCount + i) % SLOT_COUNT]);
+    }
+
+    batchTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count();
+}
+
+void ImageBatchProcessor::recordUpload(Slot& slot, const DecodedAsset& source)
+{
+    const TextureLevel& level = source.levels[0];
+
+    const auto stagingStart = std::chrono::steady_clock::now();
+    std::memcpy(slot.mappedStaging, source.getData() + level.offset, static_cast<size_t>(level.size));
+    stagingTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stagingStart).count();
+    inputBytes += level.size;
+
+    VkCommandBuffer commandBuffer = slot.uploadCommandBuffer;
+    beginCommandBuffer(commandBuffer);
+
+    const VkBufferCopy region = { 0, 0, level.size };
+    vkCmdCopyBuffer(commandBuffer, slot.staging.buffer, slot.input.buffer, 1, &region);
+
+    // Released to the compute family, recordFilters acquires it. Without a separate transfer family the semaphore
+    // between the submissions makes the copy visible.
+    if(transfersOwnership())
+    {
+        GpuResources::recordBufferBarrier(commandBuffer, slot.input.buffer, VK_ACCESS_TRANSFER_WRITE_BIT, 0,
+                                          VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queues.transferFamily, queues.computeFamily);
+    }
+
+    endCommandBuffer(commandBuffer);
+}
+
+void ImageBatchProcessor::recordFilters(Slot& slot)
+{
+    VkCommandBuffer commandBuffer = slot.computeCommandBuffer;
+    beginCommandBuffer(commandBuffer);
+
+    // Acquire matching the release of recordUpload, in the stage the upload semaphore is waited for
+    if(transfersOwnership())
+    {
+        GpuResources::recordBufferBarrier(commandBuffer, slot.input.buffer, 0, VK_ACCESS_SHADER_READ_BIT,
+                                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, queues.transferFamily, queues.computeFamily);
+    }
+
+    const uint32_t groupsX = (outputExtent.width + GROUP_SIZE - 1) / GROUP_SIZE;
+    const uint32_t groupsY = (outputExtent.height + GROUP_SIZE - 1) / GROUP_SIZE;
+
+    const ReflectedPipeline* pipelines[] = { &resizePipeline, &sharpenPipeline, &toneMapPipeline };
+    for(uint32_t i = 0; i < 3; ++i)
+    {
+        const ReflectedPipeline& pipeline = *pipelines[i];
+
+        if(i > 0)
+        {
+            GpuResources::recordMemoryBarrier(commandBuffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+        }
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+        if(slot.descriptorSets[i] != VK_NULL_HANDLE)
+        {
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout->pipelineLayout, 0, 1, &slot.descriptorSets[i], 0, nullptr);
+        }
+        GpuResources::pushConstants(commandBuffer, pipeline, &constants);
+        vkCmdDispatch(commandBuffer, groupsX, groupsY, 1);
+    }
+
+    if(transfersOwnership())
+    {
+        GpuResources::recordBufferBarrier(commandBuffer, slot.output.buffer, VK_ACCESS_SHADER_WRITE_BIT, 0,
+                                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queues.computeFamily, queues.transferFamily);
+    }
+
+    endCommandBuffer(commandBuffer);
+}
+
+void ImageBatchProcessor::recordReadback(Slot& slot)
+{
+    VkCommandBuffer commandBuffer = slot.readbackCommandBuffer;
+    beginCommandBuffer(commandBuffer);
+
+    if(transfersOwnership())
+    {
+        GpuResources::recordBufferBarrier(commandBuffer, slot.output.buffer, 0, VK_ACCESS_TRANSFER_READ_BIT,
+                                          VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, queues.computeFamily, queues.transferFamily);
+    }
+
+    const VkBufferCopy region = { 0, 0, static_cast<VkDeviceSize>(outputExtent.width) * outputExtent.height * PIXEL_SIZE };
+    vkCmdCopyBuffer(commandBuffer, slot.output.buffer, slot.readback.buffer, 1, &region);
+
+    GpuResources::recordMemoryBarrier(commandBuffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT);
+
+    endCommandBuffer(commandBuffer);
+}
+
+/// <summary>
+/// Waits for the readback of the slot, if one is pending, and hands the result to the writer. The slot can be
+/// recorded again afterwards.
+/// </summary>
+void ImageBatchProcessor::collect(Slot& slot)
+{
+    if(!slot.pending)
+    {
+        return;
+    }
+
+    const VkFence fence = slot.readbackDone;
+    const auto waitStart = std::chrono::steady_clock::now();
+    if(vkWaitForFences(vkDevice, 1, &fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS)
+    {
+        throw std::runtime_error("ImageBatchProcessor: Failed to wait for readback!");
+    }
+    waitTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+    vkResetFences(vkDevice, 1, &fence);
+
+    const size_t size = static_cast<size_t>(outputExtent.width) * outputExtent.height * PIXEL_SIZE;
+    if(writer != nullptr)
+    {
+        // Every result of a batch is wanted, the writer is waited for instead of dropping frames
+        CapturedFrame frame = {};
+        frame.frameNumber = slot.imageIndex;
+        frame.width = outputExtent.width;
+        frame.height = outputExtent.height;
+        frame.format = VK_FORMAT_R8G8B8A8_SRGB;
+        frame.pixels = writer->acquirePixelBuffer(size);
+        std::memcpy(frame.pixels.data(), slot.mappedReadback, size);
+        writer->submit(std::move(frame), true);
+    }
+
+    ++processedImages;
+    outputBytes += size;
+    slot.pending = false;
+}
+
+void ImageBatchProcessor::printStatistics(std::ostream& stream) const
+{
+    stream << "ImageBatchProcessor: " << processedImages << " images from " << sources.size() << " sources resized to "
+           << outputExtent.width << "x" << outputExtent.height << " on " << capabilities.properties.deviceName << ", compute family "
+           << queues.computeFamily << ", transfer family " << queues.transferFamily << (transfersOwnership() ? "" : " (shared)") << "\n";
+
+    if(processedImages > 0 && batchTime > 0.0)
+    {
+        const double images = static_cast<double>(processedImages);
+        const std::streamsize precision = stream.precision();
+        stream << std::fixed << std::setprecision(3)
+               << "    " << batchTime << " s, " << images / batchTime << " images per second, "
+               << static_cast<double>(inputBytes) / (1024.0 * 1024.0) / batchTime << " MiB/s uploaded, "
+               << static_cast<double>(outputBytes) / (1024.0 * 1024.0) / batchTime << " MiB/s read back\n"
+               << "    " << stagingTime / images << " ms per image copying into staging memory, "
+               << waitTime / images << " ms per image waiting for readbacks\n"
+               << std::defaultfloat << std::setprecision(precision);
+    }
+}
+
+/// <summary>
+/// Decodes the .ppm images of the directory in file name order.
+/// </summary>
+std::vector<DecodedAsset> ImageBatchProcessor::loadImages(const std::string& directory)
+{
+    std::vector<std::filesystem::path> paths;
+    for(const auto& entry : std::filesystem::directory_iterator(directory))
+    {
+        std::string extension = entry.path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+        if(entry.is_regular_file() && extension == ".ppm")
+        {
+            paths.push_back(entry.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    if(paths.empty())
+    {
+        throw std::runtime_error("ImageBatchProcessor: No .ppm images in " + directory + "!");
+    }
+
+    std::vector<DecodedAsset> images;
+    images.reserve(paths.size());
+    for(const auto& path : paths)
+    {
+        const MappedFile file(path);
+        images.push_back(AssetDecoder::decodePPM(file.getData(), file.getSize()));
+    }
+
+    return images;
+}
+
+/// <summary>
+/// Generates count distinct RGBA8 images of the extent: colour gradients under a checkerboard whose cells shrink
+/// from image to image, so resizing and sharpening have edges of every scale to work on.
+/// </summary>
+std::vector<DecodedAsset> ImageBatchProcessor::createTestImages(uint32_t count, VkExtent2D extent)
+{
+    std::vector<DecodedAsset> images(count);
+
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        const size_t pixelCount = static_cast<size_t>(extent.width) * extent.height;
+        const uint32_t cellSize = std::max(64u >> (i % 6), 1u);
+
+        DecodedAsset& image = images[i];
+        image.type = AssetType::Texture;
+        image.width = extent.width;
+        image.height = extent.height;
+        image.format = VK_FORMAT_R8G8B8A8_SRGB;
+        image.levels.push_back({ 0, pixelCount * PIXEL_SIZE, extent.width, extent.height });
+        image.data.resize(pixelCount * PIXEL_SIZE);
+
+        uint8_t* pixel = image.data.data();
+        for(uint32_t y = 0; y < extent.height; ++y)
+        {
+            for(uint32_t x = 0; x < extent.width; ++x, pixel += PIXEL_SIZE)
+            {
+                const bool lightCell = ((x / cellSize) + (y / cellSize)) % 2 == 0;
+                const uint32_t shade = lightCell ? 255 : 96;
+
+                pixel[0] = static_cast<uint8_t>(shade * x / std::max(extent.width - 1, 1u));
+                pixel[1] = static_cast<uint8_t>(shade * y / std::max(extent.height - 1, 1u));
+                pixel[2] = static_cast<uint8_t>(shade * ((i * 64) % 256) / 255);
+                pixel[3] = 255;
+            }
+        }
+    }
+
+    return images;
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include "AssetDecoder.h"
+#include "FrameWriter.h"
+#include "GpuResources.h"
+#include "QueueSubmitter.h"
+
+/// <summary>
+/// Runs a batch of images through a chain of compute kernels without any graphics work, for offline jobs on devices
+/// with or without a display.
+///
+/// Every image is copied into a host visible staging buffer, uploaded to a device local buffer on the transfer queue,
+/// filtered on the compute queue and copied back to host memory on the transfer queue again:
+///
+///     Shaders/batch_resize.comp   - bilinear resize of the sRGB input to the output extent, into linear floats
+///     Shaders/batch_sharpen.comp  - 3x3 sharpening convolution, reading its tile and border from shared memory
+///     Shaders/batch_tonemap.comp  - exposure and filmic tone map back to 8 bit sRGB
+///
+/// Two slots own the buffers, command buffers and semaphores of an image each, so the CPU fills the staging buffer
+/// of one image while the GPU works on the other. Upload of image i is submitted ahead of the readback of image i - 1,
+/// so the transfer queue copies the next input while the compute queue filters the current one. When the compute and
+/// transfer families differ, buffers are handed between them with release and acquire barriers.
+///
+/// Sources are cycled through, so a short list of images can feed a batch of any length. The time from the first
+/// upload to the last readback gives the throughput in images per second.
+/// </summary>
+class ImageBatchProcessor
+{
+public:
+    using ComputePipelineFactory = std::function<UniquePipeline(const std::vector<char>& code)>;
+
+    struct Queues
+    {
+        VkQueue                         compute                     = VK_NULL_HANDLE;
+        uint32_t                        computeFamily               = 0;
+        VkQueue                         transfer                    = VK_NULL_HANDLE;
+        uint32_t                        transferFamily              = 0;
+    };
+
+    struct Shaders
+    {
+        std::vector<char>               resize                      = {};
+        std::vector<char>               sharpen                     = {};
+        std::vector<char>               toneMap                     = {};
+    };
+
+    static constexpr uint32_t           SLOT_COUNT                  = 2;
+    static constexpr uint32_t           GROUP_SIZE                  = 8;    // local size of the kernels in x and y
+
+                                        ImageBatchProcessor(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                                                            MemoryBudgetMonitor* budgetMonitor, PipelineLayoutCache& layoutCache, QueueSubmitter& queueSubmitter,
+                                                            const Queues& queues, std::vector<DecodedAsset> sources, VkExtent2D outputExtent,
+                                                            const Shaders& shaders, const ComputePipelineFactory& computePipelineFactory,
+                                                            FrameWriter* writer);
+                                        ~ImageBatchProcessor();
+
+                                        ImageBatchProcessor(const ImageBatchProcessor&) = delete;
+    ImageBatchProcessor&                operator=(const ImageBatchProcessor&) = delete;
+
+    void                                process(uint32_t imageCount);
+
+    void                                printStatistics(std::ostream& stream)                                                   const;
+
+    static std::vector<DecodedAsset>    loadImages(const std::string& directory);
+    static std::vector<DecodedAsset>    createTestImages(uint32_t count, VkExtent2D extent);
+
+private:
+    // Matches the push constant block of Shaders/batch_constants.glsl
+    struct PushConstants
+    {
+        uint32_t                        inputWidth                  = 0;
+        uint32_t                        inputHeight                 = 0;
+        uint32_t                        outputWidth                 = 0;
+        uint32_t                        outputHeight                = 0;
+        float                           exposure                    = 1.0f;
+        float                           sharpness                   = 0.0f; // weight of the neighbours subtracted by the sharpening
+    };
+
+    struct Slot
+    {
+        BufferAllocation                staging                     = {};   // host visible input
+        BufferAllocation                readback                    = {};   // host visible output
+        BufferAllocation                input                       = {};
+        BufferAllocation                filtered[2]                 = {};   // linear RGBA floats between the kernels
+        BufferAllocation                output                      = {};
+        uint8_t*                        mappedStaging               = nullptr;
+        const uint8_t*                  mappedReadback              = nullptr;
+
+        VkCommandBuffer                 uploadCommandBuffer         = VK_NULL_HANDLE;
+        VkCommandBuffer                 computeCommandBuffer        = VK_NULL_HANDLE;
+        VkCommandBuffer                 readbackCommandBuffer       = VK_NULL_HANDLE;
+        UniqueSemaphore                 uploaded                    = {};
+        UniqueSemaphore                 filteredOutput              = {};
+        UniqueFence                     readbackDone                = {};
+        VkDescriptorSet                 descriptorSets[3]           = {};   // resize, sharpen, tone map
+
+        uint64_t                        imageIndex                  = 0;
+        bool                            pending                     = false;    // readback submitted but not collected yet
+    };
+
+    VkDevice                            vkDevice;
+    const PhysicalDeviceCapabilities&   capabilities;
+    const VkAllocationCallbacks*        vkAllocator;
+    const GpuResources                  resources;
+    QueueSubmitter&                     queueSubmitter;
+    const Queues                        queues;
+    const std::vector<DecodedAsset>     sources;
+    const VkExtent2D                    outputExtent;
+    FrameWriter*                        writer;
+
+    ReflectedPipeline                   resizePipeline              = {};
+    ReflectedPipeline                   sharpenPipeline             = {};
+    ReflectedPipeline                   toneMapPipeline             = {};
+    UniqueDescriptorPool                descriptorPool              = {};
+    UniqueCommandPool                   computeCommandPool          = {};
+    UniqueCommandPool                   transferCommandPool         = {};   // only when the transfer family differs
+    Slot                                slots[SLOT_COUNT]           = {};
+    PushConstants                       constants                   = {};
+
+    //Statistics
+    uint64_t                            processedImages             = 0;
+    uint64_t                            inputBytes                  = 0;
+    uint64_t                            outputBytes                 = 0;
+    double                              batchTime                   = 0.0;  // seconds from the first upload to the last readback
+    double                              stagingTime                 = 0.0;  // milliseconds copying inputs into staging memory
+    double                              waitTime                    = 0.0;  // milliseconds waiting for slots to be read back
+
+    bool                                transfersOwnership()                                                                    const;
+    void                                createCommandPools();
+    void                                createSlots(VkDeviceSize inputSize);
+    void                                createDescriptorSets();
+    VkDescriptorSet                     allocateDescriptorSet(const ReflectedPipeline& pipeline, const Slot& slot);
+
+    void                                recordUpload(Slot& slot, const DecodedAsset& source);
+    void                                recordFilters(Slot& slot);
+    void                                recordReadback(Slot& slot);
+    void                                collect(Slot& slot);
+};
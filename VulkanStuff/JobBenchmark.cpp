@@ -0,0 +1,182 @@
+#include "pch.h"
+#include "JobBenchmark.h"
+#include "JobSystem.h"
+
+/// <summary>
+/// Returns the best time of REPETITIONS calls in milliseconds.
+/// </summary>
+double JobBenchmark::measure(const std::function<void()>& function)
+{
+    double best = std::numeric_limits<double>::max();
+
+    for(uint32_t repetition = 0; repetition < REPETITIONS; ++repetition)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    return best;
+}
+
+/// <summary>
+/// Nanoseconds per empty job scheduled from worker 0.
+/// </summary>
+double JobBenchmark::measureEmptyJobs(uint32_t workerCount)
+{
+    JobSystem jobSystem(workerCount);
+
+    const double milliseconds = measure([&jobSystem]
+    {
+        JobCounter counter;
+        for(size_t i = 0; i < EMPTY_JOB_COUNT; ++i)
+        {
+            jobSystem.schedule([] {}, &counter);
+        }
+        jobSystem.wait(counter);
+    });
+
+    return milliseconds * 1e6 / EMPTY_JOB_COUNT;
+}
+
+/// <summary>
+/// Nanoseconds per empty job spawned by other jobs, most of the spawning jobs are stolen from worker 0.
+/// </summary>
+double JobBenchmark::measureSpawnedJobs(uint32_t workerCount)
+{
+    JobSystem jobSystem(workerCount);
+    constexpr size_t childCount = EMPTY_JOB_COUNT / SPAWNING_JOB_COUNT;
+
+    const double milliseconds = measure([&jobSystem]
+    {
+        JobCounter counter;
+        for(size_t i = 0; i < SPAWNING_JOB_COUNT; ++i)
+        {
+            jobSystem.schedule([&jobSystem, &counter]
+            {
+                for(size_t child = 0; child < childCount; ++child)
+                {
+                    jobSystem.schedule([] {}, &counter);
+                }
+            }, &counter);
+        }
+        jobSystem.wait(counter);
+    });
+
+    return milliseconds * 1e6 / (SPAWNING_JOB_COUNT * (childCount + 1));
+}
+
+/// <summary>
+/// Nanoseconds from the end of a job to the start of its continuation.
+/// </summary>
+double JobBenchmark::measureContinuationChain(uint32_t workerCount)
+{
+    JobSystem jobSystem(workerCount);
+
+    const double milliseconds = measure([&jobSystem]
+    {
+        std::unique_ptr<JobCounter[]> counters(new JobCounter[CHAIN_LENGTH]);
+
+        for(size_t i = 0; i < CHAIN_LENGTH; ++i)
+        {
+            jobSystem.schedule([] {}, &counters[i], i > 0 ? &counters[i - 1] : nullptr);
+        }
+
+        for(size_t i = 0; i < CHAIN_LENGTH; ++i)
+        {
+            jobSystem.wait(counters[i]);
+        }
+    });
+
+    return milliseconds * 1e6 / CHAIN_LENGTH;
+}
+
+double JobBenchmark::measureParallelFor(uint32_t workerCount, uint64_t& checksum)
+{
+    JobSystem jobSystem(workerCount);
+    std::vector<uint32_t> results(SCALING_ELEMENT_COUNT);
+
+    const double milliseconds = measure([&jobSystem, &results]
+    {
+        JobCounter counter;
+        jobSystem.parallelFor(SCALING_ELEMENT_COUNT, SCALING_GRAIN_SIZE, [&results](size_t begin, size_t end)
+        {
+            for(size_t i = begin; i < end; ++i)
+            {
+                // xorshift32 iterations, a dependent chain the compiler can't vectorize away
+                uint32_t state = static_cast<uint32_t>(i) | 1u;
+                for(uint32_t iteration = 0; iteration < SCALING_ITERATIONS; ++iteration)
+                {
+                    state ^= state << 13;
+                    state ^= state >> 17;
+                    state ^= state << 5;
+                }
+                results[i] = state;
+            }
+        }, counter);
+        jobSystem.wait(counter);
+    });
+
+    checksum = 0;
+    for(uint32_t result : results)
+    {
+        checksum += result;
+    }
+
+    return milliseconds;
+}
+
+void JobBenchmark::run(std::ostream& stream, uint32_t maxWorkerCount)
+{
+    if(maxWorkerCount == 0)
+    {
+        maxWorkerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::vector<uint32_t> workerCounts;
+    for(uint32_t workerCount = 1; workerCount < maxWorkerCount; workerCount *= 2)
+    {
+        workerCounts.push_back(workerCount);
+    }
+    workerCounts.push_back(maxWorkerCount);
+
+    const std::streamsize precision = stream.precision();
+    stream << "JobBenchmark: best of " << REPETITIONS << " runs, up to " << maxWorkerCount << " workers\n"
+           << std::fixed << std::setprecision(1)
+           << "    workers   empty ns/job   spawned ns/job   continuation ns   parallel-for ms   speedup   efficiency\n";
+
+    double singleWorkerTime = 0.0;
+    uint64_t referenceChecksum = 0;
+
+    for(uint32_t workerCount : workerCounts)
+    {
+        const double emptyJobs = measureEmptyJobs(workerCount);
+        const double spawnedJobs = measureSpawnedJobs(workerCount);
+        const double continuation = measureContinuationChain(workerCount);
+
+        uint64_t checksum = 0;
+        const double parallelFor = measureParallelFor(workerCount, checksum);
+
+        if(workerCount == 1)
+        {
+            singleWorkerTime = parallelFor;
+            referenceChecksum = checksum;
+        }
+        else if(checksum != referenceChecksum)
+        {
+            throw std::runtime_error("JobBenchmark: parallelFor result differs from the single worker result!");
+        }
+
+        const double speedup = singleWorkerTime / parallelFor;
+
+        stream << "    " << std::setw(7) << workerCount
+               << std::setw(15) << emptyJobs
+               << std::setw(17) << spawnedJobs
+               << std::setw(18) << continuation
+               << std::setw(18) << parallelFor
+               << std::setw(10) << speedup
+               << std::setw(12) << speedup / workerCount * 100.0 << " %\n";
+    }
+
+    stream << std::defaultfloat << std::setprecision(precision);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+/// <summary>
+/// CPU benchmarks of the JobSystem, run without a window or a Vulkan device.
+///
+/// Scheduling overhead is measured with empty jobs: scheduled from one thread, spawned by jobs (which exercises
+/// stealing) and chained as continuations (latency of a dependency). Scaling is measured with a compute bound
+/// parallelFor on 1, 2, 4, ... workers up to maxWorkerCount. Every measurement is the best of REPETITIONS runs.
+/// </summary>
+class JobBenchmark
+{
+public:
+    static void                         run(std::ostream& stream, uint32_t maxWorkerCount);
+
+private:
+    static constexpr uint32_t           REPETITIONS                 = 5;
+    static constexpr size_t             EMPTY_JOB_COUNT             = 200000;
+    static constexpr size_t             SPAWNING_JOB_COUNT          = 256;
+    static constexpr size_t             CHAIN_LENGTH                = 10000;
+    static constexpr size_t             SCALING_ELEMENT_COUNT       = 1 << 20;
+    static constexpr size_t             SCALING_GRAIN_SIZE          = 1024;
+    static constexpr uint32_t           SCALING_ITERATIONS          = 256;  // work per element
+
+    static double                       measure(const std::function<void()>& function);
+    static double                       measureEmptyJobs(uint32_t workerCount);
+    static double                       measureSpawnedJobs(uint32_t workerCount);
+    static double                       measureContinuationChain(uint32_t workerCount);
+    static double                       measureParallelFor(uint32_t workerCount, uint64_t& checksum);
+};
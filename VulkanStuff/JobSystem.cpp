@@ -0,0 +1,423 @@
+#include "pch.h"
+#include "JobSystem.h"
+
+static thread_local JobSystem*  currentJobSystem    = nullptr;
+static thread_local uint32_t    currentWorkerIndex  = JobSystem::NO_WORKER;
+
+bool JobCounter::isDone() const
+{
+    return pendingJobs.load(std::memory_order_acquire) == 0;
+}
+
+/// <summary>
+/// A worker count of 0 creates one worker per hardware thread. The calling thread becomes worker 0, so
+/// workerCount - 1 threads are started.
+/// </summary>
+JobSystem::JobSystem(uint32_t workerCount)
+{
+    if(workerCount == 0)
+    {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers.reserve(workerCount);
+    for(uint32_t i = 0; i < workerCount; ++i)
+    {
+        workers.push_back(std::make_unique<Worker>());
+        workers.back()->randomState = 0x9E3779B9u * (i + 1);
+    }
+
+    previousJobSystem = currentJobSystem;
+    previousWorkerIndex = currentWorkerIndex;
+    currentJobSystem = this;
+    currentWorkerIndex = 0;
+
+    for(uint32_t i = 1; i < workerCount; ++i)
+    {
+        workers[i]->thread = std::thread(&JobSystem::workerLoop, this, i);
+    }
+}
+
+/// <summary>
+/// Jobs which were never waited for are dropped, continuations still held by counters are leaked.
+/// </summary>
+JobSystem::~JobSystem()
+{
+    stopping.store(true);
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wakeEpoch.fetch_add(1);
+    }
+    sleepCondition.notify_all();
+
+    for(auto& worker : workers)
+    {
+        if(worker->thread.joinable())
+        {
+            worker->thread.join();
+        }
+    }
+
+    for(auto& worker : workers)
+    {
+        while(Job* job = worker->deque.pop())
+        {
+            delete job;
+        }
+    }
+
+    for(Job* job : injectionQueue)
+    {
+        delete job;
+    }
+
+    currentJobSystem = previousJobSystem;
+    currentWorkerIndex = previousWorkerIndex;
+}
+
+/// <summary>
+/// Schedules a job, the counter stays above zero until the job finished. With a dependency the job is a continuation,
+/// it is only handed to the workers once the dependency counter reached zero.
+/// </summary>
+void JobSystem::schedule(JobFunction function, JobCounter* counter, JobCounter* dependency)
+{
+    Job* job = new Job{ std::move(function), counter };
+
+    if(counter != nullptr)
+    {
+        counter->pendingJobs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if(dependency != nullptr)
+    {
+        std::lock_guard<std::mutex> lock(dependency->mutex);
+        if(dependency->pendingJobs.load(std::memory_order_acquire) > 0)
+        {
+            dependency->continuations.push_back(job);
+            return;
+        }
+    }
+
+    submit(job);
+}
+
+/// <summary>
+/// Calls function for ranges of at most grainSize elements covering [0, count). Ranges are split in halves: a job
+/// schedules one half and keeps splitting the other, so the ranges spread to thieves in log(count / grainSize) steps
+/// instead of the scheduling thread pushing every range itself.
+/// </summary>
+void JobSystem::parallelFor(size_t count, size_t grainSize, RangeFunction function, JobCounter& counter)
+{
+    if(count == 0)
+    {
+        return;
+    }
+
+    auto sharedFunction = std::make_shared<RangeFunction>(std::move(function));
+    grainSize = std::max<size_t>(grainSize, 1);
+
+    schedule([this, count, grainSize, sharedFunction, counter = &counter]
+    {
+        splitRange(0, count, grainSize, sharedFunction, counter);
+    }, &counter);
+}
+
+void JobSystem::splitRange(size_t begin, size_t end, size_t grainSize, std::shared_ptr<RangeFunction> function, JobCounter* counter)
+{
+    while(end - begin > grainSize)
+    {
+        const size_t middle = begin + (end - begin) / 2;
+        schedule([this, middle, end, grainSize, function, counter]
+        {
+            splitRange(middle, end, grainSize, function, counter);
+        }, counter);
+
+        end = middle;
+    }
+
+    (*function)(begin, end);
+}
+
+/// <summary>
+/// Runs jobs until the counter reached zero, the first exception thrown by one of its jobs is rethrown.
+/// Called from a thread which is no worker, only the injection queue and the other workers' deques are searched.
+/// </summary>
+void JobSystem::wait(JobCounter& counter)
+{
+    const uint32_t workerIndex = getLocalWorkerIndex();
+
+    while(counter.pendingJobs.load(std::memory_order_acquire) > 0)
+    {
+        if(Job* job = findJob(workerIndex))
+        {
+            execute(job, workerIndex);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    // The last job releases the mutex after taking the continuations, the counter may be destroyed once it is acquired.
+    std::exception_ptr exception = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(counter.mutex);
+        std::swap(exception, counter.exception);
+    }
+
+    if(exception)
+    {
+        std::rethrow_exception(exception);
+    }
+}
+
+uint32_t JobSystem::getWorkerCount() const
+{
+    return static_cast<uint32_t>(workers.size());
+}
+
+/// <summary>
+/// Index of the worker running on the calling thread, NO_WORKER for threads which are no worker of any job system.
+/// </summary>
+uint32_t JobSystem::getCurrentWorkerIndex()
+{
+    return currentWorkerIndex;
+}
+
+uint32_t JobSystem::getLocalWorkerIndex() const
+{
+    return currentJobSystem == this ? currentWorkerIndex : NO_WORKER;
+}
+
+void JobSystem::submit(Job* job)
+{
+    const uint32_t workerIndex = getLocalWorkerIndex();
+
+    if(workerIndex != NO_WORKER)
+    {
+        workers[workerIndex]->deque.push(job);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(injectionMutex);
+        injectionQueue.push_back(job);
+        injectionQueueSize.fetch_add(1);
+    }
+
+    wakeWorker();
+}
+
+/// <summary>
+/// A sleeping worker registers itself, reads wakeEpoch and searches for work once more before it sleeps.
+/// A job pushed before that search is found by it, a job pushed after it sees the registration and changes the epoch.
+/// </summary>
+void JobSystem::wakeWorker()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(sleepingWorkers.load(std::memory_order_relaxed) == 0)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wakeEpoch.fetch_add(1);
+    }
+    sleepCondition.notify_one();
+}
+
+/// <summary>
+/// Own jobs first, newest first, then jobs scheduled from outside, then the oldest job of another worker starting
+/// at a random victim.
+/// </summary>
+Job* JobSystem::findJob(uint32_t workerIndex)
+{
+    if(workerIndex != NO_WORKER)
+    {
+        if(Job* job = workers[workerIndex]->deque.pop())
+        {
+            return job;
+        }
+    }
+
+    if(injectionQueueSize.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(injectionMutex);
+        if(!injectionQueue.empty())
+        {
+            Job* job = injectionQueue.front();
+            injectionQueue.pop_front();
+            injectionQueueSize.fetch_sub(1);
+            return job;
+        }
+    }
+
+    const uint32_t workerCount = getWorkerCount();
+    uint32_t firstVictim = 0;
+    if(workerIndex != NO_WORKER)
+    {
+        // xorshift32
+        uint32_t& state = workers[workerIndex]->randomState;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        firstVictim = state % workerCount;
+    }
+
+    for(uint32_t i = 0; i < workerCount; ++i)
+    {
+        const uint32_t victim = (firstVictim + i) % workerCount;
+        if(victim == workerIndex)
+        {
+            continue;
+        }
+
+        if(Job* job = workers[victim]->deque.steal())
+        {
+            if(workerIndex != NO_WORKER)
+            {
+                workers[workerIndex]->stolenJobs.fetch_add(1, std::memory_order_relaxed);
+            }
+            return job;
+        }
+    }
+
+    return nullptr;
+}
+
+void JobSystem::execute(Job* job, uint32_t workerIndex)
+{
+    try
+    {
+        job->function();
+    }
+    catch(...)
+    {
+        if(job->counter != nullptr)
+        {
+            std::lock_guard<std::mutex> lock(job->counter->mutex);
+            if(!job->counter->exception)
+            {
+                job->counter->exception = std::current_exception();
+            }
+        }
+        else
+        {
+            std::cerr << "JobSystem: Exception thrown by a job without counter is lost!" << std::endl;
+        }
+    }
+
+    if(workerIndex != NO_WORKER)
+    {
+        workers[workerIndex]->executedJobs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    finish(job->counter);
+    delete job;
+}
+
+/// <summary>
+/// Decrements the counter and submits its continuations when it reaches zero. Only the decrement which may reach
+/// zero takes the mutex, so a continuation added concurrently is either taken here or sees the counter at zero.
+/// </summary>
+void JobSystem::finish(JobCounter* counter)
+{
+    if(counter == nullptr)
+    {
+        return;
+    }
+
+    uint32_t pendingJobs = counter->pendingJobs.load(std::memory_order_relaxed);
+    while(pendingJobs > 1)
+    {
+        if(counter->pendingJobs.compare_exchange_weak(pendingJobs, pendingJobs - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+        {
+            return;
+        }
+    }
+
+    std::vector<Job*> continuations;
+    {
+        std::lock_guard<std::mutex> lock(counter->mutex);
+        if(counter->pendingJobs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            continuations.swap(counter->continuations);
+        }
+    }
+
+    for(Job* continuation : continuations)
+    {
+        submit(continuation);
+    }
+}
+
+/// <summary>
+/// Workers spin through IDLE_SPIN_ROUNDS searches, yielding in between, before they sleep. Short gaps between the
+/// jobs of a frame don't pay for a wake up, idle phases don't burn a core.
+/// </summary>
+void JobSystem::workerLoop(uint32_t workerIndex)
+{
+    currentJobSystem = this;
+    currentWorkerIndex = workerIndex;
+
+    Worker& worker = *workers[workerIndex];
+    uint32_t idleRounds = 0;
+
+    while(!stopping.load(std::memory_order_relaxed))
+    {
+        if(Job* job = findJob(workerIndex))
+        {
+            execute(job, workerIndex);
+            idleRounds = 0;
+            continue;
+        }
+
+        if(++idleRounds < IDLE_SPIN_ROUNDS)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        idleRounds = 0;
+
+        sleepingWorkers.fetch_add(1);
+        const uint64_t epoch = wakeEpoch.load();
+
+        if(Job* job = findJob(workerIndex))
+        {
+            sleepingWorkers.fetch_sub(1);
+            execute(job, workerIndex);
+            continue;
+        }
+
+        worker.sleeps.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepCondition.wait(lock, [this, epoch] { return wakeEpoch.load() != epoch || stopping.load(); });
+        }
+        sleepingWorkers.fetch_sub(1);
+    }
+}
+
+void JobSystem::printStatistics(std::ostream& stream) const
+{
+    uint64_t executedJobs = 0;
+    uint64_t stolenJobs = 0;
+    uint64_t sleeps = 0;
+
+    for(const auto& worker : workers)
+    {
+        executedJobs += worker->executedJobs.load(std::memory_order_relaxed);
+        stolenJobs += worker->stolenJobs.load(std::memory_order_relaxed);
+        sleeps += worker->sleeps.load(std::memory_order_relaxed);
+    }
+
+    stream << "JobSystem: " << workers.size() << " workers, " << executedJobs << " jobs executed, " << stolenJobs << " stolen, "
+           << sleeps << " sleeps\n";
+
+    for(size_t i = 0; i < workers.size(); ++i)
+    {
+        stream << "    [worker " << i << "] " << workers[i]->executedJobs.load(std::memory_order_relaxed) << " executed, "
+               << workers[i]->stolenJobs.load(std::memory_order_relaxed) << " stolen, "
+               << workers[i]->sleeps.load(std::memory_order_relaxed) << " sleeps\n";
+    }
+}
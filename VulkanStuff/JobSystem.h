@@ -0,0 +1,249 @@
+#pragma once
+
+class JobCounter;
+
+/// <summary>
+/// A unit of work, allocated when it is scheduled and deleted by the worker which ran it.
+/// </summary>
+struct Job
+{
+    std::function<void()>               function                    = {};
+    JobCounter*                         counter                     = nullptr;
+};
+
+/// <summary>
+/// Counts the jobs scheduled against it which did not finish yet.
+///
+/// JobSystem::wait() returns once the counter reached zero and rethrows the first exception thrown by one of its jobs.
+/// Jobs scheduled with a counter as dependency are continuations, they are held back until the counter reaches zero.
+/// A counter may be reused after it was waited for and has to outlive its jobs and continuations.
+/// </summary>
+class JobCounter
+{
+public:
+    bool                                isDone()                                                                                const;
+
+private:
+    friend class JobSystem;
+
+    std::atomic<uint32_t>               pendingJobs                 = 0;
+
+    std::mutex                          mutex;
+    std::vector<Job*>                   continuations               = {};
+    std::exception_ptr                  exception                   = nullptr;
+};
+
+/// <summary>
+/// Chase-Lev work-stealing deque (Le, Pop, Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak
+/// Memory Models", 2013).
+///
+/// The owning worker pushes and pops at the bottom without locks, other workers steal from the top. Buffers grow when
+/// full, replaced buffers are kept until the deque is destroyed because a thief may still read from them.
+/// </summary>
+template<typename T>
+class WorkStealingDeque
+{
+public:
+    explicit                            WorkStealingDeque(int64_t capacity = 1024);
+
+    void                                push(T* item);
+    T*                                  pop();
+    T*                                  steal();
+
+    bool                                isEmpty()                                                                               const;
+
+private:
+    struct Buffer
+    {
+        explicit                        Buffer(int64_t capacity) : capacity(capacity), items(new std::atomic<T*>[static_cast<size_t>(capacity)]) {}
+
+        const int64_t                   capacity;
+        std::unique_ptr<std::atomic<T*>[]> items;
+
+        T*                              get(int64_t index) const { return items[static_cast<size_t>(index & (capacity - 1))].load(std::memory_order_relaxed); }
+        void                            put(int64_t index, T* item) { items[static_cast<size_t>(index & (capacity - 1))].store(item, std::memory_order_relaxed); }
+    };
+
+    alignas(64) std::atomic<int64_t>    top                         = 0;
+    alignas(64) std::atomic<int64_t>    bottom                      = 0;
+    std::atomic<Buffer*>                buffer                      = nullptr;
+
+    //Owner only
+    std::vector<std::unique_ptr<Buffer>> buffers                    = {};
+
+    Buffer*                             grow(Buffer* current, int64_t bottomIndex, int64_t topIndex);
+};
+
+/// <summary>
+/// Work-stealing job scheduler with one worker per hardware thread.
+///
+/// The thread creating the job system is worker 0, it has no thread of its own and executes jobs while it waits for a
+/// counter, so the frame loop can fan work out and help finishing it. Every worker owns a Chase-Lev deque: jobs
+/// scheduled by a worker are pushed onto its own deque and popped in LIFO order, which keeps caches warm, while idle
+/// workers steal the oldest jobs of a random victim. Threads which are no workers of this job system schedule through
+/// a shared injection queue.
+///
+/// Dependencies are expressed with continuations instead of fibers: a job can be held back until a counter reaches
+/// zero, and a waiting worker runs other jobs instead of blocking. Workers which found no work for a while sleep on a
+/// condition variable and are woken when new jobs are scheduled. With a single worker, jobs only run while the
+/// creating thread waits.
+/// </summary>
+class JobSystem
+{
+public:
+    using JobFunction       = std::function<void()>;
+    using RangeFunction     = std::function<void(size_t begin, size_t end)>;
+
+    static constexpr uint32_t           NO_WORKER                   = std::numeric_limits<uint32_t>::max();
+
+    explicit                            JobSystem(uint32_t workerCount = 0);
+                                        ~JobSystem();
+
+                                        JobSystem(const JobSystem&) = delete;
+    JobSystem&                          operator=(const JobSystem&) = delete;
+
+    void                                schedule(JobFunction function, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+    void                                parallelFor(size_t count, size_t grainSize, RangeFunction function, JobCounter& counter);
+    void                                wait(JobCounter& counter);
+
+    uint32_t                            getWorkerCount()                                                                        const;
+    static uint32_t                     getCurrentWorkerIndex();
+    void                                printStatistics(std::ostream& stream)                                                   const;
+
+private:
+    struct alignas(64) Worker
+    {
+        WorkStealingDeque<Job>          deque;
+        std::thread                     thread;
+        uint32_t                        randomState                 = 0;
+
+        std::atomic<uint64_t>           executedJobs                = 0;
+        std::atomic<uint64_t>           stolenJobs                  = 0;
+        std::atomic<uint64_t>           sleeps                      = 0;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers                    = {};
+    std::atomic<bool>                   stopping                    = false;
+
+    //Jobs scheduled by threads which are no workers
+    std::mutex                          injectionMutex;
+    std::deque<Job*>                    injectionQueue              = {};
+    std::atomic<size_t>                 injectionQueueSize          = 0;
+
+    //Sleeping workers wait for wakeEpoch to change
+    std::mutex                          sleepMutex;
+    std::condition_variable             sleepCondition;
+    std::atomic<uint64_t>               wakeEpoch                   = 0;
+    std::atomic<uint32_t>               sleepingWorkers             = 0;
+
+    //The job system and worker index of the current thread, restored when a nested job system is destroyed
+    JobSystem*                          previousJobSystem           = nullptr;
+    uint32_t                            previousWorkerIndex         = 0;
+
+    static constexpr uint32_t           IDLE_SPIN_ROUNDS            = 64;   // failed searches for work before a worker sleeps
+
+    void                                submit(Job* job);
+    void                                wakeWorker();
+    Job*                                findJob(uint32_t workerIndex);
+    void                                execute(Job* job, uint32_t workerIndex);
+    void                                finish(JobCounter* counter);
+    void                                splitRange(size_t begin, size_t end, size_t grainSize, std::shared_ptr<RangeFunction> function, JobCounter* counter);
+    void                                workerLoop(uint32_t workerIndex);
+    uint32_t                            getLocalWorkerIndex()                                                                   const;
+};
+
+template<typename T>
+WorkStealingDeque<T>::WorkStealingDeque(int64_t capacity)
+{
+    buffers.push_back(std::make_unique<Buffer>(capacity));
+    buffer.store(buffers.back().get(), std::memory_order_relaxed);
+}
+
+template<typename T>
+void WorkStealingDeque<T>::push(T* item)
+{
+    const int64_t bottomIndex = bottom.load(std::memory_order_relaxed);
+    const int64_t topIndex = top.load(std::memory_order_acquire);
+    Buffer* current = buffer.load(std::memory_order_relaxed);
+
+    if(bottomIndex - topIndex > current->capacity - 1)
+    {
+        current = grow(current, bottomIndex, topIndex);
+    }
+
+    current->put(bottomIndex, item);
+    bottom.store(bottomIndex + 1, std::memory_order_release);
+}
+
+template<typename T>
+T* WorkStealingDeque<T>::pop()
+{
+    const int64_t bottomIndex = bottom.load(std::memory_order_relaxed) - 1;
+    Buffer* current = buffer.load(std::memory_order_relaxed);
+    bottom.store(bottomIndex, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t topIndex = top.load(std::memory_order_relaxed);
+
+    if(topIndex > bottomIndex)
+    {
+        // Empty
+        bottom.store(bottomIndex + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    T* item = current->get(bottomIndex);
+    if(topIndex == bottomIndex)
+    {
+        // Last item, a thief may take it at the same time
+        if(!top.compare_exchange_strong(topIndex, topIndex + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            item = nullptr;
+        }
+        bottom.store(bottomIndex + 1, std::memory_order_relaxed);
+    }
+
+    return item;
+}
+
+template<typename T>
+T* WorkStealingDeque<T>::steal()
+{
+    int64_t topIndex = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottomIndex = bottom.load(std::memory_order_acquire);
+
+    if(topIndex >= bottomIndex)
+    {
+        return nullptr;
+    }
+
+    T* item = buffer.load(std::memory_order_acquire)->get(topIndex);
+    if(!top.compare_exchange_strong(topIndex, topIndex + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        // Lost the race against the owner or another thief
+        return nullptr;
+    }
+
+    return item;
+}
+
+template<typename T>
+bool WorkStealingDeque<T>::isEmpty() const
+{
+    return top.load(std::memory_order_relaxed) >= bottom.load(std::memory_order_relaxed);
+}
+
+template<typename T>
+typename WorkStealingDeque<T>::Buffer* WorkStealingDeque<T>::grow(Buffer* current, int64_t bottomIndex, int64_t topIndex)
+{
+    auto grown = std::make_unique<Buffer>(current->capacity * 2);
+    for(int64_t index = topIndex; index < bottomIndex; ++index)
+    {
+        grown->put(index, current->get(index));
+    }
+
+    buffers.push_back(std::move(grown));
+    buffer.store(buffers.back().get(), std::memory_order_release);
+
+    return buffers.back().get();
+}
@@ -0,0 +1,82 @@
+#include "pch.h"
+#include "Ktx2File.h"
+#include "TextureFormat.h"
+
+bool Ktx2File::isKtx2File(const std::filesystem::path& path)
+{
+    return path.extension() == ".ktx2";
+}
+
+DecodedAsset Ktx2File::load(const std::filesystem::path& path)
+{
+    static_assert(sizeof(Header) == 80, "Ktx2File: header layout doesn't match the file");
+
+    auto mapping = std::make_shared<const MappedFile>(path);
+    const uint64_t fileSize = mapping->getSize();
+
+    Header header = {};
+    if(fileSize < sizeof(header))
+    {
+        throw std::runtime_error("Ktx2File: " + path.string() + " is truncated!");
+    }
+    std::memcpy(&header, mapping->getData(), sizeof(header));
+
+    if(std::memcmp(header.identifier, IDENTIFIER, sizeof(IDENTIFIER)) != 0)
+    {
+        throw std::runtime_error("Ktx2File: " + path.string() + " is not a KTX2 file!");
+    }
+    if(header.supercompressionScheme != 0 || header.vkFormat == VK_FORMAT_UNDEFINED)
+    {
+        throw std::runtime_error("Ktx2File: " + path.string() + " is supercompressed, transcode it offline!");
+    }
+    if(header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1 || header.pixelWidth == 0 || header.pixelHeight == 0)
+    {
+        throw std::runtime_error("Ktx2File: " + path.string() + " is not a single 2D image!");
+    }
+
+    const VkFormat format = static_cast<VkFormat>(header.vkFormat);
+    const auto formatInfo = TextureFormat::getInfo(format);
+    if(!formatInfo.has_value())
+    {
+        throw std::runtime_error("Ktx2File: " + path.string() + " has unsupported format " + std::to_string(header.vkFormat) + "!");
+    }
+
+    const uint32_t levelCount = std::max(header.levelCount, 1u);
+    if(levelCount > TextureFormat::getMipLevelCount(header.pixelWidth, header.pixelHeight)
+       || sizeof(header) + levelCount * sizeof(LevelIndex) > fileSize)
+    {
+        throw std::runtime_error("Ktx2File: " + path.string() + " has an invalid level index!");
+    }
+
+    DecodedAsset texture = {};
+    texture.type = AssetType::Texture;
+    texture.format = format;
+    texture.width = header.pixelWidth;
+    texture.height = header.pixelHeight;
+    texture.mipLevels = levelCount;
+    texture.levels.resize(levelCount);
+
+    // Level 0 is the full resolution image, even though it is stored last in the file.
+    for(uint32_t level = 0; level < levelCount; ++level)
+    {
+        LevelIndex index = {};
+        std::memcpy(&index, mapping->getData() + sizeof(header) + level * sizeof(LevelIndex), sizeof(index));
+
+        const uint32_t width = std::max(header.pixelWidth >> level, 1u);
+        const uint32_t height = std::max(header.pixelHeight >> level, 1u);
+
+        if(index.byteLength != TextureFormat::getLevelSize(formatInfo.value(), width, height)
+           || index.byteOffset > fileSize || index.byteLength > fileSize - index.byteOffset)
+        {
+            throw std::runtime_error("Ktx2File: " + path.string() + " has an invalid mip level " + std::to_string(level) + "!");
+        }
+
+        texture.levels[level] = { index.byteOffset, index.byteLength, width, height };
+    }
+
+    texture.mappedData = mapping->getData();
+    texture.mappedSize = static_cast<size_t>(fileSize);
+    texture.mapping = std::move(mapping);
+
+    return texture;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "AssetDecoder.h"
+
+/// <summary>
+/// Loads KTX2 textures (Khronos, "KTX File Format Specification 2.0") without decoding them.
+///
+/// The file is memory mapped and the mip levels are copied to the GPU straight from the mapping in the format
+/// they are stored in, usually BC or ASTC compressed. Only single 2D images without supercompression are
+/// supported; Basis Universal files have to be transcoded offline. A file without mip levels (levelCount 0)
+/// gets its mip chain generated on the GPU, like any other uncompressed texture.
+/// </summary>
+class Ktx2File
+{
+public:
+    static bool                         isKtx2File(const std::filesystem::path& path);
+    static DecodedAsset                 load(const std::filesystem::path& path);
+
+private:
+    struct Header
+    {
+        uint8_t                         identifier[12]              = {};
+        uint32_t                        vkFormat                    = 0;
+        uint32_t                        typeSize                    = 0;
+        uint32_t                        pixelWidth                  = 0;
+        uint32_t                        pixelHeight                 = 0;
+        uint32_t                        pixelDepth                  = 0;
+        uint32_t                        layerCount                  = 0;
+        uint32_t                        faceCount                   = 0;
+        uint32_t                        levelCount                  = 0;
+        uint32_t                        supercompressionScheme      = 0;
+        uint32_t                        dfdByteOffset               = 0;
+        uint32_t                        dfdByteLength               = 0;
+        uint32_t                        kvdByteOffset               = 0;
+        uint32_t                        kvdByteLength               = 0;
+        uint64_t                        sgdByteOffset               = 0;
+        uint64_t                        sgdByteLength               = 0;
+    };
+
+    struct LevelIndex
+    {
+        uint64_t                        byteOffset                  = 0;
+        uint64_t                        byteLength                  = 0;
+        uint64_t                        uncompressedByteLength      = 0;
+    };
+
+    static constexpr uint8_t            IDENTIFIER[12]              = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+};
@@ -0,0 +1,652 @@
+#include "pch.h"
+#include "LodRenderer.h"
+#include "Camera.h"
+
+// Descriptor bindings of set 0 declared by the level of detail shaders
+static constexpr uint32_t BINDING_OBJECTS           = 0;
+static constexpr uint32_t BINDING_INSTANCES         = 1;
+static constexpr uint32_t BINDING_DRAW_COMMANDS     = 2;
+static constexpr uint32_t BINDING_LEVELS            = 3;
+static constexpr uint32_t BINDING_LEVEL_STATES      = 4;
+
+// Angle a row of objects has turned per frame, only one row is updated each frame
+static constexpr float ROW_SPIN_ANGLE               = 0.02f;
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+LodRenderer::LodRenderer(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                         uint32_t slotCount, MemoryBudgetMonitor* budgetMonitor, PipelineLayoutCache& layoutCache,
+                         const DecodedAsset& mesh, uint32_t objectCount, LodMode mode, const LodSelector& selector,
+                         const Shaders& shaders, const GraphicsPipelineFactory& graphicsPipelineFactory,
+                         const ComputePipelineFactory& computePipelineFactory)
+    : vkDevice(device)
+    , capabilities(capabilities)
+    , vkAllocator(allocator)
+    , budgetMonitor(budgetMonitor)
+    , resources(device, capabilities, allocator, budgetMonitor, "LodRenderer")
+    , mode(mode)
+    , selector(selector)
+    , objectCount(std::max(objectCount, 1u))
+    , slots(slotCount)
+{
+    if(mesh.type != AssetType::Mesh || mesh.lods.empty() || mesh.lods.size() > AssetDecoder::MAX_LOD_COUNT || selector.getLevelCount() != mesh.lods.size())
+    {
+        throw std::runtime_error("LodRenderer: Asset is not a mesh with levels of detail matching the selector!");
+    }
+    if(mode == LodMode::Auto)
+    {
+        throw std::runtime_error("LodRenderer: Mode has to be chosen with chooseMode!");
+    }
+    if(static_cast<uint64_t>(this->objectCount) * mesh.lods.size() > std::numeric_limits<uint32_t>::max())
+    {
+        throw std::runtime_error("LodRenderer: Too many objects for the instance lists!");
+    }
+
+    uploadScene(mesh);
+
+    drawPipeline = resources.createPipeline(graphicsPipelineFactory(shaders.drawStages), shaders.drawStages, layoutCache, sizeof(PushConstants));
+    if(mode == LodMode::Gpu)
+    {
+        selectionPipeline = resources.createPipeline(computePipelineFactory(shaders.selection), { shaders.selection }, layoutCache, sizeof(PushConstants));
+
+        resources.allocateBuffer(levelStates, this->objectCount * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+    else
+    {
+        currentLevels.assign(this->objectCount, 0);
+    }
+
+    const VkDeviceSize instancesSize = static_cast<VkDeviceSize>(this->objectCount) * levels.size() * sizeof(uint32_t);
+    for(Slot& slot : slots)
+    {
+        if(mode == LodMode::Gpu)
+        {
+            resources.allocateBuffer(slot.instances, instancesSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            resources.allocateBuffer(slot.drawCommands, levels.size() * sizeof(VkDrawIndexedIndirectCommand),
+                                     VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            resources.allocateBuffer(slot.statistics, levels.size() * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+            void* mapped = nullptr;
+            resources.mapBuffer(slot.statistics, &mapped);
+            slot.mappedStatistics = static_cast<const VkDrawIndexedIndirectCommand*>(mapped);
+        }
+        else
+        {
+            // Written once per frame by the CPU and read once by the vertex shader
+            resources.allocateBuffer(slot.instances, instancesSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+            void* mapped = nullptr;
+            resources.mapBuffer(slot.instances, &mapped);
+            slot.mappedInstances = static_cast<uint32_t*>(mapped);
+        }
+    }
+
+    createDescriptorSets();
+}
+
+LodRenderer::~LodRenderer()
+{
+    descriptorPool.reset();
+
+    for(Slot& slot : slots)
+    {
+        resources.releaseBuffer(slot.instances);
+        resources.releaseBuffer(slot.drawCommands);
+        resources.releaseBuffer(slot.statistics);
+    }
+    resources.releaseBuffer(levelStates);
+    resources.releaseBuffer(transforms);
+    resources.releaseBuffer(meshBuffer);
+    resources.releaseBuffer(stagingBuffer);
+}
+
+/// <summary>
+/// Places the objects on a square grid in the xz plane, lays out the mesh buffer and fills the staging buffer it is
+/// copied from by the first frame. Meshlets are not drawn, the buffer ends with the indices.
+/// </summary>
+void LodRenderer::uploadScene(const DecodedAsset& mesh)
+{
+    const float spacing = 3.0f * mesh.bounds.radius;
+    const uint32_t gridSize = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(objectCount))));
+    const float gridOffset = (static_cast<float>(gridSize) - 1.0f) * 0.5f;
+
+    createSceneGraph(spacing, gridSize);
+
+    const float extent = gridOffset * spacing + mesh.bounds.radius;
+    sceneBounds.minimum[0] = sceneBounds.minimum[2] = -extent;
+    sceneBounds.maximum[0] = sceneBounds.maximum[2] = extent;
+    sceneBounds.minimum[1] = mesh.bounds.minimum[1];
+    sceneBounds.maximum[1] = mesh.bounds.maximum[1];
+    sceneBounds.radius = std::sqrt(2.0f) * extent;
+
+    // The selector's errors, which never shrink from one level to the next, are the ones the compute shader sees
+    levels = mesh.lods;
+    for(uint32_t level = 0; level < levels.size(); ++level)
+    {
+        levels[level].error = selector.getError(level);
+    }
+
+    std::vector<VkDrawIndexedIndirectCommand> commands;
+    for(uint32_t level = 0; level < levels.size(); ++level)
+    {
+        commands.push_back({ levels[level].indexCount, 0, levels[level].firstIndex, 0, level * objectCount });
+    }
+
+    const VkDeviceSize alignment = std::max<VkDeviceSize>(capabilities.properties.limits.minStorageBufferOffsetAlignment, 16);
+    const VkDeviceSize dataSize = mesh.indexOffset + static_cast<VkDeviceSize>(mesh.indexCount) * sizeof(uint32_t);
+    indexOffset = mesh.indexOffset;
+    levelsOffset = alignUp(dataSize, alignment);
+    commandsOffset = alignUp(levelsOffset + levels.size() * sizeof(MeshLod), alignment);
+    const VkDeviceSize bufferSize = commandsOffset + commands.size() * sizeof(VkDrawIndexedIndirectCommand);
+
+    resources.allocateBuffer(stagingBuffer, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    resources.allocateBuffer(meshBuffer, bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                                                     | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    void* mapped = nullptr;
+    resources.mapBuffer(stagingBuffer, &mapped);
+    uint8_t* staging = static_cast<uint8_t*>(mapped);
+    std::memset(staging, 0, static_cast<size_t>(bufferSize));
+    std::memcpy(staging, mesh.getData(), static_cast<size_t>(dataSize));
+    std::memcpy(staging + levelsOffset, levels.data(), levels.size() * sizeof(MeshLod));
+    std::memcpy(staging + commandsOffset, commands.data(), commands.size() * sizeof(VkDrawIndexedIndirectCommand));
+    vkUnmapMemory(vkDevice, stagingBuffer.memory);
+
+    std::copy_n(mesh.bounds.center, 3, constants.meshSphere);
+    constants.meshSphere[3] = mesh.bounds.radius;
+    constants.objectCount = objectCount;
+    constants.levelCount = static_cast<uint32_t>(levels.size());
+    constants.pixelError = selector.getPixelError();
+    constants.coarsenError = selector.getCoarsenError();
+}
+
+/// <summary>
+/// Builds the grid as a scene: a node per row at the row's z, the objects of the row as its children at their x.
+/// Children follow each other in the sorted scene and rows are added in order, so the objects' matrices are one
+/// range of the transform buffer in object order. The ring holds a full upload for every frame in flight.
+/// </summary>
+void LodRenderer::createSceneGraph(float spacing, uint32_t gridSize)
+{
+    const float gridOffset = (static_cast<float>(gridSize) - 1.0f) * 0.5f;
+
+    for(uint32_t i = 0; i < objectCount; ++i)
+    {
+        if(i % gridSize == 0)
+        {
+            SceneTransform row = {};
+            row.position[2] = (static_cast<float>(i / gridSize) - gridOffset) * spacing;
+            rowNodes.push_back(scene.addNode(SceneGraph::NO_PARENT, row));
+        }
+
+        SceneTransform object = {};
+        object.position[0] = (static_cast<float>(i % gridSize) - gridOffset) * spacing;
+        objectNodes.push_back(scene.addNode(rowNodes.back(), object));
+    }
+
+    scene.update();
+
+    constants.firstObjectTransform = scene.getTransformIndex(objectNodes[0]);
+    for(uint32_t i = 0; i < objectCount; ++i)
+    {
+        if(scene.getTransformIndex(objectNodes[i]) != constants.firstObjectTransform + i)
+        {
+            throw std::runtime_error("LodRenderer: Object transforms are not consecutive in the scene!");
+        }
+    }
+
+    const VkDeviceSize transformsSize = scene.getNodeCount() * SceneGraph::MATRIX_SIZE;
+    resources.allocateBuffer(transforms, transformsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    transformRing = std::make_unique<StagingRing>(vkDevice, capabilities, vkAllocator, budgetMonitor, transformsSize * slots.size());
+}
+
+void LodRenderer::createDescriptorSets()
+{
+    uint32_t setCount = 0;
+    uint32_t storageBufferCount = 0;
+    for(const ReflectedPipeline* pipeline : { &drawPipeline, &selectionPipeline })
+    {
+        if(pipeline->layout != nullptr && !pipeline->layout->setBindings.empty())
+        {
+            setCount += static_cast<uint32_t>(slots.size());
+            storageBufferCount += static_cast<uint32_t>(pipeline->layout->setBindings[0].size() * slots.size());
+        }
+    }
+
+    if(setCount == 0)
+    {
+        return;
+    }
+
+    descriptorPool = resources.createDescriptorPool(setCount, storageBufferCount);
+
+    for(uint32_t i = 0; i < slots.size(); ++i)
+    {
+        slots[i].drawDescriptorSet = allocateDescriptorSet(drawPipeline, i);
+        slots[i].selectionDescriptorSet = allocateDescriptorSet(selectionPipeline, i);
+    }
+}
+
+/// <summary>
+/// Allocates set 0 of the pipeline and points every binding the shaders declare at its buffer.
+/// </summary>
+VkDescriptorSet LodRenderer::allocateDescriptorSet(const ReflectedPipeline& pipeline, uint32_t slotIndex)
+{
+    if(pipeline.layout == nullptr || pipeline.layout->setBindings.empty())
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    const Slot& slot = slots[slotIndex];
+    return resources.allocateDescriptorSet(descriptorPool, *pipeline.layout, 0, [this, &slot](uint32_t binding) -> VkDescriptorBufferInfo
+    {
+        switch(binding)
+        {
+        case BINDING_OBJECTS:   return { transforms.buffer, 0, VK_WHOLE_SIZE };
+        case BINDING_INSTANCES: return { slot.instances.buffer, 0, VK_WHOLE_SIZE };
+        case BINDING_LEVELS:    return { meshBuffer.buffer, levelsOffset, levels.size() * sizeof(MeshLod) };
+        case BINDING_DRAW_COMMANDS:
+        case BINDING_LEVEL_STATES:
+            if(mode != LodMode::Gpu)
+            {
+                throw std::runtime_error("LodRenderer: Draw commands and level states only exist for selection on the GPU!");
+            }
+            return { binding == BINDING_DRAW_COMMANDS ? slot.drawCommands.buffer.get() : levelStates.buffer.get(), 0, VK_WHOLE_SIZE };
+        default:
+            throw std::runtime_error("LodRenderer: Shaders use unknown binding " + std::to_string(binding) + "!");
+        }
+    });
+}
+
+/// <summary>
+/// CPU side work of the frame, called after the fence of the slot was waited for: collects the statistics of the
+/// last frame of the slot, turns one row of the scene, places the camera and, unless the GPU selects, culls the
+/// objects and picks their levels.
+/// </summary>
+void LodRenderer::update(uint32_t slotIndex, uint64_t frameNumber, VkExtent2D extent)
+{
+    Slot& slot = slots[slotIndex];
+
+    if(slot.pending)
+    {
+        ++measuredFrames;
+        for(uint32_t level = 0; level < levels.size(); ++level)
+        {
+            const uint64_t instances = mode == LodMode::Gpu ? slot.mappedStatistics[level].instanceCount : slot.instanceCounts[level];
+            drawnObjects += instances;
+            drawnTriangles += instances * (levels[level].indexCount / 3);
+            fullDetailTriangles += instances * (levels[0].indexCount / 3);
+            levelObjects[level] += instances;
+        }
+        slot.pending = false;
+    }
+
+    // Every frame before this slot's previous one has completed
+    if(uploadFrameNumber != 0 && uploadFrameNumber + slots.size() <= frameNumber)
+    {
+        resources.releaseBuffer(stagingBuffer);
+    }
+    if(frameNumber > slots.size())
+    {
+        transformRing->release(frameNumber - slots.size());
+    }
+
+    // Rows take turns, the row updated this frame catches up to the angle of the frame
+    const double angle = ROW_SPIN_ANGLE * static_cast<double>(frameNumber);
+    SceneTransform row = scene.getLocalTransform(rowNodes[frameNumber % rowNodes.size()]);
+    row.rotation[0] = static_cast<float>(std::sin(0.5 * angle));
+    row.rotation[3] = static_cast<float>(std::cos(0.5 * angle));
+    scene.setLocalTransform(rowNodes[frameNumber % rowNodes.size()], row);
+
+    recomputedNodes += scene.update();
+    ++sceneUpdates;
+
+    // A fixed camera looking across the objects, so their distances span from next to the camera to the far edge
+    const Camera camera = Camera::lookAcross(sceneBounds);
+    const float aspect = extent.height > 0 ? static_cast<float>(extent.width) / static_cast<float>(extent.height) : 1.0f;
+
+    camera.getViewProjection(aspect, constants.viewProjection);
+    std::copy_n(camera.position, 3, constants.cameraPosition);
+    constants.cameraPosition[3] = 1.0f;
+    constants.projectionScale = camera.getProjectionScale(static_cast<float>(std::max(extent.height, 1u)));
+
+    if(mode != LodMode::Gpu)
+    {
+        selectLevels(slot, camera.position);
+    }
+}
+
+/// <summary>
+/// The CPU culling pass: appends every object inside the view frustum to the instance list of its level.
+/// </summary>
+void LodRenderer::selectLevels(Slot& slot, const float cameraPosition[3])
+{
+    float planes[5][4] = {};
+    Camera::getFrustumPlanes(constants.viewProjection, planes);
+
+    std::fill(std::begin(slot.instanceCounts), std::end(slot.instanceCounts), 0);
+
+    for(uint32_t i = 0; i < objectCount; ++i)
+    {
+        // The objects are not scaled, the sphere only moves with them
+        float world[16] = {};
+        scene.getWorldMatrix(objectNodes[i], world);
+
+        float center[3] = {};
+        for(uint32_t row = 0; row < 3; ++row)
+        {
+            center[row] = world[row] * constants.meshSphere[0] + world[4 + row] * constants.meshSphere[1] + world[8 + row] * constants.meshSphere[2] + world[12 + row];
+        }
+        if(!Camera::isSphereVisible(planes, center, constants.meshSphere[3]))
+        {
+            continue;
+        }
+
+        uint32_t level = 0;
+        if(mode == LodMode::Cpu)
+        {
+            const float distance = LodSelector::getDistance(cameraPosition, center, constants.meshSphere[3]);
+            level = selector.select(currentLevels[i], distance, constants.projectionScale);
+            currentLevels[i] = static_cast<uint8_t>(level);
+            largestProjectedError = std::max(largestProjectedError, selector.getProjectedError(level, distance, constants.projectionScale));
+        }
+
+        slot.mappedInstances[level * objectCount + slot.instanceCounts[level]++] = i;
+    }
+}
+
+/// <summary>
+/// Transfer and compute work before the render pass: the one time upload, the changed world matrices and, for
+/// LodMode::Gpu, the selection pass writing this slot's instance lists and draw commands.
+/// </summary>
+void LodRenderer::recordSelection(VkCommandBuffer commandBuffer, uint32_t slotIndex, uint64_t frameNumber)
+{
+    Slot& slot = slots[slotIndex];
+
+    // One buffer serves all frames in flight, the copies wait for the shaders of the previous frame
+    GpuResources::recordBufferBarrier(commandBuffer, transforms.buffer, VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    uploadedMatrices += scene.recordUpload(commandBuffer, *transformRing, transforms.buffer);
+    transformRing->commit(frameNumber);
+    GpuResources::recordBufferBarrier(commandBuffer, transforms.buffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                      VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+
+    if(uploadFrameNumber == 0)
+    {
+        const VkBufferCopy region = { 0, 0, meshBuffer.size };
+        vkCmdCopyBuffer(commandBuffer, stagingBuffer.buffer, meshBuffer.buffer, 1, &region);
+
+        GpuResources::recordBufferBarrier(commandBuffer, meshBuffer.buffer, VK_ACCESS_TRANSFER_WRITE_BIT,
+                                          VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT,
+                                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+        if(mode == LodMode::Gpu)
+        {
+            vkCmdFillBuffer(commandBuffer, levelStates.buffer, 0, VK_WHOLE_SIZE, 0);
+            GpuResources::recordBufferBarrier(commandBuffer, levelStates.buffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                                              VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+        }
+
+        uploadFrameNumber = frameNumber;
+    }
+
+    if(mode != LodMode::Gpu)
+    {
+        return;
+    }
+
+    const VkBufferCopy region = { commandsOffset, 0, levels.size() * sizeof(VkDrawIndexedIndirectCommand) };
+    vkCmdCopyBuffer(commandBuffer, meshBuffer.buffer, slot.drawCommands.buffer, 1, &region);
+    GpuResources::recordBufferBarrier(commandBuffer, slot.drawCommands.buffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                                      VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+    // The levels were written by the previous frame's selection, which may still run in the other slot
+    GpuResources::recordBufferBarrier(commandBuffer, levelStates.buffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, selectionPipeline.pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, selectionPipeline.layout->pipelineLayout, 0, 1, &slot.selectionDescriptorSet, 0, nullptr);
+    GpuResources::pushConstants(commandBuffer, selectionPipeline, &constants);
+    vkCmdDispatch(commandBuffer, (objectCount + OBJECTS_PER_SELECTION_GROUP - 1) / OBJECTS_PER_SELECTION_GROUP, 1, 1);
+
+    GpuResources::recordBufferBarrier(commandBuffer, slot.drawCommands.buffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT,
+                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT);
+    GpuResources::recordBufferBarrier(commandBuffer, slot.instances.buffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+}
+
+/// <summary>
+/// Records one instanced draw per level inside the render pass, returns the number of draw calls.
+/// </summary>
+uint32_t LodRenderer::recordDraws(VkCommandBuffer commandBuffer, uint32_t slotIndex)
+{
+    const Slot& slot = slots[slotIndex];
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPipeline.pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPipeline.layout->pipelineLayout, 0, 1, &slot.drawDescriptorSet, 0, nullptr);
+    GpuResources::pushConstants(commandBuffer, drawPipeline, &constants);
+
+    const VkBuffer vertexBuffer = meshBuffer.buffer;
+    const VkDeviceSize vertexOffset = 0;
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &vertexOffset);
+    vkCmdBindIndexBuffer(commandBuffer, meshBuffer.buffer, indexOffset, VK_INDEX_TYPE_UINT32);
+
+    uint32_t drawCount = 0;
+    for(uint32_t level = 0; level < levels.size(); ++level)
+    {
+        if(mode == LodMode::Gpu)
+        {
+            vkCmdDrawIndexedIndirect(commandBuffer, slot.drawCommands.buffer, level * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+            ++drawCount;
+        }
+        else if(slot.instanceCounts[level] > 0)
+        {
+            vkCmdDrawIndexed(commandBuffer, levels[level].indexCount, slot.instanceCounts[level], levels[level].firstIndex, 0, level * objectCount);
+            ++drawCount;
+        }
+    }
+
+    return drawCount;
+}
+
+/// <summary>
+/// Copies the draw commands written by the selection pass to host memory, after the render pass.
+/// </summary>
+void LodRenderer::recordStatistics(VkCommandBuffer commandBuffer, uint32_t slotIndex)
+{
+    Slot& slot = slots[slotIndex];
+
+    if(mode == LodMode::Gpu)
+    {
+        const VkBufferCopy region = { 0, 0, levels.size() * sizeof(VkDrawIndexedIndirectCommand) };
+        vkCmdCopyBuffer(commandBuffer, slot.drawCommands.buffer, slot.statistics.buffer, 1, &region);
+        GpuResources::recordBufferBarrier(commandBuffer, slot.statistics.buffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT,
+                                          VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT);
+    }
+
+    slot.pending = true;
+}
+
+LodMode LodRenderer::getMode() const
+{
+    return mode;
+}
+
+void LodRenderer::printStatistics(std::ostream& stream) const
+{
+    const std::streamsize precision = stream.precision();
+
+    stream << "LodRenderer: " << getModeName(mode) << " selection, " << objectCount << " objects, " << levels.size() << " levels of";
+    for(uint32_t level = 0; level < levels.size(); ++level)
+    {
+        stream << (level == 0 ? " " : " / ") << levels[level].indexCount / 3;
+    }
+    stream << " triangles, budget " << selector.getPixelError() << " px coarsening below " << selector.getCoarsenError() << " px\n";
+
+    if(sceneUpdates > 0)
+    {
+        stream << std::fixed << std::setprecision(1)
+               << "    scene of " << scene.getNodeCount() << " nodes: " << static_cast<double>(recomputedNodes) / static_cast<double>(sceneUpdates)
+               << " recomputed and " << static_cast<double>(uploadedMatrices) / static_cast<double>(sceneUpdates) << " matrices uploaded per frame\n"
+               << std::defaultfloat << std::setprecision(precision);
+    }
+
+    if(measuredFrames == 0)
+    {
+        return;
+    }
+
+    const double frames = static_cast<double>(measuredFrames);
+    stream << std::fixed << std::setprecision(1)
+           << "    " << static_cast<double>(drawnObjects) / frames << " objects and " << static_cast<double>(drawnTriangles) / frames
+           << " triangles drawn on average over " << measuredFrames << " frames, "
+           << 100.0 * static_cast<double>(drawnTriangles) / static_cast<double>(std::max<uint64_t>(fullDetailTriangles, 1)) << "% of full detail\n"
+           << "    objects per level:";
+    for(uint32_t level = 0; level < levels.size(); ++level)
+    {
+        stream << " " << static_cast<double>(levelObjects[level]) / frames;
+    }
+    stream << "\n";
+    if(mode == LodMode::Cpu)
+    {
+        stream << std::setprecision(3) << "    largest projected error of a drawn level " << largestProjectedError << " px\n";
+    }
+    stream << std::defaultfloat << std::setprecision(precision);
+}
+
+/// <summary>
+/// Resolves LodMode::Auto and checks that the device can run the requested mode. Selection on the GPU starts the
+/// instances of a level at level * objectCount, indirect draws with a firstInstance need drawIndirectFirstInstance.
+/// </summary>
+LodMode LodRenderer::chooseMode(LodMode requested, const Features& features)
+{
+    switch(requested)
+    {
+    case LodMode::Auto:
+        return features.drawIndirectFirstInstance ? LodMode::Gpu : LodMode::Cpu;
+
+    case LodMode::Gpu:
+        if(!features.drawIndirectFirstInstance)
+        {
+            throw std::runtime_error("LodRenderer: Device does not support drawIndirectFirstInstance!");
+        }
+        return requested;
+
+    default:
+        return requested;
+    }
+}
+
+LodMode LodRenderer::parseMode(const std::string& name)
+{
+    for(LodMode mode : { LodMode::Auto, LodMode::Off, LodMode::Cpu, LodMode::Gpu })
+    {
+        if(name == getModeName(mode))
+        {
+            return mode;
+        }
+    }
+
+    throw std::runtime_error("LodRenderer: Unknown mode " + name + "!");
+}
+
+const char* LodRenderer::getModeName(LodMode mode)
+{
+    switch(mode)
+    {
+    case LodMode::Off:  return "off";
+    case LodMode::Cpu:  return "cpu";
+    case LodMode::Gpu:  return "gpu";
+    default:            return "auto";
+    }
+}
+
+/// <summary>
+/// Benchmark object: a sphere with bumps, closed and without seams so the simplifier can reduce it all the way.
+/// The levels of detail are generated here, as the conversion to .vsmesh does offline for loaded meshes.
+/// </summary>
+DecodedAsset LodRenderer::createObjectMesh()
+{
+    constexpr uint32_t SEGMENTS = 128;
+    constexpr uint32_t RINGS = 64;
+    constexpr float PI = 3.14159265358979f;
+
+    const auto radiusAt = [](float theta, float phi) { return 1.0f + 0.08f * std::sin(6.0f * theta) * std::cos(5.0f * phi); };
+
+    // Poles are single vertices, every ring in between has SEGMENTS vertices and wraps around
+    std::vector<MeshVertex> vertices;
+    vertices.reserve(2 + (RINGS - 1) * SEGMENTS);
+    vertices.push_back({ { 0.0f, radiusAt(0.0f, 0.0f), 0.0f } });
+    for(uint32_t ring = 1; ring < RINGS; ++ring)
+    {
+        const float theta = PI * static_cast<float>(ring) / static_cast<float>(RINGS);
+        for(uint32_t segment = 0; segment < SEGMENTS; ++segment)
+        {
+            const float phi = 2.0f * PI * static_cast<float>(segment) / static_cast<float>(SEGMENTS);
+            const float radius = radiusAt(theta, phi);
+
+            MeshVertex vertex = {};
+            vertex.position[0] = radius * std::sin(theta) * std::cos(phi);
+            vertex.position[1] = radius * std::cos(theta);
+            vertex.position[2] = radius * std::sin(theta) * std::sin(phi);
+            vertex.texCoord[0] = static_cast<float>(segment) / static_cast<float>(SEGMENTS);
+            vertex.texCoord[1] = static_cast<float>(ring) / static_cast<float>(RINGS);
+            vertices.push_back(vertex);
+        }
+    }
+    vertices.push_back({ { 0.0f, -radiusAt(PI, 0.0f), 0.0f } });
+
+    const uint32_t southPole = static_cast<uint32_t>(vertices.size() - 1);
+    const auto ringVertex = [](uint32_t ring, uint32_t segment) { return 1 + (ring - 1) * SEGMENTS + segment % SEGMENTS; };
+
+    // Counter clockwise seen from outside the sphere
+    std::vector<uint32_t> indices;
+    for(uint32_t segment = 0; segment < SEGMENTS; ++segment)
+    {
+        indices.insert(indices.end(), { 0, ringVertex(1, segment + 1), ringVertex(1, segment) });
+        for(uint32_t ring = 1; ring < RINGS - 1; ++ring)
+        {
+            const uint32_t upper = ringVertex(ring, segment);
+            const uint32_t upperNext = ringVertex(ring, segment + 1);
+            const uint32_t lower = ringVertex(ring + 1, segment);
+            const uint32_t lowerNext = ringVertex(ring + 1, segment + 1);
+            indices.insert(indices.end(), { upper, upperNext, lower, upperNext, lowerNext, lower });
+        }
+        indices.insert(indices.end(), { ringVertex(RINGS - 1, segment), ringVertex(RINGS - 1, segment + 1), southPole });
+    }
+
+    // Smooth normals from the area weighted face normals
+    for(size_t i = 0; i < indices.size(); i += 3)
+    {
+        const float* p0 = vertices[indices[i]].position;
+        const float* p1 = vertices[indices[i + 1]].position;
+        const float* p2 = vertices[indices[i + 2]].position;
+        const float edge1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        const float edge2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        const float normal[3] = { edge1[1] * edge2[2] - edge1[2] * edge2[1], edge1[2] * edge2[0] - edge1[0] * edge2[2], edge1[0] * edge2[1] - edge1[1] * edge2[0] };
+
+        for(int corner = 0; corner < 3; ++corner)
+        {
+            for(int component = 0; component < 3; ++component)
+            {
+                vertices[indices[i + corner]].normal[component] += normal[component];
+            }
+        }
+    }
+    for(MeshVertex& vertex : vertices)
+    {
+        const float length = std::sqrt(vertex.normal[0] * vertex.normal[0] + vertex.normal[1] * vertex.normal[1] + vertex.normal[2] * vertex.normal[2]);
+        for(float& component : vertex.normal)
+        {
+            component /= length;
+        }
+    }
+
+    return AssetDecoder::createMesh(vertices, indices);
+}
@@ -0,0 +1,154 @@
+#pragma once
+#include "AssetDecoder.h"
+#include "GpuResources.h"
+#include "LodSelector.h"
+#include "SceneGraph.h"
+#include "StagingRing.h"
+
+enum class LodMode
+{
+    Auto,   // selection on the GPU when the device can draw its indirect commands, on the CPU otherwise
+    Off,    // every visible object at full detail, the baseline the other modes are measured against
+    Cpu,    // levels selected in the CPU culling pass, which writes the instance lists of the frame
+    Gpu     // levels selected by a compute shader, which appends the instances to one indirect draw per level
+};
+
+/// <summary>
+/// Draws many instances of one mesh, each at the level of detail LodSelector picks from the distance to the camera.
+///
+/// Objects are culled against the view frustum and assigned a level, then appended to the instance list of their
+/// level: objectCount slots per level, filled from the start. One instanced draw per level covers all of its objects,
+/// the vertex shader looks the object up through gl_InstanceIndex, which starts at level * objectCount. On the CPU
+/// the lists are written to host visible memory and drawn with vkCmdDrawIndexed. On the GPU Shaders/lod_select.comp
+/// counts the instances of a level in its VkDrawIndexedIndirectCommand, reset from a template every frame; the level
+/// of every object persists in a buffer between frames for the hysteresis.
+///
+/// The objects are the leaves of a SceneGraph: one parent node per grid row, one row spinning about its axis every
+/// frame. Only the changed subtree is recomputed, and its matrices are copied from a StagingRing into the buffer of
+/// world matrices both selections and the vertex shader read; the objects' matrices follow each other in it.
+///
+/// Every frame in flight owns its instance lists and indirect commands. The drawn objects and triangles of a frame
+/// are read back once it completed.
+/// </summary>
+class LodRenderer
+{
+public:
+    using GraphicsPipelineFactory = std::function<UniquePipeline(const std::vector<std::vector<char>>& stageCode)>;
+    using ComputePipelineFactory = std::function<UniquePipeline(const std::vector<char>& code)>;
+
+    struct Shaders
+    {
+        std::vector<std::vector<char>>  drawStages                  = {};   // vertex and fragment
+        std::vector<char>               selection                   = {};   // compute shader of LodMode::Gpu
+    };
+
+    struct Features
+    {
+        bool                            drawIndirectFirstInstance   = false;
+    };
+
+    static constexpr uint32_t           OBJECTS_PER_SELECTION_GROUP = 64;   // local size of lod_select.comp
+
+                                        LodRenderer(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                                                    uint32_t slotCount, MemoryBudgetMonitor* budgetMonitor, PipelineLayoutCache& layoutCache,
+                                                    const DecodedAsset& mesh, uint32_t objectCount, LodMode mode, const LodSelector& selector,
+                                                    const Shaders& shaders, const GraphicsPipelineFactory& graphicsPipelineFactory,
+                                                    const ComputePipelineFactory& computePipelineFactory);
+                                        ~LodRenderer();
+
+                                        LodRenderer(const LodRenderer&) = delete;
+    LodRenderer&                        operator=(const LodRenderer&) = delete;
+
+    void                                update(uint32_t slot, uint64_t frameNumber, VkExtent2D extent);
+    void                                recordSelection(VkCommandBuffer commandBuffer, uint32_t slot, uint64_t frameNumber);
+    uint32_t                            recordDraws(VkCommandBuffer commandBuffer, uint32_t slot);
+    void                                recordStatistics(VkCommandBuffer commandBuffer, uint32_t slot);
+
+    LodMode                             getMode()                                                                               const;
+    void                                printStatistics(std::ostream& stream)                                                   const;
+
+    static LodMode                      chooseMode(LodMode requested, const Features& features);
+    static LodMode                      parseMode(const std::string& name);
+    static const char*                  getModeName(LodMode mode);
+    static DecodedAsset                 createObjectMesh();
+
+private:
+    // Matches the push constant block of Shaders/lod_constants.glsl
+    struct PushConstants
+    {
+        float                           viewProjection[16]          = {};
+        float                           cameraPosition[4]           = {};
+        float                           meshSphere[4]               = {};   // bounding sphere of the mesh in object space
+        uint32_t                        objectCount                 = 0;
+        uint32_t                        levelCount                  = 0;
+        float                           projectionScale             = 0.0f;
+        float                           pixelError                  = 0.0f;
+        float                           coarsenError                = 0.0f;
+        uint32_t                        firstObjectTransform        = 0;    // world matrix of object 0 in the transform buffer
+        uint32_t                        reserved[2]                 = {};
+    };
+
+    struct Slot
+    {
+        BufferAllocation                instances                   = {};   // object indices, objectCount per level
+        BufferAllocation                drawCommands                = {};   // LodMode::Gpu, one command per level
+        BufferAllocation                statistics                  = {};   // LodMode::Gpu, host visible copy of the commands
+        uint32_t*                       mappedInstances             = nullptr;
+        const VkDrawIndexedIndirectCommand* mappedStatistics        = nullptr;
+        uint32_t                        instanceCounts[AssetDecoder::MAX_LOD_COUNT] = {};  // written by the CPU selection
+        VkDescriptorSet                 drawDescriptorSet           = VK_NULL_HANDLE;
+        VkDescriptorSet                 selectionDescriptorSet      = VK_NULL_HANDLE;
+        bool                            pending                     = false;    // statistics of a submitted frame not read yet
+    };
+
+    VkDevice                            vkDevice;
+    const PhysicalDeviceCapabilities&   capabilities;
+    const VkAllocationCallbacks*        vkAllocator;
+    MemoryBudgetMonitor*                budgetMonitor;
+    const GpuResources                  resources;
+    const LodMode                       mode;
+    const LodSelector                   selector;
+    const uint32_t                      objectCount;
+
+    //Mesh - vertices and the indices of every level as laid out by the asset, then the level table and the command template
+    BufferAllocation                    meshBuffer                  = {};
+    BufferAllocation                    stagingBuffer               = {};
+    BufferAllocation                    levelStates                 = {};   // LodMode::Gpu, level of every object in the last frame
+    uint64_t                            uploadFrameNumber           = 0;    // frame recording the upload, 0 until then
+    std::vector<MeshLod>                levels                      = {};
+    VkDeviceSize                        indexOffset                 = 0;
+    VkDeviceSize                        levelsOffset                = 0;
+    VkDeviceSize                        commandsOffset              = 0;
+    MeshBounds                          sceneBounds                 = {};   // places the camera
+    std::vector<uint8_t>                currentLevels               = {};   // CPU selection, level of every object in the last frame
+    PushConstants                       constants                   = {};
+
+    //Scene - a row node per grid row with the objects of the row as children
+    SceneGraph                          scene                       = {};
+    std::vector<SceneNodeId>            rowNodes                    = {};
+    std::vector<SceneNodeId>            objectNodes                 = {};
+    std::unique_ptr<StagingRing>        transformRing               = {};
+    BufferAllocation                    transforms                  = {};   // world matrix of every scene node
+
+    ReflectedPipeline                   drawPipeline                = {};
+    ReflectedPipeline                   selectionPipeline           = {};
+    UniqueDescriptorPool                descriptorPool              = {};
+    std::vector<Slot>                   slots;
+
+    //Statistics
+    uint64_t                            measuredFrames              = 0;
+    uint64_t                            drawnObjects                = 0;
+    uint64_t                            drawnTriangles              = 0;
+    uint64_t                            fullDetailTriangles         = 0;    // of the drawn objects
+    uint64_t                            levelObjects[AssetDecoder::MAX_LOD_COUNT] = {};
+    float                               largestProjectedError       = 0.0f; // CPU selection only
+    uint64_t                            sceneUpdates                = 0;
+    uint64_t                            recomputedNodes             = 0;
+    uint64_t                            uploadedMatrices            = 0;
+
+    void                                uploadScene(const DecodedAsset& mesh);
+    void                                createSceneGraph(float spacing, uint32_t gridSize);
+    void                                selectLevels(Slot& slot, const float cameraPosition[3]);
+    void                                createDescriptorSets();
+    VkDescriptorSet                     allocateDescriptorSet(const ReflectedPipeline& pipeline, uint32_t slotIndex);
+};
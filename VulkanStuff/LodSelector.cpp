@@ -0,0 +1,76 @@
+#include "pch.h"
+#include "LodSelector.h"
+
+LodSelector::LodSelector(const std::vector<MeshLod>& lods, float pixelError, float hysteresis)
+    : pixelError(pixelError)
+    , coarsenError(pixelError * (1.0f - hysteresis))
+{
+    if(lods.empty())
+    {
+        throw std::runtime_error("LodSelector: Mesh has no levels of detail!");
+    }
+    if(!(pixelError > 0.0f) || !(hysteresis >= 0.0f && hysteresis < 1.0f))
+    {
+        throw std::runtime_error("LodSelector: Pixel error has to be positive and hysteresis within [0, 1)!");
+    }
+
+    errors.reserve(lods.size());
+    for(const MeshLod& lod : lods)
+    {
+        // Coarser levels never claim less error than finer ones, or the search from the coarse end would skip them
+        errors.push_back(std::max(lod.error, errors.empty() ? 0.0f : errors.back()));
+    }
+}
+
+uint32_t LodSelector::select(uint32_t currentLevel, float distance, float projectionScale) const
+{
+    uint32_t level = 0;
+    for(uint32_t i = static_cast<uint32_t>(errors.size()) - 1; i > 0; --i)
+    {
+        if(errors[i] * projectionScale <= pixelError * distance)
+        {
+            level = i;
+            break;
+        }
+    }
+
+    while(level > currentLevel && errors[level] * projectionScale > coarsenError * distance)
+    {
+        --level;
+    }
+
+    return level;
+}
+
+float LodSelector::getProjectedError(uint32_t level, float distance, float projectionScale) const
+{
+    return errors[level] * projectionScale / distance;
+}
+
+uint32_t LodSelector::getLevelCount() const
+{
+    return static_cast<uint32_t>(errors.size());
+}
+
+float LodSelector::getError(uint32_t level) const
+{
+    return errors[level];
+}
+
+float LodSelector::getPixelError() const
+{
+    return pixelError;
+}
+
+float LodSelector::getCoarsenError() const
+{
+    return coarsenError;
+}
+
+float LodSelector::getDistance(const float cameraPosition[3], const float center[3], float radius)
+{
+    const float offset[3] = { center[0] - cameraPosition[0], center[1] - cameraPosition[1], center[2] - cameraPosition[2] };
+    const float distance = std::sqrt(offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]);
+
+    return std::max(distance - radius, MIN_DISTANCE);
+}
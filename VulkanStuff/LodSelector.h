@@ -0,0 +1,35 @@
+#pragma once
+#include "AssetDecoder.h"
+
+/// <summary>
+/// Picks the level of detail of an object from the size its simplification error would have on screen.
+///
+/// The error of a level is projected as error * projectionScale / distance pixels, with the distance measured to the
+/// nearest point of the bounding sphere. The coarsest level within pixelError is chosen, but switching to a coarser
+/// level than the current one needs the stricter coarsenError = pixelError * (1 - hysteresis), so objects resting
+/// near a switching distance don't flip between two levels every frame. Refining is never delayed, the budget holds.
+///
+/// Shaders/lod_select.comp implements the same rule for selection on the GPU.
+/// </summary>
+class LodSelector
+{
+public:
+    static constexpr float              MIN_DISTANCE                = 0.001f;   // the camera inside a sphere sees full detail
+
+                                        LodSelector(const std::vector<MeshLod>& lods, float pixelError, float hysteresis);
+
+    uint32_t                            select(uint32_t currentLevel, float distance, float projectionScale)                    const;
+    float                               getProjectedError(uint32_t level, float distance, float projectionScale)                const;
+
+    uint32_t                            getLevelCount()                                                                         const;
+    float                               getError(uint32_t level)                                                                const;
+    float                               getPixelError()                                                                         const;
+    float                               getCoarsenError()                                                                       const;
+
+    static float                        getDistance(const float cameraPosition[3], const float center[3], float radius);
+
+private:
+    std::vector<float>                  errors;
+    float                               pixelError;
+    float                               coarsenError;
+};
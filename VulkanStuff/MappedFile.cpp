@@ -0,0 +1,112 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+    // Sharing delete access lets writers replace the file while it is mapped, see MeshFile::write.
+    const HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("MappedFile: Failed to open " + path.string() + "!");
+    }
+    fileHandle = file;
+
+    LARGE_INTEGER fileSize = {};
+    if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        throw std::runtime_error("MappedFile: " + path.string() + " is empty!");
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+
+    const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(mapping == nullptr)
+    {
+        CloseHandle(file);
+        throw std::runtime_error("MappedFile: Failed to map " + path.string() + "!");
+    }
+    mappingHandle = mapping;
+
+    data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if(data == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error("MappedFile: Failed to map " + path.string() + "!");
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    UnmapViewOfFile(data);
+    CloseHandle(mappingHandle);
+    CloseHandle(fileHandle);
+}
+
+void MappedFile::prefetch() const
+{
+    WIN32_MEMORY_RANGE_ENTRY range = { const_cast<uint8_t*>(data), size };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+    const int file = open(path.c_str(), O_RDONLY);
+    if(file < 0)
+    {
+        throw std::runtime_error("MappedFile: Failed to open " + path.string() + "!");
+    }
+
+    struct stat status = {};
+    if(fstat(file, &status) != 0 || status.st_size == 0)
+    {
+        close(file);
+        throw std::runtime_error("MappedFile: " + path.string() + " is empty!");
+    }
+    size = static_cast<size_t>(status.st_size);
+
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if(mapping == MAP_FAILED)
+    {
+        throw std::runtime_error("MappedFile: Failed to map " + path.string() + "!");
+    }
+    data = static_cast<const uint8_t*>(mapping);
+}
+
+MappedFile::~MappedFile()
+{
+    munmap(const_cast<uint8_t*>(data), size);
+}
+
+void MappedFile::prefetch() const
+{
+    madvise(const_cast<uint8_t*>(data), size, MADV_WILLNEED);
+}
+
+#endif
+
+const uint8_t* MappedFile::getData() const
+{
+    return data;
+}
+
+size_t MappedFile::getSize() const
+{
+    return size;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+/// <summary>
+/// Read-only memory mapping of a whole file.
+///
+/// The pages are loaded by the OS on first access, so the file is never copied into an intermediate buffer:
+/// readers copy straight from the mapping to where the data is needed. prefetch() asks the OS to read the
+/// pages ahead, so the thread copying from the mapping doesn't stall on page faults.
+/// </summary>
+class MappedFile
+{
+public:
+    explicit                            MappedFile(const std::filesystem::path& path);
+                                        ~MappedFile();
+
+                                        MappedFile(const MappedFile&) = delete;
+    MappedFile&                         operator=(const MappedFile&) = delete;
+
+    void                                prefetch()                                                                              const;
+
+    const uint8_t*                      getData()                                                                               const;
+    size_t                              getSize()                                                                               const;
+
+private:
+    const uint8_t*                      data                        = nullptr;
+    size_t                              size                        = 0;
+
+#ifdef _WIN32
+    void*                               fileHandle                  = nullptr;
+    void*                               mappingHandle               = nullptr;
+#endif
+};
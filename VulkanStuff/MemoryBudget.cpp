@@ -0,0 +1,129 @@
+#include "pch.h"
+#include "MemoryBudget.h"
+
+static double toMiB(VkDeviceSize bytes)
+{
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+MemoryBudgetMonitor::MemoryBudgetMonitor(VkPhysicalDevice physicalDevice, const VkPhysicalDeviceMemoryProperties& memoryProperties,
+                                         bool budgetExtensionEnabled, double evictionThreshold)
+    : vkPhysicalDevice(physicalDevice)
+    , memoryProperties(memoryProperties)
+    , budgetExtensionEnabled(budgetExtensionEnabled)
+    , evictionThreshold(evictionThreshold)
+{
+    heaps.resize(memoryProperties.memoryHeapCount);
+    for(uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i)
+    {
+        heaps[i].flags = memoryProperties.memoryHeaps[i].flags;
+        heaps[i].size = memoryProperties.memoryHeaps[i].size;
+    }
+
+    update();
+}
+
+/// <summary>
+/// Called once per frame. Reports every heap which crosses the eviction threshold in either direction.
+/// </summary>
+void MemoryBudgetMonitor::update()
+{
+    const auto updateStart = std::chrono::steady_clock::now();
+
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT, nullptr, {}, {} };
+
+    if(budgetExtensionEnabled)
+    {
+        VkPhysicalDeviceMemoryProperties2 memoryProperties2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2, &budgetProperties, {} };
+        vkGetPhysicalDeviceMemoryProperties2(vkPhysicalDevice, &memoryProperties2);
+    }
+
+    for(uint32_t i = 0; i < heaps.size(); ++i)
+    {
+        HeapBudget& heap = heaps[i];
+        heap.trackedUsage = trackedUsage[i].load(std::memory_order_relaxed);
+
+        if(budgetExtensionEnabled)
+        {
+            heap.budget = budgetProperties.heapBudget[i];
+            heap.usage = budgetProperties.heapUsage[i];
+        }
+        else
+        {
+            heap.budget = static_cast<VkDeviceSize>(static_cast<double>(heap.size) * ESTIMATED_BUDGET_FRACTION);
+            heap.usage = heap.trackedUsage;
+        }
+
+        heap.peakUsage = std::max(heap.peakUsage, heap.usage);
+
+        const bool overThreshold = static_cast<double>(heap.usage) > static_cast<double>(heap.budget) * evictionThreshold;
+        if(overThreshold != heap.overThreshold)
+        {
+            std::cout << "MemoryBudget: Heap " << i << (overThreshold ? " exceeded " : " is back below ") << evictionThreshold * 100.0
+                      << "% of its budget, usage " << toMiB(heap.usage) << " MiB of " << toMiB(heap.budget) << " MiB" << std::endl;
+        }
+        heap.overThreshold = overThreshold;
+    }
+
+    ++updateCount;
+    updateTime += std::chrono::steady_clock::now() - updateStart;
+}
+
+void MemoryBudgetMonitor::trackAllocation(uint32_t memoryTypeIndex, VkDeviceSize size)
+{
+    trackedUsage[getHeapIndex(memoryTypeIndex)].fetch_add(size, std::memory_order_relaxed);
+}
+
+void MemoryBudgetMonitor::trackFree(uint32_t memoryTypeIndex, VkDeviceSize size)
+{
+    trackedUsage[getHeapIndex(memoryTypeIndex)].fetch_sub(size, std::memory_order_relaxed);
+}
+
+uint32_t MemoryBudgetMonitor::getHeapIndex(uint32_t memoryTypeIndex) const
+{
+    return memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+}
+
+const std::vector<HeapBudget>& MemoryBudgetMonitor::getHeapBudgets() const
+{
+    return heaps;
+}
+
+/// <summary>
+/// Number of bytes which have to be released from the heap to get back below the eviction threshold.
+/// </summary>
+VkDeviceSize MemoryBudgetMonitor::getExcessBytes(uint32_t heapIndex) const
+{
+    const HeapBudget& heap = heaps[heapIndex];
+    const VkDeviceSize target = static_cast<VkDeviceSize>(static_cast<double>(heap.budget) * evictionThreshold);
+
+    return heap.usage > target ? heap.usage - target : 0;
+}
+
+bool MemoryBudgetMonitor::isBudgetExtensionEnabled() const
+{
+    return budgetExtensionEnabled;
+}
+
+void MemoryBudgetMonitor::printStatistics(std::ostream& stream) const
+{
+    stream << "MemoryBudget: " << (budgetExtensionEnabled ? "VK_EXT_memory_budget" : "estimated budget") << ", eviction threshold "
+           << evictionThreshold * 100.0 << "%, " << updateCount << " updates, "
+           << (updateCount > 0 ? updateTime.count() / static_cast<double>(updateCount) : 0.0) << " us per update\n";
+
+    const std::streamsize precision = stream.precision();
+
+    stream << std::fixed << std::setprecision(1);
+    for(size_t i = 0; i < heaps.size(); ++i)
+    {
+        const HeapBudget& heap = heaps[i];
+
+        stream << "    heap " << i << ((heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " device local" : " host        ")
+               << " size " << std::setw(9) << toMiB(heap.size) << " MiB"
+               << " budget " << std::setw(9) << toMiB(heap.budget) << " MiB"
+               << " usage " << std::setw(9) << toMiB(heap.usage) << " MiB"
+               << " peak " << std::setw(9) << toMiB(heap.peakUsage) << " MiB"
+               << " tracked " << std::setw(9) << toMiB(heap.trackedUsage) << " MiB\n";
+    }
+    stream << std::defaultfloat << std::setprecision(precision);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+struct HeapBudget
+{
+    VkMemoryHeapFlags                   flags                       = 0;
+    VkDeviceSize                        size                        = 0;
+    VkDeviceSize                        budget                      = 0;
+    VkDeviceSize                        usage                       = 0;
+    VkDeviceSize                        peakUsage                   = 0;
+    VkDeviceSize                        trackedUsage                = 0;    // allocations made by the application itself, as of the last update
+    bool                                overThreshold               = false;
+};
+
+/// <summary>
+/// Polls the memory budget and usage of every heap of the physical device.
+///
+/// With VK_EXT_memory_budget the values come from the driver and include allocations made by other processes,
+/// which matters when several renderer instances share a device. Without the extension the budget is estimated as
+/// a fixed fraction of the heap size and usage is whatever the application tracked through trackAllocation.
+/// A heap is over threshold once its usage passes evictionThreshold of its budget, which is the signal for
+/// the ResidencyManager to evict resources before the OS starts paging video memory.
+/// trackAllocation and trackFree may be called from any thread, everything else belongs to the render thread.
+/// </summary>
+class MemoryBudgetMonitor
+{
+public:
+                                        MemoryBudgetMonitor(VkPhysicalDevice physicalDevice, const VkPhysicalDeviceMemoryProperties& memoryProperties,
+                                                            bool budgetExtensionEnabled, double evictionThreshold);
+
+    void                                update();
+
+    void                                trackAllocation(uint32_t memoryTypeIndex, VkDeviceSize size);
+    void                                trackFree(uint32_t memoryTypeIndex, VkDeviceSize size);
+
+    uint32_t                            getHeapIndex(uint32_t memoryTypeIndex)                                                  const;
+    const std::vector<HeapBudget>&      getHeapBudgets()                                                                        const;
+    VkDeviceSize                        getExcessBytes(uint32_t heapIndex)                                                      const;
+    bool                                isBudgetExtensionEnabled()                                                              const;
+    void                                printStatistics(std::ostream& stream)                                                   const;
+
+private:
+    // Budget assumed without VK_EXT_memory_budget, the rest of the heap is left to the OS and other processes.
+    static constexpr double             ESTIMATED_BUDGET_FRACTION   = 0.8;
+
+    VkPhysicalDevice                    vkPhysicalDevice;
+    VkPhysicalDeviceMemoryProperties    memoryProperties;
+    const bool                          budgetExtensionEnabled;
+    const double                        evictionThreshold;
+
+    std::vector<HeapBudget>             heaps                       = {};
+    std::atomic<VkDeviceSize>           trackedUsage[VK_MAX_MEMORY_HEAPS] = {};  // init tasks allocate on several workers at once
+    uint64_t                            updateCount                 = 0;
+    std::chrono::duration<double, std::micro> updateTime            = {};
+};
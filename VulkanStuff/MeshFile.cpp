@@ -0,0 +1,279 @@
+#include "pch.h"
+#include "MeshFile.h"
+#include "MeshletBuilder.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#endif
+
+static_assert(sizeof(MeshVertex) == 32, "MeshFile: vertex layout changed, increase MeshFile::VERSION");
+static_assert(sizeof(Meshlet) == 48, "MeshFile: meshlet layout changed, increase MeshFile::VERSION");
+static_assert(sizeof(MeshLod) == 24, "MeshFile: LOD layout changed, increase MeshFile::VERSION");
+
+static std::vector<uint8_t> readWholeFile(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if(!file.is_open())
+    {
+        throw std::runtime_error("MeshFile: Failed to open " + path.string() + "!");
+    }
+
+    std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+    return data;
+}
+
+bool MeshFile::isMeshFile(const std::filesystem::path& path)
+{
+    return path.extension() == ".vsmesh";
+}
+
+/// <summary>
+/// Maps the file and returns a mesh whose data points into the mapping. The header and the meshlet and level tables
+/// are validated, the vertex, index and meshlet streams are not read.
+/// </summary>
+DecodedAsset MeshFile::load(const std::filesystem::path& path)
+{
+    auto mapping = std::make_shared<const MappedFile>(path);
+    const uint64_t fileSize = mapping->getSize();
+
+    MeshFileHeader header = {};
+    if(fileSize < sizeof(header))
+    {
+        throw std::runtime_error("MeshFile: " + path.string() + " is truncated!");
+    }
+    std::memcpy(&header, mapping->getData(), sizeof(header));
+
+    if(header.magic != MAGIC)
+    {
+        throw std::runtime_error("MeshFile: " + path.string() + " is not a mesh file!");
+    }
+    if(header.version != VERSION || header.vertexStride != sizeof(MeshVertex))
+    {
+        throw std::runtime_error("MeshFile: " + path.string() + " has version " + std::to_string(header.version) + ", convert it again!");
+    }
+
+    const auto section = [&header](MeshFileSection index) -> const MeshFileSectionEntry&
+    {
+        return header.sections[static_cast<size_t>(index)];
+    };
+
+    for(const MeshFileSectionEntry& entry : header.sections)
+    {
+        if(entry.offset % SECTION_ALIGNMENT != 0 || entry.offset > fileSize || entry.size > fileSize - entry.offset)
+        {
+            throw std::runtime_error("MeshFile: " + path.string() + " has a section outside of the file!");
+        }
+    }
+
+    // The GPU sections are uploaded as one range
+    for(uint32_t i = static_cast<uint32_t>(MeshFileSection::Indices); i <= static_cast<uint32_t>(MeshFileSection::MeshletTriangles); ++i)
+    {
+        const MeshFileSectionEntry& previous = header.sections[i - 1];
+        if(header.sections[i].offset < previous.offset + previous.size)
+        {
+            throw std::runtime_error("MeshFile: " + path.string() + " has overlapping sections!");
+        }
+    }
+
+    if(section(MeshFileSection::Vertices).size != static_cast<uint64_t>(header.vertexCount) * sizeof(MeshVertex)
+       || section(MeshFileSection::Indices).size != static_cast<uint64_t>(header.indexCount) * sizeof(uint32_t)
+       || section(MeshFileSection::MeshletVertices).size % sizeof(uint32_t) != 0
+       || section(MeshFileSection::Meshlets).size != static_cast<uint64_t>(header.meshletCount) * sizeof(Meshlet)
+       || section(MeshFileSection::Lods).size != static_cast<uint64_t>(header.lodCount) * sizeof(MeshLod)
+       || header.indexCount == 0 || header.lodCount == 0)
+    {
+        throw std::runtime_error("MeshFile: " + path.string() + " has inconsistent section sizes!");
+    }
+
+    const uint64_t gpuBegin = section(MeshFileSection::Vertices).offset;
+    const uint64_t gpuEnd = section(MeshFileSection::MeshletTriangles).offset + section(MeshFileSection::MeshletTriangles).size;
+
+    DecodedAsset mesh = {};
+    mesh.type = AssetType::Mesh;
+    mesh.mappedData = mapping->getData() + gpuBegin;
+    mesh.mappedSize = static_cast<size_t>(gpuEnd - gpuBegin);
+    mesh.vertexCount = header.vertexCount;
+    mesh.indexCount = header.indexCount;
+    mesh.indexOffset = section(MeshFileSection::Indices).offset - gpuBegin;
+    mesh.meshletVertexOffset = section(MeshFileSection::MeshletVertices).offset - gpuBegin;
+    mesh.meshletTriangleOffset = section(MeshFileSection::MeshletTriangles).offset - gpuBegin;
+    mesh.bounds = header.bounds;
+
+    // The tables are small and read by the CPU, copying them keeps their alignment independent of the mapping.
+    mesh.meshlets.resize(header.meshletCount);
+    std::memcpy(mesh.meshlets.data(), mapping->getData() + section(MeshFileSection::Meshlets).offset, section(MeshFileSection::Meshlets).size);
+    mesh.lods.resize(header.lodCount);
+    std::memcpy(mesh.lods.data(), mapping->getData() + section(MeshFileSection::Lods).offset, section(MeshFileSection::Lods).size);
+
+    // Meshlet and level ranges are trusted by every draw, unlike the streams they are cheap to check
+    const uint64_t meshletVertexCount = section(MeshFileSection::MeshletVertices).size / sizeof(uint32_t);
+    const uint64_t meshletTriangleSize = section(MeshFileSection::MeshletTriangles).size;
+
+    for(const Meshlet& meshlet : mesh.meshlets)
+    {
+        if(static_cast<uint64_t>(meshlet.vertexOffset) + meshlet.vertexCount > meshletVertexCount
+           || static_cast<uint64_t>(meshlet.triangleOffset) + static_cast<uint64_t>(meshlet.triangleCount) * 3 > meshletTriangleSize
+           || meshlet.vertexCount > MeshletBuilder::MAX_VERTICES || meshlet.triangleCount > MeshletBuilder::MAX_TRIANGLES)
+        {
+            throw std::runtime_error("MeshFile: " + path.string() + " has a meshlet outside of its vertex or triangle arrays!");
+        }
+    }
+
+    for(const MeshLod& lod : mesh.lods)
+    {
+        if(static_cast<uint64_t>(lod.firstIndex) + lod.indexCount > header.indexCount
+           || static_cast<uint64_t>(lod.firstMeshlet) + lod.meshletCount > header.meshletCount
+           || lod.indexCount == 0 || lod.indexCount % 3 != 0 || !(lod.error >= 0.0f))
+        {
+            throw std::runtime_error("MeshFile: " + path.string() + " has an invalid level of detail!");
+        }
+    }
+
+    mesh.mapping = std::move(mapping);
+
+    return mesh;
+}
+
+void MeshFile::write(const std::filesystem::path& path, const DecodedAsset& mesh)
+{
+    if(mesh.type != AssetType::Mesh)
+    {
+        throw std::runtime_error("MeshFile: Only meshes can be written!");
+    }
+
+    const uint8_t* data = mesh.getData();
+    const uint64_t dataSize = mesh.getSize();
+
+    struct SectionSource
+    {
+        const void*                     data;
+        uint64_t                        size;
+    };
+
+    const SectionSource sources[] =
+    {
+        { data,                                 static_cast<uint64_t>(mesh.vertexCount) * sizeof(MeshVertex) },
+        { data + mesh.indexOffset,              static_cast<uint64_t>(mesh.indexCount) * sizeof(uint32_t) },
+        { data + mesh.meshletVertexOffset,      mesh.meshletTriangleOffset - mesh.meshletVertexOffset },
+        { data + mesh.meshletTriangleOffset,    dataSize - mesh.meshletTriangleOffset },
+        { mesh.meshlets.data(),                 mesh.meshlets.size() * sizeof(Meshlet) },
+        { mesh.lods.data(),                     mesh.lods.size() * sizeof(MeshLod) }
+    };
+
+    MeshFileHeader header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.vertexStride = sizeof(MeshVertex);
+    header.vertexCount = mesh.vertexCount;
+    header.indexCount = mesh.indexCount;
+    header.meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+    header.lodCount = static_cast<uint32_t>(mesh.lods.size());
+    header.bounds = mesh.bounds;
+
+    uint64_t offset = sizeof(header);
+    for(size_t i = 0; i < std::size(sources); ++i)
+    {
+        offset = (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+        header.sections[i] = { offset, sources[i].size };
+        offset += sources[i].size;
+    }
+
+    std::vector<uint8_t> file(static_cast<size_t>(offset), 0);
+    std::memcpy(file.data(), &header, sizeof(header));
+    for(size_t i = 0; i < std::size(sources); ++i)
+    {
+        if(sources[i].size > 0)
+        {
+            std::memcpy(file.data() + header.sections[i].offset, sources[i].data, static_cast<size_t>(sources[i].size));
+        }
+    }
+
+    // Written next to the target and moved over it, so a running streamer never maps a half written file.
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+        if(!output.is_open())
+        {
+            throw std::runtime_error("MeshFile: Failed to create " + temporaryPath.string() + "!");
+        }
+        output.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+        if(!output)
+        {
+            throw std::runtime_error("MeshFile: Failed to write " + temporaryPath.string() + "!");
+        }
+    }
+
+#ifdef _WIN32
+    // A rename fails while the old file is mapped. MappedFile shares delete access, which lets ReplaceFile move the
+    // old file aside; existing mappings keep reading it until they are released.
+    if(std::filesystem::exists(path))
+    {
+        if(!ReplaceFileW(path.c_str(), temporaryPath.c_str(), nullptr, REPLACEFILE_IGNORE_MERGE_ERRORS, nullptr, nullptr))
+        {
+            std::filesystem::remove(temporaryPath);
+            throw std::runtime_error("MeshFile: Failed to replace " + path.string() + ", error " + std::to_string(GetLastError()) + "!");
+        }
+        return;
+    }
+#endif
+    std::filesystem::rename(temporaryPath, path);
+}
+
+/// <summary>
+/// Converts a text mesh to a .vsmesh file next to it and returns the path of the new file.
+/// </summary>
+std::filesystem::path MeshFile::convert(const std::filesystem::path& source)
+{
+    if(isMeshFile(source) || AssetDecoder::getType(source) != AssetType::Mesh)
+    {
+        throw std::runtime_error("MeshFile: " + source.string() + " is not a text mesh!");
+    }
+
+    const std::vector<uint8_t> text = readWholeFile(source);
+    const DecodedAsset mesh = AssetDecoder::decode(AssetType::Mesh, text.data(), text.size());
+
+    std::filesystem::path target = source;
+    target.replace_extension(".vsmesh");
+    write(target, mesh);
+
+    return target;
+}
+
+/// <summary>
+/// Converts the file, or every text mesh in the directory.
+/// </summary>
+void MeshFile::convertAll(const std::filesystem::path& path, std::ostream& stream)
+{
+    std::vector<std::filesystem::path> sources;
+    if(std::filesystem::is_directory(path))
+    {
+        for(const auto& entry : std::filesystem::directory_iterator(path))
+        {
+            if(entry.is_regular_file() && !isMeshFile(entry.path()) && AssetDecoder::getType(entry.path()) == AssetType::Mesh)
+            {
+                sources.push_back(entry.path());
+            }
+        }
+        std::sort(sources.begin(), sources.end());
+    }
+    else
+    {
+        sources.push_back(path);
+    }
+
+    for(const auto& source : sources)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const std::filesystem::path target = convert(source);
+
+        stream << "MeshFile: " << source.string() << " -> " << target.filename().string() << ", "
+               << std::filesystem::file_size(source) << " -> " << std::filesystem::file_size(target) << " bytes in "
+               << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms\n";
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "AssetDecoder.h"
+
+/// <summary>
+/// Sections of a .vsmesh file. The first four hold GPU data and follow each other in this order, so they are
+/// uploaded as one range. The tables are read by the CPU.
+/// </summary>
+enum class MeshFileSection : uint32_t
+{
+    Vertices,
+    Indices,
+    MeshletVertices,
+    MeshletTriangles,
+    Meshlets,
+    Lods,
+    Count
+};
+
+struct MeshFileSectionEntry
+{
+    uint64_t                            offset                      = 0;    // from the start of the file
+    uint64_t                            size                        = 0;
+};
+
+/// <summary>
+/// First bytes of a .vsmesh file. All values are little endian.
+/// </summary>
+struct MeshFileHeader
+{
+    uint32_t                            magic                       = 0;
+    uint32_t                            version                     = 0;
+    uint32_t                            vertexStride                = 0;
+    uint32_t                            vertexCount                 = 0;
+    uint32_t                            indexCount                  = 0;
+    uint32_t                            meshletCount                = 0;
+    uint32_t                            lodCount                    = 0;
+    uint32_t                            flags                       = 0;
+    MeshBounds                          bounds                      = {};
+    MeshFileSectionEntry                sections[static_cast<size_t>(MeshFileSection::Count)] = {};
+};
+
+/// <summary>
+/// Versioned binary mesh container, written offline from text formats and loaded without parsing.
+///
+/// Every section starts at a multiple of SECTION_ALIGNMENT, so the vertex, index and meshlet streams can be
+/// copied from a memory mapping straight into staging memory with the offsets GPU copies need. Loading maps
+/// the file and validates the header against the file size and the meshlet and level tables against the stream
+/// sizes; the streams are neither copied nor inspected.
+/// Files of another version are rejected, they have to be converted again.
+/// </summary>
+class MeshFile
+{
+public:
+    static constexpr uint32_t           MAGIC                       = 0x48534D56;   // "VMSH"
+    static constexpr uint32_t           VERSION                     = 3;            // 2: meshlets are built on conversion, 3: levels of detail
+    static constexpr uint64_t           SECTION_ALIGNMENT           = 64;
+
+    static bool                         isMeshFile(const std::filesystem::path& path);
+
+    static DecodedAsset                 load(const std::filesystem::path& path);
+    static void                         write(const std::filesystem::path& path, const DecodedAsset& mesh);
+    static std::filesystem::path        convert(const std::filesystem::path& source);
+    static void                         convertAll(const std::filesystem::path& path, std::ostream& stream);
+};
@@ -0,0 +1,65 @@
+#include "pch.h"
+#include "MeshLoadBenchmark.h"
+#include "MeshFile.h"
+
+/// <summary>
+/// Returns the best time of REPETITIONS calls in milliseconds.
+/// </summary>
+double MeshLoadBenchmark::measure(const std::function<void()>& function)
+{
+    double best = std::numeric_limits<double>::max();
+
+    for(uint32_t repetition = 0; repetition < REPETITIONS; ++repetition)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    return best;
+}
+
+void MeshLoadBenchmark::run(std::ostream& stream, const std::filesystem::path& source)
+{
+    const std::filesystem::path binary = MeshFile::convert(source);
+
+    const DecodedAsset reference = MeshFile::load(binary);
+    std::vector<uint8_t> staging(reference.getSize());
+
+    uint64_t checksum = 0;
+
+    const double textTime = measure([&]
+    {
+        std::ifstream file(source, std::ios::ate | std::ios::binary);
+        std::vector<uint8_t> text(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(text.data()), static_cast<std::streamsize>(text.size()));
+
+        const DecodedAsset mesh = AssetDecoder::decode(AssetType::Mesh, text.data(), text.size());
+        std::memcpy(staging.data(), mesh.getData(), std::min(mesh.getSize(), staging.size()));
+        checksum += staging[staging.size() / 2];
+    });
+
+    const double binaryTime = measure([&]
+    {
+        const DecodedAsset mesh = MeshFile::load(binary);
+        std::memcpy(staging.data(), mesh.getData(), mesh.getSize());
+        checksum += staging[staging.size() / 2];
+    });
+
+    const auto toMiB = [](uintmax_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+    const uintmax_t textSize = std::filesystem::file_size(source);
+    const uintmax_t binarySize = std::filesystem::file_size(binary);
+
+    const std::streamsize precision = stream.precision();
+    stream << std::fixed << std::setprecision(3)
+           << "MeshLoadBenchmark: " << source.filename().string() << ", " << reference.vertexCount << " vertices, " << reference.lods[0].indexCount / 3 << " triangles, "
+           << reference.lods.size() << " levels of detail, "
+           << toMiB(reference.getSize()) << " MiB of GPU data, best of " << REPETITIONS << "\n"
+           << "    text    " << std::setw(10) << textTime << " ms  " << std::setw(10) << toMiB(textSize) << " MiB file  "
+           << std::setw(10) << toMiB(textSize) / (textTime / 1000.0) << " MiB/s\n"
+           << "    binary  " << std::setw(10) << binaryTime << " ms  " << std::setw(10) << toMiB(binarySize) << " MiB file  "
+           << std::setw(10) << toMiB(binarySize) / (binaryTime / 1000.0) << " MiB/s\n"
+           << "    speedup " << std::setw(10) << textTime / binaryTime << "x  (checksum " << checksum << ")\n";
+    stream << std::defaultfloat << std::setprecision(precision);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+/// <summary>
+/// Compares the load time of a text mesh with the same mesh converted to a .vsmesh file, without a Vulkan device.
+///
+/// Both paths end with the GPU data copied into a preallocated buffer standing in for staging memory:
+///
+///     text    - read the file, parse and deduplicate vertices, copy the result
+///     binary  - map the file, validate the header, copy straight from the mapping
+///
+/// The converted file is written next to the source. The files are read repeatedly, so both measure loads from
+/// the OS file cache. Every measurement is the best of
+/// REPETITIONS runs.
+/// </summary>
+class MeshLoadBenchmark
+{
+public:
+    static void                         run(std::ostream& stream, const std::filesystem::path& source);
+
+private:
+    static constexpr uint32_t           REPETITIONS                 = 5;
+
+    static double                       measure(const std::function<void()>& function);
+};
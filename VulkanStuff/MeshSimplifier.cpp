@@ -0,0 +1,291 @@
+#include "pch.h"
+#include "MeshSimplifier.h"
+
+/// <summary>
+/// Symmetric 4x4 matrix summing weighted plane equations p * p^T, the upper triangle row by row.
+/// </summary>
+struct Quadric
+{
+    double                              a00, a01, a02, a03;
+    double                              a11, a12, a13;
+    double                              a22, a23;
+    double                              a33;
+    double                              weight;
+};
+
+struct Collapse
+{
+    uint32_t                            from;
+    uint32_t                            to;
+    double                              cost;
+};
+
+static void add(Quadric& quadric, const Quadric& other)
+{
+    quadric.a00 += other.a00; quadric.a01 += other.a01; quadric.a02 += other.a02; quadric.a03 += other.a03;
+    quadric.a11 += other.a11; quadric.a12 += other.a12; quadric.a13 += other.a13;
+    quadric.a22 += other.a22; quadric.a23 += other.a23;
+    quadric.a33 += other.a33;
+    quadric.weight += other.weight;
+}
+
+/// <summary>
+/// Weighted mean squared distance of a position to the planes of the quadric.
+/// </summary>
+static double evaluate(const Quadric& quadric, const float position[3])
+{
+    if(quadric.weight <= 0.0)
+    {
+        return 0.0;
+    }
+
+    const double x = position[0];
+    const double y = position[1];
+    const double z = position[2];
+    const double sum = quadric.a00 * x * x + 2.0 * quadric.a01 * x * y + 2.0 * quadric.a02 * x * z + 2.0 * quadric.a03 * x
+                     + quadric.a11 * y * y + 2.0 * quadric.a12 * y * z + 2.0 * quadric.a13 * y
+                     + quadric.a22 * z * z + 2.0 * quadric.a23 * z
+                     + quadric.a33;
+
+    return std::max(sum, 0.0) / quadric.weight;
+}
+
+static void computeNormal(const float* p0, const float* p1, const float* p2, double normal[3])
+{
+    const double edge1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    const double edge2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+    normal[0] = edge1[1] * edge2[2] - edge1[2] * edge2[1];
+    normal[1] = edge1[2] * edge2[0] - edge1[0] * edge2[2];
+    normal[2] = edge1[0] * edge2[1] - edge1[1] * edge2[0];
+}
+
+/// <summary>
+/// Returns the simplified index list with at most targetIndexCount indices, or as few as collapses could reach, and
+/// the largest distance error of a collapse in object space units.
+/// </summary>
+std::vector<uint32_t> MeshSimplifier::simplify(const MeshVertex* vertices, size_t vertexCount, const std::vector<uint32_t>& indices,
+                                               size_t targetIndexCount, float& error)
+{
+    if(indices.size() % 3 != 0)
+    {
+        throw std::runtime_error("MeshSimplifier: Index count is not a multiple of 3!");
+    }
+    for(const uint32_t index : indices)
+    {
+        if(index >= vertexCount)
+        {
+            throw std::runtime_error("MeshSimplifier: Index " + std::to_string(index) + " is out of range!");
+        }
+    }
+
+    // Plane quadrics weighted by triangle area, so small triangles don't outweigh large ones
+    std::vector<Quadric> quadrics(vertexCount, Quadric{});
+    for(size_t i = 0; i < indices.size(); i += 3)
+    {
+        double normal[3] = {};
+        computeNormal(vertices[indices[i]].position, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position, normal);
+
+        const double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if(length == 0.0)
+        {
+            continue;
+        }
+
+        const double a = normal[0] / length;
+        const double b = normal[1] / length;
+        const double c = normal[2] / length;
+        const float* p0 = vertices[indices[i]].position;
+        const double d = -(a * p0[0] + b * p0[1] + c * p0[2]);
+        const double w = length * 0.5;
+
+        const Quadric plane = { w * a * a, w * a * b, w * a * c, w * a * d,
+                                w * b * b, w * b * c, w * b * d,
+                                w * c * c, w * c * d,
+                                w * d * d,
+                                w };
+        for(int corner = 0; corner < 3; ++corner)
+        {
+            add(quadrics[indices[i + corner]], plane);
+        }
+    }
+
+    std::vector<uint32_t> result = indices;
+    std::vector<uint32_t> adjacencyOffsets;
+    std::vector<uint32_t> adjacency;
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<uint8_t> locked;
+    std::vector<uint8_t> touched;
+    std::vector<Collapse> collapses;
+    double maximumCost = 0.0;
+
+    targetIndexCount -= targetIndexCount % 3;
+
+    while(result.size() > targetIndexCount)
+    {
+        // Triangles around every vertex
+        adjacencyOffsets.assign(vertexCount + 1, 0);
+        for(const uint32_t index : result)
+        {
+            ++adjacencyOffsets[index + 1];
+        }
+        for(size_t vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            adjacencyOffsets[vertex + 1] += adjacencyOffsets[vertex];
+        }
+        adjacency.resize(result.size());
+        std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for(size_t i = 0; i < result.size(); ++i)
+        {
+            adjacency[cursors[result[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        // A directed edge without its opposite edge is on a border, which locks both of its vertices
+        const auto hasEdge = [&](uint32_t a, uint32_t b)
+        {
+            for(uint32_t k = adjacencyOffsets[a]; k < adjacencyOffsets[a + 1]; ++k)
+            {
+                const uint32_t* triangle = result.data() + adjacency[k] * 3;
+                for(int corner = 0; corner < 3; ++corner)
+                {
+                    if(triangle[corner] == a && triangle[(corner + 1) % 3] == b)
+                    {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        };
+
+        locked.assign(vertexCount, 0);
+        for(size_t i = 0; i < result.size(); i += 3)
+        {
+            for(int corner = 0; corner < 3; ++corner)
+            {
+                const uint32_t a = result[i + corner];
+                const uint32_t b = result[i + (corner + 1) % 3];
+                if(!hasEdge(b, a))
+                {
+                    locked[a] = 1;
+                    locked[b] = 1;
+                }
+            }
+        }
+
+        // Every inner edge once, collapsing in the cheaper direction
+        collapses.clear();
+        for(size_t i = 0; i < result.size(); i += 3)
+        {
+            for(int corner = 0; corner < 3; ++corner)
+            {
+                const uint32_t a = result[i + corner];
+                const uint32_t b = result[i + (corner + 1) % 3];
+                if(a >= b || (locked[a] && locked[b]))
+                {
+                    continue;
+                }
+
+                Quadric quadric = quadrics[a];
+                add(quadric, quadrics[b]);
+                const double costToB = locked[a] ? std::numeric_limits<double>::max() : evaluate(quadric, vertices[b].position);
+                const double costToA = locked[b] ? std::numeric_limits<double>::max() : evaluate(quadric, vertices[a].position);
+                collapses.push_back(costToB <= costToA ? Collapse{ a, b, costToB } : Collapse{ b, a, costToA });
+            }
+        }
+        if(collapses.empty())
+        {
+            break;
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& left, const Collapse& right) { return left.cost < right.cost; });
+
+        // Cheapest collapses first. The triangles around a collapsed vertex are left alone for the rest of the pass,
+        // so the flip test of every collapse sees the positions it will end up with.
+        for(size_t vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            remap[vertex] = static_cast<uint32_t>(vertex);
+        }
+        touched.assign(vertexCount, 0);
+
+        const size_t excessTriangles = (result.size() - targetIndexCount) / 3;
+        size_t removedTriangles = 0;
+        size_t collapseCount = 0;
+
+        for(const Collapse& collapse : collapses)
+        {
+            if(removedTriangles >= excessTriangles)
+            {
+                break;
+            }
+            if(touched[collapse.from] || touched[collapse.to])
+            {
+                continue;
+            }
+
+            bool flips = false;
+            size_t sharedTriangles = 0;
+            for(uint32_t k = adjacencyOffsets[collapse.from]; k < adjacencyOffsets[collapse.from + 1] && !flips; ++k)
+            {
+                const uint32_t* triangle = result.data() + adjacency[k] * 3;
+                if(triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                {
+                    ++sharedTriangles;
+                    continue;
+                }
+
+                const float* before[3] = {};
+                const float* after[3] = {};
+                for(int corner = 0; corner < 3; ++corner)
+                {
+                    before[corner] = vertices[triangle[corner]].position;
+                    after[corner] = triangle[corner] == collapse.from ? vertices[collapse.to].position : before[corner];
+                }
+
+                double normalBefore[3] = {};
+                double normalAfter[3] = {};
+                computeNormal(before[0], before[1], before[2], normalBefore);
+                computeNormal(after[0], after[1], after[2], normalAfter);
+                flips = normalBefore[0] * normalAfter[0] + normalBefore[1] * normalAfter[1] + normalBefore[2] * normalAfter[2] <= 0.0;
+            }
+            if(flips)
+            {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            add(quadrics[collapse.to], quadrics[collapse.from]);
+            maximumCost = std::max(maximumCost, collapse.cost);
+            removedTriangles += sharedTriangles;
+            ++collapseCount;
+
+            for(uint32_t k = adjacencyOffsets[collapse.from]; k < adjacencyOffsets[collapse.from + 1]; ++k)
+            {
+                const uint32_t* triangle = result.data() + adjacency[k] * 3;
+                touched[triangle[0]] = 1;
+                touched[triangle[1]] = 1;
+                touched[triangle[2]] = 1;
+            }
+        }
+        if(collapseCount == 0)
+        {
+            break;
+        }
+
+        // Triangles that lost an edge are gone
+        size_t written = 0;
+        for(size_t i = 0; i < result.size(); i += 3)
+        {
+            const uint32_t a = remap[result[i]];
+            const uint32_t b = remap[result[i + 1]];
+            const uint32_t c = remap[result[i + 2]];
+            if(a != b && b != c && c != a)
+            {
+                result[written++] = a;
+                result[written++] = b;
+                result[written++] = c;
+            }
+        }
+        result.resize(written);
+    }
+
+    error = static_cast<float>(std::sqrt(maximumCost));
+    return result;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "AssetDecoder.h"
+
+/// <summary>
+/// Reduces the triangle count of an indexed triangle list by edge collapses ordered by quadric error.
+///
+/// Every vertex carries the area weighted quadric of the planes of its triangles, so the cost of collapsing one
+/// vertex onto another is the weighted mean squared distance of the target position to the planes both vertices
+/// stood on. Collapses keep one of the two vertices, the vertex array is left untouched and the result indexes the
+/// same vertices as the input, which lets all levels of detail share one vertex buffer.
+///
+/// Vertices on open borders are locked, this includes attribute seams where a position is split into several
+/// vertices, so holes don't grow and seams don't tear. Collapses flipping a triangle are rejected. Each pass
+/// collapses the cheapest independent edges, passes repeat until the target is reached or nothing can collapse.
+/// </summary>
+class MeshSimplifier
+{
+public:
+    static std::vector<uint32_t>        simplify(const MeshVertex* vertices, size_t vertexCount, const std::vector<uint32_t>& indices,
+                                                 size_t targetIndexCount, float& error);
+};
@@ -0,0 +1,159 @@
+#include "pch.h"
+#include "MeshletBuilder.h"
+
+/// <summary>
+/// Appends the meshlets of an indexed triangle list and their vertex and triangle arrays, returns the number of
+/// meshlets added. Meshlet offsets are relative to the start of the arrays as passed in.
+/// </summary>
+uint32_t MeshletBuilder::build(const MeshVertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount,
+                               std::vector<Meshlet>& meshlets, std::vector<uint32_t>& meshletVertices, std::vector<uint8_t>& meshletTriangles)
+{
+    if(indexCount % 3 != 0)
+    {
+        throw std::runtime_error("MeshletBuilder: Index count is not a multiple of 3!");
+    }
+
+    const size_t firstMeshlet = meshlets.size();
+
+    // A vertex belongs to the current meshlet when its stamp matches, which saves clearing the table per meshlet
+    std::vector<uint32_t> vertexStamps(vertexCount, 0);
+    std::vector<uint8_t> localIndices(vertexCount, 0);
+    uint32_t stamp = 1;
+
+    Meshlet meshlet = {};
+    meshlet.vertexOffset = static_cast<uint32_t>(meshletVertices.size());
+    meshlet.triangleOffset = static_cast<uint32_t>(meshletTriangles.size());
+
+    const auto finishMeshlet = [&]()
+    {
+        if(meshlet.triangleCount == 0)
+        {
+            return;
+        }
+
+        computeBounds(meshlet, vertices, meshletVertices.data() + meshlet.vertexOffset, meshletTriangles.data() + meshlet.triangleOffset);
+        meshlets.push_back(meshlet);
+
+        meshlet = {};
+        meshlet.vertexOffset = static_cast<uint32_t>(meshletVertices.size());
+        meshlet.triangleOffset = static_cast<uint32_t>(meshletTriangles.size());
+        ++stamp;
+    };
+
+    for(size_t i = 0; i < indexCount; i += 3)
+    {
+        const uint32_t* triangle = indices + i;
+
+        uint32_t newVertices = 0;
+        for(int corner = 0; corner < 3; ++corner)
+        {
+            if(triangle[corner] >= vertexCount)
+            {
+                throw std::runtime_error("MeshletBuilder: Index " + std::to_string(triangle[corner]) + " is out of range!");
+            }
+            newVertices += vertexStamps[triangle[corner]] != stamp ? 1 : 0;
+        }
+
+        if(meshlet.vertexCount + newVertices > MAX_VERTICES || meshlet.triangleCount == MAX_TRIANGLES)
+        {
+            finishMeshlet();
+        }
+
+        for(int corner = 0; corner < 3; ++corner)
+        {
+            const uint32_t vertex = triangle[corner];
+            if(vertexStamps[vertex] != stamp)
+            {
+                vertexStamps[vertex] = stamp;
+                localIndices[vertex] = static_cast<uint8_t>(meshlet.vertexCount++);
+                meshletVertices.push_back(vertex);
+            }
+            meshletTriangles.push_back(localIndices[vertex]);
+        }
+        ++meshlet.triangleCount;
+    }
+    finishMeshlet();
+
+    return static_cast<uint32_t>(meshlets.size() - firstMeshlet);
+}
+
+void MeshletBuilder::computeBounds(Meshlet& meshlet, const MeshVertex* vertices, const uint32_t* meshletVertices, const uint8_t* meshletTriangles)
+{
+    // Sphere around the center of the bounding box
+    float minimum[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+    float maximum[3] = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+    for(uint32_t i = 0; i < meshlet.vertexCount; ++i)
+    {
+        const float* position = vertices[meshletVertices[i]].position;
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            minimum[axis] = std::min(minimum[axis], position[axis]);
+            maximum[axis] = std::max(maximum[axis], position[axis]);
+        }
+    }
+
+    float radiusSquared = 0.0f;
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        meshlet.center[axis] = (minimum[axis] + maximum[axis]) * 0.5f;
+    }
+    for(uint32_t i = 0; i < meshlet.vertexCount; ++i)
+    {
+        const float* position = vertices[meshletVertices[i]].position;
+        float distanceSquared = 0.0f;
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            distanceSquared += (position[axis] - meshlet.center[axis]) * (position[axis] - meshlet.center[axis]);
+        }
+        radiusSquared = std::max(radiusSquared, distanceSquared);
+    }
+    meshlet.radius = std::sqrt(radiusSquared);
+
+    // Cone around the average of the counter clockwise face normals, degenerate triangles don't count
+    float normals[MAX_TRIANGLES][3] = {};
+    uint32_t normalCount = 0;
+    float axis[3] = {};
+    for(uint32_t i = 0; i < meshlet.triangleCount; ++i)
+    {
+        const float* p0 = vertices[meshletVertices[meshletTriangles[i * 3 + 0]]].position;
+        const float* p1 = vertices[meshletVertices[meshletTriangles[i * 3 + 1]]].position;
+        const float* p2 = vertices[meshletVertices[meshletTriangles[i * 3 + 2]]].position;
+
+        const float edge1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        const float edge2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        float* normal = normals[normalCount];
+        normal[0] = edge1[1] * edge2[2] - edge1[2] * edge2[1];
+        normal[1] = edge1[2] * edge2[0] - edge1[0] * edge2[2];
+        normal[2] = edge1[0] * edge2[1] - edge1[1] * edge2[0];
+
+        const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if(length > 0.0f)
+        {
+            for(int component = 0; component < 3; ++component)
+            {
+                normal[component] /= length;
+                axis[component] += normal[component];
+            }
+            ++normalCount;
+        }
+    }
+
+    const float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    if(axisLength == 0.0f)
+    {
+        return;
+    }
+    for(int component = 0; component < 3; ++component)
+    {
+        meshlet.coneAxis[component] = axis[component] / axisLength;
+    }
+
+    float minimumDot = 1.0f;
+    for(uint32_t i = 0; i < normalCount; ++i)
+    {
+        minimumDot = std::min(minimumDot, normals[i][0] * meshlet.coneAxis[0] + normals[i][1] * meshlet.coneAxis[1] + normals[i][2] * meshlet.coneAxis[2]);
+    }
+
+    // Normals more than ~84 degrees from the axis leave a cone too wide to ever cull
+    meshlet.coneCutoff = minimumDot <= 0.1f ? 1.0f : std::sqrt(1.0f - minimumDot * minimumDot);
+}
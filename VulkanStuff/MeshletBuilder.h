@@ -0,0 +1,27 @@
+#pragma once
+#include "AssetDecoder.h"
+
+/// <summary>
+/// Splits an indexed triangle list into meshlets small enough for one mesh shader workgroup.
+///
+/// Triangles are taken in index buffer order and added to the current meshlet until it would exceed MAX_VERTICES
+/// unique vertices or MAX_TRIANGLES triangles, so meshlets stay as coherent as the index order of the mesh. Each
+/// meshlet gets a bounding sphere for frustum culling and a normal cone for backface culling: a meshlet is invisible
+/// from camera position c when dot(center - c, coneAxis) >= coneCutoff * length(center - c) + radius. Meshlets whose
+/// normals spread too far for a useful cone get coneCutoff 1 and are never backface culled.
+///
+/// The triangle bytes of a meshlet follow those of the previous meshlet without gaps, so triangleOffset is also the
+/// first index of the meshlet in an index buffer expanded from the meshlets.
+/// </summary>
+class MeshletBuilder
+{
+public:
+    static constexpr uint32_t           MAX_VERTICES                = 64;
+    static constexpr uint32_t           MAX_TRIANGLES               = 124;
+
+    static uint32_t                     build(const MeshVertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount,
+                                              std::vector<Meshlet>& meshlets, std::vector<uint32_t>& meshletVertices, std::vector<uint8_t>& meshletTriangles);
+
+private:
+    static void                         computeBounds(Meshlet& meshlet, const MeshVertex* vertices, const uint32_t* meshletVertices, const uint8_t* meshletTriangles);
+};
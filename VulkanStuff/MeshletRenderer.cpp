@@ -0,0 +1,510 @@
+#include "pch.h"
+#include "MeshletRenderer.h"
+#include "Camera.h"
+
+// Descriptor bindings of set 0 declared by the meshlet shaders
+static constexpr uint32_t BINDING_MESHLETS          = 0;
+static constexpr uint32_t BINDING_MESH_DATA         = 1;
+static constexpr uint32_t BINDING_DRAW_COMMANDS     = 2;
+static constexpr uint32_t BINDING_STATISTICS        = 3;
+
+// Smallest maxTaskWorkGroupCount[0] the extension guarantees
+static constexpr uint32_t MIN_MAX_TASK_WORKGROUPS   = 65535;
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+MeshletRenderer::MeshletRenderer(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                                 uint32_t slotCount, MemoryBudgetMonitor* budgetMonitor, PipelineLayoutCache& layoutCache,
+                                 const DecodedAsset& mesh, MeshletPath path, const Features& features, const Shaders& shaders,
+                                 const GraphicsPipelineFactory& graphicsPipelineFactory, const ComputePipelineFactory& computePipelineFactory,
+                                 PFN_vkCmdDrawMeshTasksEXT drawMeshTasks)
+    : vkDevice(device)
+    , capabilities(capabilities)
+    , resources(device, capabilities, allocator, budgetMonitor, "MeshletRenderer")
+    , path(path)
+    , features(features)
+    , drawMeshTasks(drawMeshTasks)
+    , bounds(mesh.bounds)
+    , slots(slotCount)
+{
+    if(mesh.type != AssetType::Mesh || mesh.meshlets.empty())
+    {
+        throw std::runtime_error("MeshletRenderer: Asset is not a mesh with meshlets!");
+    }
+    if(path == MeshletPath::Auto)
+    {
+        throw std::runtime_error("MeshletRenderer: Path has to be chosen with choosePath!");
+    }
+    if(path == MeshletPath::MeshShader && drawMeshTasks == nullptr)
+    {
+        throw std::runtime_error("MeshletRenderer: vkCmdDrawMeshTasksEXT is not available!");
+    }
+
+    uploadMesh(mesh);
+
+    if(path == MeshletPath::MeshShader && (meshletCount + MESHLETS_PER_TASK - 1) / MESHLETS_PER_TASK > MIN_MAX_TASK_WORKGROUPS)
+    {
+        throw std::runtime_error("MeshletRenderer: " + std::to_string(meshletCount) + " meshlets need too many task shader workgroups!");
+    }
+    if(path == MeshletPath::ComputeCulling && meshletCount > capabilities.properties.limits.maxDrawIndirectCount)
+    {
+        throw std::runtime_error("MeshletRenderer: " + std::to_string(meshletCount) + " meshlets exceed maxDrawIndirectCount!");
+    }
+
+    drawPipeline = resources.createPipeline(graphicsPipelineFactory(shaders.drawStages), shaders.drawStages, layoutCache, sizeof(PushConstants));
+    if(path == MeshletPath::ComputeCulling)
+    {
+        cullingPipeline = resources.createPipeline(computePipelineFactory(shaders.culling), { shaders.culling }, layoutCache, sizeof(PushConstants));
+    }
+
+    for(Slot& slot : slots)
+    {
+        if(path == MeshletPath::ComputeCulling)
+        {
+            resources.allocateBuffer(slot.drawCommands, DRAW_COMMANDS_OFFSET + static_cast<VkDeviceSize>(meshletCount) * sizeof(VkDrawIndexedIndirectCommand),
+                                     VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        }
+
+        // A handful of atomics per frame, written straight into host memory instead of being copied back
+        resources.allocateBuffer(slot.statistics, 4 * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+        void* mapped = nullptr;
+        resources.mapBuffer(slot.statistics, &mapped);
+        slot.mappedStatistics = static_cast<const uint32_t*>(mapped);
+    }
+
+    createDescriptorSets();
+}
+
+MeshletRenderer::~MeshletRenderer()
+{
+    descriptorPool.reset();
+
+    for(Slot& slot : slots)
+    {
+        resources.releaseBuffer(slot.drawCommands);
+        resources.releaseBuffer(slot.statistics);
+    }
+    resources.releaseBuffer(meshBuffer);
+    resources.releaseBuffer(stagingBuffer);
+}
+
+/// <summary>
+/// Lays out the mesh buffer and fills the staging buffer it is copied from by the first frame. Only the meshlets of
+/// the full detail level are drawn.
+/// </summary>
+void MeshletRenderer::uploadMesh(const DecodedAsset& mesh)
+{
+    const MeshLod lod = mesh.lods.empty() ? MeshLod{ 0, mesh.indexCount, 0, static_cast<uint32_t>(mesh.meshlets.size()), 0.0f, 0 } : mesh.lods[0];
+    if(lod.firstMeshlet != 0 || lod.meshletCount == 0 || mesh.meshletVertexOffset % sizeof(uint32_t) != 0)
+    {
+        throw std::runtime_error("MeshletRenderer: Mesh layout is not supported!");
+    }
+
+    const uint8_t* data = mesh.getData();
+    const uint32_t* meshletVertices = reinterpret_cast<const uint32_t*>(data + mesh.meshletVertexOffset);
+    const uint8_t* meshletTriangles = data + mesh.meshletTriangleOffset;
+
+    indexCount = lod.indexCount;
+    meshletCount = lod.meshletCount;
+
+    // The indirect draws index a buffer expanded from the meshlets, where triangleOffset is the first index of a meshlet
+    std::vector<uint32_t> meshletIndices;
+    for(uint32_t i = 0; i < meshletCount; ++i)
+    {
+        const Meshlet& meshlet = mesh.meshlets[i];
+        if(meshlet.triangleOffset != triangleCount * 3)
+        {
+            throw std::runtime_error("MeshletRenderer: Meshlet triangles are not contiguous!");
+        }
+        triangleCount += meshlet.triangleCount;
+
+        if(path == MeshletPath::ComputeCulling)
+        {
+            for(uint32_t corner = 0; corner < meshlet.triangleCount * 3; ++corner)
+            {
+                meshletIndices.push_back(meshletVertices[meshlet.vertexOffset + meshletTriangles[meshlet.triangleOffset + corner]]);
+            }
+        }
+    }
+
+    const VkDeviceSize alignment = std::max<VkDeviceSize>(capabilities.properties.limits.minStorageBufferOffsetAlignment, 16);
+    dataSize = alignUp(mesh.getSize(), sizeof(uint32_t));
+    indexOffset = mesh.indexOffset + lod.firstIndex * sizeof(uint32_t);
+    meshletsOffset = alignUp(dataSize, alignment);
+    meshletIndicesOffset = alignUp(meshletsOffset + meshletCount * sizeof(Meshlet), alignment);
+    const VkDeviceSize bufferSize = meshletIndicesOffset + meshletIndices.size() * sizeof(uint32_t);
+
+    if(dataSize > capabilities.properties.limits.maxStorageBufferRange)
+    {
+        throw std::runtime_error("MeshletRenderer: Mesh data exceeds maxStorageBufferRange!");
+    }
+
+    resources.allocateBuffer(stagingBuffer, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    resources.allocateBuffer(meshBuffer, bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                                                     | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    void* mapped = nullptr;
+    resources.mapBuffer(stagingBuffer, &mapped);
+    uint8_t* staging = static_cast<uint8_t*>(mapped);
+    std::memset(staging, 0, static_cast<size_t>(bufferSize));
+    std::memcpy(staging, data, mesh.getSize());
+    std::memcpy(staging + meshletsOffset, mesh.meshlets.data(), meshletCount * sizeof(Meshlet));
+    if(!meshletIndices.empty())
+    {
+        std::memcpy(staging + meshletIndicesOffset, meshletIndices.data(), meshletIndices.size() * sizeof(uint32_t));
+    }
+    vkUnmapMemory(vkDevice, stagingBuffer.memory);
+
+    constants.meshletCount = meshletCount;
+    constants.meshletVertexOffset = static_cast<uint32_t>(mesh.meshletVertexOffset / sizeof(uint32_t));
+    constants.meshletTriangleOffset = static_cast<uint32_t>(mesh.meshletTriangleOffset);
+}
+
+void MeshletRenderer::createDescriptorSets()
+{
+    uint32_t setCount = 0;
+    uint32_t storageBufferCount = 0;
+    for(const ReflectedPipeline* pipeline : { &drawPipeline, &cullingPipeline })
+    {
+        if(pipeline->layout != nullptr && !pipeline->layout->setBindings.empty())
+        {
+            setCount += static_cast<uint32_t>(slots.size());
+            storageBufferCount += static_cast<uint32_t>(pipeline->layout->setBindings[0].size() * slots.size());
+        }
+    }
+
+    if(setCount == 0)
+    {
+        return;
+    }
+
+    descriptorPool = resources.createDescriptorPool(setCount, storageBufferCount);
+
+    for(uint32_t i = 0; i < slots.size(); ++i)
+    {
+        slots[i].drawDescriptorSet = allocateDescriptorSet(drawPipeline, i);
+        slots[i].cullingDescriptorSet = allocateDescriptorSet(cullingPipeline, i);
+    }
+}
+
+/// <summary>
+/// Allocates set 0 of the pipeline and points every binding the shaders declare at its buffer.
+/// </summary>
+VkDescriptorSet MeshletRenderer::allocateDescriptorSet(const ReflectedPipeline& pipeline, uint32_t slotIndex)
+{
+    if(pipeline.layout == nullptr || pipeline.layout->setBindings.empty())
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    const Slot& slot = slots[slotIndex];
+    return resources.allocateDescriptorSet(descriptorPool, *pipeline.layout, 0, [this, &slot](uint32_t binding) -> VkDescriptorBufferInfo
+    {
+        switch(binding)
+        {
+        case BINDING_MESHLETS:      return { meshBuffer.buffer, meshletsOffset, meshletCount * sizeof(Meshlet) };
+        case BINDING_MESH_DATA:     return { meshBuffer.buffer, 0, dataSize };
+        case BINDING_STATISTICS:    return { slot.statistics.buffer, 0, VK_WHOLE_SIZE };
+        case BINDING_DRAW_COMMANDS:
+            if(slot.drawCommands.buffer.get() == VK_NULL_HANDLE)
+            {
+                throw std::runtime_error("MeshletRenderer: Draw commands are only written by the compute culling path!");
+            }
+            return { slot.drawCommands.buffer, 0, VK_WHOLE_SIZE };
+        default:
+            throw std::runtime_error("MeshletRenderer: Shaders use unknown binding " + std::to_string(binding) + "!");
+        }
+    });
+}
+
+/// <summary>
+/// CPU side work of the frame, called after the fence of the slot was waited for: collects the statistics of the
+/// last frame of the slot and places the camera for the new one.
+/// </summary>
+void MeshletRenderer::update(uint32_t slotIndex, uint64_t frameNumber, VkExtent2D extent)
+{
+    Slot& slot = slots[slotIndex];
+
+    if(slot.pending)
+    {
+        ++measuredFrames;
+        visibleMeshlets += path == MeshletPath::Vertex ? meshletCount : slot.mappedStatistics[0];
+        visibleTriangles += path == MeshletPath::Vertex ? triangleCount : slot.mappedStatistics[1];
+        slot.pending = false;
+    }
+
+    // Every frame before this slot's previous one has completed
+    if(uploadFrameNumber != 0 && uploadFrameNumber + slots.size() <= frameNumber)
+    {
+        resources.releaseBuffer(stagingBuffer);
+    }
+
+    // A fixed camera looking across the mesh, about half of every object faces away from it
+    const Camera camera = Camera::lookAcross(bounds);
+    const float aspect = extent.height > 0 ? static_cast<float>(extent.width) / static_cast<float>(extent.height) : 1.0f;
+
+    camera.getViewProjection(aspect, constants.viewProjection);
+    std::copy_n(camera.position, 3, constants.cameraPosition);
+    constants.cameraPosition[3] = 1.0f;
+}
+
+/// <summary>
+/// Transfer and compute work before the render pass: the one time mesh upload, clearing the counters of the slot
+/// and the culling pass of MeshletPath::ComputeCulling.
+/// </summary>
+void MeshletRenderer::recordCulling(VkCommandBuffer commandBuffer, uint32_t slotIndex, uint64_t frameNumber)
+{
+    Slot& slot = slots[slotIndex];
+
+    const VkPipelineStageFlags shaderStages = path == MeshletPath::MeshShader ? VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT | VK_PIPELINE_STAGE_MESH_SHADER_BIT_EXT
+                                                                              : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+    if(uploadFrameNumber == 0)
+    {
+        const VkBufferCopy region = { 0, 0, meshBuffer.size };
+        vkCmdCopyBuffer(commandBuffer, stagingBuffer.buffer, meshBuffer.buffer, 1, &region);
+
+        GpuResources::recordBufferBarrier(commandBuffer, meshBuffer.buffer, VK_ACCESS_TRANSFER_WRITE_BIT,
+                                          VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT,
+                                          VK_PIPELINE_STAGE_TRANSFER_BIT, shaderStages | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+
+        uploadFrameNumber = frameNumber;
+    }
+
+    if(path == MeshletPath::Vertex)
+    {
+        return;
+    }
+
+    vkCmdFillBuffer(commandBuffer, slot.statistics.buffer, 0, VK_WHOLE_SIZE, 0);
+    GpuResources::recordBufferBarrier(commandBuffer, slot.statistics.buffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                                      VK_PIPELINE_STAGE_TRANSFER_BIT, shaderStages);
+
+    if(path != MeshletPath::ComputeCulling)
+    {
+        return;
+    }
+
+    // Without a GPU draw count every command is drawn, the ones no visible meshlet was written to have to be empty
+    vkCmdFillBuffer(commandBuffer, slot.drawCommands.buffer, 0, features.drawIndirectCount ? DRAW_COMMANDS_OFFSET : VK_WHOLE_SIZE, 0);
+    GpuResources::recordBufferBarrier(commandBuffer, slot.drawCommands.buffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                                      VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullingPipeline.pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullingPipeline.layout->pipelineLayout, 0, 1, &slot.cullingDescriptorSet, 0, nullptr);
+    GpuResources::pushConstants(commandBuffer, cullingPipeline, &constants);
+    vkCmdDispatch(commandBuffer, (meshletCount + MESHLETS_PER_CULLING_GROUP - 1) / MESHLETS_PER_CULLING_GROUP, 1, 1);
+
+    GpuResources::recordBufferBarrier(commandBuffer, slot.drawCommands.buffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
+}
+
+/// <summary>
+/// Records the draws inside the render pass, returns the number of draw calls.
+/// </summary>
+uint32_t MeshletRenderer::recordDraws(VkCommandBuffer commandBuffer, uint32_t slotIndex)
+{
+    const Slot& slot = slots[slotIndex];
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPipeline.pipeline);
+    if(slot.drawDescriptorSet != VK_NULL_HANDLE)
+    {
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPipeline.layout->pipelineLayout, 0, 1, &slot.drawDescriptorSet, 0, nullptr);
+    }
+    GpuResources::pushConstants(commandBuffer, drawPipeline, &constants);
+
+    if(path == MeshletPath::MeshShader)
+    {
+        drawMeshTasks(commandBuffer, (meshletCount + MESHLETS_PER_TASK - 1) / MESHLETS_PER_TASK, 1, 1);
+        return 1;
+    }
+
+    const VkBuffer vertexBuffer = meshBuffer.buffer;
+    const VkDeviceSize vertexOffset = 0;
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &vertexOffset);
+
+    if(path == MeshletPath::ComputeCulling)
+    {
+        vkCmdBindIndexBuffer(commandBuffer, meshBuffer.buffer, meshletIndicesOffset, VK_INDEX_TYPE_UINT32);
+        if(features.drawIndirectCount)
+        {
+            vkCmdDrawIndexedIndirectCount(commandBuffer, slot.drawCommands.buffer, DRAW_COMMANDS_OFFSET, slot.drawCommands.buffer, 0,
+                                          meshletCount, sizeof(VkDrawIndexedIndirectCommand));
+        }
+        else
+        {
+            vkCmdDrawIndexedIndirect(commandBuffer, slot.drawCommands.buffer, DRAW_COMMANDS_OFFSET, meshletCount, sizeof(VkDrawIndexedIndirectCommand));
+        }
+        return 1;
+    }
+
+    vkCmdBindIndexBuffer(commandBuffer, meshBuffer.buffer, indexOffset, VK_INDEX_TYPE_UINT32);
+    vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+    return 1;
+}
+
+/// <summary>
+/// Makes the counters written by the shaders visible to the host once the frame completed, after the render pass.
+/// </summary>
+void MeshletRenderer::recordStatistics(VkCommandBuffer commandBuffer, uint32_t slotIndex)
+{
+    Slot& slot = slots[slotIndex];
+
+    if(path != MeshletPath::Vertex)
+    {
+        const VkPipelineStageFlags countingStage = path == MeshletPath::MeshShader ? VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        GpuResources::recordBufferBarrier(commandBuffer, slot.statistics.buffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT, countingStage, VK_PIPELINE_STAGE_HOST_BIT);
+    }
+
+    slot.pending = true;
+}
+
+MeshletPath MeshletRenderer::getPath() const
+{
+    return path;
+}
+
+void MeshletRenderer::printStatistics(std::ostream& stream) const
+{
+    stream << "MeshletRenderer: " << getPathName(path) << " path, " << meshletCount << " meshlets of " << triangleCount << " triangles";
+    if(measuredFrames > 0)
+    {
+        const double meanMeshlets = static_cast<double>(visibleMeshlets) / static_cast<double>(measuredFrames);
+        const double meanTriangles = static_cast<double>(visibleTriangles) / static_cast<double>(measuredFrames);
+        const std::streamsize precision = stream.precision();
+        stream << ", " << std::fixed << std::setprecision(1)
+               << 100.0 * meanMeshlets / meshletCount << "% of meshlets and "
+               << 100.0 * meanTriangles / triangleCount << "% of triangles drawn on average over " << measuredFrames << " frames"
+               << std::defaultfloat << std::setprecision(precision);
+    }
+    stream << "\n";
+}
+
+/// <summary>
+/// Resolves MeshletPath::Auto and checks that the device can run the requested path.
+/// </summary>
+MeshletPath MeshletRenderer::choosePath(MeshletPath requested, const Features& features)
+{
+    switch(requested)
+    {
+    case MeshletPath::Auto:
+        return features.meshShaders ? MeshletPath::MeshShader : features.multiDrawIndirect ? MeshletPath::ComputeCulling : MeshletPath::Vertex;
+
+    case MeshletPath::MeshShader:
+        if(!features.meshShaders)
+        {
+            throw std::runtime_error("MeshletRenderer: Device does not support task and mesh shaders!");
+        }
+        return requested;
+
+    case MeshletPath::ComputeCulling:
+        if(!features.multiDrawIndirect)
+        {
+            throw std::runtime_error("MeshletRenderer: Device does not support multiDrawIndirect!");
+        }
+        return requested;
+
+    default:
+        return requested;
+    }
+}
+
+MeshletPath MeshletRenderer::parsePath(const std::string& name)
+{
+    for(MeshletPath path : { MeshletPath::Auto, MeshletPath::MeshShader, MeshletPath::ComputeCulling, MeshletPath::Vertex })
+    {
+        if(name == getPathName(path))
+        {
+            return path;
+        }
+    }
+
+    throw std::runtime_error("MeshletRenderer: Unknown path " + name + "!");
+}
+
+const char* MeshletRenderer::getPathName(MeshletPath path)
+{
+    switch(path)
+    {
+    case MeshletPath::MeshShader:       return "mesh-shader";
+    case MeshletPath::ComputeCulling:   return "compute";
+    case MeshletPath::Vertex:           return "vertex";
+    default:                            return "auto";
+    }
+}
+
+/// <summary>
+/// Benchmark mesh: spheres on a square grid in the xz plane, baked into one mesh. The triangles of a sphere are
+/// emitted in patches of PATCH x PATCH quads, so the meshlets built in index order are compact and have narrow
+/// normal cones.
+/// </summary>
+DecodedAsset MeshletRenderer::createSphereField(uint32_t sphereCount)
+{
+    constexpr uint32_t SEGMENTS = 48;
+    constexpr uint32_t RINGS = 24;
+    constexpr uint32_t PATCH = 7;           // 8 x 8 vertices, 98 triangles: within one meshlet
+    constexpr float RADIUS = 1.0f;
+    constexpr float SPACING = 3.0f;
+    constexpr float PI = 3.14159265358979f;
+
+    const uint32_t gridSize = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(std::max(sphereCount, 1u)))));
+    const float gridOffset = (static_cast<float>(gridSize) - 1.0f) * 0.5f;
+
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t> indices;
+    vertices.reserve(static_cast<size_t>(sphereCount) * (RINGS + 1) * (SEGMENTS + 1));
+    indices.reserve(static_cast<size_t>(sphereCount) * RINGS * SEGMENTS * 6);
+
+    for(uint32_t sphere = 0; sphere < sphereCount; ++sphere)
+    {
+        const float centerX = (static_cast<float>(sphere % gridSize) - gridOffset) * SPACING;
+        const float centerZ = (static_cast<float>(sphere / gridSize) - gridOffset) * SPACING;
+        const uint32_t firstVertex = static_cast<uint32_t>(vertices.size());
+
+        for(uint32_t ring = 0; ring <= RINGS; ++ring)
+        {
+            const float theta = PI * static_cast<float>(ring) / static_cast<float>(RINGS);
+            for(uint32_t segment = 0; segment <= SEGMENTS; ++segment)
+            {
+                const float phi = 2.0f * PI * static_cast<float>(segment) / static_cast<float>(SEGMENTS);
+
+                MeshVertex vertex = {};
+                vertex.normal[0] = std::sin(theta) * std::cos(phi);
+                vertex.normal[1] = std::cos(theta);
+                vertex.normal[2] = std::sin(theta) * std::sin(phi);
+                vertex.position[0] = centerX + RADIUS * vertex.normal[0];
+                vertex.position[1] = RADIUS * vertex.normal[1];
+                vertex.position[2] = centerZ + RADIUS * vertex.normal[2];
+                vertex.texCoord[0] = static_cast<float>(segment) / static_cast<float>(SEGMENTS);
+                vertex.texCoord[1] = static_cast<float>(ring) / static_cast<float>(RINGS);
+                vertices.push_back(vertex);
+            }
+        }
+
+        for(uint32_t patchRing = 0; patchRing < RINGS; patchRing += PATCH)
+        {
+            for(uint32_t patchSegment = 0; patchSegment < SEGMENTS; patchSegment += PATCH)
+            {
+                for(uint32_t ring = patchRing; ring < std::min(patchRing + PATCH, RINGS); ++ring)
+                {
+                    for(uint32_t segment = patchSegment; segment < std::min(patchSegment + PATCH, SEGMENTS); ++segment)
+                    {
+                        // Counter clockwise seen from outside the sphere
+                        const uint32_t upper = firstVertex + ring * (SEGMENTS + 1) + segment;
+                        const uint32_t lower = upper + SEGMENTS + 1;
+                        indices.insert(indices.end(), { upper, upper + 1, lower, upper + 1, lower + 1, lower });
+                    }
+                }
+            }
+        }
+    }
+
+    // One object, levels of detail would only take up memory
+    return AssetDecoder::createMesh(vertices, indices, 1);
+}
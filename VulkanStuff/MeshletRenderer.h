@@ -0,0 +1,129 @@
+#pragma once
+#include "AssetDecoder.h"
+#include "GpuResources.h"
+
+enum class MeshletPath
+{
+    Auto,           // mesh shaders when the device has them, compute culling otherwise
+    MeshShader,     // a task shader culls meshlets, a mesh shader emits the survivors
+    ComputeCulling, // a compute pass culls meshlets and writes an indexed indirect draw per survivor
+    Vertex          // the whole index buffer in one draw, no culling; the baseline the other paths are measured against
+};
+
+/// <summary>
+/// Renders a mesh as meshlets, culling meshlets outside the view frustum or facing away from the camera before
+/// their triangles reach the rasterizer.
+///
+/// With mesh shaders one task shader invocation tests each meshlet and launches a mesh shader workgroup for every
+/// visible one, which reads its vertices and triangle bytes from storage buffers. Without them a compute pass does
+/// the same test and appends a VkDrawIndexedIndirectCommand per visible meshlet, drawn from an index buffer expanded
+/// from the meshlets; the number of draws comes from vkCmdDrawIndexedIndirectCount when the device has it, otherwise
+/// the unused commands are zero and drawn as empty draws. Both share the culling code in Shaders/meshlet.glsl.
+///
+/// Mesh data is uploaded once by the first frame. Every frame in flight owns its indirect commands and a statistics
+/// buffer counting the visible meshlets and triangles, read back once the frame completed.
+/// </summary>
+class MeshletRenderer
+{
+public:
+    using GraphicsPipelineFactory = std::function<UniquePipeline(const std::vector<std::vector<char>>& stageCode)>;
+    using ComputePipelineFactory = std::function<UniquePipeline(const std::vector<char>& code)>;
+
+    struct Shaders
+    {
+        std::vector<std::vector<char>>  drawStages                  = {};   // task, mesh and fragment or vertex and fragment
+        std::vector<char>               culling                     = {};   // compute shader of MeshletPath::ComputeCulling
+    };
+
+    struct Features
+    {
+        bool                            meshShaders                 = false;
+        bool                            multiDrawIndirect           = false;
+        bool                            drawIndirectCount           = false;
+    };
+
+    static constexpr uint32_t           MESHLETS_PER_TASK           = 32;   // local size of meshlet.task
+    static constexpr uint32_t           MESHLETS_PER_CULLING_GROUP  = 64;   // local size of meshlet_cull.comp
+
+                                        MeshletRenderer(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                                                        uint32_t slotCount, MemoryBudgetMonitor* budgetMonitor, PipelineLayoutCache& layoutCache,
+                                                        const DecodedAsset& mesh, MeshletPath path, const Features& features, const Shaders& shaders,
+                                                        const GraphicsPipelineFactory& graphicsPipelineFactory, const ComputePipelineFactory& computePipelineFactory,
+                                                        PFN_vkCmdDrawMeshTasksEXT drawMeshTasks);
+                                        ~MeshletRenderer();
+
+                                        MeshletRenderer(const MeshletRenderer&) = delete;
+    MeshletRenderer&                    operator=(const MeshletRenderer&) = delete;
+
+    void                                update(uint32_t slot, uint64_t frameNumber, VkExtent2D extent);
+    void                                recordCulling(VkCommandBuffer commandBuffer, uint32_t slot, uint64_t frameNumber);
+    uint32_t                            recordDraws(VkCommandBuffer commandBuffer, uint32_t slot);
+    void                                recordStatistics(VkCommandBuffer commandBuffer, uint32_t slot);
+
+    MeshletPath                         getPath()                                                                               const;
+    void                                printStatistics(std::ostream& stream)                                                   const;
+
+    static MeshletPath                  choosePath(MeshletPath requested, const Features& features);
+    static MeshletPath                  parsePath(const std::string& name);
+    static const char*                  getPathName(MeshletPath path);
+    static DecodedAsset                 createSphereField(uint32_t sphereCount);
+
+private:
+    // Matches the push constant block of Shaders/meshlet_constants.glsl
+    struct PushConstants
+    {
+        float                           viewProjection[16]          = {};
+        float                           cameraPosition[4]           = {};
+        uint32_t                        meshletCount                = 0;
+        uint32_t                        meshletVertexOffset         = 0;    // words into the mesh data
+        uint32_t                        meshletTriangleOffset       = 0;    // bytes into the mesh data
+        uint32_t                        reserved                    = 0;
+    };
+
+    struct Slot
+    {
+        BufferAllocation                drawCommands                = {};   // draw count, padded to 16 bytes, then one command per meshlet
+        BufferAllocation                statistics                  = {};   // visible meshlets and triangles, host visible
+        const uint32_t*                 mappedStatistics            = nullptr;
+        VkDescriptorSet                 drawDescriptorSet           = VK_NULL_HANDLE;
+        VkDescriptorSet                 cullingDescriptorSet        = VK_NULL_HANDLE;
+        bool                            pending                     = false;    // statistics of a submitted frame not read yet
+    };
+
+    static constexpr VkDeviceSize       DRAW_COMMANDS_OFFSET        = 16;
+
+    VkDevice                            vkDevice;
+    const PhysicalDeviceCapabilities&   capabilities;
+    const GpuResources                  resources;
+    const MeshletPath                   path;
+    const Features                      features;
+    const PFN_vkCmdDrawMeshTasksEXT     drawMeshTasks;
+
+    //Mesh - vertices, indices, meshlet vertices and triangles as laid out by the asset, then meshlets and the expanded index buffer
+    BufferAllocation                    meshBuffer                  = {};
+    BufferAllocation                    stagingBuffer               = {};
+    uint64_t                            uploadFrameNumber           = 0;    // frame recording the upload, 0 until then
+    uint32_t                            indexCount                  = 0;
+    uint32_t                            meshletCount                = 0;
+    uint32_t                            triangleCount               = 0;
+    VkDeviceSize                        dataSize                    = 0;
+    VkDeviceSize                        indexOffset                 = 0;
+    VkDeviceSize                        meshletsOffset              = 0;
+    VkDeviceSize                        meshletIndicesOffset        = 0;
+    MeshBounds                          bounds                      = {};   // places the camera
+    PushConstants                       constants                   = {};
+
+    ReflectedPipeline                   drawPipeline                = {};
+    ReflectedPipeline                   cullingPipeline             = {};
+    UniqueDescriptorPool                descriptorPool              = {};
+    std::vector<Slot>                   slots;
+
+    //Statistics
+    uint64_t                            measuredFrames              = 0;
+    uint64_t                            visibleMeshlets             = 0;
+    uint64_t                            visibleTriangles            = 0;
+
+    void                                uploadMesh(const DecodedAsset& mesh);
+    void                                createDescriptorSets();
+    VkDescriptorSet                     allocateDescriptorSet(const ReflectedPipeline& pipeline, uint32_t slotIndex);
+};
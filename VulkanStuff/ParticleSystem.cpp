@@ -0,0 +1,252 @@
+#include "pch.h"
+#include "ParticleSystem.h"
+#include "Camera.h"
+
+// Descriptor bindings of set 0 declared by the particle shaders
+static constexpr uint32_t BINDING_PARTICLES         = 0;
+static constexpr uint32_t BINDING_FREE_LIST         = 1;
+static constexpr uint32_t BINDING_ALIVE_LISTS       = 2;
+static constexpr uint32_t BINDING_STATE             = 3;
+
+// Size of a particle in Shaders/particle_constants.glsl: position and remaining life, velocity and lifetime
+static constexpr VkDeviceSize PARTICLE_SIZE         = 8 * sizeof(float);
+
+static constexpr float TIME_STEP                    = 1.0f / 60.0f;
+static constexpr float LONGEST_LIFETIME             = 4.0f;     // seconds, particle_emit.comp picks between half and all of it
+static constexpr float SPRITE_SIZE                  = 0.03f;
+
+ParticleSystem::ParticleSystem(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                               uint32_t slotCount, MemoryBudgetMonitor* budgetMonitor, PipelineLayoutCache& layoutCache,
+                               uint32_t capacity, const Shaders& shaders, const GraphicsPipelineFactory& graphicsPipelineFactory,
+                               const ComputePipelineFactory& computePipelineFactory)
+    : resources(device, capabilities, allocator, budgetMonitor, "ParticleSystem")
+    , capacity(std::max(capacity, 1u))
+    , slots(slotCount)
+{
+    const uint64_t simulateGroups = (static_cast<uint64_t>(this->capacity) + PARTICLES_PER_SIMULATE_GROUP - 1) / PARTICLES_PER_SIMULATE_GROUP;
+    if(simulateGroups > capabilities.properties.limits.maxComputeWorkGroupCount[0])
+    {
+        throw std::runtime_error("ParticleSystem: Too many particles for one simulation dispatch!");
+    }
+    if(static_cast<uint64_t>(this->capacity) * 2 > std::numeric_limits<uint32_t>::max())
+    {
+        throw std::runtime_error("ParticleSystem: Too many particles for the alive lists!");
+    }
+
+    // Particles live between half and all of the longest lifetime, emitting this many per frame keeps about
+    // three quarters of them alive once the fountain is running.
+    constants.capacity = this->capacity;
+    constants.emitCount = std::max(static_cast<uint32_t>(static_cast<double>(this->capacity) * TIME_STEP / LONGEST_LIFETIME), 1u);
+    constants.timeStep = TIME_STEP;
+
+    drawPipeline.reflected = resources.createPipeline(graphicsPipelineFactory(shaders.drawStages), shaders.drawStages, layoutCache, sizeof(PushConstants));
+    emitPipeline.reflected = resources.createPipeline(computePipelineFactory(shaders.emission), { shaders.emission }, layoutCache, sizeof(PushConstants));
+    preparePipeline.reflected = resources.createPipeline(computePipelineFactory(shaders.preparation), { shaders.preparation }, layoutCache, sizeof(PushConstants));
+    simulatePipeline.reflected = resources.createPipeline(computePipelineFactory(shaders.simulation), { shaders.simulation }, layoutCache, sizeof(PushConstants));
+
+    resources.allocateBuffer(particles, this->capacity * PARTICLE_SIZE, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    resources.allocateBuffer(freeList, this->capacity * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    resources.allocateBuffer(aliveLists, 2 * static_cast<VkDeviceSize>(this->capacity) * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    resources.allocateBuffer(state, sizeof(State), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+                                                   | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    for(Slot& slot : slots)
+    {
+        resources.allocateBuffer(slot.statistics, sizeof(State), VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+        void* mapped = nullptr;
+        resources.mapBuffer(slot.statistics, &mapped);
+        slot.mappedStatistics = static_cast<const State*>(mapped);
+    }
+
+    createDescriptorSets();
+}
+
+ParticleSystem::~ParticleSystem()
+{
+    descriptorPool.reset();
+
+    for(Slot& slot : slots)
+    {
+        resources.releaseBuffer(slot.statistics);
+    }
+    resources.releaseBuffer(state);
+    resources.releaseBuffer(aliveLists);
+    resources.releaseBuffer(freeList);
+    resources.releaseBuffer(particles);
+}
+
+void ParticleSystem::createDescriptorSets()
+{
+    Pipeline* pipelines[] = { &drawPipeline, &emitPipeline, &preparePipeline, &simulatePipeline };
+
+    uint32_t setCount = 0;
+    uint32_t storageBufferCount = 0;
+    for(const Pipeline* pipeline : pipelines)
+    {
+        if(!pipeline->reflected.layout->setBindings.empty())
+        {
+            ++setCount;
+            storageBufferCount += static_cast<uint32_t>(pipeline->reflected.layout->setBindings[0].size());
+        }
+    }
+
+    if(setCount == 0)
+    {
+        return;
+    }
+
+    descriptorPool = resources.createDescriptorPool(setCount, storageBufferCount);
+
+    // The buffers persist across frames, every pipeline needs a single set
+    const auto bufferForBinding = [this](uint32_t binding) -> VkDescriptorBufferInfo
+    {
+        switch(binding)
+        {
+        case BINDING_PARTICLES:     return { particles.buffer, 0, VK_WHOLE_SIZE };
+        case BINDING_FREE_LIST:     return { freeList.buffer, 0, VK_WHOLE_SIZE };
+        case BINDING_ALIVE_LISTS:   return { aliveLists.buffer, 0, VK_WHOLE_SIZE };
+        case BINDING_STATE:         return { state.buffer, 0, VK_WHOLE_SIZE };
+        default:
+            throw std::runtime_error("ParticleSystem: Shaders use unknown binding " + std::to_string(binding) + "!");
+        }
+    };
+
+    for(Pipeline* pipeline : pipelines)
+    {
+        if(!pipeline->reflected.layout->setBindings.empty())
+        {
+            pipeline->descriptorSet = resources.allocateDescriptorSet(descriptorPool, *pipeline->reflected.layout, 0, bufferForBinding);
+        }
+    }
+}
+
+/// <summary>
+/// CPU side work of the frame, called after the fence of the slot was waited for: collects the statistics of the
+/// last frame of the slot and sets the constants of this one. Nothing here depends on the number of particles.
+/// </summary>
+void ParticleSystem::update(uint32_t slotIndex, uint64_t frameNumber, VkExtent2D extent)
+{
+    Slot& slot = slots[slotIndex];
+
+    if(slot.pending)
+    {
+        // The last frame of the slot wrote the list its input list was not
+        const uint64_t outputList = 1 - (frameNumber - slots.size()) % 2;
+        const uint32_t alive = slot.mappedStatistics->draws[outputList].instanceCount;
+
+        ++measuredFrames;
+        aliveParticles += alive;
+        mostAliveParticles = std::max(mostAliveParticles, alive);
+        slot.pending = false;
+    }
+
+    // The fountain rises from the origin and falls back to the ground around it
+    Camera camera = {};
+    camera.position[1] = 6.0f;
+    camera.position[2] = 18.0f;
+    camera.target[1] = 5.0f;
+    camera.target[2] = 0.0f;
+
+    const float aspect = extent.height > 0 ? static_cast<float>(extent.width) / static_cast<float>(extent.height) : 1.0f;
+    camera.getViewProjection(aspect, constants.viewProjection);
+    constants.spriteScale[0] = SPRITE_SIZE / aspect;
+    constants.spriteScale[1] = SPRITE_SIZE;
+
+    constants.inputList = static_cast<uint32_t>(frameNumber % 2);
+    constants.frameNumber = static_cast<uint32_t>(frameNumber);
+}
+
+/// <summary>
+/// Compute work before the render pass: emission, the size of the simulation and the simulation itself.
+/// </summary>
+void ParticleSystem::recordSimulation(VkCommandBuffer commandBuffer)
+{
+    if(!initialized)
+    {
+        vkCmdFillBuffer(commandBuffer, state.buffer, 0, VK_WHOLE_SIZE, 0);
+        GpuResources::recordMemoryBarrier(commandBuffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                                          VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+        initialized = true;
+    }
+
+    // The previous frame may still draw from the buffers or copy the state, which this frame's passes overwrite
+    GpuResources::recordMemoryBarrier(commandBuffer, 0, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                                      VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, emitPipeline.reflected.pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, emitPipeline.reflected.layout->pipelineLayout, 0, 1, &emitPipeline.descriptorSet, 0, nullptr);
+    GpuResources::pushConstants(commandBuffer, emitPipeline.reflected, &constants);
+    vkCmdDispatch(commandBuffer, (constants.emitCount + PARTICLES_PER_EMIT_GROUP - 1) / PARTICLES_PER_EMIT_GROUP, 1, 1);
+
+    GpuResources::recordMemoryBarrier(commandBuffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, preparePipeline.reflected.pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, preparePipeline.reflected.layout->pipelineLayout, 0, 1, &preparePipeline.descriptorSet, 0, nullptr);
+    GpuResources::pushConstants(commandBuffer, preparePipeline.reflected, &constants);
+    vkCmdDispatch(commandBuffer, 1, 1, 1);
+
+    GpuResources::recordMemoryBarrier(commandBuffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, simulatePipeline.reflected.pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, simulatePipeline.reflected.layout->pipelineLayout, 0, 1, &simulatePipeline.descriptorSet, 0, nullptr);
+    GpuResources::pushConstants(commandBuffer, simulatePipeline.reflected, &constants);
+    vkCmdDispatchIndirect(commandBuffer, state.buffer, offsetof(State, dispatch));
+
+    GpuResources::recordMemoryBarrier(commandBuffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT,
+                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                      VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT);
+}
+
+/// <summary>
+/// Records the indirect draw of the output list inside the render pass, returns the number of draw calls.
+/// </summary>
+uint32_t ParticleSystem::recordDraws(VkCommandBuffer commandBuffer)
+{
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPipeline.reflected.pipeline);
+    if(drawPipeline.descriptorSet != VK_NULL_HANDLE)
+    {
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPipeline.reflected.layout->pipelineLayout, 0, 1, &drawPipeline.descriptorSet, 0, nullptr);
+    }
+    GpuResources::pushConstants(commandBuffer, drawPipeline.reflected, &constants);
+
+    const uint32_t outputList = 1 - constants.inputList;
+    vkCmdDrawIndirect(commandBuffer, state.buffer, offsetof(State, draws) + outputList * sizeof(VkDrawIndirectCommand), 1, sizeof(VkDrawIndirectCommand));
+
+    return 1;
+}
+
+/// <summary>
+/// Copies the state to host memory after the render pass, for the number of living particles.
+/// </summary>
+void ParticleSystem::recordStatistics(VkCommandBuffer commandBuffer, uint32_t slotIndex)
+{
+    Slot& slot = slots[slotIndex];
+
+    const VkBufferCopy region = { 0, 0, sizeof(State) };
+    vkCmdCopyBuffer(commandBuffer, state.buffer, slot.statistics.buffer, 1, &region);
+    GpuResources::recordMemoryBarrier(commandBuffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT);
+
+    slot.pending = true;
+}
+
+void ParticleSystem::printStatistics(std::ostream& stream) const
+{
+    stream << "ParticleSystem: " << capacity << " particles, " << constants.emitCount << " emitted per frame, "
+           << (capacity * PARTICLE_SIZE + 3 * capacity * sizeof(uint32_t)) / (1024 * 1024) << " MiB of particle state\n";
+
+    if(measuredFrames == 0)
+    {
+        return;
+    }
+
+    const std::streamsize precision = stream.precision();
+    stream << std::fixed << std::setprecision(1)
+           << "    " << static_cast<double>(aliveParticles) / static_cast<double>(measuredFrames) << " particles alive on average over "
+           << measuredFrames << " frames, " << mostAliveParticles << " at most\n"
+           << std::defaultfloat << std::setprecision(precision);
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include "GpuResources.h"
+
+/// <summary>
+/// Particle fountain simulated and drawn entirely on the GPU, the CPU only records a fixed set of commands per frame.
+///
+/// The particle state lives in device local storage buffers which persist across frames:
+///
+///     particles   - position and remaining life, velocity and lifetime of every particle
+///     free list   - indices of dead particles, a stack with its size in the state buffer
+///     alive lists - two lists of living particle indices, read and written alternately
+///     state       - a VkDrawIndirectCommand per alive list whose instanceCount is the size of the list, the
+///                   VkDispatchIndirectCommand of the simulation, the free list size and the first never used particle
+///
+/// Every frame Shaders/particle_emit.comp pops indices from the free list, falling back to particles never used, and
+/// appends the new particles to the input list. particle_prepare.comp sizes the simulation dispatch from the input
+/// list and empties the output list. particle_simulate.comp, dispatched indirectly, integrates every particle of the
+/// input list and appends the survivors to the output list and the dead to the free list, so the output list is the
+/// compacted set of living particles. Its draw command then draws a quad per particle with vkCmdDrawIndirect.
+/// Nothing is read back to draw; the state is copied to host memory only for the statistics.
+///
+/// The simulation steps a fixed time per frame, so a run does the same work whatever its frame rate.
+/// </summary>
+class ParticleSystem
+{
+public:
+    using GraphicsPipelineFactory = std::function<UniquePipeline(const std::vector<std::vector<char>>& stageCode)>;
+    using ComputePipelineFactory = std::function<UniquePipeline(const std::vector<char>& code)>;
+
+    struct Shaders
+    {
+        std::vector<std::vector<char>>  drawStages                  = {};   // vertex and fragment
+        std::vector<char>               emission                    = {};
+        std::vector<char>               preparation                 = {};
+        std::vector<char>               simulation                  = {};
+    };
+
+    static constexpr uint32_t           PARTICLES_PER_EMIT_GROUP    = 64;   // local size of particle_emit.comp
+    static constexpr uint32_t           PARTICLES_PER_SIMULATE_GROUP = 256; // local size of particle_simulate.comp
+
+                                        ParticleSystem(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                                                       uint32_t slotCount, MemoryBudgetMonitor* budgetMonitor, PipelineLayoutCache& layoutCache,
+                                                       uint32_t capacity, const Shaders& shaders, const GraphicsPipelineFactory& graphicsPipelineFactory,
+                                                       const ComputePipelineFactory& computePipelineFactory);
+                                        ~ParticleSystem();
+
+                                        ParticleSystem(const ParticleSystem&) = delete;
+    ParticleSystem&                     operator=(const ParticleSystem&) = delete;
+
+    void                                update(uint32_t slot, uint64_t frameNumber, VkExtent2D extent);
+    void                                recordSimulation(VkCommandBuffer commandBuffer);
+    uint32_t                            recordDraws(VkCommandBuffer commandBuffer);
+    void                                recordStatistics(VkCommandBuffer commandBuffer, uint32_t slot);
+
+    void                                printStatistics(std::ostream& stream)                                                   const;
+
+private:
+    // Matches the push constant block of Shaders/particle_constants.glsl
+    struct PushConstants
+    {
+        float                           viewProjection[16]          = {};
+        float                           spriteScale[2]              = {};   // half extent of a particle in clip space at w = 1
+        uint32_t                        capacity                    = 0;
+        uint32_t                        emitCount                   = 0;
+        uint32_t                        inputList                   = 0;    // alive list read this frame, the other one is written
+        uint32_t                        frameNumber                 = 0;
+        float                           timeStep                    = 0.0f; // seconds
+        uint32_t                        reserved                    = 0;
+    };
+
+    // Matches the State block of Shaders/particle_constants.glsl
+    struct State
+    {
+        VkDrawIndirectCommand           draws[2]                    = {};   // instanceCount is the size of the alive list
+        VkDispatchIndirectCommand       dispatch                    = {};
+        uint32_t                        reserved                    = 0;
+        int32_t                         freeCount                   = 0;
+        uint32_t                        nextUnused                  = 0;
+    };
+
+    struct Pipeline
+    {
+        ReflectedPipeline               reflected                   = {};
+        VkDescriptorSet                 descriptorSet               = VK_NULL_HANDLE;
+    };
+
+    struct Slot
+    {
+        BufferAllocation                statistics                  = {};   // host visible copy of the state
+        const State*                    mappedStatistics            = nullptr;
+        bool                            pending                     = false;    // statistics of a submitted frame not read yet
+    };
+
+    const GpuResources                  resources;
+    const uint32_t                      capacity;
+
+    BufferAllocation                    particles                   = {};
+    BufferAllocation                    freeList                    = {};
+    BufferAllocation                    aliveLists                  = {};
+    BufferAllocation                    state                       = {};
+    bool                                initialized                 = false;    // state cleared by the first frame
+    PushConstants                       constants                   = {};
+
+    Pipeline                            drawPipeline                = {};
+    Pipeline                            emitPipeline                = {};
+    Pipeline                            preparePipeline             = {};
+    Pipeline                            simulatePipeline            = {};
+    UniqueDescriptorPool                descriptorPool              = {};
+    std::vector<Slot>                   slots;
+
+    //Statistics
+    uint64_t                            measuredFrames              = 0;
+    uint64_t                            aliveParticles              = 0;
+    uint32_t                            mostAliveParticles          = 0;
+
+    void                                createDescriptorSets();
+};
@@ -0,0 +1,158 @@
+#include "pch.h"
+#include "PipelineLayoutCache.h"
+
+static void appendBindings(std::vector<uint32_t>& key, const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+{
+    key.push_back(static_cast<uint32_t>(bindings.size()));
+    for(const auto& binding : bindings)
+    {
+        key.insert(key.end(), { binding.binding, static_cast<uint32_t>(binding.descriptorType), binding.descriptorCount, binding.stageFlags });
+    }
+}
+
+PipelineLayoutCache::PipelineLayoutCache(VkDevice device, const VkAllocationCallbacks* allocator)
+    : vkDevice(device)
+    , vkAllocator(allocator)
+{
+}
+
+/// <summary>
+/// Returns the layout of a pipeline made of the reflected stages, creating it on first use.
+/// </summary>
+const PipelineLayoutInfo& PipelineLayoutCache::getPipelineLayout(const std::vector<const ShaderReflection*>& stages)
+{
+    // Merge the stages, ordered by set and binding
+    std::map<std::pair<uint32_t, uint32_t>, VkDescriptorSetLayoutBinding> bindings;
+    VkPushConstantRange pushConstantRange = { 0, std::numeric_limits<uint32_t>::max(), 0 };
+    uint32_t pushConstantEnd = 0;
+
+    for(const ShaderReflection* stage : stages)
+    {
+        for(const auto& descriptor : stage->descriptorBindings)
+        {
+            const VkDescriptorSetLayoutBinding binding = { descriptor.binding, descriptor.descriptorType, descriptor.descriptorCount, descriptor.stageFlags, nullptr };
+            auto [found, inserted] = bindings.try_emplace({ descriptor.set, descriptor.binding }, binding);
+
+            if(!inserted)
+            {
+                if(found->second.descriptorType != binding.descriptorType || found->second.descriptorCount != binding.descriptorCount)
+                {
+                    throw std::runtime_error("PipelineLayoutCache: Binding " + std::to_string(descriptor.set) + "." + std::to_string(descriptor.binding)
+                                             + " differs between shader stages!");
+                }
+                found->second.stageFlags |= binding.stageFlags;
+            }
+        }
+
+        if(stage->pushConstantSize > 0)
+        {
+            pushConstantRange.stageFlags |= stage->stage;
+            pushConstantRange.offset = std::min(pushConstantRange.offset, stage->pushConstantOffset);
+            pushConstantEnd = std::max(pushConstantEnd, stage->pushConstantOffset + stage->pushConstantSize);
+        }
+    }
+
+    const uint32_t setCount = bindings.empty() ? 0 : bindings.rbegin()->first.first + 1;
+    std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets(setCount);
+    for(const auto& [location, binding] : bindings)
+    {
+        sets[location.first].push_back(binding);
+    }
+
+    std::vector<uint32_t> key;
+    for(const auto& set : sets)
+    {
+        appendBindings(key, set);
+    }
+    if(pushConstantRange.stageFlags != 0)
+    {
+        pushConstantRange.size = pushConstantEnd - pushConstantRange.offset;
+        key.insert(key.end(), { pushConstantRange.stageFlags, pushConstantRange.offset, pushConstantRange.size });
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ++requests;
+
+    auto cached = pipelineLayouts.find(key);
+    if(cached != pipelineLayouts.end())
+    {
+        ++hits;
+        return cached->second.info;
+    }
+
+    PipelineLayoutInfo info = {};
+    for(const auto& set : sets)
+    {
+        info.setLayouts.push_back(getSetLayout(set));
+    }
+    info.setBindings = std::move(sets);
+    if(pushConstantRange.stageFlags != 0)
+    {
+        info.pushConstantRanges.push_back(pushConstantRange);
+    }
+
+    VkPipelineLayoutCreateInfo layoutCreateInfo
+    {
+        VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        nullptr,
+        NULL,
+        static_cast<uint32_t>(info.setLayouts.size()),
+        info.setLayouts.data(),
+        static_cast<uint32_t>(info.pushConstantRanges.size()),
+        info.pushConstantRanges.data()
+    };
+
+    VkPipelineLayout pipelineLayout = nullptr;
+    if(vkCreatePipelineLayout(vkDevice, &layoutCreateInfo, vkAllocator, &pipelineLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("PipelineLayoutCache: Failed to create pipeline layout!");
+    }
+    info.pipelineLayout = pipelineLayout;
+
+    CachedPipelineLayout& entry = pipelineLayouts[key];
+    entry.layout = UniquePipelineLayout(vkDevice, pipelineLayout, vkAllocator);
+    entry.info = std::move(info);
+
+    return entry.info;
+}
+
+/// <summary>
+/// Called with the mutex locked.
+/// </summary>
+VkDescriptorSetLayout PipelineLayoutCache::getSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+{
+    std::vector<uint32_t> key;
+    appendBindings(key, bindings);
+
+    auto cached = setLayouts.find(key);
+    if(cached != setLayouts.end())
+    {
+        return cached->second;
+    }
+
+    VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo
+    {
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        nullptr,
+        NULL,
+        static_cast<uint32_t>(bindings.size()),
+        bindings.data()
+    };
+
+    VkDescriptorSetLayout setLayout = nullptr;
+    if(vkCreateDescriptorSetLayout(vkDevice, &setLayoutCreateInfo, vkAllocator, &setLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("PipelineLayoutCache: Failed to create descriptor set layout!");
+    }
+
+    setLayouts[key] = UniqueDescriptorSetLayout(vkDevice, setLayout, vkAllocator);
+    return setLayout;
+}
+
+void PipelineLayoutCache::printStatistics(std::ostream& stream) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    stream << "PipelineLayoutCache: " << pipelineLayouts.size() << " pipeline layout(s), " << setLayouts.size() << " descriptor set layout(s), "
+           << hits << " of " << requests << " request(s) shared an existing layout\n";
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "ShaderReflection.h"
+#include "VkHandle.h"
+
+struct PipelineLayoutInfo
+{
+    VkPipelineLayout                    pipelineLayout              = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSetLayout>  setLayouts                  = {};   // index is the set number, unused sets get an empty layout
+    std::vector<std::vector<VkDescriptorSetLayoutBinding>> setBindings = {};   // bindings of each set layout, ordered by binding
+    std::vector<VkPushConstantRange>    pushConstantRanges          = {};
+};
+
+/// <summary>
+/// Creates descriptor set layouts and pipeline layouts from the reflection of the shader stages of a pipeline.
+///
+/// The bindings of all stages are merged, a binding used by several stages gets the stage flags of each. Push
+/// constants become a single range visible to every stage declaring them. Layouts are cached by their description,
+/// so compatible pipelines share the same VkPipelineLayout and VkDescriptorSetLayout objects and can bind the same
+/// descriptor sets. Cached layouts live as long as the cache.
+///
+/// getPipelineLayout is thread safe, pipelines are also built by background threads like shader hot reload.
+/// </summary>
+class PipelineLayoutCache
+{
+public:
+                                        PipelineLayoutCache(VkDevice device, const VkAllocationCallbacks* allocator);
+
+                                        PipelineLayoutCache(const PipelineLayoutCache&) = delete;
+    PipelineLayoutCache&                operator=(const PipelineLayoutCache&) = delete;
+
+    const PipelineLayoutInfo&           getPipelineLayout(const std::vector<const ShaderReflection*>& stages);
+
+    void                                printStatistics(std::ostream& stream)                                                   const;
+
+private:
+    struct CachedPipelineLayout
+    {
+        UniquePipelineLayout            layout                      = {};
+        PipelineLayoutInfo              info                        = {};
+    };
+
+    VkDevice                            vkDevice;
+    const VkAllocationCallbacks*        vkAllocator;
+
+    mutable std::mutex                  mutex;
+
+    // Keys are the layout descriptions flattened to words, std::map keeps the values at a stable address
+    std::map<std::vector<uint32_t>, UniqueDescriptorSetLayout> setLayouts = {};
+    std::map<std::vector<uint32_t>, CachedPipelineLayout> pipelineLayouts = {};
+
+    //Statistics
+    uint64_t                            requests                    = 0;
+    uint64_t                            hits                        = 0;
+
+    VkDescriptorSetLayout               getSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+};
@@ -0,0 +1,173 @@
+#include "pch.h"
+#include "PresentLatency.h"
+
+PresentLatencyMonitor::PresentLatencyMonitor(VkDevice device, PFN_vkWaitForPresentKHR waitForPresent, uint32_t warmupFrames)
+    : vkDevice(device)
+    , vkWaitForPresent(waitForPresent)
+    , warmupFrames(warmupFrames)
+{
+}
+
+/// <summary>
+/// Called after vkQueuePresentKHR accepted a present tagged with presentId through VkPresentIdKHR.
+/// Present ids have to increase with every present, frame numbers are used.
+/// </summary>
+void PresentLatencyMonitor::presented(uint64_t presentId, std::chrono::steady_clock::time_point frameStart)
+{
+    pending.push_back({ presentId, frameStart });
+}
+
+/// <summary>
+/// Waits until the present with presentId, or a later one, completed and returns the time it was observed.
+/// Returns no value on timeout or when the present was dropped together with its swapchain.
+/// </summary>
+std::optional<std::chrono::steady_clock::time_point> PresentLatencyMonitor::waitForPresent(VkSwapchainKHR swapchain, uint64_t presentId,
+                                                                                          std::chrono::nanoseconds timeout)
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while(!pending.empty() && pending.front().presentId <= presentId)
+    {
+        const auto remaining = std::max(std::chrono::nanoseconds(0), std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now()));
+        if(!waitForOldest(swapchain, static_cast<uint64_t>(remaining.count())))
+        {
+            return std::nullopt;
+        }
+    }
+
+    if(lastCompletedId == 0 || lastCompletedId < presentId)
+    {
+        return std::nullopt;
+    }
+
+    return lastCompletionTime;
+}
+
+/// <summary>
+/// Collects every present which completed since the last call without blocking.
+/// </summary>
+void PresentLatencyMonitor::poll(VkSwapchainKHR swapchain)
+{
+    while(!pending.empty() && waitForOldest(swapchain, 0))
+    {
+    }
+}
+
+/// <summary>
+/// Present ids belong to a swapchain. Presents still pending on a retired swapchain are never waited for,
+/// waiting on a retired swapchain is not allowed.
+/// </summary>
+void PresentLatencyMonitor::swapchainRetired()
+{
+    droppedPresents += pending.size();
+    pending.clear();
+
+    lastCompletedId = 0;
+}
+
+bool PresentLatencyMonitor::waitForOldest(VkSwapchainKHR swapchain, uint64_t timeoutNanoseconds)
+{
+    const VkResult result = vkWaitForPresent(vkDevice, swapchain, pending.front().presentId, timeoutNanoseconds);
+
+    // A suboptimal swapchain still presents, the wait completed like a successful one.
+    if(result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)
+    {
+        complete(pending.front(), std::chrono::steady_clock::now());
+        pending.pop_front();
+        return true;
+    }
+
+    // Out of date or lost surfaces will not complete any of the pending presents.
+    if(result != VK_TIMEOUT)
+    {
+        swapchainRetired();
+    }
+
+    return false;
+}
+
+void PresentLatencyMonitor::complete(const PendingPresent& present, std::chrono::steady_clock::time_point completionTime)
+{
+    if(present.presentId > warmupFrames)
+    {
+        const double latency = std::chrono::duration<double, std::milli>(completionTime - present.frameStart).count();
+        latencies.push_back(latency);
+
+        const size_t bucket = static_cast<size_t>(latency / HISTOGRAM_BUCKET_WIDTH);
+        ++histogram[std::min(bucket, HISTOGRAM_BUCKET_COUNT - 1)];
+    }
+
+    // Presents replaced in a mailbox complete together with the one replacing them, they carry no interval.
+    if(lastCompletedId != 0 && present.presentId == lastCompletedId + 1 && completionTime > lastCompletionTime)
+    {
+        refreshIntervals.push_back(std::chrono::duration<double, std::milli>(completionTime - lastCompletionTime).count());
+        if(refreshIntervals.size() > REFRESH_INTERVAL_SAMPLES)
+        {
+            refreshIntervals.pop_front();
+        }
+    }
+
+    lastCompletedId = present.presentId;
+    lastCompletionTime = completionTime;
+}
+
+/// <summary>
+/// Median interval between consecutive presents in milliseconds. With FIFO presentation and frames finishing in time
+/// this is the refresh interval of the display.
+/// </summary>
+std::optional<double> PresentLatencyMonitor::getRefreshInterval() const
+{
+    if(refreshIntervals.size() < 8)
+    {
+        return std::nullopt;
+    }
+
+    std::vector<double> sorted(refreshIntervals.begin(), refreshIntervals.end());
+    std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+
+    return sorted[sorted.size() / 2];
+}
+
+std::vector<uint64_t> PresentLatencyMonitor::getHistogram() const
+{
+    return std::vector<uint64_t>(histogram.begin(), histogram.end());
+}
+
+void PresentLatencyMonitor::printSummary(std::ostream& stream) const
+{
+    const FrameTimeRecorder::Summary summary = FrameTimeRecorder::summarize(latencies);
+
+    stream << "PresentLatency: " << summary.frameCount << " presents after " << warmupFrames << " warm-up frames, mean " << summary.mean
+           << " ms, median " << summary.median << " ms, p95 " << summary.p95 << " ms, p99 " << summary.p99 << " ms, max " << summary.maximum
+           << " ms, " << droppedPresents << " dropped\n";
+
+    if(summary.frameCount == 0)
+    {
+        return;
+    }
+
+    const uint64_t largestBucket = *std::max_element(histogram.begin(), histogram.end());
+    constexpr uint64_t BAR_WIDTH = 50;
+
+    for(size_t bucket = 0; bucket < HISTOGRAM_BUCKET_COUNT; ++bucket)
+    {
+        if(histogram[bucket] == 0)
+        {
+            continue;
+        }
+
+        std::ostringstream range;
+        range << bucket * HISTOGRAM_BUCKET_WIDTH;
+        if(bucket + 1 < HISTOGRAM_BUCKET_COUNT)
+        {
+            range << "-" << (bucket + 1) * HISTOGRAM_BUCKET_WIDTH << " ms";
+        }
+        else
+        {
+            range << "+ ms";
+        }
+
+        stream << "    " << std::left << std::setw(12) << range.str() << std::right << std::setw(8) << histogram[bucket] << " "
+               << std::string(static_cast<size_t>(std::max<uint64_t>(1, histogram[bucket] * BAR_WIDTH / largestBucket)), '#') << "\n";
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "FrameTimeRecorder.h"
+
+/// <summary>
+/// Measures the time from the start of a frame, where input is sampled, until its image is shown, using
+/// VK_KHR_present_id to tag presents and VK_KHR_present_wait to learn when they completed.
+///
+/// vkWaitForPresentKHR requires external synchronization of the swapchain, so the monitor is only used from the
+/// render thread: it polls at the start of every frame and waits when the frame pacer needs the previous present.
+/// Completions observed by a blocking wait are exact, polled ones are late by at most one frame.
+/// </summary>
+class PresentLatencyMonitor
+{
+public:
+                                        PresentLatencyMonitor(VkDevice device, PFN_vkWaitForPresentKHR waitForPresent, uint32_t warmupFrames);
+
+                                        PresentLatencyMonitor(const PresentLatencyMonitor&) = delete;
+    PresentLatencyMonitor&              operator=(const PresentLatencyMonitor&) = delete;
+
+    void                                presented(uint64_t presentId, std::chrono::steady_clock::time_point frameStart);
+    std::optional<std::chrono::steady_clock::time_point> waitForPresent(VkSwapchainKHR swapchain, uint64_t presentId,
+                                                                        std::chrono::nanoseconds timeout);
+    void                                poll(VkSwapchainKHR swapchain);
+    void                                swapchainRetired();
+
+    std::optional<double>               getRefreshInterval()                                                                    const;
+    std::vector<uint64_t>               getHistogram()                                                                          const;
+    void                                printSummary(std::ostream& stream)                                                      const;
+
+    static constexpr double             HISTOGRAM_BUCKET_WIDTH      = 1.0;  // milliseconds
+    static constexpr size_t             HISTOGRAM_BUCKET_COUNT      = 64;   // the last bucket counts everything above
+
+private:
+    struct PendingPresent
+    {
+        uint64_t                        presentId                   = 0;
+        std::chrono::steady_clock::time_point frameStart            = {};
+    };
+
+    VkDevice                            vkDevice;
+    PFN_vkWaitForPresentKHR             vkWaitForPresent;
+    const uint32_t                      warmupFrames;
+
+    std::deque<PendingPresent>          pending                     = {};
+
+    uint64_t                            lastCompletedId             = 0;
+    std::chrono::steady_clock::time_point lastCompletionTime        = {};
+
+    //Results
+    std::vector<double>                 latencies                   = {};   // milliseconds
+    std::array<uint64_t, HISTOGRAM_BUCKET_COUNT> histogram          = {};
+    std::deque<double>                  refreshIntervals            = {};   // intervals between consecutive completions
+    uint64_t                            droppedPresents             = 0;
+
+    static constexpr size_t             REFRESH_INTERVAL_SAMPLES    = 64;
+
+    bool                                waitForOldest(VkSwapchainKHR swapchain, uint64_t timeoutNanoseconds);
+    void                                complete(const PendingPresent& present, std::chrono::steady_clock::time_point completionTime);
+};
@@ -0,0 +1,235 @@
+#include "pch.h"
+#include "QueueSubmitter.h"
+
+QueueSubmitter::QueueSubmitter(VkDevice device, bool synchronization2)
+{
+    // vkQueueSubmit2KHR is not exported by the loader for a Vulkan 1.2 device and has to be loaded from it.
+    if(synchronization2)
+    {
+        queueSubmit2 = reinterpret_cast<PFN_vkQueueSubmit2KHR>(vkGetDeviceProcAddr(device, "vkQueueSubmit2KHR"));
+    }
+}
+
+QueueSubmitter::PendingQueue& QueueSubmitter::getQueue(VkQueue queue)
+{
+    for(uint32_t i = 0; i < queueCount; ++i)
+    {
+        if(queues[i].queue == queue)
+        {
+            return queues[i];
+        }
+    }
+
+    if(queueCount == queues.size())
+    {
+        queues.emplace_back();
+    }
+    queues[queueCount].queue = queue;
+    return queues[queueCount++];
+}
+
+/// <summary>
+/// Returns the batch the next wait or command buffer of the queue goes to, starting a new one when the last batch
+/// already holds work which has to happen before it.
+/// </summary>
+QueueSubmitter::Batch& QueueSubmitter::getBatch(PendingQueue& pending, bool forWait, bool forCommandBuffer)
+{
+    const bool startBatch = pending.batches.empty()
+                         || (forWait && (pending.batches.back().commandBufferCount > 0 || pending.batches.back().signalCount > 0))
+                         || (forCommandBuffer && pending.batches.back().signalCount > 0);
+    if(startBatch)
+    {
+        Batch batch = {};
+        batch.firstWait = static_cast<uint32_t>(pending.waitSemaphores.size());
+        batch.firstCommandBuffer = static_cast<uint32_t>(pending.commandBuffers.size());
+        batch.firstSignal = static_cast<uint32_t>(pending.signalSemaphores.size());
+        pending.batches.push_back(batch);
+    }
+
+    return pending.batches.back();
+}
+
+void QueueSubmitter::addWait(VkQueue queue, VkSemaphore semaphore, VkPipelineStageFlags stageMask)
+{
+    // A queue which is not pending yet is appended and submitted after every signal added so far
+    uint32_t queueIndex = 0;
+    while(queueIndex < queueCount && queues[queueIndex].queue != queue)
+    {
+        ++queueIndex;
+    }
+    for(uint32_t i = queueIndex + 1; i < queueCount; ++i)
+    {
+        const std::vector<VkSemaphore>& signals = queues[i].signalSemaphores;
+        if(std::find(signals.begin(), signals.end(), semaphore) != signals.end())
+        {
+            flush();
+            break;
+        }
+    }
+
+    PendingQueue& pending = getQueue(queue);
+    Batch& batch = getBatch(pending, true, false);
+    pending.waitSemaphores.push_back(semaphore);
+    pending.waitStages.push_back(stageMask);
+    ++batch.waitCount;
+}
+
+void QueueSubmitter::addCommandBuffer(VkQueue queue, VkCommandBuffer commandBuffer)
+{
+    PendingQueue& pending = getQueue(queue);
+    Batch& batch = getBatch(pending, false, true);
+    pending.commandBuffers.push_back(commandBuffer);
+    ++batch.commandBufferCount;
+}
+
+void QueueSubmitter::addSignal(VkQueue queue, VkSemaphore semaphore)
+{
+    PendingQueue& pending = getQueue(queue);
+    Batch& batch = getBatch(pending, false, false);
+    pending.signalSemaphores.push_back(semaphore);
+    ++batch.signalCount;
+}
+
+/// <summary>
+/// Sets the fence signaled once all batches of the queue submitted by the next flush completed.
+/// </summary>
+void QueueSubmitter::setFence(VkQueue queue, VkFence fence)
+{
+    getQueue(queue).fence = fence;
+}
+
+/// <summary>
+/// Submits the pending work of every queue with one call per queue.
+/// </summary>
+void QueueSubmitter::flush()
+{
+    if(queueCount == 0)
+    {
+        return;
+    }
+
+    for(uint32_t i = 0; i < queueCount; ++i)
+    {
+        const auto submitStart = std::chrono::steady_clock::now();
+        if(queueSubmit2 != nullptr)
+        {
+            submit(queues[i]);
+        }
+        else
+        {
+            submitLegacy(queues[i]);
+        }
+        const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - submitStart;
+
+        ++submitCalls;
+        submittedBatches += queues[i].batches.size();
+        submittedCommandBuffers += queues[i].commandBuffers.size();
+        submitTime += time.count();
+        longestSubmitTime = std::max(longestSubmitTime, time.count());
+    }
+
+    for(uint32_t i = 0; i < queueCount; ++i)
+    {
+        PendingQueue& pending = queues[i];
+        pending.queue = VK_NULL_HANDLE;
+        pending.fence = VK_NULL_HANDLE;
+        pending.batches.clear();
+        pending.waitSemaphores.clear();
+        pending.waitStages.clear();
+        pending.commandBuffers.clear();
+        pending.signalSemaphores.clear();
+    }
+    queueCount = 0;
+    ++flushes;
+}
+
+void QueueSubmitter::submit(const PendingQueue& pending)
+{
+    // Every semaphore and command buffer gets its info first, the batches point into the filled arrays
+    semaphoreInfos.resize(pending.waitSemaphores.size() + pending.signalSemaphores.size());
+    commandBufferInfos.resize(pending.commandBuffers.size());
+    submitInfos2.clear();
+
+    const size_t firstSignalInfo = pending.waitSemaphores.size();
+    for(size_t i = 0; i < pending.waitSemaphores.size(); ++i)
+    {
+        // The legacy stage bits have the same values as their VkPipelineStageFlags2 counterparts
+        semaphoreInfos[i] = { VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR, nullptr, pending.waitSemaphores[i], 0, pending.waitStages[i], 0 };
+    }
+    for(size_t i = 0; i < pending.signalSemaphores.size(); ++i)
+    {
+        semaphoreInfos[firstSignalInfo + i] = { VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR, nullptr, pending.signalSemaphores[i], 0,
+                                                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0 };
+    }
+    for(size_t i = 0; i < pending.commandBuffers.size(); ++i)
+    {
+        commandBufferInfos[i] = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO_KHR, nullptr, pending.commandBuffers[i], 0 };
+    }
+
+    for(const Batch& batch : pending.batches)
+    {
+        submitInfos2.push_back(
+        {
+            VK_STRUCTURE_TYPE_SUBMIT_INFO_2_KHR,
+            nullptr,
+            NULL,
+            batch.waitCount,
+            semaphoreInfos.data() + batch.firstWait,
+            batch.commandBufferCount,
+            commandBufferInfos.data() + batch.firstCommandBuffer,
+            batch.signalCount,
+            semaphoreInfos.data() + firstSignalInfo + batch.firstSignal
+        });
+    }
+
+    if(queueSubmit2(pending.queue, static_cast<uint32_t>(submitInfos2.size()), submitInfos2.data(), pending.fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("QueueSubmitter: Failed to submit command buffers!");
+    }
+}
+
+void QueueSubmitter::submitLegacy(const PendingQueue& pending)
+{
+    submitInfos.clear();
+    for(const Batch& batch : pending.batches)
+    {
+        submitInfos.push_back(
+        {
+            VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            nullptr,
+            batch.waitCount,
+            pending.waitSemaphores.data() + batch.firstWait,
+            pending.waitStages.data() + batch.firstWait,
+            batch.commandBufferCount,
+            pending.commandBuffers.data() + batch.firstCommandBuffer,
+            batch.signalCount,
+            pending.signalSemaphores.data() + batch.firstSignal
+        });
+    }
+
+    if(vkQueueSubmit(pending.queue, static_cast<uint32_t>(submitInfos.size()), submitInfos.data(), pending.fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("QueueSubmitter: Failed to submit command buffers!");
+    }
+}
+
+bool QueueSubmitter::usesSynchronization2() const
+{
+    return queueSubmit2 != nullptr;
+}
+
+void QueueSubmitter::printStatistics(std::ostream& stream) const
+{
+    stream << "QueueSubmitter: " << (usesSynchronization2() ? "vkQueueSubmit2KHR" : "vkQueueSubmit") << ", " << submitCalls << " submit calls in "
+           << flushes << " flushes, " << submittedBatches << " batches of " << submittedCommandBuffers << " command buffers\n";
+
+    if(submitCalls > 0)
+    {
+        const std::streamsize precision = stream.precision();
+        stream << std::fixed << std::setprecision(3)
+               << "    " << static_cast<double>(submitCalls) / static_cast<double>(std::max<uint64_t>(flushes, 1)) << " submit calls per flush, "
+               << submitTime / static_cast<double>(submitCalls) << " ms per call on average, " << longestSubmitTime << " ms at most, "
+               << submitTime << " ms in total\n"
+               << std::defaultfloat << std::setprecision(precision);
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+/// <summary>
+/// Gathers the submissions of a frame per queue and hands each queue its work with a single submit call.
+///
+/// Waits, command buffers and signals are added in the order they happen on a queue. Consecutive command buffers
+/// share a batch, a wait after command buffers or a command buffer after a signal starts the next batch, so the
+/// order within the queue is kept while as few batches as possible are built. flush() is the sync point: every queue
+/// with pending work gets one vkQueueSubmit2KHR, or one vkQueueSubmit without synchronization2, holding all of its
+/// batches and the fence set for it. Queues are submitted in the order they were first used since the last flush.
+/// A binary semaphore has to be signaled by a submitted batch before a batch waiting on it is submitted; a wait on a
+/// semaphore signaled by a queue submitted after the waiting one therefore flushes first.
+///
+/// The submit calls, batches and the CPU time spent in the submit calls are counted.
+/// </summary>
+class QueueSubmitter
+{
+public:
+                                        QueueSubmitter(VkDevice device, bool synchronization2);
+
+                                        QueueSubmitter(const QueueSubmitter&) = delete;
+    QueueSubmitter&                     operator=(const QueueSubmitter&) = delete;
+
+    void                                addWait(VkQueue queue, VkSemaphore semaphore, VkPipelineStageFlags stageMask);
+    void                                addCommandBuffer(VkQueue queue, VkCommandBuffer commandBuffer);
+    void                                addSignal(VkQueue queue, VkSemaphore semaphore);
+    void                                setFence(VkQueue queue, VkFence fence);
+    void                                flush();
+
+    bool                                usesSynchronization2()                                                                  const;
+    void                                printStatistics(std::ostream& stream)                                                   const;
+
+private:
+    // Ranges of the queue's arrays
+    struct Batch
+    {
+        uint32_t                        firstWait                   = 0;
+        uint32_t                        waitCount                   = 0;
+        uint32_t                        firstCommandBuffer          = 0;
+        uint32_t                        commandBufferCount          = 0;
+        uint32_t                        firstSignal                 = 0;
+        uint32_t                        signalCount                 = 0;
+    };
+
+    struct PendingQueue
+    {
+        VkQueue                         queue                       = VK_NULL_HANDLE;
+        VkFence                         fence                       = VK_NULL_HANDLE;
+        std::vector<Batch>              batches                     = {};
+        std::vector<VkSemaphore>        waitSemaphores              = {};
+        std::vector<VkPipelineStageFlags> waitStages                = {};
+        std::vector<VkCommandBuffer>    commandBuffers              = {};
+        std::vector<VkSemaphore>        signalSemaphores            = {};
+    };
+
+    PFN_vkQueueSubmit2KHR               queueSubmit2                = nullptr;
+
+    // Queues with work since the last flush, in submission order; cleared vectors keep their memory
+    std::vector<PendingQueue>           queues                      = {};
+    uint32_t                            queueCount                  = 0;
+
+    // Scratch of the submit calls
+    std::vector<VkSubmitInfo>           submitInfos                 = {};
+    std::vector<VkSubmitInfo2KHR>       submitInfos2                = {};
+    std::vector<VkSemaphoreSubmitInfoKHR> semaphoreInfos            = {};
+    std::vector<VkCommandBufferSubmitInfoKHR> commandBufferInfos    = {};
+
+    //Statistics
+    uint64_t                            flushes                     = 0;
+    uint64_t                            submitCalls                 = 0;
+    uint64_t                            submittedBatches            = 0;
+    uint64_t                            submittedCommandBuffers     = 0;
+    double                              submitTime                  = 0.0;  // milliseconds
+    double                              longestSubmitTime           = 0.0;
+
+    PendingQueue&                       getQueue(VkQueue queue);
+    Batch&                              getBatch(PendingQueue& pending, bool forWait, bool forCommandBuffer);
+    void                                submit(const PendingQueue& pending);
+    void                                submitLegacy(const PendingQueue& pending);
+};
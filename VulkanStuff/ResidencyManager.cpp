@@ -0,0 +1,102 @@
+#include "pch.h"
+#include "ResidencyManager.h"
+
+ResidencyManager::ResourceId ResidencyManager::registerResource(uint32_t heapIndex, VkDeviceSize size, bool demotable, EvictCallback evict)
+{
+    const ResourceId id = nextResourceId++;
+
+    Resource resource = {};
+    resource.id = id;
+    resource.heapIndex = heapIndex;
+    resource.size = size;
+    resource.demotable = demotable;
+    resource.evict = std::move(evict);
+
+    resources.push_back(std::move(resource));
+    resourceLookup.emplace(id, std::prev(resources.end()));
+
+    return id;
+}
+
+void ResidencyManager::unregisterResource(ResourceId id)
+{
+    const auto lookup = resourceLookup.find(id);
+    if(lookup == resourceLookup.end())
+    {
+        return;
+    }
+
+    resources.erase(lookup->second);
+    resourceLookup.erase(lookup);
+}
+
+void ResidencyManager::touch(ResourceId id, uint64_t frameNumber)
+{
+    const auto lookup = resourceLookup.find(id);
+    if(lookup == resourceLookup.end())
+    {
+        return;
+    }
+
+    lookup->second->lastUsedFrame = frameNumber;
+    resources.splice(resources.end(), resources, lookup->second);
+}
+
+/// <summary>
+/// Evicts least recently used resources from every heap over its eviction threshold and returns how many were evicted.
+/// Demotable resources are demoted, the others are dropped.
+/// </summary>
+size_t ResidencyManager::enforceBudget(const MemoryBudgetMonitor& monitor, uint64_t completedFrameNumber)
+{
+    const auto& heaps = monitor.getHeapBudgets();
+
+    std::vector<VkDeviceSize> excessBytes(heaps.size(), 0);
+    bool overBudget = false;
+    for(uint32_t i = 0; i < heaps.size(); ++i)
+    {
+        excessBytes[i] = monitor.getExcessBytes(i);
+        overBudget = overBudget || excessBytes[i] > 0;
+    }
+
+    if(!overBudget)
+    {
+        return 0;
+    }
+
+    size_t evictedResources = 0;
+
+    auto resource = resources.begin();
+    while(resource != resources.end())
+    {
+        // The list is ordered by last use, every following resource may still be used by a frame in flight.
+        if(resource->lastUsedFrame > completedFrameNumber)
+        {
+            break;
+        }
+
+        if(excessBytes[resource->heapIndex] == 0)
+        {
+            ++resource;
+            continue;
+        }
+
+        const EvictionAction action = resource->demotable ? EvictionAction::Demote : EvictionAction::Drop;
+        const VkDeviceSize freedBytes = resource->evict(action);
+
+        excessBytes[resource->heapIndex] -= std::min(excessBytes[resource->heapIndex], freedBytes);
+        evictedBytes += freedBytes;
+        ++(action == EvictionAction::Demote ? demotedResources : droppedResources);
+        ++evictedResources;
+
+        resourceLookup.erase(resource->id);
+        resource = resources.erase(resource);
+    }
+
+    return evictedResources;
+}
+
+void ResidencyManager::printStatistics(std::ostream& stream) const
+{
+    stream << "ResidencyManager: " << resources.size() << " resident, " << demotedResources << " demoted, "
+           << droppedResources << " dropped, " << evictedBytes << " bytes evicted\n";
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "MemoryBudget.h"
+
+enum class EvictionAction
+{
+    Demote,     // move the resource to a host visible heap, it stays usable at lower performance
+    Drop        // release the resource, its owner has to reload it before the next use
+};
+
+/// <summary>
+/// Least recently used bookkeeping of device memory resources which can be evicted.
+///
+/// Owners register a resource together with the heap it lives in and a callback which demotes or drops it.
+/// Every frame that uses a resource touches it, which moves it to the back of the LRU list. When the
+/// MemoryBudgetMonitor reports a heap over its eviction threshold, enforceBudget walks the list from the front
+/// and evicts resources until the excess is covered. Only resources whose last use was completed by the GPU
+/// are evicted, so callbacks can release memory immediately. Evicted resources are unregistered, owners
+/// register them again once reloaded.
+/// </summary>
+class ResidencyManager
+{
+public:
+    using ResourceId = uint64_t;
+
+    // Releases the resource memory from its heap and returns the number of bytes freed there.
+    using EvictCallback = std::function<VkDeviceSize(EvictionAction action)>;
+
+    ResourceId                          registerResource(uint32_t heapIndex, VkDeviceSize size, bool demotable, EvictCallback evict);
+    void                                unregisterResource(ResourceId id);
+    void                                touch(ResourceId id, uint64_t frameNumber);
+
+    size_t                              enforceBudget(const MemoryBudgetMonitor& monitor, uint64_t completedFrameNumber);
+    void                                printStatistics(std::ostream& stream)                                                   const;
+
+private:
+    struct Resource
+    {
+        ResourceId                      id                          = 0;
+        uint32_t                        heapIndex                   = 0;
+        VkDeviceSize                    size                        = 0;
+        bool                            demotable                   = false;
+        uint64_t                        lastUsedFrame               = 0;
+        EvictCallback                   evict                       = {};
+    };
+
+    // Front is the least recently used resource
+    std::list<Resource>                 resources                   = {};
+    std::unordered_map<ResourceId, std::list<Resource>::iterator> resourceLookup = {};
+    ResourceId                          nextResourceId              = 1;
+
+    //Statistics
+    uint64_t                            demotedResources            = 0;
+    uint64_t                            droppedResources            = 0;
+    VkDeviceSize                        evictedBytes                = 0;
+};
@@ -0,0 +1,103 @@
+#include "pch.h"
+#include "SceneBenchmark.h"
+#include "SceneGraph.h"
+
+/// <summary>
+/// Returns the best time of REPETITIONS calls in milliseconds.
+/// </summary>
+double SceneBenchmark::measure(const std::function<void()>& function)
+{
+    double best = std::numeric_limits<double>::max();
+
+    for(uint32_t repetition = 0; repetition < REPETITIONS; ++repetition)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    return best;
+}
+
+void SceneBenchmark::run(std::ostream& stream)
+{
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    // Small rotations about random axes, so matrices stay well conditioned down the hierarchy
+    const auto randomTransform = [&random, &distribution]
+    {
+        SceneTransform transform = {};
+        const float axis[3] = { distribution(random), distribution(random), distribution(random) };
+        const float length = std::max(std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]), 1e-3f);
+        const float halfAngle = 0.5f * distribution(random);
+        for(uint32_t i = 0; i < 3; ++i)
+        {
+            transform.position[i] = 2.0f * distribution(random);
+            transform.rotation[i] = axis[i] / length * std::sin(halfAngle);
+        }
+        transform.rotation[3] = std::cos(halfAngle);
+        return transform;
+    };
+
+    SceneGraph scene;
+    std::vector<SceneNodeId> nodes;
+    nodes.reserve(NODE_COUNT);
+    for(uint32_t i = 0; i < NODE_COUNT; ++i)
+    {
+        nodes.push_back(scene.addNode(i < ROOT_COUNT ? SceneGraph::NO_PARENT : nodes[(i - ROOT_COUNT) / FAN_OUT], randomTransform()));
+    }
+
+    std::vector<float> matrices(static_cast<size_t>(NODE_COUNT) * 16);
+
+    const double buildTime = measure([&scene, &matrices]
+    {
+        // A node added to the scene reorders it, every node is computed again
+        scene.addNode(SceneGraph::NO_PARENT, SceneTransform{});
+        scene.update();
+        matrices.resize(static_cast<size_t>(scene.getNodeCount()) * 16);
+        scene.writeUpload(matrices.data());
+    });
+
+    const std::streamsize precision = stream.precision();
+    stream << "SceneBenchmark: best of " << REPETITIONS << " runs, " << scene.getNodeCount() << " nodes in " << scene.getDepthCount() << " levels\n"
+           << std::fixed << std::setprecision(3)
+           << "    sort and full update " << buildTime << " ms\n"
+           << "    changed nodes   recomputed nodes   update ms   ns per recomputed node\n";
+
+    std::vector<SceneTransform> transforms(NODE_COUNT);
+    for(SceneTransform& transform : transforms)
+    {
+        transform = randomTransform();
+    }
+
+    for(uint32_t changedCount = 1; ; changedCount = std::min(changedCount * 8, NODE_COUNT))
+    {
+        std::vector<SceneNodeId> changed(nodes);
+        std::shuffle(changed.begin(), changed.end(), random);
+        changed.resize(changedCount);
+
+        uint32_t recomputedCount = 0;
+        const double updateTime = measure([&scene, &changed, &transforms, &matrices, &recomputedCount]
+        {
+            for(SceneNodeId node : changed)
+            {
+                scene.setLocalTransform(node, transforms[node]);
+            }
+            recomputedCount = scene.update();
+            scene.writeUpload(matrices.data());
+        });
+
+        stream << "    " << std::setw(13) << changedCount
+               << std::setw(19) << recomputedCount
+               << std::setw(12) << updateTime
+               << std::setw(25) << updateTime * 1e6 / std::max(recomputedCount, 1u) << "\n";
+
+        if(changedCount == NODE_COUNT)
+        {
+            break;
+        }
+    }
+
+    stream << std::defaultfloat << std::setprecision(precision);
+}
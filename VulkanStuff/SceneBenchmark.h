@@ -0,0 +1,23 @@
+#pragma once
+
+/// <summary>
+/// CPU benchmark of SceneGraph updates, run without a window or a Vulkan device.
+///
+/// A hierarchy of NODE_COUNT nodes, ROOT_COUNT trees with FAN_OUT children per node, is updated after changing the
+/// local transforms of a growing number of random nodes, up to every node. An update includes writing the changed
+/// matrices to a host buffer laid out like the GPU buffer. The time per recomputed node stays flat while the time
+/// per update follows the number of changed subtrees. Every measurement is the best of REPETITIONS runs.
+/// </summary>
+class SceneBenchmark
+{
+public:
+    static void                         run(std::ostream& stream);
+
+private:
+    static constexpr uint32_t           REPETITIONS                 = 5;
+    static constexpr uint32_t           NODE_COUNT                  = 1 << 17;
+    static constexpr uint32_t           ROOT_COUNT                  = 16;
+    static constexpr uint32_t           FAN_OUT                     = 4;
+
+    static double                       measure(const std::function<void()>& function);
+};
@@ -0,0 +1,486 @@
+#include "pch.h"
+#include "SceneGraph.h"
+
+SceneNodeId SceneGraph::addNode(SceneNodeId parent, const SceneTransform& transform)
+{
+    if(parent != NO_PARENT && parent >= nodeIndices.size())
+    {
+        throw std::runtime_error("SceneGraph: Parent of a new node does not exist!");
+    }
+    if(nodeIndices.size() >= NO_PARENT)
+    {
+        throw std::runtime_error("SceneGraph: Too many nodes!");
+    }
+
+    // Appended behind the sorted nodes; parents are always added first, so they still come before their children
+    const SceneNodeId node = static_cast<SceneNodeId>(nodeIndices.size());
+    nodeIndices.push_back(static_cast<uint32_t>(ids.size()));
+    ids.push_back(node);
+    parents.push_back(parent == NO_PARENT ? NO_PARENT : nodeIndices[parent]);
+
+    for(std::vector<float>& component : local)
+    {
+        component.push_back(0.0f);
+    }
+    for(std::vector<float>& component : world)
+    {
+        component.push_back(0.0f);
+    }
+
+    layoutDirty = true;
+    setLocalTransform(node, transform);
+
+    return node;
+}
+
+void SceneGraph::setLocalTransform(SceneNodeId node, const SceneTransform& transform)
+{
+    const uint32_t index = nodeIndices.at(node);
+
+    for(uint32_t i = 0; i < 3; ++i)
+    {
+        local[i][index] = transform.position[i];
+        local[7 + i][index] = transform.scale[i];
+    }
+    for(uint32_t i = 0; i < 4; ++i)
+    {
+        local[3 + i][index] = transform.rotation[i];
+    }
+
+    // Everything is recomputed after the layout changed
+    if(!layoutDirty && dirtyFlags[index] == 0)
+    {
+        dirtyFlags[index] = 1;
+        dirtyNodes.push_back(index);
+    }
+}
+
+SceneTransform SceneGraph::getLocalTransform(SceneNodeId node) const
+{
+    const uint32_t index = nodeIndices.at(node);
+
+    SceneTransform transform = {};
+    for(uint32_t i = 0; i < 3; ++i)
+    {
+        transform.position[i] = local[i][index];
+        transform.scale[i] = local[7 + i][index];
+    }
+    for(uint32_t i = 0; i < 4; ++i)
+    {
+        transform.rotation[i] = local[3 + i][index];
+    }
+
+    return transform;
+}
+
+/// <summary>
+/// Reorders the nodes breadth first: the roots in their current order, then depth by depth the children of every
+/// node in the order of their parents. Each array is permuted once.
+/// </summary>
+void SceneGraph::sortByDepth()
+{
+    const uint32_t nodeCount = static_cast<uint32_t>(ids.size());
+
+    // Children of every node in their current order, parents come first so a counting pass suffices
+    std::vector<uint32_t> childOffsets(nodeCount + 1, 0);
+    for(uint32_t i = 0; i < nodeCount; ++i)
+    {
+        if(parents[i] != NO_PARENT)
+        {
+            ++childOffsets[parents[i] + 1];
+        }
+    }
+    for(uint32_t i = 0; i < nodeCount; ++i)
+    {
+        childOffsets[i + 1] += childOffsets[i];
+    }
+    std::vector<uint32_t> children(childOffsets[nodeCount]);
+    std::vector<uint32_t> childFill(childOffsets.begin(), childOffsets.end() - 1);
+    for(uint32_t i = 0; i < nodeCount; ++i)
+    {
+        if(parents[i] != NO_PARENT)
+        {
+            children[childFill[parents[i]]++] = i;
+        }
+    }
+
+    std::vector<uint32_t> order;
+    order.reserve(nodeCount);
+    for(uint32_t i = 0; i < nodeCount; ++i)
+    {
+        if(parents[i] == NO_PARENT)
+        {
+            order.push_back(i);
+        }
+    }
+
+    depthStarts.assign(1, 0);
+    for(size_t begin = 0; begin < order.size();)
+    {
+        const size_t end = order.size();
+        depthStarts.push_back(static_cast<uint32_t>(end));
+        for(size_t i = begin; i < end; ++i)
+        {
+            order.insert(order.end(), children.begin() + childOffsets[order[i]], children.begin() + childOffsets[order[i] + 1]);
+        }
+        begin = end;
+    }
+
+    std::vector<uint32_t> newIndices(nodeCount);
+    for(uint32_t i = 0; i < nodeCount; ++i)
+    {
+        newIndices[order[i]] = i;
+    }
+
+    std::vector<float> sorted(nodeCount);
+    for(std::vector<float>& component : local)
+    {
+        for(uint32_t i = 0; i < nodeCount; ++i)
+        {
+            sorted[i] = component[order[i]];
+        }
+        component.swap(sorted);
+    }
+
+    std::vector<SceneNodeId> sortedIds(nodeCount);
+    std::vector<uint32_t> sortedParents(nodeCount);
+    for(uint32_t i = 0; i < nodeCount; ++i)
+    {
+        sortedIds[i] = ids[order[i]];
+        sortedParents[i] = parents[order[i]] == NO_PARENT ? NO_PARENT : newIndices[parents[order[i]]];
+        nodeIndices[sortedIds[i]] = i;
+    }
+    ids.swap(sortedIds);
+    parents.swap(sortedParents);
+
+    firstChildren.assign(nodeCount, 0);
+    childCounts.assign(nodeCount, 0);
+    for(uint32_t i = 0; i < nodeCount; ++i)
+    {
+        if(parents[i] != NO_PARENT && childCounts[parents[i]]++ == 0)
+        {
+            firstChildren[parents[i]] = i;
+        }
+    }
+
+    dirtyFlags.assign(nodeCount, 0);
+    dirtyNodes.clear();
+}
+
+/// <summary>
+/// Recomputes the world matrices of a range of nodes at one depth: the local matrices from the transform components,
+/// then, below the roots, the product with the parent's world matrix. Both loops only index plain arrays.
+/// </summary>
+void SceneGraph::computeRange(Range range)
+{
+    const float* const px = local[0].data();
+    const float* const py = local[1].data();
+    const float* const pz = local[2].data();
+    const float* const qx = local[3].data();
+    const float* const qy = local[4].data();
+    const float* const qz = local[5].data();
+    const float* const qw = local[6].data();
+    const float* const sx = local[7].data();
+    const float* const sy = local[8].data();
+    const float* const sz = local[9].data();
+
+    float* m[MATRIX_COMPONENTS] = {};
+    for(uint32_t i = 0; i < MATRIX_COMPONENTS; ++i)
+    {
+        m[i] = world[i].data();
+    }
+
+    for(uint32_t i = range.begin; i < range.end; ++i)
+    {
+        const float xx = qx[i] * qx[i], yy = qy[i] * qy[i], zz = qz[i] * qz[i];
+        const float xy = qx[i] * qy[i], xz = qx[i] * qz[i], yz = qy[i] * qz[i];
+        const float wx = qw[i] * qx[i], wy = qw[i] * qy[i], wz = qw[i] * qz[i];
+
+        m[0][i]  = (1.0f - 2.0f * (yy + zz)) * sx[i];
+        m[1][i]  = 2.0f * (xy - wz) * sy[i];
+        m[2][i]  = 2.0f * (xz + wy) * sz[i];
+        m[3][i]  = px[i];
+        m[4][i]  = 2.0f * (xy + wz) * sx[i];
+        m[5][i]  = (1.0f - 2.0f * (xx + zz)) * sy[i];
+        m[6][i]  = 2.0f * (yz - wx) * sz[i];
+        m[7][i]  = py[i];
+        m[8][i]  = 2.0f * (xz - wy) * sx[i];
+        m[9][i]  = 2.0f * (yz + wx) * sy[i];
+        m[10][i] = (1.0f - 2.0f * (xx + yy)) * sz[i];
+        m[11][i] = pz[i];
+    }
+
+    // A range never spans two depths, either all of its nodes are roots or none
+    if(range.begin == range.end || parents[range.begin] == NO_PARENT)
+    {
+        return;
+    }
+
+    const uint32_t* const parent = parents.data();
+    for(uint32_t i = range.begin; i < range.end; ++i)
+    {
+        const uint32_t p = parent[i];
+
+        float l[MATRIX_COMPONENTS];
+        for(uint32_t k = 0; k < MATRIX_COMPONENTS; ++k)
+        {
+            l[k] = m[k][i];
+        }
+
+        for(uint32_t row = 0; row < 3; ++row)
+        {
+            const float a0 = m[row * 4 + 0][p], a1 = m[row * 4 + 1][p], a2 = m[row * 4 + 2][p], a3 = m[row * 4 + 3][p];
+            m[row * 4 + 0][i] = a0 * l[0] + a1 * l[4] + a2 * l[8];
+            m[row * 4 + 1][i] = a0 * l[1] + a1 * l[5] + a2 * l[9];
+            m[row * 4 + 2][i] = a0 * l[2] + a1 * l[6] + a2 * l[10];
+            m[row * 4 + 3][i] = a0 * l[3] + a1 * l[7] + a2 * l[11] + a3;
+        }
+    }
+}
+
+/// <summary>
+/// Recomputes the nodes changed since the last update and their descendants, returns the number of recomputed nodes.
+///
+/// Depth by depth, the nodes marked at that depth are merged into the ranges inherited from changed parents; the
+/// child ranges of the result are the inherited ranges of the next depth. Only changed subtrees are visited.
+/// </summary>
+uint32_t SceneGraph::update()
+{
+    const uint32_t nodeCount = static_cast<uint32_t>(ids.size());
+
+    if(layoutDirty)
+    {
+        sortByDepth();
+        layoutDirty = false;
+
+        for(uint32_t depth = 0; depth + 1 < depthStarts.size(); ++depth)
+        {
+            computeRange({ depthStarts[depth], depthStarts[depth + 1] });
+        }
+
+        // The order changed, every matrix in the buffer is stale
+        pendingUploads.assign(1, { 0, nodeCount });
+        return nodeCount;
+    }
+
+    if(dirtyNodes.empty())
+    {
+        return 0;
+    }
+
+    // When a large part of the scene changed, collecting the marked nodes in order is cheaper than sorting them
+    if(dirtyNodes.size() > nodeCount / 16)
+    {
+        dirtyNodes.clear();
+        for(uint32_t i = 0; i < nodeCount; ++i)
+        {
+            if(dirtyFlags[i] != 0)
+            {
+                dirtyNodes.push_back(i);
+            }
+        }
+    }
+    else
+    {
+        std::sort(dirtyNodes.begin(), dirtyNodes.end());
+    }
+
+    uint32_t updatedCount = 0;
+    size_t nextDirty = 0;
+    currentRanges.clear();
+
+    for(uint32_t depth = 0; depth + 1 < depthStarts.size(); ++depth)
+    {
+        const uint32_t depthEnd = depthStarts[depth + 1];
+
+        // Both lists are sorted, so are the merged ranges
+        childRanges.clear();
+        size_t nextRange = 0;
+        while(nextRange < currentRanges.size() || (nextDirty < dirtyNodes.size() && dirtyNodes[nextDirty] < depthEnd))
+        {
+            if(nextDirty < dirtyNodes.size() && dirtyNodes[nextDirty] < depthEnd
+               && (nextRange == currentRanges.size() || dirtyNodes[nextDirty] < currentRanges[nextRange].begin))
+            {
+                appendRange(childRanges, { dirtyNodes[nextDirty], dirtyNodes[nextDirty] + 1 });
+                ++nextDirty;
+            }
+            else
+            {
+                appendRange(childRanges, currentRanges[nextRange++]);
+            }
+        }
+        currentRanges.swap(childRanges);
+
+        childRanges.clear();
+        for(const Range& range : currentRanges)
+        {
+            computeRange(range);
+            appendRange(pendingUploads, range);
+            updatedCount += range.end - range.begin;
+
+            for(uint32_t i = range.begin; i < range.end; ++i)
+            {
+                dirtyFlags[i] = 0;
+                if(childCounts[i] > 0)
+                {
+                    appendRange(childRanges, { firstChildren[i], firstChildren[i] + childCounts[i] });
+                }
+            }
+        }
+        currentRanges.swap(childRanges);
+
+        if(currentRanges.empty() && nextDirty == dirtyNodes.size())
+        {
+            break;
+        }
+    }
+
+    dirtyNodes.clear();
+
+    return updatedCount;
+}
+
+/// <summary>
+/// Writes the matrices recomputed since the last upload into the staging ring and records their copies into the
+/// destination buffer, returns the number of uploaded matrices. Ranges larger than half the ring are split, so
+/// every part fits next to the uploads of the other frame in flight; what finds no space waits for a later frame.
+///
+/// The caller orders the copies after the last reads of the destination and before the next ones, and commits the
+/// ring with the frame number.
+/// </summary>
+uint32_t SceneGraph::recordUpload(VkCommandBuffer commandBuffer, StagingRing& ring, VkBuffer destination)
+{
+    mergePendingUploads();
+
+    const uint32_t largestCount = static_cast<uint32_t>(std::max<VkDeviceSize>(ring.getCapacity() / (2 * MATRIX_SIZE), 1));
+
+    std::vector<VkBufferCopy> regions;
+    uint32_t uploadedCount = 0;
+    size_t uploadedRanges = 0;
+
+    while(uploadedRanges < pendingUploads.size())
+    {
+        Range& range = pendingUploads[uploadedRanges];
+        const uint32_t count = std::min(range.end - range.begin, largestCount);
+
+        const auto offset = ring.allocate(count * MATRIX_SIZE, 16);
+        if(!offset.has_value())
+        {
+            break;
+        }
+
+        writeMatrices({ range.begin, range.begin + count }, reinterpret_cast<float*>(ring.getMapped() + offset.value()));
+        regions.push_back({ offset.value(), range.begin * MATRIX_SIZE, count * MATRIX_SIZE });
+
+        uploadedCount += count;
+        range.begin += count;
+        if(range.begin == range.end)
+        {
+            ++uploadedRanges;
+        }
+    }
+
+    pendingUploads.erase(pendingUploads.begin(), pendingUploads.begin() + uploadedRanges);
+
+    if(!regions.empty())
+    {
+        vkCmdCopyBuffer(commandBuffer, ring.getBuffer(), destination, static_cast<uint32_t>(regions.size()), regions.data());
+    }
+
+    return uploadedCount;
+}
+
+/// <summary>
+/// Writes the matrices recomputed since the last upload to memory laid out like the destination buffer, such as a
+/// mapped host visible buffer, returns their number.
+/// </summary>
+uint32_t SceneGraph::writeUpload(float* destination)
+{
+    mergePendingUploads();
+
+    uint32_t uploadedCount = 0;
+    for(const Range& range : pendingUploads)
+    {
+        writeMatrices(range, destination + static_cast<size_t>(range.begin) * 16);
+        uploadedCount += range.end - range.begin;
+    }
+    pendingUploads.clear();
+
+    return uploadedCount;
+}
+
+/// <summary>
+/// Transposes the world matrices of a range into consecutive column major mat4s.
+/// </summary>
+void SceneGraph::writeMatrices(Range range, float* destination) const
+{
+    for(uint32_t i = range.begin; i < range.end; ++i)
+    {
+        float* matrix = destination + static_cast<size_t>(i - range.begin) * 16;
+        for(uint32_t column = 0; column < 4; ++column)
+        {
+            matrix[column * 4 + 0] = world[0 + column][i];
+            matrix[column * 4 + 1] = world[4 + column][i];
+            matrix[column * 4 + 2] = world[8 + column][i];
+            matrix[column * 4 + 3] = column == 3 ? 1.0f : 0.0f;
+        }
+    }
+}
+
+/// <summary>
+/// Ranges of several updates may overlap when a frame uploaded nothing, they are sorted and merged first.
+/// </summary>
+void SceneGraph::mergePendingUploads()
+{
+    std::sort(pendingUploads.begin(), pendingUploads.end(), [](const Range& a, const Range& b) { return a.begin < b.begin; });
+
+    std::vector<Range> merged;
+    merged.reserve(pendingUploads.size());
+    for(const Range& range : pendingUploads)
+    {
+        appendRange(merged, range);
+    }
+    pendingUploads.swap(merged);
+}
+
+/// <summary>
+/// Appends a range to a list sorted by begin, joining it with the last range when they touch or overlap.
+/// </summary>
+void SceneGraph::appendRange(std::vector<Range>& ranges, Range range)
+{
+    if(!ranges.empty() && range.begin <= ranges.back().end && range.begin >= ranges.back().begin)
+    {
+        ranges.back().end = std::max(ranges.back().end, range.end);
+        return;
+    }
+
+    ranges.push_back(range);
+}
+
+void SceneGraph::getWorldMatrix(SceneNodeId node, float matrix[16]) const
+{
+    writeMatrices({ getTransformIndex(node), getTransformIndex(node) + 1 }, matrix);
+}
+
+/// <summary>
+/// Index of the node's matrix in the uploaded buffer, valid from the update after the node was added.
+/// </summary>
+uint32_t SceneGraph::getTransformIndex(SceneNodeId node) const
+{
+    if(layoutDirty)
+    {
+        throw std::runtime_error("SceneGraph: Nodes were added since the last update!");
+    }
+
+    return nodeIndices.at(node);
+}
+
+uint32_t SceneGraph::getNodeCount() const
+{
+    return static_cast<uint32_t>(ids.size());
+}
+
+uint32_t SceneGraph::getDepthCount() const
+{
+    return depthStarts.empty() ? 0 : static_cast<uint32_t>(depthStarts.size() - 1);
+}
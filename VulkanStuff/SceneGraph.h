@@ -0,0 +1,87 @@
+#pragma once
+#include "StagingRing.h"
+
+using SceneNodeId = uint32_t;
+
+struct SceneTransform
+{
+    float                               position[3]                 = {};
+    float                               rotation[4]                 = { 0.0f, 0.0f, 0.0f, 1.0f };  // unit quaternion, xyzw
+    float                               scale[3]                    = { 1.0f, 1.0f, 1.0f };
+};
+
+/// <summary>
+/// Transform hierarchy stored as structure of arrays and sorted by depth.
+///
+/// Nodes are ordered breadth first: all nodes of a depth follow each other, and the children of a node are one
+/// contiguous range ordered like their parents. Every component of the local transforms and of the affine world
+/// matrices has its own array, so a range of nodes is computed by linear loops over plain float arrays, the
+/// parents of a range always being finished since they come earlier.
+///
+/// setLocalTransform() only marks the node. update() recomputes the marked nodes and their descendants depth by
+/// depth, expanding the changed ranges of one depth to the child ranges of the next, so its cost follows the number
+/// of changed nodes and not the size of the scene. Adding nodes reorders the arrays on the next update(), which
+/// then recomputes everything; node ids stay stable, getTransformIndex() maps them to the current order.
+///
+/// World matrices are uploaded to a buffer holding one column major mat4 per node, in node order. The ranges
+/// recomputed since the last upload are transposed straight into staging ring memory by recordUpload(); ranges
+/// the ring has no space for stay pending until a later frame.
+/// </summary>
+class SceneGraph
+{
+public:
+    static constexpr SceneNodeId        NO_PARENT                   = std::numeric_limits<SceneNodeId>::max();
+    static constexpr VkDeviceSize       MATRIX_SIZE                 = 16 * sizeof(float);
+
+    SceneNodeId                         addNode(SceneNodeId parent, const SceneTransform& local);
+    void                                setLocalTransform(SceneNodeId node, const SceneTransform& local);
+    SceneTransform                      getLocalTransform(SceneNodeId node)                                                     const;
+
+    uint32_t                            update();
+    uint32_t                            recordUpload(VkCommandBuffer commandBuffer, StagingRing& ring, VkBuffer destination);
+    uint32_t                            writeUpload(float* destination);
+
+    void                                getWorldMatrix(SceneNodeId node, float matrix[16])                                      const;
+    uint32_t                            getTransformIndex(SceneNodeId node)                                                     const;
+    uint32_t                            getNodeCount()                                                                          const;
+    uint32_t                            getDepthCount()                                                                         const;
+
+private:
+    // Components of the local transforms: position xyz, rotation xyzw, scale xyz
+    static constexpr uint32_t           TRANSFORM_COMPONENTS        = 10;
+    // Components of the world matrices: the upper three rows, row major
+    static constexpr uint32_t           MATRIX_COMPONENTS           = 12;
+
+    struct Range
+    {
+        uint32_t                        begin                       = 0;
+        uint32_t                        end                         = 0;
+    };
+
+    //Stable ids and the order of the arrays
+    std::vector<uint32_t>               nodeIndices                 = {};   // position of every id in the arrays
+    std::vector<SceneNodeId>            ids                         = {};
+    std::vector<uint32_t>               parents                     = {};   // index of the parent or NO_PARENT
+    std::vector<uint32_t>               firstChildren               = {};
+    std::vector<uint32_t>               childCounts                 = {};
+    std::vector<uint32_t>               depthStarts                 = {};   // first index of every depth, then the node count
+    bool                                layoutDirty                 = false;
+
+    //Components
+    std::vector<float>                  local[TRANSFORM_COMPONENTS] = {};
+    std::vector<float>                  world[MATRIX_COMPONENTS]    = {};
+
+    //Changes
+    std::vector<uint8_t>                dirtyFlags                  = {};
+    std::vector<uint32_t>               dirtyNodes                  = {};   // indices set since the last update
+    std::vector<Range>                  pendingUploads              = {};   // recomputed since the last upload
+    std::vector<Range>                  currentRanges               = {};
+    std::vector<Range>                  childRanges                 = {};
+
+    void                                sortByDepth();
+    void                                computeRange(Range range);
+    void                                writeMatrices(Range range, float* destination)                                          const;
+    void                                mergePendingUploads();
+
+    static void                         appendRange(std::vector<Range>& ranges, Range range);
+};
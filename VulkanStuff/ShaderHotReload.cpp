@@ -0,0 +1,450 @@
+#include "pch.h"
+#include "ShaderHotReload.h"
+#include "FrameTimeRecorder.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+static std::optional<ShaderHotReload::ShaderCode> readBinary(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if(!file.is_open())
+    {
+        return std::nullopt;
+    }
+
+    ShaderHotReload::ShaderCode code(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(code.data(), static_cast<std::streamsize>(code.size()));
+
+    return code;
+}
+
+static bool isSpirv(const ShaderHotReload::ShaderCode& code)
+{
+    uint32_t magic = 0;
+    if(code.size() < sizeof(magic) || code.size() % sizeof(uint32_t) != 0)
+    {
+        return false;
+    }
+
+    std::memcpy(&magic, code.data(), sizeof(magic));
+    return magic == SPIRV_MAGIC;
+}
+
+ShaderHotReload::ShaderHotReload(const std::filesystem::path& shaderDirectory, const std::filesystem::path& compilerPath)
+    : shaderDirectory(shaderDirectory)
+    , compilerPath(compilerPath)
+{
+}
+
+ShaderHotReload::~ShaderHotReload()
+{
+    stop();
+}
+
+/// <summary>
+/// Looks for glslc on PATH first, then in the Bin directory of the Vulkan SDK, which the SDK installer does not
+/// always put on PATH.
+/// </summary>
+std::optional<std::filesystem::path> ShaderHotReload::findCompiler()
+{
+#ifdef _WIN32
+    const char* executable = "glslc.exe";
+    const char separator = ';';
+#else
+    const char* executable = "glslc";
+    const char separator = ':';
+#endif
+
+    std::vector<std::filesystem::path> directories;
+    if(const char* path = std::getenv("PATH"))
+    {
+        std::stringstream stream(path);
+        std::string directory;
+        while(std::getline(stream, directory, separator))
+        {
+            if(!directory.empty())
+            {
+                directories.push_back(directory);
+            }
+        }
+    }
+
+    if(const char* sdk = std::getenv("VULKAN_SDK"))
+    {
+        directories.push_back(std::filesystem::path(sdk) / "Bin");
+        directories.push_back(std::filesystem::path(sdk) / "bin");
+    }
+
+    for(const auto& directory : directories)
+    {
+        std::error_code error;
+        const std::filesystem::path candidate = directory / executable;
+        if(std::filesystem::is_regular_file(candidate, error))
+        {
+            return candidate;
+        }
+    }
+
+    return std::nullopt;
+}
+
+/// <summary>
+/// Binaries are named after the source, like compile.bat does: Shaders/shader.frag is compiled to Shaders/shader.frag.spv.
+/// </summary>
+std::filesystem::path ShaderHotReload::getBinaryPath(const std::filesystem::path& sourcePath)
+{
+    std::filesystem::path binaryPath = sourcePath;
+    binaryPath += ".spv";
+    return binaryPath;
+}
+
+/// <summary>
+/// Registers a pipeline built from the given sources of the shader directory, in stage order. The builder gets the
+/// SPIR-V of every stage and runs on the watcher thread. Pipelines are registered before start().
+/// </summary>
+void ShaderHotReload::addPipeline(UniquePipeline& target, const std::vector<std::string>& sourceNames, PipelineBuilder builder)
+{
+    Pipeline pipeline = {};
+    pipeline.target = &target;
+    pipeline.builder = std::move(builder);
+
+    for(const auto& sourceName : sourceNames)
+    {
+        const std::filesystem::path path = shaderDirectory / sourceName;
+        auto found = std::find_if(sources.begin(), sources.end(), [&path](const Source& source) { return source.path == path; });
+
+        if(found == sources.end())
+        {
+            // The current binary is used for the stages which did not change when another stage of the pipeline does.
+            Source source = {};
+            source.path = path;
+            source.lastWriteTime = std::filesystem::last_write_time(path);
+            source.code = readBinary(getBinaryPath(path)).value_or(ShaderCode());
+
+            found = sources.insert(sources.end(), std::move(source));
+        }
+
+        pipeline.sources.push_back(static_cast<size_t>(found - sources.begin()));
+    }
+
+    pipelines.push_back(std::move(pipeline));
+}
+
+void ShaderHotReload::start()
+{
+    openWatch();
+    watcherThread = std::thread(&ShaderHotReload::watcherLoop, this);
+
+    std::cout << "ShaderHotReload: Watching " << sources.size() << " shader(s) in " << shaderDirectory.string()
+              << ", compiling with " << compilerPath.string() << std::endl;
+}
+
+/// <summary>
+/// Joins the watcher thread. Pipelines it built but which were not swapped in yet are destroyed.
+/// </summary>
+void ShaderHotReload::stop()
+{
+    stopping = true;
+
+    if(watcherThread.joinable())
+    {
+        watcherThread.join();
+    }
+
+    closeWatch();
+
+    std::lock_guard<std::mutex> lock(rebuiltMutex);
+    rebuiltPipelines.clear();
+}
+
+#ifdef _WIN32
+
+void ShaderHotReload::openWatch()
+{
+    const HANDLE handle = FindFirstChangeNotificationW(shaderDirectory.c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+    if(handle == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("ShaderHotReload: Failed to watch " + shaderDirectory.string() + "!");
+    }
+    changeHandle = handle;
+}
+
+bool ShaderHotReload::waitForChange()
+{
+    if(WaitForSingleObject(changeHandle, static_cast<DWORD>(POLL_INTERVAL.count())) != WAIT_OBJECT_0)
+    {
+        return false;
+    }
+
+    FindNextChangeNotification(changeHandle);
+    return true;
+}
+
+void ShaderHotReload::closeWatch()
+{
+    if(changeHandle != nullptr)
+    {
+        FindCloseChangeNotification(changeHandle);
+        changeHandle = nullptr;
+    }
+}
+
+#else
+
+void ShaderHotReload::openWatch()
+{
+    inotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(inotifyDescriptor < 0)
+    {
+        throw std::runtime_error("ShaderHotReload: Failed to initialize inotify!");
+    }
+
+    // Editors either write the file in place or write a new file and rename it over the old one.
+    if(inotify_add_watch(inotifyDescriptor, shaderDirectory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        closeWatch();
+        throw std::runtime_error("ShaderHotReload: Failed to watch " + shaderDirectory.string() + "!");
+    }
+}
+
+bool ShaderHotReload::waitForChange()
+{
+    pollfd descriptor = { inotifyDescriptor, POLLIN, 0 };
+    if(poll(&descriptor, 1, static_cast<int>(POLL_INTERVAL.count())) <= 0)
+    {
+        return false;
+    }
+
+    // The events only wake the watcher, which sources changed is decided by their write time.
+    alignas(inotify_event) char events[4096];
+    bool changed = false;
+    while(read(inotifyDescriptor, events, sizeof(events)) > 0)
+    {
+        changed = true;
+    }
+
+    return changed;
+}
+
+void ShaderHotReload::closeWatch()
+{
+    if(inotifyDescriptor >= 0)
+    {
+        close(inotifyDescriptor);
+        inotifyDescriptor = -1;
+    }
+}
+
+#endif
+
+/// <summary>
+/// Change notifications only wake the watcher. A source is recompiled when its write time differs from the last
+/// one seen, which also ignores the notifications caused by writing the binaries into the same directory.
+/// </summary>
+void ShaderHotReload::watcherLoop()
+{
+    while(!stopping)
+    {
+        if(!waitForChange())
+        {
+            continue;
+        }
+
+        const auto changeTime = Clock::now();
+        std::this_thread::sleep_for(SETTLE_TIME);
+
+        std::vector<bool> recompiled(sources.size(), false);
+        for(size_t sourceIndex = 0; sourceIndex < sources.size(); ++sourceIndex)
+        {
+            Source& source = sources[sourceIndex];
+
+            std::error_code error;
+            const auto lastWriteTime = std::filesystem::last_write_time(source.path, error);
+            if(error || lastWriteTime == source.lastWriteTime)
+            {
+                continue;
+            }
+
+            source.lastWriteTime = lastWriteTime;
+            recompiled[sourceIndex] = compile(source);
+        }
+
+        for(size_t pipelineIndex = 0; pipelineIndex < pipelines.size(); ++pipelineIndex)
+        {
+            const auto& pipelineSources = pipelines[pipelineIndex].sources;
+            if(std::any_of(pipelineSources.begin(), pipelineSources.end(), [&recompiled](size_t sourceIndex) { return recompiled[sourceIndex]; }))
+            {
+                rebuild(pipelineIndex, changeTime);
+            }
+        }
+    }
+}
+
+/// <summary>
+/// Runs glslc into a temporary file which replaces the binary only when it holds valid SPIR-V, so a failed compile
+/// leaves the binary of the last working source on disk.
+/// </summary>
+bool ShaderHotReload::compile(Source& source)
+{
+    const std::filesystem::path binaryPath = getBinaryPath(source.path);
+    std::filesystem::path temporaryPath = binaryPath;
+    temporaryPath += ".tmp";
+    std::filesystem::path logPath = binaryPath;
+    logPath += ".log";
+
+    // Vulkan 1.2 targets SPIR-V 1.5, which mesh shaders need, the other stages stay loadable on Vulkan 1.0 devices
+    const std::string extension = source.path.extension().string();
+    const std::string targetEnvironment = extension == ".task" || extension == ".mesh" ? " --target-env=vulkan1.2" : "";
+    std::string command = "\"" + compilerPath.string() + "\"" + targetEnvironment + " \"" + source.path.string() + "\" -o \"" + temporaryPath.string()
+                        + "\" 2> \"" + logPath.string() + "\"";
+#ifdef _WIN32
+    // cmd.exe strips the outer quotes of a command which starts with one
+    command = "\"" + command + "\"";
+#endif
+
+    const auto start = Clock::now();
+    const int result = std::system(command.c_str());
+    const double compileTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    const ShaderCode log = readBinary(logPath).value_or(ShaderCode());
+    const ShaderCode code = result == 0 ? readBinary(temporaryPath).value_or(ShaderCode()) : ShaderCode();
+
+    std::error_code error;
+    std::filesystem::remove(logPath, error);
+
+    if(!isSpirv(code))
+    {
+        std::filesystem::remove(temporaryPath, error);
+
+        std::lock_guard<std::mutex> lock(statisticsMutex);
+        ++failedCompiles;
+        std::cerr << "ShaderHotReload: Failed to compile " << source.path.string() << ", keeping the current pipelines\n"
+                  << std::string(log.begin(), log.end()) << std::flush;
+        return false;
+    }
+
+    std::filesystem::rename(temporaryPath, binaryPath, error);
+    if(error)
+    {
+        std::cerr << "ShaderHotReload: Failed to replace " << binaryPath.string() << ", the next start uses the old binary" << std::endl;
+    }
+
+    source.code = code;
+
+    std::lock_guard<std::mutex> lock(statisticsMutex);
+    ++compiledShaders;
+    compileTimes.push_back(compileTime);
+    std::cout << "ShaderHotReload: Compiled " << source.path.string() << " in " << compileTime << " ms" << std::endl;
+
+    return true;
+}
+
+void ShaderHotReload::rebuild(size_t pipelineIndex, Clock::time_point changeTime)
+{
+    const Pipeline& pipeline = pipelines[pipelineIndex];
+
+    std::vector<ShaderCode> stages;
+    for(size_t sourceIndex : pipeline.sources)
+    {
+        // A stage without binary has never compiled, the pipeline is built once it does.
+        if(sources[sourceIndex].code.empty())
+        {
+            return;
+        }
+        stages.push_back(sources[sourceIndex].code);
+    }
+
+    const auto start = Clock::now();
+    UniquePipeline rebuilt;
+    try
+    {
+        rebuilt = pipeline.builder(stages);
+    }
+    catch(const std::exception& exception)
+    {
+        std::lock_guard<std::mutex> lock(statisticsMutex);
+        ++failedBuilds;
+        std::cerr << "ShaderHotReload: " << exception.what() << std::endl;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(statisticsMutex);
+        buildTimes.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+
+    // A pipeline rebuilt again before it was swapped in replaces the pending one, which no frame used.
+    std::lock_guard<std::mutex> lock(rebuiltMutex);
+    auto pending = std::find_if(rebuiltPipelines.begin(), rebuiltPipelines.end(),
+                                [pipelineIndex](const RebuiltPipeline& entry) { return entry.pipelineIndex == pipelineIndex; });
+    if(pending != rebuiltPipelines.end())
+    {
+        pending->pipeline = std::move(rebuilt);
+    }
+    else
+    {
+        rebuiltPipelines.push_back({ pipelineIndex, std::move(rebuilt), changeTime });
+    }
+}
+
+/// <summary>
+/// Moves the pipelines rebuilt since the last call into their targets. Frames up to retireValue may still use the
+/// replaced pipelines, they are destroyed by the deletion queue once those completed.
+/// Returns the number of pipelines swapped.
+/// </summary>
+size_t ShaderHotReload::swapPipelines(DeletionQueue& deletionQueue, uint64_t retireValue)
+{
+    std::vector<RebuiltPipeline> rebuilt;
+    {
+        std::lock_guard<std::mutex> lock(rebuiltMutex);
+        rebuilt.swap(rebuiltPipelines);
+    }
+
+    if(rebuilt.empty())
+    {
+        return 0;
+    }
+
+    const auto now = Clock::now();
+
+    std::lock_guard<std::mutex> lock(statisticsMutex);
+    for(auto& entry : rebuilt)
+    {
+        // Targets are only written here, the watcher thread never touches them.
+        UniquePipeline& target = *pipelines[entry.pipelineIndex].target;
+        deletionQueue.push(retireValue, std::move(target));
+        target = std::move(entry.pipeline);
+
+        reloadLatencies.push_back(std::chrono::duration<double, std::milli>(now - entry.changeTime).count());
+    }
+    swappedPipelines += rebuilt.size();
+
+    std::cout << "ShaderHotReload: Swapped in " << rebuilt.size() << " pipeline(s)" << std::endl;
+
+    return rebuilt.size();
+}
+
+void ShaderHotReload::printStatistics(std::ostream& stream) const
+{
+    std::lock_guard<std::mutex> lock(statisticsMutex);
+
+    const FrameTimeRecorder::Summary compile = FrameTimeRecorder::summarize(compileTimes);
+    const FrameTimeRecorder::Summary build = FrameTimeRecorder::summarize(buildTimes);
+    const FrameTimeRecorder::Summary latency = FrameTimeRecorder::summarize(reloadLatencies);
+
+    stream << "ShaderHotReload: " << compiledShaders << " shader(s) compiled, " << failedCompiles << " failed, compile mean " << compile.mean << " ms, max "
+           << compile.maximum << " ms\n"
+           << "    " << swappedPipelines << " pipeline(s) swapped, " << failedBuilds << " failed to build, build mean " << build.mean << " ms, change to swap mean "
+           << latency.mean << " ms, max " << latency.maximum << " ms\n";
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "DeletionQueue.h"
+#include "VkHandle.h"
+
+/// <summary>
+/// Recompiles GLSL shaders when their source changes and rebuilds the pipelines using them, so shaders can be
+/// iterated on without restarting the application.
+///
+/// A watcher thread waits for changes in the shader directory (change notifications on Windows, inotify elsewhere),
+/// compiles every changed source with glslc and writes the SPIR-V next to it the way compile.bat does:
+/// shader.vert becomes shader.vert.spv. It then builds every pipeline using one of the changed stages, all off the render
+/// thread. A source which fails to compile keeps the previous pipeline and prints the compiler output.
+///
+/// swapPipelines() is called by the render thread at a frame boundary. It moves the rebuilt pipelines into place and
+/// retires the replaced ones through the DeletionQueue, so no vkDeviceWaitIdle is needed.
+/// </summary>
+class ShaderHotReload
+{
+public:
+    using ShaderCode = std::vector<char>;
+    using PipelineBuilder = std::function<UniquePipeline(const std::vector<ShaderCode>& stages)>;
+
+                                        ShaderHotReload(const std::filesystem::path& shaderDirectory, const std::filesystem::path& compilerPath);
+                                        ~ShaderHotReload();
+
+                                        ShaderHotReload(const ShaderHotReload&) = delete;
+    ShaderHotReload&                    operator=(const ShaderHotReload&) = delete;
+
+    void                                addPipeline(UniquePipeline& target, const std::vector<std::string>& sources, PipelineBuilder builder);
+    void                                start();
+    void                                stop();
+
+    size_t                              swapPipelines(DeletionQueue& deletionQueue, uint64_t retireValue);
+
+    void                                printStatistics(std::ostream& stream)                                                   const;
+
+    static std::optional<std::filesystem::path> findCompiler();
+    static std::filesystem::path        getBinaryPath(const std::filesystem::path& sourcePath);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr auto               POLL_INTERVAL               = std::chrono::milliseconds(100);   // how often the watcher checks for stop()
+    static constexpr auto               SETTLE_TIME                 = std::chrono::milliseconds(50);    // editors write a file in several steps
+
+    struct Source
+    {
+        std::filesystem::path           path                        = {};
+        std::filesystem::file_time_type lastWriteTime               = {};
+        ShaderCode                      code                        = {};
+    };
+
+    struct Pipeline
+    {
+        UniquePipeline*                 target                      = nullptr;
+        std::vector<size_t>             sources                     = {};
+        PipelineBuilder                 builder                     = {};
+    };
+
+    struct RebuiltPipeline
+    {
+        size_t                          pipelineIndex               = 0;
+        UniquePipeline                  pipeline                    = {};
+        Clock::time_point               changeTime                  = {};
+    };
+
+    const std::filesystem::path         shaderDirectory;
+    const std::filesystem::path         compilerPath;
+
+    // Owned by the watcher thread once it started
+    std::vector<Source>                 sources                     = {};
+    std::vector<Pipeline>               pipelines                   = {};
+
+    std::thread                         watcherThread;
+    std::atomic<bool>                   stopping                    = false;
+
+#ifdef _WIN32
+    void*                               changeHandle                = nullptr;
+#else
+    int                                 inotifyDescriptor           = -1;
+#endif
+
+    // Pipelines built by the watcher thread, waiting for the render thread to swap them in
+    mutable std::mutex                  rebuiltMutex;
+    std::vector<RebuiltPipeline>        rebuiltPipelines            = {};
+
+    //Statistics
+    mutable std::mutex                  statisticsMutex;
+    uint64_t                            compiledShaders             = 0;
+    uint64_t                            failedCompiles              = 0;
+    uint64_t                            failedBuilds                = 0;
+    uint64_t                            swappedPipelines            = 0;
+    std::vector<double>                 compileTimes                = {};   // ms per glslc run
+    std::vector<double>                 buildTimes                  = {};   // ms per pipeline
+    std::vector<double>                 reloadLatencies             = {};   // ms from the change being seen to the swap
+
+    void                                openWatch();
+    bool                                waitForChange();
+    void                                closeWatch();
+
+    void                                watcherLoop();
+    bool                                compile(Source& source);
+    void                                rebuild(size_t pipelineIndex, Clock::time_point changeTime);
+};
@@ -0,0 +1,568 @@
+#include "pch.h"
+#include "ShaderReflection.h"
+
+// Values of the SPIR-V specification (Khronos, "SPIR-V Specification", section 3) used by the reflection.
+static constexpr uint32_t SPIRV_MAGIC                               = 0x07230203;
+static constexpr uint32_t SPIRV_HEADER_WORDS                        = 5;
+
+enum SpirvOp : uint32_t
+{
+    OpName                      = 5,
+    OpEntryPoint                = 15,
+    OpExecutionMode             = 16,
+    OpTypeBool                  = 20,
+    OpTypeInt                   = 21,
+    OpTypeFloat                 = 22,
+    OpTypeVector                = 23,
+    OpTypeMatrix                = 24,
+    OpTypeImage                 = 25,
+    OpTypeSampler               = 26,
+    OpTypeSampledImage          = 27,
+    OpTypeArray                 = 28,
+    OpTypeRuntimeArray          = 29,
+    OpTypeStruct                = 30,
+    OpTypePointer               = 32,
+    OpConstantTrue              = 41,
+    OpConstantFalse             = 42,
+    OpConstant                  = 43,
+    OpConstantComposite         = 44,
+    OpSpecConstantTrue          = 48,
+    OpSpecConstantFalse         = 49,
+    OpSpecConstant              = 50,
+    OpSpecConstantComposite     = 51,
+    OpFunction                  = 54,
+    OpVariable                  = 59,
+    OpDecorate                  = 71,
+    OpMemberDecorate            = 72,
+    OpExecutionModeId           = 331
+};
+
+enum SpirvDecoration : uint32_t
+{
+    DecorationSpecId            = 1,
+    DecorationBlock             = 2,
+    DecorationBufferBlock       = 3,
+    DecorationArrayStride       = 6,
+    DecorationMatrixStride      = 7,
+    DecorationBuiltIn           = 11,
+    DecorationLocation          = 30,
+    DecorationBinding           = 33,
+    DecorationDescriptorSet     = 34,
+    DecorationOffset            = 35
+};
+
+enum SpirvStorageClass : uint32_t
+{
+    StorageClassUniformConstant = 0,
+    StorageClassInput           = 1,
+    StorageClassUniform         = 2,
+    StorageClassPushConstant    = 9,
+    StorageClassStorageBuffer   = 12
+};
+
+static constexpr uint32_t SPIRV_EXECUTION_MODE_LOCAL_SIZE           = 17;
+static constexpr uint32_t SPIRV_EXECUTION_MODE_LOCAL_SIZE_ID        = 38;
+static constexpr uint32_t SPIRV_BUILT_IN_WORKGROUP_SIZE             = 25;
+static constexpr uint32_t SPIRV_DIM_BUFFER                          = 5;
+static constexpr uint32_t SPIRV_DIM_SUBPASS_DATA                    = 6;
+
+/// <summary>
+/// Everything known about one result id of the module: the instruction defining it and its decorations.
+/// </summary>
+struct SpirvId
+{
+    uint32_t                            opcode                      = 0;
+    uint32_t                            typeId                      = 0;    // result type of constants and variables
+    std::vector<uint32_t>               operands                    = {};   // words following the result id
+    std::string                         name                        = {};
+
+    std::optional<uint32_t>             set                         = {};
+    std::optional<uint32_t>             binding                     = {};
+    std::optional<uint32_t>             location                    = {};
+    std::optional<uint32_t>             specId                      = {};
+    std::optional<uint32_t>             builtIn                     = {};
+    std::optional<uint32_t>             arrayStride                 = {};
+    bool                                block                       = false;
+    bool                                bufferBlock                 = false;
+    bool                                builtInMembers              = false;    // gl_PerVertex and the like
+    std::vector<uint32_t>               memberOffsets               = {};
+    std::vector<uint32_t>               memberMatrixStrides         = {};
+};
+
+class SpirvModule
+{
+public:
+    explicit                            SpirvModule(const std::vector<char>& code);
+
+    const SpirvId&                      get(uint32_t id)                                                                        const;
+    uint32_t                            getConstant(uint32_t id)                                                                const;
+    uint32_t                            getTypeSize(uint32_t typeId)                                                            const;
+
+    std::vector<SpirvId>                ids                         = {};
+    std::optional<uint32_t>             executionModel              = {};
+    uint32_t                            entryPointId                = 0;
+    std::string                         entryPoint                  = {};
+    std::array<uint32_t, 3>             localSize                   = { 1, 1, 1 };
+    std::array<uint32_t, 3>             localSizeIds                = { 0, 0, 0 };
+
+private:
+    SpirvId&                            getMutable(uint32_t id);
+    static std::string                  readString(const uint32_t* words, size_t wordCount);
+};
+
+SpirvModule::SpirvModule(const std::vector<char>& code)
+{
+    if(code.size() < SPIRV_HEADER_WORDS * sizeof(uint32_t) || code.size() % sizeof(uint32_t) != 0)
+    {
+        throw std::runtime_error("ShaderReflection: Code is not a SPIR-V module!");
+    }
+
+    std::vector<uint32_t> words(code.size() / sizeof(uint32_t));
+    std::memcpy(words.data(), code.data(), code.size());
+
+    if(words[0] != SPIRV_MAGIC)
+    {
+        throw std::runtime_error("ShaderReflection: Code is not a SPIR-V module!");
+    }
+    ids.resize(words[3]);
+
+    size_t offset = SPIRV_HEADER_WORDS;
+    while(offset < words.size())
+    {
+        const uint32_t* instruction = &words[offset];
+        const uint32_t wordCount = instruction[0] >> 16;
+        const uint32_t opcode = instruction[0] & 0xFFFF;
+
+        if(wordCount == 0 || offset + wordCount > words.size())
+        {
+            throw std::runtime_error("ShaderReflection: SPIR-V module is truncated!");
+        }
+
+        // Declarations and decorations all precede the first function.
+        if(opcode == OpFunction)
+        {
+            break;
+        }
+
+        switch(opcode)
+        {
+        case OpName:
+            getMutable(instruction[1]).name = readString(instruction + 2, wordCount - 2);
+            break;
+
+        case OpEntryPoint:
+            if(!executionModel.has_value())
+            {
+                executionModel = instruction[1];
+                entryPointId = instruction[2];
+                entryPoint = readString(instruction + 3, wordCount - 3);
+            }
+            break;
+
+        case OpExecutionMode:
+        case OpExecutionModeId:
+            if(instruction[1] == entryPointId && wordCount >= 6)
+            {
+                if(opcode == OpExecutionMode && instruction[2] == SPIRV_EXECUTION_MODE_LOCAL_SIZE)
+                {
+                    localSize = { instruction[3], instruction[4], instruction[5] };
+                }
+                else if(opcode == OpExecutionModeId && instruction[2] == SPIRV_EXECUTION_MODE_LOCAL_SIZE_ID)
+                {
+                    localSizeIds = { instruction[3], instruction[4], instruction[5] };
+                }
+            }
+            break;
+
+        case OpDecorate:
+        {
+            SpirvId& target = getMutable(instruction[1]);
+            const uint32_t literal = wordCount > 3 ? instruction[3] : 0;
+            switch(instruction[2])
+            {
+            case DecorationSpecId:          target.specId = literal;        break;
+            case DecorationBlock:           target.block = true;            break;
+            case DecorationBufferBlock:     target.bufferBlock = true;      break;
+            case DecorationArrayStride:     target.arrayStride = literal;   break;
+            case DecorationBuiltIn:         target.builtIn = literal;       break;
+            case DecorationLocation:        target.location = literal;      break;
+            case DecorationBinding:         target.binding = literal;       break;
+            case DecorationDescriptorSet:   target.set = literal;           break;
+            default:                                                        break;
+            }
+            break;
+        }
+
+        case OpMemberDecorate:
+        {
+            SpirvId& target = getMutable(instruction[1]);
+            const uint32_t member = instruction[2];
+            const uint32_t literal = wordCount > 4 ? instruction[4] : 0;
+            if(instruction[3] == DecorationOffset || instruction[3] == DecorationMatrixStride)
+            {
+                auto& values = instruction[3] == DecorationOffset ? target.memberOffsets : target.memberMatrixStrides;
+                if(values.size() <= member)
+                {
+                    values.resize(member + 1, 0);
+                }
+                values[member] = literal;
+            }
+            else if(instruction[3] == DecorationBuiltIn)
+            {
+                target.builtInMembers = true;
+            }
+            break;
+        }
+
+        case OpTypeBool:
+        case OpTypeInt:
+        case OpTypeFloat:
+        case OpTypeVector:
+        case OpTypeMatrix:
+        case OpTypeImage:
+        case OpTypeSampler:
+        case OpTypeSampledImage:
+        case OpTypeArray:
+        case OpTypeRuntimeArray:
+        case OpTypeStruct:
+        case OpTypePointer:
+        {
+            SpirvId& type = getMutable(instruction[1]);
+            type.opcode = opcode;
+            type.operands.assign(instruction + 2, instruction + wordCount);
+            break;
+        }
+
+        case OpConstantTrue:
+        case OpConstantFalse:
+        case OpConstant:
+        case OpConstantComposite:
+        case OpSpecConstantTrue:
+        case OpSpecConstantFalse:
+        case OpSpecConstant:
+        case OpSpecConstantComposite:
+        case OpVariable:
+        {
+            SpirvId& value = getMutable(instruction[2]);
+            value.opcode = opcode;
+            value.typeId = instruction[1];
+            value.operands.assign(instruction + 3, instruction + wordCount);
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        offset += wordCount;
+    }
+
+    if(!executionModel.has_value())
+    {
+        throw std::runtime_error("ShaderReflection: SPIR-V module has no entry point!");
+    }
+}
+
+const SpirvId& SpirvModule::get(uint32_t id) const
+{
+    if(id >= ids.size())
+    {
+        throw std::runtime_error("ShaderReflection: SPIR-V id " + std::to_string(id) + " is out of bounds!");
+    }
+
+    return ids[id];
+}
+
+SpirvId& SpirvModule::getMutable(uint32_t id)
+{
+    return const_cast<SpirvId&>(get(id));
+}
+
+uint32_t SpirvModule::getConstant(uint32_t id) const
+{
+    const SpirvId& constant = get(id);
+    if((constant.opcode != OpConstant && constant.opcode != OpSpecConstant) || constant.operands.empty())
+    {
+        throw std::runtime_error("ShaderReflection: SPIR-V id " + std::to_string(id) + " is not a scalar constant!");
+    }
+
+    // Values wider than 32 bits keep their low word first
+    return constant.operands[0];
+}
+
+/// <summary>
+/// Size in bytes of a type in a block, following the Offset, ArrayStride and MatrixStride decorations.
+/// Runtime arrays have no size.
+/// </summary>
+uint32_t SpirvModule::getTypeSize(uint32_t typeId) const
+{
+    const SpirvId& type = get(typeId);
+    switch(type.opcode)
+    {
+    case OpTypeBool:
+        return sizeof(VkBool32);
+
+    case OpTypeInt:
+    case OpTypeFloat:
+        return type.operands[0] / 8;
+
+    case OpTypeVector:
+        return getTypeSize(type.operands[0]) * type.operands[1];
+
+    case OpTypeMatrix:
+        return getTypeSize(type.operands[0]) * type.operands[1];
+
+    case OpTypeArray:
+        return getConstant(type.operands[1]) * type.arrayStride.value_or(getTypeSize(type.operands[0]));
+
+    case OpTypeRuntimeArray:
+        return 0;
+
+    case OpTypeStruct:
+    {
+        uint32_t size = 0;
+        for(size_t member = 0; member < type.operands.size(); ++member)
+        {
+            const SpirvId& memberType = get(type.operands[member]);
+            const uint32_t offset = member < type.memberOffsets.size() ? type.memberOffsets[member] : size;
+            const uint32_t matrixStride = member < type.memberMatrixStrides.size() ? type.memberMatrixStrides[member] : 0;
+
+            const uint32_t memberSize = memberType.opcode == OpTypeMatrix && matrixStride > 0 ? matrixStride * memberType.operands[1]
+                                                                                                : getTypeSize(type.operands[member]);
+            size = std::max(size, offset + memberSize);
+        }
+        return size;
+    }
+
+    default:
+        throw std::runtime_error("ShaderReflection: SPIR-V type " + std::to_string(typeId) + " has no size!");
+    }
+}
+
+std::string SpirvModule::readString(const uint32_t* words, size_t wordCount)
+{
+    const char* characters = reinterpret_cast<const char*>(words);
+    return std::string(characters, strnlen(characters, wordCount * sizeof(uint32_t)));
+}
+
+static std::optional<VkShaderStageFlagBits> getStage(uint32_t executionModel)
+{
+    switch(executionModel)
+    {
+    case 0:     return VK_SHADER_STAGE_VERTEX_BIT;
+    case 1:     return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+    case 2:     return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+    case 3:     return VK_SHADER_STAGE_GEOMETRY_BIT;
+    case 4:     return VK_SHADER_STAGE_FRAGMENT_BIT;
+    case 5:     return VK_SHADER_STAGE_COMPUTE_BIT;
+    case 5364:  return VK_SHADER_STAGE_TASK_BIT_EXT;
+    case 5365:  return VK_SHADER_STAGE_MESH_BIT_EXT;
+    default:    return std::nullopt;
+    }
+}
+
+static VkDescriptorType getDescriptorType(const SpirvId& type, const SpirvId& variable, uint32_t storageClass)
+{
+    if(storageClass == StorageClassStorageBuffer || (storageClass == StorageClassUniform && type.bufferBlock))
+    {
+        return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    }
+    if(storageClass == StorageClassUniform)
+    {
+        return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    }
+
+    switch(type.opcode)
+    {
+    case OpTypeSampler:
+        return VK_DESCRIPTOR_TYPE_SAMPLER;
+
+    case OpTypeSampledImage:
+        return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+    case OpTypeImage:
+    {
+        // Operands: sampled type, dim, depth, arrayed, multisampled, sampled (1 with a sampler, 2 for storage), format
+        const uint32_t dim = type.operands[1];
+        const bool storage = type.operands[5] == 2;
+
+        if(dim == SPIRV_DIM_SUBPASS_DATA)
+        {
+            return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        }
+        if(dim == SPIRV_DIM_BUFFER)
+        {
+            return storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+        }
+        return storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    }
+
+    default:
+        throw std::runtime_error("ShaderReflection: Descriptor " + variable.name + " has an unsupported type!");
+    }
+}
+
+static VkFormat getVertexInputFormat(const SpirvModule& module, const SpirvId& type, const std::string& name)
+{
+    // 32 bit scalars and vectors, one row per component type
+    static constexpr VkFormat FORMATS[3][4] =
+    {
+        { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT },
+        { VK_FORMAT_R32_SINT,   VK_FORMAT_R32G32_SINT,   VK_FORMAT_R32G32B32_SINT,   VK_FORMAT_R32G32B32A32_SINT },
+        { VK_FORMAT_R32_UINT,   VK_FORMAT_R32G32_UINT,   VK_FORMAT_R32G32B32_UINT,   VK_FORMAT_R32G32B32A32_UINT }
+    };
+
+    const bool vector = type.opcode == OpTypeVector;
+    const SpirvId& component = vector ? module.get(type.operands[0]) : type;
+    const uint32_t componentCount = vector ? type.operands[1] : 1;
+
+    if((component.opcode != OpTypeFloat && component.opcode != OpTypeInt) || component.operands[0] != 32 || componentCount > 4)
+    {
+        throw std::runtime_error("ShaderReflection: Vertex input " + name + " has an unsupported type!");
+    }
+
+    const size_t row = component.opcode == OpTypeFloat ? 0 : (component.operands[1] != 0 ? 1 : 2);
+    return FORMATS[row][componentCount - 1];
+}
+
+ShaderReflection ShaderReflection::reflect(const std::vector<char>& code)
+{
+    const SpirvModule module(code);
+
+    ShaderReflection reflection = {};
+    const auto stage = getStage(module.executionModel.value());
+    if(!stage.has_value())
+    {
+        throw std::runtime_error("ShaderReflection: Execution model " + std::to_string(module.executionModel.value()) + " is not supported!");
+    }
+    reflection.stage = stage.value();
+    reflection.entryPoint = module.entryPoint;
+
+    for(const SpirvId& variable : module.ids)
+    {
+        if(variable.opcode != OpVariable)
+        {
+            continue;
+        }
+
+        const SpirvId& pointer = module.get(variable.typeId);
+        const uint32_t storageClass = variable.operands[0];
+        const SpirvId& pointee = module.get(pointer.operands[1]);
+
+        switch(storageClass)
+        {
+        case StorageClassUniformConstant:
+        case StorageClassUniform:
+        case StorageClassStorageBuffer:
+        {
+            if(!variable.binding.has_value())
+            {
+                break;
+            }
+
+            // Arrays of descriptors, the element type decides the descriptor type
+            const SpirvId* type = &pointee;
+            uint32_t descriptorCount = 1;
+            while(type->opcode == OpTypeArray || type->opcode == OpTypeRuntimeArray)
+            {
+                if(type->opcode == OpTypeRuntimeArray)
+                {
+                    throw std::runtime_error("ShaderReflection: Descriptor " + variable.name + " is a runtime array, which needs descriptor indexing!");
+                }
+                descriptorCount *= module.getConstant(type->operands[1]);
+                type = &module.get(type->operands[0]);
+            }
+
+            ShaderDescriptorBinding binding = {};
+            binding.set = variable.set.value_or(0);
+            binding.binding = variable.binding.value();
+            binding.descriptorType = getDescriptorType(*type, variable, storageClass);
+            binding.descriptorCount = descriptorCount;
+            binding.stageFlags = reflection.stage;
+            binding.name = !variable.name.empty() ? variable.name : type->name;
+            reflection.descriptorBindings.push_back(binding);
+            break;
+        }
+
+        case StorageClassPushConstant:
+        {
+            const auto& offsets = pointee.memberOffsets;
+            reflection.pushConstantOffset = offsets.empty() ? 0 : *std::min_element(offsets.begin(), offsets.end());
+            reflection.pushConstantSize = module.getTypeSize(pointer.operands[1]) - reflection.pushConstantOffset;
+            break;
+        }
+
+        case StorageClassInput:
+        {
+            if(reflection.stage != VK_SHADER_STAGE_VERTEX_BIT || variable.builtIn.has_value() || pointee.builtInMembers)
+            {
+                break;
+            }
+            if(!variable.location.has_value())
+            {
+                throw std::runtime_error("ShaderReflection: Vertex input " + variable.name + " has no location!");
+            }
+
+            ShaderVertexInput input = {};
+            input.location = variable.location.value();
+            input.format = getVertexInputFormat(module, pointee, variable.name);
+            input.size = module.getTypeSize(pointer.operands[1]);
+            input.name = variable.name;
+            reflection.vertexInputs.push_back(input);
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+
+    // The WorkgroupSize built-in overrides the execution mode, glslang emits it for local_size_*_id.
+    bool workgroupSizeBuiltIn = false;
+    for(const SpirvId& constant : module.ids)
+    {
+        if(constant.specId.has_value())
+        {
+            reflection.specializationConstants.push_back({ constant.specId.value(), module.getTypeSize(constant.typeId), constant.name });
+        }
+
+        if(constant.builtIn == SPIRV_BUILT_IN_WORKGROUP_SIZE && constant.operands.size() == 3)
+        {
+            for(size_t axis = 0; axis < 3; ++axis)
+            {
+                reflection.workgroupSize[axis] = module.getConstant(constant.operands[axis]);
+            }
+            workgroupSizeBuiltIn = true;
+        }
+    }
+
+    if(reflection.stage == VK_SHADER_STAGE_COMPUTE_BIT && !workgroupSizeBuiltIn)
+    {
+        for(size_t axis = 0; axis < 3; ++axis)
+        {
+            reflection.workgroupSize[axis] = module.localSizeIds[axis] != 0 ? module.getConstant(module.localSizeIds[axis]) : module.localSize[axis];
+        }
+    }
+
+    std::sort(reflection.descriptorBindings.begin(), reflection.descriptorBindings.end(), [](const auto& a, const auto& b)
+    {
+        return std::tie(a.set, a.binding) < std::tie(b.set, b.binding);
+    });
+    std::sort(reflection.vertexInputs.begin(), reflection.vertexInputs.end(), [](const auto& a, const auto& b) { return a.location < b.location; });
+    std::sort(reflection.specializationConstants.begin(), reflection.specializationConstants.end(),
+              [](const auto& a, const auto& b) { return a.constantId < b.constantId; });
+
+    // Vertex inputs are read interleaved from binding 0, in location order.
+    if(!reflection.vertexInputs.empty())
+    {
+        uint32_t stride = 0;
+        for(const auto& input : reflection.vertexInputs)
+        {
+            reflection.vertexInputLayout.attributes.push_back({ input.location, 0, input.format, stride });
+            stride += input.size;
+        }
+        reflection.vertexInputLayout.bindings.push_back({ 0, stride, VK_VERTEX_INPUT_RATE_VERTEX });
+    }
+
+    return reflection;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+struct ShaderDescriptorBinding
+{
+    uint32_t                            set                         = 0;
+    uint32_t                            binding                     = 0;
+    VkDescriptorType                    descriptorType              = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+    uint32_t                            descriptorCount             = 1;
+    VkShaderStageFlags                  stageFlags                  = 0;
+    std::string                         name                        = {};
+};
+
+struct ShaderVertexInput
+{
+    uint32_t                            location                    = 0;
+    VkFormat                            format                      = VK_FORMAT_UNDEFINED;
+    uint32_t                            size                        = 0;
+    std::string                         name                        = {};
+};
+
+struct ShaderSpecializationConstant
+{
+    uint32_t                            constantId                  = 0;
+    uint32_t                            size                        = 0;    // bytes of the VkSpecializationMapEntry, booleans are VkBool32
+    std::string                         name                        = {};
+};
+
+struct VertexInputLayout
+{
+    std::vector<VkVertexInputBindingDescription>   bindings         = {};
+    std::vector<VkVertexInputAttributeDescription> attributes       = {};
+};
+
+/// <summary>
+/// Interface of a shader stage, read from its SPIR-V binary.
+///
+/// reflect() walks the declarations of the module (everything before the first function) and collects what
+/// pipeline creation needs to know about the stage, so layouts and vertex input are derived from the shaders
+/// instead of being written by hand next to them:
+///
+///     descriptor bindings         - uniform and storage buffers, images, samplers and texel buffers
+///     push constants              - the byte range of the push constant block
+///     vertex inputs               - location and format of every non built-in input of a vertex shader, packed
+///                                   into one interleaved binding by vertexInputLayout
+///     workgroup size              - LocalSize, LocalSizeId or the WorkgroupSize built-in of a compute shader
+///     specialization constants    - the SpecId of every specialization constant
+///
+/// Only the first entry point of a module is reflected.
+/// </summary>
+struct ShaderReflection
+{
+    VkShaderStageFlagBits               stage                       = VK_SHADER_STAGE_VERTEX_BIT;
+    std::string                         entryPoint                  = {};
+    std::vector<ShaderDescriptorBinding> descriptorBindings         = {};   // sorted by set and binding
+    uint32_t                            pushConstantOffset          = 0;
+    uint32_t                            pushConstantSize            = 0;    // 0 without push constants
+    std::vector<ShaderVertexInput>      vertexInputs                = {};   // sorted by location
+    VertexInputLayout                   vertexInputLayout           = {};
+    std::array<uint32_t, 3>             workgroupSize               = { 1, 1, 1 };
+    std::vector<ShaderSpecializationConstant> specializationConstants = {};
+
+    static ShaderReflection             reflect(const std::vector<char>& code);
+};
@@ -0,0 +1,18 @@
+// Push constants of the batch kernels, matches ImageBatchProcessor::PushConstants
+layout(push_constant) uniform Constants {
+    uvec2 inputExtent;
+    uvec2 outputExtent;
+    float exposure;
+    float sharpness;        // weight of the neighbours subtracted by the sharpening
+} constants;
+
+// Matches ImageBatchProcessor::GROUP_SIZE
+#define GROUP_SIZE 8
+
+bool isOutside(uvec2 pixel) {
+    return any(greaterThanEqual(pixel, constants.outputExtent));
+}
+
+uint getOutputIndex(uvec2 pixel) {
+    return pixel.y * constants.outputExtent.x + pixel.x;
+}
@@ -1,3 +1,20 @@
-C:/VulkanSDK/1.2.154.1/Bin32/glslc.exe shader.vert -o vert.spv
-C:/VulkanSDK/1.2.154.1/Bin32/glslc.exe shader.frag -o frag.spv
+set GLSLC=glslc
+if defined VULKAN_SDK set GLSLC="%VULKAN_SDK%/Bin/glslc.exe"
+%GLSLC% shader.vert -o shader.vert.spv
+%GLSLC% shader.frag -o shader.frag.spv
+%GLSLC% mesh.vert -o mesh.vert.spv
+%GLSLC% meshlet_cull.comp -o meshlet_cull.comp.spv
+rem Vulkan 1.2 targets SPIR-V 1.5, which the mesh shaders need, the other shaders stay loadable on Vulkan 1.0
+%GLSLC% --target-env=vulkan1.2 meshlet.task -o meshlet.task.spv
+%GLSLC% --target-env=vulkan1.2 meshlet.mesh -o meshlet.mesh.spv
+%GLSLC% lod.vert -o lod.vert.spv
+%GLSLC% lod_select.comp -o lod_select.comp.spv
+%GLSLC% sorted_draw.vert -o sorted_draw.vert.spv
+%GLSLC% particle.vert -o particle.vert.spv
+%GLSLC% particle_emit.comp -o particle_emit.comp.spv
+%GLSLC% particle_prepare.comp -o particle_prepare.comp.spv
+%GLSLC% particle_simulate.comp -o particle_simulate.comp.spv
+%GLSLC% batch_resize.comp -o batch_resize.comp.spv
+%GLSLC% batch_sharpen.comp -o batch_sharpen.comp.spv
+%GLSLC% batch_tonemap.comp -o batch_tonemap.comp.spv
 pause
\ No newline at end of file
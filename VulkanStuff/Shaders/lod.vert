@@ -0,0 +1,26 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+#include "lod_constants.glsl"
+
+// Every MeshVertex attribute is declared, so the reflected vertex layout has the stride of MeshVertex
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec2 texCoord;
+
+// World matrix of every scene node, the objects' follow each other from firstObjectTransform
+layout(std430, set = 0, binding = 0) readonly buffer Transforms {
+    mat4 transforms[];
+};
+
+// Object indices, objectCount per level; the draw of a level starts at its first instance
+layout(std430, set = 0, binding = 1) readonly buffer Instances {
+    uint instances[];
+};
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    mat4 world = transforms[constants.firstObjectTransform + instances[gl_InstanceIndex]];
+    gl_Position = constants.viewProjection * world * vec4(position, 1.0);
+    fragColor = normalize(mat3(world) * normal) * 0.5 + 0.5;
+}
@@ -0,0 +1,13 @@
+// Push constants of the level of detail shaders, matches LodRenderer::PushConstants
+layout(push_constant) uniform Constants {
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 meshSphere;        // bounding sphere of the mesh in object space
+    uint objectCount;
+    uint levelCount;
+    float projectionScale;  // pixels per unit of object space at a distance of one unit
+    float pixelError;
+    float coarsenError;     // stricter budget for switching to a coarser level
+    uint firstObjectTransform;  // world matrix of object 0 in the transform buffer
+    uint reserved[2];
+} constants;
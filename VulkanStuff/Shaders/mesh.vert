@@ -0,0 +1,15 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+#include "meshlet_constants.glsl"
+
+// Every MeshVertex attribute is declared, so the reflected vertex layout has the stride of MeshVertex
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec2 texCoord;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    gl_Position = constants.viewProjection * vec4(position, 1.0);
+    fragColor = normal * 0.5 + 0.5;
+}
@@ -0,0 +1,44 @@
+// Meshlets, mesh data and culling shared by meshlet.task, meshlet.mesh and meshlet_cull.comp
+#include "meshlet_constants.glsl"
+
+// Matches Meshlet of AssetDecoder.h
+struct Meshlet {
+    uint vertexOffset;
+    uint triangleOffset;
+    uint vertexCount;
+    uint triangleCount;
+    vec4 sphere;    // center and radius
+    vec4 cone;      // axis and cutoff
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Meshlets {
+    Meshlet meshlets[];
+};
+
+// The asset data as words: vertices of 8 words, indices, meshlet vertices and meshlet triangle bytes
+layout(std430, set = 0, binding = 1) readonly buffer MeshData {
+    uint meshData[];
+};
+
+layout(std430, set = 0, binding = 3) buffer Statistics {
+    uint visibleMeshlets;
+    uint visibleTriangles;
+} statistics;
+
+bool isMeshletVisible(Meshlet meshlet) {
+    vec3 center = meshlet.sphere.xyz;
+    float radius = meshlet.sphere.w;
+
+    // Frustum planes from the rows of the view projection matrix, depth is 0..1
+    mat4 m = transpose(constants.viewProjection);
+    vec4 planes[5] = vec4[](m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1], m[3] - m[2]);
+    for(int i = 0; i < 5; ++i) {
+        if(dot(planes[i].xyz, center) + planes[i].w < -radius * length(planes[i].xyz)) {
+            return false;
+        }
+    }
+
+    // Every triangle faces away when the camera is inside the cone behind the meshlet
+    vec3 offset = center - constants.cameraPosition.xyz;
+    return dot(offset, meshlet.cone.xyz) < meshlet.cone.w * length(offset) + radius;
+}
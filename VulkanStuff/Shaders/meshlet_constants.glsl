@@ -0,0 +1,9 @@
+// Push constants of the meshlet shaders, matches MeshletRenderer::PushConstants
+layout(push_constant) uniform Constants {
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    uint meshletCount;
+    uint meshletVertexOffset;   // words into meshData
+    uint meshletTriangleOffset; // bytes into meshData
+    uint reserved;
+} constants;
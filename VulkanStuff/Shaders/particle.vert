@@ -0,0 +1,29 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+#include "particle_constants.glsl"
+
+layout(std430, set = 0, binding = 0) readonly buffer Particles {
+    Particle particles[];
+};
+
+layout(std430, set = 0, binding = 2) readonly buffer AliveLists {
+    uint alive[];
+};
+
+layout(location = 0) out vec3 fragColor;
+
+// Two triangles of a quad facing the camera
+const vec2 CORNERS[6] = vec2[](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+void main() {
+    // The draw covers the list the simulation wrote this frame
+    uint outputList = 1 - constants.inputList;
+    Particle particle = particles[alive[outputList * constants.capacity + gl_InstanceIndex]];
+
+    gl_Position = constants.viewProjection * vec4(particle.positionLife.xyz, 1.0);
+    gl_Position.xy += CORNERS[gl_VertexIndex] * constants.spriteScale;
+
+    // White hot when emitted, cooling to red as the particle ages
+    float age = 1.0 - particle.positionLife.w / particle.velocityLifetime.w;
+    fragColor = mix(vec3(1.0, 0.9, 0.6), vec3(0.8, 0.1, 0.0), age);
+}
@@ -0,0 +1,34 @@
+// Push constants of the particle shaders, matches ParticleSystem::PushConstants
+layout(push_constant) uniform Constants {
+    mat4 viewProjection;
+    vec2 spriteScale;       // half extent of a particle in clip space at w = 1
+    uint capacity;
+    uint emitCount;
+    uint inputList;         // alive list read this frame, the other one is written
+    uint frameNumber;
+    float timeStep;         // seconds
+    uint reserved;
+} constants;
+
+struct Particle {
+    vec4 positionLife;      // xyz position, w remaining life in seconds
+    vec4 velocityLifetime;  // xyz velocity, w lifetime in seconds
+};
+
+// Matches VkDrawIndirectCommand
+struct DrawCommand {
+    uint vertexCount;
+    uint instanceCount;
+    uint firstVertex;
+    uint firstInstance;
+};
+
+// Matches ParticleSystem::State; instanceCount of a draw is the size of its alive list
+#define PARTICLE_STATE_MEMBERS \
+    DrawCommand draws[2]; \
+    uint dispatchX; \
+    uint dispatchY; \
+    uint dispatchZ; \
+    uint reserved; \
+    int freeCount; \
+    uint nextUnused;
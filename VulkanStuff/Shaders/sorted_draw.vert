@@ -0,0 +1,21 @@
+#version 450
+
+layout(location = 0) in vec2 position;
+
+// Position xy, size and depth of every object, its draw starts at the object's index as first instance
+layout(std430, set = 0, binding = 0) readonly buffer Objects {
+    vec4 objects[];
+};
+
+// Bound per material by the draw queue
+layout(std430, set = 1, binding = 0) readonly buffer Material {
+    vec4 color;
+};
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    vec4 object = objects[gl_InstanceIndex];
+    gl_Position = vec4(object.xy + position * object.z, object.w, 1.0);
+    fragColor = color.rgb;
+}
@@ -0,0 +1,265 @@
+#include "pch.h"
+#include "SortedDrawRenderer.h"
+
+// Descriptor sets and bindings declared by Shaders/sorted_draw.vert
+static constexpr uint32_t SET_OBJECTS               = 0;
+static constexpr uint32_t BINDING_OBJECTS           = 0;
+static constexpr uint32_t BINDING_MATERIAL          = 0;
+
+static constexpr uint32_t OBJECT_COMPONENTS         = 4;    // position xy, size, depth
+static constexpr uint32_t OBJECT_SEED               = 47;
+
+static_assert(DrawQueue::MATERIAL_SET != SET_OBJECTS, "SortedDrawRenderer: Objects and materials need their own descriptor sets!");
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+SortedDrawRenderer::SortedDrawRenderer(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                                       uint32_t slotCount, MemoryBudgetMonitor* budgetMonitor, PipelineLayoutCache& layoutCache,
+                                       JobSystem& jobSystem, uint32_t objectCount, bool sortEnabled, const std::vector<std::vector<char>>& drawStages,
+                                       const GraphicsPipelineFactory& graphicsPipelineFactory)
+    : vkDevice(device)
+    , capabilities(capabilities)
+    , resources(device, capabilities, allocator, budgetMonitor, "SortedDrawRenderer")
+    , jobSystem(jobSystem)
+    , sortEnabled(sortEnabled)
+    , slots(slotCount)
+{
+    // All variants share the stages and therefore the layout the cache returns for them
+    layout = &resources.getPipelineLayout(drawStages, layoutCache);
+
+    if(layout->setBindings.size() != DrawQueue::MATERIAL_SET + 1)
+    {
+        throw std::runtime_error("SortedDrawRenderer: Shaders have to use the object and the material descriptor set!");
+    }
+
+    for(uint32_t variant = 0; variant < PIPELINE_COUNT; ++variant)
+    {
+        pipelines.push_back(graphicsPipelineFactory(variant, drawStages));
+        queue.addPipeline({ pipelines.back(), layout->pipelineLayout });
+    }
+
+    createMeshes();
+    createObjects(std::max(objectCount, 1u));
+
+    for(Slot& slot : slots)
+    {
+        // Written once per frame by the CPU and read once by the vertex shader
+        resources.allocateBuffer(slot.objects, objects.size() * OBJECT_COMPONENTS * sizeof(float), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+        void* mapped = nullptr;
+        resources.mapBuffer(slot.objects, &mapped);
+        slot.mappedObjects = static_cast<float*>(mapped);
+    }
+
+    createDescriptorSets();
+}
+
+SortedDrawRenderer::~SortedDrawRenderer()
+{
+    descriptorPool.reset();
+
+    for(Slot& slot : slots)
+    {
+        resources.releaseBuffer(slot.objects);
+    }
+    resources.releaseBuffer(materialBuffer);
+    resources.releaseBuffer(meshBuffer);
+}
+
+/// <summary>
+/// Builds MESH_COUNT regular polygons of 3 to MESH_COUNT + 2 corners as triangle fans around their center, each with
+/// its own vertex and index range in one buffer, so every mesh change rebinds both buffers. The buffer is small and
+/// only written once, it stays in host visible memory.
+/// </summary>
+void SortedDrawRenderer::createMeshes()
+{
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<std::pair<uint32_t, uint32_t>> firsts;    // first vertex and first index of every mesh
+
+    for(uint32_t mesh = 0; mesh < MESH_COUNT; ++mesh)
+    {
+        const uint32_t corners = mesh + 3;
+        firsts.emplace_back(static_cast<uint32_t>(vertices.size() / 2), static_cast<uint32_t>(indices.size()));
+
+        vertices.push_back(0.0f);
+        vertices.push_back(0.0f);
+        for(uint32_t corner = 0; corner < corners; ++corner)
+        {
+            const float angle = 2.0f * 3.14159265f * static_cast<float>(corner) / static_cast<float>(corners);
+            vertices.push_back(std::cos(angle));
+            vertices.push_back(std::sin(angle));
+
+            indices.push_back(0);
+            indices.push_back(corner + 1);
+            indices.push_back((corner + 1) % corners + 1);
+        }
+    }
+
+    const VkDeviceSize verticesSize = vertices.size() * sizeof(float);
+    const VkDeviceSize indicesOffset = alignUp(verticesSize, sizeof(uint32_t));
+    resources.allocateBuffer(meshBuffer, indicesOffset + indices.size() * sizeof(uint32_t), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    void* mapped = nullptr;
+    resources.mapBuffer(meshBuffer, &mapped);
+    std::memcpy(mapped, vertices.data(), static_cast<size_t>(verticesSize));
+    std::memcpy(static_cast<uint8_t*>(mapped) + indicesOffset, indices.data(), indices.size() * sizeof(uint32_t));
+    vkUnmapMemory(vkDevice, meshBuffer.memory);
+
+    for(uint32_t mesh = 0; mesh < MESH_COUNT; ++mesh)
+    {
+        MeshRange range = {};
+        range.vertexOffset = firsts[mesh].first * 2 * sizeof(float);
+        range.indexOffset = indicesOffset + firsts[mesh].second * sizeof(uint32_t);
+        range.indexCount = (mesh + 3) * 3;
+        meshRanges.push_back(range);
+
+        queue.addMesh({ meshBuffer.buffer, range.vertexOffset, meshBuffer.buffer, range.indexOffset, VK_INDEX_TYPE_UINT32 });
+    }
+}
+
+/// <summary>
+/// Places the objects at random in normalized device coordinates with a random state and depth. The generator is
+/// seeded, every run submits the same objects in the same order.
+/// </summary>
+void SortedDrawRenderer::createObjects(uint32_t objectCount)
+{
+    std::mt19937 random(OBJECT_SEED);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    // Objects cover about the screen twice over whatever their number
+    const float baseSize = std::sqrt(2.0f / static_cast<float>(objectCount));
+
+    objects.resize(objectCount);
+    for(Object& object : objects)
+    {
+        object.position[0] = unit(random) * 2.0f - 1.0f;
+        object.position[1] = unit(random) * 2.0f - 1.0f;
+        object.size = baseSize * (0.5f + unit(random));
+        object.depth = unit(random);
+        object.depthSpeed = (unit(random) - 0.5f) * 0.01f;
+        object.pipeline = static_cast<uint32_t>(random() % PIPELINE_COUNT);
+        object.material = static_cast<uint32_t>(random() % MATERIAL_COUNT);
+        object.mesh = static_cast<uint32_t>(random() % MESH_COUNT);
+    }
+}
+
+void SortedDrawRenderer::createDescriptorSets()
+{
+    const uint32_t setCount = static_cast<uint32_t>(slots.size()) + MATERIAL_COUNT;
+    descriptorPool = resources.createDescriptorPool(setCount, setCount);
+
+    for(Slot& slot : slots)
+    {
+        slot.descriptorSet = allocateDescriptorSet(SET_OBJECTS, slot.objects.buffer, 0, VK_WHOLE_SIZE);
+    }
+
+    // Colors spread over the hue circle, the material index picks one
+    const VkDeviceSize stride = alignUp(4 * sizeof(float), capabilities.properties.limits.minStorageBufferOffsetAlignment);
+    resources.allocateBuffer(materialBuffer, stride * MATERIAL_COUNT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    void* mapped = nullptr;
+    resources.mapBuffer(materialBuffer, &mapped);
+    for(uint32_t material = 0; material < MATERIAL_COUNT; ++material)
+    {
+        const float hue = 2.0f * 3.14159265f * static_cast<float>(material) / static_cast<float>(MATERIAL_COUNT);
+        const float color[4] =
+        {
+            0.5f + 0.5f * std::cos(hue),
+            0.5f + 0.5f * std::cos(hue - 2.0943951f),
+            0.5f + 0.5f * std::cos(hue + 2.0943951f),
+            1.0f
+        };
+        std::memcpy(static_cast<uint8_t*>(mapped) + material * stride, color, sizeof(color));
+
+        queue.addMaterial(allocateDescriptorSet(DrawQueue::MATERIAL_SET, materialBuffer.buffer, material * stride, sizeof(color)));
+    }
+    vkUnmapMemory(vkDevice, materialBuffer.memory);
+}
+
+/// <summary>
+/// Allocates a descriptor set of the given set number and points its only binding at the buffer range.
+/// </summary>
+VkDescriptorSet SortedDrawRenderer::allocateDescriptorSet(uint32_t set, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    const std::vector<VkDescriptorSetLayoutBinding>& bindings = layout->setBindings[set];
+    const uint32_t expectedBinding = set == SET_OBJECTS ? BINDING_OBJECTS : BINDING_MATERIAL;
+    if(bindings.size() != 1 || bindings[0].binding != expectedBinding || bindings[0].descriptorType != VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+       || bindings[0].descriptorCount != 1)
+    {
+        throw std::runtime_error("SortedDrawRenderer: Set " + std::to_string(set) + " has to be a single storage buffer at binding "
+                                 + std::to_string(expectedBinding) + "!");
+    }
+
+    return resources.allocateDescriptorSet(descriptorPool, *layout, set, [=](uint32_t) -> VkDescriptorBufferInfo
+    {
+        return { buffer, offset, range };
+    });
+}
+
+/// <summary>
+/// CPU side work of the frame, called after the fence of the slot was waited for: moves the objects in depth,
+/// writes their data for the vertex shader and fills the queue, then sorts it on the workers unless sorting is
+/// disabled.
+/// </summary>
+void SortedDrawRenderer::update(uint32_t slotIndex, uint64_t frameNumber)
+{
+    Slot& slot = slots[slotIndex];
+
+    queue.clear();
+    for(uint32_t i = 0; i < objects.size(); ++i)
+    {
+        const Object& object = objects[i];
+
+        float depth = object.depth + object.depthSpeed * static_cast<float>(frameNumber % 100000);
+        depth -= std::floor(depth);
+
+        float* data = slot.mappedObjects + i * OBJECT_COMPONENTS;
+        data[0] = object.position[0];
+        data[1] = object.position[1];
+        data[2] = object.size;
+        data[3] = depth;
+
+        // Opaque objects front to back, blended ones after them back to front
+        const bool blended = object.pipeline >= PIPELINE_COUNT / 2;
+        const uint64_t key = DrawQueue::makeKey(blended ? 1 : 0, object.pipeline, object.material, object.mesh, blended ? 1.0f - depth : depth);
+
+        DrawQueue::Packet packet = {};
+        packet.indexCount = meshRanges[object.mesh].indexCount;
+        packet.firstInstance = i;
+        queue.submit(key, packet);
+    }
+
+    if(sortEnabled)
+    {
+        queue.sort(&jobSystem);
+    }
+}
+
+/// <summary>
+/// Records the queue inside the render pass, returns the number of draw calls.
+/// </summary>
+uint32_t SortedDrawRenderer::recordDraws(VkCommandBuffer commandBuffer, uint32_t slotIndex)
+{
+    // The object set stays bound across the pipeline binds of the queue, all pipelines share the layout
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout->pipelineLayout, SET_OBJECTS, 1, &slots[slotIndex].descriptorSet, 0, nullptr);
+
+    return queue.record(commandBuffer);
+}
+
+bool SortedDrawRenderer::isSortEnabled() const
+{
+    return sortEnabled;
+}
+
+void SortedDrawRenderer::printStatistics(std::ostream& stream) const
+{
+    stream << "SortedDrawRenderer: " << objects.size() << " objects, sorting " << (sortEnabled ? "on" : "off") << "\n";
+    queue.printStatistics(stream);
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "DrawQueue.h"
+#include "GpuResources.h"
+
+/// <summary>
+/// Draws many small objects with one draw call each through a DrawQueue, every object with its own combination of
+/// pipeline, material and mesh, to measure what sorting the draws by state saves over submitting them as they come.
+///
+/// The objects are submitted in creation order, which is random with respect to their state. The opaque pipelines
+/// are drawn first and front to back, the blended ones after them and back to front; depths change every frame, so
+/// the order within a state group does too. Materials are descriptor sets of set 1, each pointing at the color of the
+/// material in one storage buffer. Set 0 holds the per frame object data: position, size and depth of every object,
+/// looked up by the vertex shader through gl_InstanceIndex, which is the firstInstance of the object's draw.
+///
+/// Every frame in flight owns its object data. The queue is sorted on the workers of the job system. With sorting
+/// disabled it records in submission order, the bind counts of both orders are reported either way.
+/// </summary>
+class SortedDrawRenderer
+{
+public:
+    using GraphicsPipelineFactory = std::function<UniquePipeline(uint32_t variant, const std::vector<std::vector<char>>& stageCode)>;
+
+    static constexpr uint32_t           PIPELINE_COUNT              = 8;    // the second half blends
+    static constexpr uint32_t           MATERIAL_COUNT              = 64;
+    static constexpr uint32_t           MESH_COUNT                  = 16;
+
+                                        SortedDrawRenderer(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                                                           uint32_t slotCount, MemoryBudgetMonitor* budgetMonitor, PipelineLayoutCache& layoutCache,
+                                                           JobSystem& jobSystem, uint32_t objectCount, bool sortEnabled, const std::vector<std::vector<char>>& drawStages,
+                                                           const GraphicsPipelineFactory& graphicsPipelineFactory);
+                                        ~SortedDrawRenderer();
+
+                                        SortedDrawRenderer(const SortedDrawRenderer&) = delete;
+    SortedDrawRenderer&                 operator=(const SortedDrawRenderer&) = delete;
+
+    void                                update(uint32_t slot, uint64_t frameNumber);
+    uint32_t                            recordDraws(VkCommandBuffer commandBuffer, uint32_t slot);
+
+    bool                                isSortEnabled()                                                                         const;
+    void                                printStatistics(std::ostream& stream)                                                   const;
+
+private:
+    struct Object
+    {
+        float                           position[2]                 = {};
+        float                           size                        = 0.0f;
+        float                           depth                       = 0.0f;     // at frame 0
+        float                           depthSpeed                  = 0.0f;     // per frame, wraps around
+        uint32_t                        pipeline                    = 0;
+        uint32_t                        material                    = 0;
+        uint32_t                        mesh                        = 0;
+    };
+
+    struct MeshRange
+    {
+        VkDeviceSize                    vertexOffset                = 0;
+        VkDeviceSize                    indexOffset                 = 0;
+        uint32_t                        indexCount                  = 0;
+    };
+
+    struct Slot
+    {
+        BufferAllocation                objects                     = {};   // vec4 of position, size and depth per object
+        float*                          mappedObjects               = nullptr;
+        VkDescriptorSet                 descriptorSet               = VK_NULL_HANDLE;
+    };
+
+    VkDevice                            vkDevice;
+    const PhysicalDeviceCapabilities&   capabilities;
+    const GpuResources                  resources;
+    JobSystem&                          jobSystem;
+    const bool                          sortEnabled;
+
+    std::vector<Object>                 objects                     = {};   // in submission order
+    std::vector<MeshRange>              meshRanges                  = {};
+    BufferAllocation                    meshBuffer                  = {};   // vertices and indices of every mesh
+    BufferAllocation                    materialBuffer              = {};   // one color per material, at the storage buffer offset alignment
+
+    std::vector<UniquePipeline>         pipelines                   = {};
+    const PipelineLayoutInfo*           layout                      = nullptr;
+    UniqueDescriptorPool                descriptorPool              = {};
+    std::vector<Slot>                   slots;
+    DrawQueue                           queue                       = {};
+
+    void                                createObjects(uint32_t objectCount);
+    void                                createMeshes();
+    void                                createDescriptorSets();
+    VkDescriptorSet                     allocateDescriptorSet(uint32_t set, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+};
@@ -0,0 +1,91 @@
+#include "pch.h"
+#include "StagingRing.h"
+
+StagingRing::StagingRing(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                         MemoryBudgetMonitor* budgetMonitor, VkDeviceSize capacity)
+    : resources(device, capabilities, allocator, budgetMonitor, "StagingRing")
+    , capacity(capacity)
+{
+    // Host writes are sequential memcpys, write combined memory is fine and coherent memory needs no flush.
+    resources.allocateBuffer(buffer, capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    void* mappedMemory = nullptr;
+    resources.mapBuffer(buffer, &mappedMemory);
+    mapped = static_cast<uint8_t*>(mappedMemory);
+}
+
+StagingRing::~StagingRing()
+{
+    resources.releaseBuffer(buffer);
+}
+
+/// <summary>
+/// Returns the offset of size bytes in the buffer, or no value when the ring is full until more frames complete.
+/// </summary>
+std::optional<VkDeviceSize> StagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+    if(size == 0 || size > capacity)
+    {
+        return std::nullopt;
+    }
+
+    uint64_t offset = (head + alignment - 1) / alignment * alignment;
+
+    // Skip the end of the buffer when the allocation would wrap around
+    if(offset % capacity + size > capacity)
+    {
+        offset = (offset / capacity + 1) * capacity;
+    }
+
+    if(offset + size - tail > capacity)
+    {
+        return std::nullopt;
+    }
+
+    head = offset + size;
+
+    return static_cast<VkDeviceSize>(offset % capacity);
+}
+
+/// <summary>
+/// Assigns the allocations made since the last commit to the frame which copies from them.
+/// </summary>
+void StagingRing::commit(uint64_t frameNumber)
+{
+    if(head == committed)
+    {
+        return;
+    }
+
+    frames.push_back({ frameNumber, head });
+    committed = head;
+}
+
+void StagingRing::release(uint64_t completedFrameNumber)
+{
+    while(!frames.empty() && frames.front().frameNumber <= completedFrameNumber)
+    {
+        tail = frames.front().end;
+        frames.pop_front();
+    }
+}
+
+VkBuffer StagingRing::getBuffer() const
+{
+    return buffer.buffer;
+}
+
+uint8_t* StagingRing::getMapped() const
+{
+    return mapped;
+}
+
+VkDeviceSize StagingRing::getCapacity() const
+{
+    return capacity;
+}
+
+VkDeviceSize StagingRing::getUsedBytes() const
+{
+    return static_cast<VkDeviceSize>(head - tail);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "GpuResources.h"
+
+/// <summary>
+/// Persistently mapped, host coherent staging buffer used as a ring.
+///
+/// Allocations are made by the render thread while it records a frame and belong to that frame once commit() is
+/// called with its frame number. release() returns the space of every frame the GPU completed, so the ring never
+/// needs a wait: when it is full, allocate() fails and the caller retries in a later frame. The capacity bounds the
+/// bytes in flight between host and device.
+///
+/// Offsets grow monotonically and are mapped into the buffer modulo its capacity. An allocation never wraps,
+/// the rest of the buffer is skipped instead.
+/// </summary>
+class StagingRing
+{
+public:
+                                        StagingRing(VkDevice device, const PhysicalDeviceCapabilities& capabilities, const VkAllocationCallbacks* allocator,
+                                                    MemoryBudgetMonitor* budgetMonitor, VkDeviceSize capacity);
+                                        ~StagingRing();
+
+                                        StagingRing(const StagingRing&) = delete;
+    StagingRing&                        operator=(const StagingRing&) = delete;
+
+    std::optional<VkDeviceSize>         allocate(VkDeviceSize size, VkDeviceSize alignment);
+    void                                commit(uint64_t frameNumber);
+    void                                release(uint64_t completedFrameNumber);
+
+    VkBuffer                            getBuffer()                                                                             const;
+    uint8_t*                            getMapped()                                                                             const;
+    VkDeviceSize                        getCapacity()                                                                           const;
+    VkDeviceSize                        getUsedBytes()                                                                          const;
+
+private:
+    struct FrameRange
+    {
+        uint64_t                        frameNumber                 = 0;
+        uint64_t                        end                         = 0;
+    };
+
+    const GpuResources                  resources;
+    const VkDeviceSize                  capacity;
+
+    BufferAllocation                    buffer                      = {};
+    uint8_t*                            mapped                      = nullptr;
+
+    uint64_t                            head                        = 0;    // next free offset
+    uint64_t                            tail                        = 0;    // oldest offset still used by the GPU
+    uint64_t                            committed                   = 0;    // end of the allocations already assigned to a frame
+    std::deque<FrameRange>              frames                      = {};
+};
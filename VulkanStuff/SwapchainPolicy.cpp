@@ -0,0 +1,72 @@
+#include "pch.h"
+#include "SwapchainPolicy.h"
+
+std::vector<VkSurfaceFormatKHR> SwapchainPolicy::getCandidateFormats()
+{
+    return { { VK_FORMAT_B8G8R8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+             { VK_FORMAT_R8G8B8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR } };
+}
+
+VkSurfaceFormatKHR SwapchainPolicy::chooseSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats)
+{
+    for(const VkSurfaceFormatKHR& candidate : getCandidateFormats())
+    {
+        for(const VkSurfaceFormatKHR& availableFormat : availableFormats)
+        {
+            if(availableFormat.format == candidate.format && availableFormat.colorSpace == candidate.colorSpace)
+            {
+                return availableFormat;
+            }
+        }
+    }
+
+    return availableFormats[0];
+}
+
+/// <summary>
+/// The presentation engine holds on to minImageCount - 1 images, the displayed one and the ones queued for display.
+/// Each frame in flight beyond the first needs one more image, otherwise acquire blocks until the presentation engine
+/// releases an image instead of the frame fence being the only limit. A requested count of 0 uses that derived count,
+/// any count is clamped to the limits of the surface.
+/// </summary>
+uint32_t SwapchainPolicy::chooseImageCount(const VkSurfaceCapabilitiesKHR& surfaceCapabilities, uint32_t framesInFlight, uint32_t requestedImageCount)
+{
+    uint32_t imageCount = requestedImageCount > 0 ? requestedImageCount : surfaceCapabilities.minImageCount + framesInFlight - 1;
+
+    imageCount = std::max(imageCount, surfaceCapabilities.minImageCount);
+    if(surfaceCapabilities.maxImageCount > 0)
+    {
+        imageCount = std::min(imageCount, surfaceCapabilities.maxImageCount);
+    }
+
+    return imageCount;
+}
+
+std::string SwapchainPolicy::getSurfaceFormatName(const VkSurfaceFormatKHR& surfaceFormat)
+{
+    std::string name;
+
+    switch(surfaceFormat.format)
+    {
+    case VK_FORMAT_B8G8R8A8_SRGB:               name = "B8G8R8A8_SRGB";             break;
+    case VK_FORMAT_R8G8B8A8_SRGB:               name = "R8G8B8A8_SRGB";             break;
+    case VK_FORMAT_B8G8R8A8_UNORM:              name = "B8G8R8A8_UNORM";            break;
+    case VK_FORMAT_R8G8B8A8_UNORM:              name = "R8G8B8A8_UNORM";            break;
+    case VK_FORMAT_B5G6R5_UNORM_PACK16:         name = "B5G6R5_UNORM";              break;
+    case VK_FORMAT_R5G6B5_UNORM_PACK16:         name = "R5G6B5_UNORM";              break;
+    case VK_FORMAT_A2B10G10R10_UNORM_PACK32:    name = "A2B10G10R10_UNORM";         break;
+    case VK_FORMAT_A2R10G10B10_UNORM_PACK32:    name = "A2R10G10B10_UNORM";         break;
+    case VK_FORMAT_R16G16B16A16_SFLOAT:         name = "R16G16B16A16_SFLOAT";       break;
+    default:                                    name = "format " + std::to_string(surfaceFormat.format); break;
+    }
+
+    switch(surfaceFormat.colorSpace)
+    {
+    case VK_COLOR_SPACE_SRGB_NONLINEAR_KHR:         name += " sRGB";                break;
+    case VK_COLOR_SPACE_HDR10_ST2084_EXT:           name += " HDR10";               break;
+    case VK_COLOR_SPACE_EXTENDED_SRGB_LINEAR_EXT:   name += " scRGB";               break;
+    default:                                        name += " color space " + std::to_string(surfaceFormat.colorSpace); break;
+    }
+
+    return name;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+/// <summary>
+/// Chooses swapchain image count and surface format.
+///
+/// The candidate formats are 8 bit sRGB formats in order of preference, the hardware encodes the linear shader output
+/// on write. Without any of them the first format of the surface is used, so the swapchain can always be created.
+/// There are no UNORM, 16 bit or HDR policies: the fragment shader writes linear SDR values, and nothing encodes them
+/// for formats without sRGB encoding or converts them to a PQ or scRGB signal.
+/// </summary>
+class SwapchainPolicy
+{
+public:
+    static VkSurfaceFormatKHR           chooseSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
+    static std::vector<VkSurfaceFormatKHR> getCandidateFormats();
+
+    static uint32_t                     chooseImageCount(const VkSurfaceCapabilitiesKHR& surfaceCapabilities, uint32_t framesInFlight,
+                                                         uint32_t requestedImageCount);
+
+    static std::string                  getSurfaceFormatName(const VkSurfaceFormatKHR& surfaceFormat);
+};
@@ -0,0 +1,112 @@
+#include "pch.h"
+#include "TaskGraph.h"
+#include "JobSystem.h"
+
+TaskGraph::TaskId TaskGraph::addTask(const char* name, std::function<void()> function, std::initializer_list<TaskId> dependencies)
+{
+    const TaskId taskId = tasks.size();
+
+    Task task = {};
+    task.name = name;
+    task.function = std::move(function);
+    tasks.push_back(std::move(task));
+
+    for(TaskId dependency : dependencies)
+    {
+        if(dependency >= taskId)
+        {
+            throw std::runtime_error("TaskGraph: Dependencies have to be added before their dependents!");
+        }
+
+        tasks[dependency].dependents.push_back(taskId);
+        ++tasks[taskId].dependencyCount;
+    }
+
+    return taskId;
+}
+
+/// <summary>
+/// Runs every task of the graph on the job system and returns once all of them finished.
+///
+/// Tasks without dependencies are scheduled up front, every other task is scheduled by the last of its dependencies
+/// to finish. The calling thread takes part in the execution while it waits. When a task throws, no new tasks are
+/// started, the tasks already running are allowed to finish and the first exception is rethrown on the calling thread.
+/// </summary>
+void TaskGraph::execute(JobSystem& jobSystem)
+{
+    std::vector<std::atomic<uint32_t>>  pendingDependencies(tasks.size());
+    std::atomic<bool>                   failed              = false;
+    JobCounter                          counter;
+
+    std::function<void(TaskId)> runTask;
+    runTask = [&](TaskId taskId)
+    {
+        if(failed.load())
+        {
+            return;
+        }
+
+        Task& task = tasks[taskId];
+        task.workerIndex = JobSystem::getCurrentWorkerIndex();
+        task.startTime = std::chrono::steady_clock::now();
+
+        try
+        {
+            task.function();
+        }
+        catch(...)
+        {
+            task.endTime = std::chrono::steady_clock::now();
+            failed.store(true);
+            throw;
+        }
+
+        task.endTime = std::chrono::steady_clock::now();
+
+        for(TaskId dependent : task.dependents)
+        {
+            if(pendingDependencies[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                jobSystem.schedule([&runTask, dependent] { runTask(dependent); }, &counter);
+            }
+        }
+    };
+
+    for(TaskId taskId = 0; taskId < tasks.size(); ++taskId)
+    {
+        pendingDependencies[taskId].store(tasks[taskId].dependencyCount, std::memory_order_relaxed);
+    }
+
+    executionStartTime = std::chrono::steady_clock::now();
+
+    for(TaskId taskId = 0; taskId < tasks.size(); ++taskId)
+    {
+        if(tasks[taskId].dependencyCount == 0)
+        {
+            jobSystem.schedule([&runTask, taskId] { runTask(taskId); }, &counter);
+        }
+    }
+
+    jobSystem.wait(counter);
+
+    executionEndTime = std::chrono::steady_clock::now();
+}
+
+void TaskGraph::printTimings(std::ostream& stream) const
+{
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    const std::streamsize precision = stream.precision();
+
+    stream << "TaskGraph: " << tasks.size() << " tasks finished in "
+           << Milliseconds(executionEndTime - executionStartTime).count() << " ms\n";
+
+    for(const auto& task : tasks)
+    {
+        stream << "    [worker " << task.workerIndex << "] "
+               << std::setw(24) << std::left << task.name << std::right
+               << " start " << std::setw(8) << std::fixed << std::setprecision(2) << Milliseconds(task.startTime - executionStartTime).count() << " ms"
+               << " duration " << std::setw(8) << Milliseconds(task.endTime - task.startTime).count() << " ms\n";
+    }
+
+    stream << std::defaultfloat << std::setprecision(precision);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+class JobSystem;
+
+/// <summary>
+/// Dependency graph of tasks executed on the workers of a JobSystem.
+///
+/// Tasks are added together with the ids of the tasks they depend on. A task is scheduled as soon
+/// as all of its dependencies finished, so independent work (like loading shader files and creating
+/// the instance) runs concurrently. Dependencies must be added before their dependents, which keeps
+/// the graph acyclic by construction.
+/// </summary>
+class TaskGraph
+{
+public:
+    using TaskId = size_t;
+
+    TaskId                              addTask(const char* name, std::function<void()> function, std::initializer_list<TaskId> dependencies = {});
+    void                                execute(JobSystem& jobSystem);
+    void                                printTimings(std::ostream& stream)                                                      const;
+
+private:
+    struct Task
+    {
+        const char*                                 name                    = nullptr;
+        std::function<void()>                       function                = {};
+        std::vector<TaskId>                         dependents              = {};
+        uint32_t                                    dependencyCount         = 0;
+
+        std::chrono::steady_clock::time_point       startTime               = {};
+        std::chrono::steady_clock::time_point       endTime                 = {};
+        uint32_t                                    workerIndex             = 0;
+    };
+
+    std::vector<Task>                   tasks                       = {};
+    std::chrono::steady_clock::time_point executionStartTime        = {};
+    std::chrono::steady_clock::time_point executionEndTime          = {};
+};
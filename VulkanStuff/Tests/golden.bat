@@ -0,0 +1,27 @@
+@echo off
+rem Renders the deterministic scenes headless and compares them with the golden images in Tests/golden.
+rem Exits with 1 when any scene does not match. Options are passed on to every run, for example
+rem --device=name:llvmpipe to test on lavapipe or --update-golden to replace the golden images.
+rem The executable defaults to the x64 Release build, set VULKANSTUFF_EXE to test another one.
+setlocal
+if not defined VULKANSTUFF_EXE set VULKANSTUFF_EXE=%~dp0..\..\x64\Release\VulkanStuff.exe
+
+rem Shaders are loaded relative to the project directory
+pushd "%~dp0.."
+
+rem Kept in a variable, arguments of a call are split at the = of the options
+set OPTIONS=%*
+set FAILED=0
+call :scene triangle
+
+popd
+if %FAILED% neq 0 echo GoldenTest: FAILED
+if %FAILED% equ 0 echo GoldenTest: PASSED
+exit /b %FAILED%
+
+rem Frame 4 is compared, after every frame in flight has been used at least once
+:scene
+echo GoldenTest: %1
+"%VULKANSTUFF_EXE%" --headless --frames=4 --capture-interval=4 --golden=Tests/golden/%1 %OPTIONS%
+if errorlevel 1 set FAILED=1
+exit /b 0
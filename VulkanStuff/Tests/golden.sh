@@ -0,0 +1,46 @@
+#!/bin/sh
+# Renders the deterministic scenes headless and compares them with the golden images in Tests/golden.
+# Exits with 1 when any scene does not match. Options are passed on to every run, for example
+# --update-golden to replace the golden images with the frames of this run.
+# Meant for Linux CI hosts without a GPU: unless VK_ICD_FILENAMES is set already, the loader only sees lavapipe.
+# Set it to the SwiftShader ICD to test on SwiftShader instead. The executable defaults to VulkanStuff in the
+# project directory, set VULKANSTUFF_EXE to test another one.
+
+# Shaders are loaded relative to the project directory
+cd "$(dirname "$0")/.." || exit 1
+
+VULKANSTUFF_EXE=${VULKANSTUFF_EXE:-./VulkanStuff}
+
+if [ -z "$VK_ICD_FILENAMES" ]; then
+    for icd in /usr/share/vulkan/icd.d/lvp_icd.*.json /usr/local/share/vulkan/icd.d/lvp_icd.*.json; do
+        if [ -f "$icd" ]; then
+            VK_ICD_FILENAMES=$icd
+            break
+        fi
+    done
+    if [ -z "$VK_ICD_FILENAMES" ]; then
+        echo "GoldenTest: No lavapipe ICD found, set VK_ICD_FILENAMES"
+        exit 1
+    fi
+fi
+export VK_ICD_FILENAMES
+
+FAILED=0
+
+# Frame 4 is compared, after every frame in flight has been used at least once
+scene()
+{
+    name=$1
+    shift
+    echo "GoldenTest: $name"
+    "$VULKANSTUFF_EXE" --headless --frames=4 --capture-interval=4 --golden="Tests/golden/$name" "$@" || FAILED=1
+}
+
+scene triangle "$@"
+
+if [ $FAILED -ne 0 ]; then
+    echo "GoldenTest: FAILED"
+else
+    echo "GoldenTest: PASSED"
+fi
+exit $FAILED
@@ -0,0 +1,108 @@
+#include "pch.h"
+#include "TextureFormat.h"
+
+std::optional<TextureFormatInfo> TextureFormat::getInfo(VkFormat format)
+{
+    switch(format)
+    {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+        return TextureFormatInfo{ 1, 1, 4, false };
+
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+        return TextureFormatInfo{ 4, 4, 8, true };
+
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+    case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+    case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+        return TextureFormatInfo{ 4, 4, 16, true };
+
+    case VK_FORMAT_ASTC_6x6_UNORM_BLOCK:
+    case VK_FORMAT_ASTC_6x6_SRGB_BLOCK:
+        return TextureFormatInfo{ 6, 6, 16, true };
+
+    case VK_FORMAT_ASTC_8x8_UNORM_BLOCK:
+    case VK_FORMAT_ASTC_8x8_SRGB_BLOCK:
+        return TextureFormatInfo{ 8, 8, 16, true };
+
+    default:
+        return std::nullopt;
+    }
+}
+
+bool TextureFormat::isEnabled(VkFormat format, const VkPhysicalDeviceFeatures& enabledFeatures)
+{
+    if(format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK)
+    {
+        return enabledFeatures.textureCompressionBC == VK_TRUE;
+    }
+    if(format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK)
+    {
+        return enabledFeatures.textureCompressionASTC_LDR == VK_TRUE;
+    }
+
+    return getInfo(format).has_value();
+}
+
+const char* TextureFormat::getName(VkFormat format)
+{
+    switch(format)
+    {
+    case VK_FORMAT_R8G8B8A8_UNORM:              return "R8G8B8A8_UNORM";
+    case VK_FORMAT_R8G8B8A8_SRGB:               return "R8G8B8A8_SRGB";
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:         return "BC1_RGB_UNORM";
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:          return "BC1_RGB_SRGB";
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:        return "BC1_RGBA_UNORM";
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:         return "BC1_RGBA_SRGB";
+    case VK_FORMAT_BC3_UNORM_BLOCK:             return "BC3_UNORM";
+    case VK_FORMAT_BC3_SRGB_BLOCK:              return "BC3_SRGB";
+    case VK_FORMAT_BC4_UNORM_BLOCK:             return "BC4_UNORM";
+    case VK_FORMAT_BC5_UNORM_BLOCK:             return "BC5_UNORM";
+    case VK_FORMAT_BC7_UNORM_BLOCK:             return "BC7_UNORM";
+    case VK_FORMAT_BC7_SRGB_BLOCK:              return "BC7_SRGB";
+    case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:        return "ASTC_4x4_UNORM";
+    case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:         return "ASTC_4x4_SRGB";
+    case VK_FORMAT_ASTC_6x6_UNORM_BLOCK:        return "ASTC_6x6_UNORM";
+    case VK_FORMAT_ASTC_6x6_SRGB_BLOCK:         return "ASTC_6x6_SRGB";
+    case VK_FORMAT_ASTC_8x8_UNORM_BLOCK:        return "ASTC_8x8_UNORM";
+    case VK_FORMAT_ASTC_8x8_SRGB_BLOCK:         return "ASTC_8x8_SRGB";
+    default:                                    return "unknown";
+    }
+}
+
+VkDeviceSize TextureFormat::getRowSize(const TextureFormatInfo& info, uint32_t width)
+{
+    return static_cast<VkDeviceSize>((width + info.blockWidth - 1) / info.blockWidth) * info.blockSize;
+}
+
+/// <summary>
+/// Rows of blocks, a compressed texture is copied in multiples of its block height.
+/// </summary>
+uint32_t TextureFormat::getRowCount(const TextureFormatInfo& info, uint32_t height)
+{
+    return (height + info.blockHeight - 1) / info.blockHeight;
+}
+
+VkDeviceSize TextureFormat::getLevelSize(const TextureFormatInfo& info, uint32_t width, uint32_t height)
+{
+    return getRowSize(info, width) * getRowCount(info, height);
+}
+
+uint32_t TextureFormat::getMipLevelCount(uint32_t width, uint32_t height)
+{
+    uint32_t levelCount = 1;
+    for(uint32_t size = std::max(width, height); size > 1; size /= 2)
+    {
+        ++levelCount;
+    }
+
+    return levelCount;
+}
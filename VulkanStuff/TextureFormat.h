@@ -0,0 +1,29 @@
+#pragma once
+
+/// <summary>
+/// Memory layout of a texture format. Uncompressed formats have 1x1 blocks of one texel.
+/// </summary>
+struct TextureFormatInfo
+{
+    uint32_t                            blockWidth                  = 1;
+    uint32_t                            blockHeight                 = 1;
+    uint32_t                            blockSize                   = 4;    // bytes
+    bool                                compressed                  = false;
+};
+
+/// <summary>
+/// The texture formats the asset pipeline knows: 8 bit RGBA, BC1/3/4/5/7 and ASTC 4x4, 6x6 and 8x8 LDR.
+/// Compressed formats are only usable when their device feature was enabled.
+/// </summary>
+class TextureFormat
+{
+public:
+    static std::optional<TextureFormatInfo> getInfo(VkFormat format);
+    static bool                         isEnabled(VkFormat format, const VkPhysicalDeviceFeatures& enabledFeatures);
+    static const char*                  getName(VkFormat format);
+
+    static VkDeviceSize                 getRowSize(const TextureFormatInfo& info, uint32_t width);
+    static uint32_t                     getRowCount(const TextureFormatInfo& info, uint32_t height);
+    static VkDeviceSize                 getLevelSize(const TextureFormatInfo& info, uint32_t width, uint32_t height);
+    static uint32_t                     getMipLevelCount(uint32_t width, uint32_t height);
+};
@@ -0,0 +1,127 @@
+#pragma once
+#include "Debug.h"
+
+/// <summary>
+/// Parent type of handles which are destroyed without a parent object, like VkInstance and VkDevice.
+/// </summary>
+struct NoParent {};
+
+/// <summary>
+/// Move-only owner of a Vulkan handle.
+///
+/// Stores the parent object and the allocation callbacks used at creation, and destroys the handle with
+/// DestroyFunction when reset or destroyed itself. The wrapper converts implicitly to the raw handle,
+/// so it can be passed straight to Vulkan calls. To destroy a handle which may still be used by the GPU,
+/// move it into a DeletionQueue instead of resetting it.
+/// </summary>
+template<typename Handle, typename Parent, auto DestroyFunction>
+class UniqueHandle
+{
+public:
+    UniqueHandle() = default;
+
+    UniqueHandle(Parent parent, Handle handle, const VkAllocationCallbacks* allocator)
+        : parent(parent)
+        , handle(handle)
+        , allocator(allocator)
+    {
+    }
+
+    UniqueHandle(Handle handle, const VkAllocationCallbacks* allocator)
+        : handle(handle)
+        , allocator(allocator)
+    {
+        static_assert(std::is_same_v<Parent, NoParent>, "Handle requires a parent object");
+    }
+
+    ~UniqueHandle()
+    {
+        reset();
+    }
+
+    UniqueHandle(const UniqueHandle&) = delete;
+    UniqueHandle& operator=(const UniqueHandle&) = delete;
+
+    UniqueHandle(UniqueHandle&& other) noexcept
+        : parent(other.parent)
+        , handle(other.release())
+        , allocator(other.allocator)
+    {
+    }
+
+    UniqueHandle& operator=(UniqueHandle&& other) noexcept
+    {
+        if(this != &other)
+        {
+            reset();
+            parent = other.parent;
+            allocator = other.allocator;
+            handle = other.release();
+        }
+
+        return *this;
+    }
+
+    operator Handle() const
+    {
+        return handle;
+    }
+
+    Handle get() const
+    {
+        return handle;
+    }
+
+    Handle release()
+    {
+        Handle released = handle;
+        handle = VK_NULL_HANDLE;
+        return released;
+    }
+
+    void reset()
+    {
+        if(handle == VK_NULL_HANDLE)
+        {
+            return;
+        }
+
+        if constexpr(std::is_same_v<Parent, NoParent>)
+        {
+            DestroyFunction(handle, allocator);
+        }
+        else
+        {
+            DestroyFunction(parent, handle, allocator);
+        }
+
+        handle = VK_NULL_HANDLE;
+    }
+
+private:
+    Parent                              parent                      = {};
+    Handle                              handle                      = VK_NULL_HANDLE;
+    const VkAllocationCallbacks*        allocator                   = nullptr;
+};
+
+using UniqueInstance                    = UniqueHandle<VkInstance,                  NoParent,       &vkDestroyInstance>;
+using UniqueDevice                      = UniqueHandle<VkDevice,                    NoParent,       &vkDestroyDevice>;
+using UniqueDebugUtilsMessenger         = UniqueHandle<VkDebugUtilsMessengerEXT,    VkInstance,     &destroyDebugUtilsMessengerEXT>;
+using UniqueSurface                     = UniqueHandle<VkSurfaceKHR,                VkInstance,     &vkDestroySurfaceKHR>;
+using UniqueSwapchain                   = UniqueHandle<VkSwapchainKHR,              VkDevice,       &vkDestroySwapchainKHR>;
+using UniqueImage                       = UniqueHandle<VkImage,                     VkDevice,       &vkDestroyImage>;
+using UniqueImageView                   = UniqueHandle<VkImageView,                 VkDevice,       &vkDestroyImageView>;
+using UniqueBuffer                      = UniqueHandle<VkBuffer,                    VkDevice,       &vkDestroyBuffer>;
+using UniqueDeviceMemory                = UniqueHandle<VkDeviceMemory,              VkDevice,       &vkFreeMemory>;
+using UniqueSampler                     = UniqueHandle<VkSampler,                   VkDevice,       &vkDestroySampler>;
+using UniqueShaderModule                = UniqueHandle<VkShaderModule,              VkDevice,       &vkDestroyShaderModule>;
+using UniqueRenderPass                  = UniqueHandle<VkRenderPass,                VkDevice,       &vkDestroyRenderPass>;
+using UniqueFramebuffer                 = UniqueHandle<VkFramebuffer,               VkDevice,       &vkDestroyFramebuffer>;
+using UniquePipelineLayout              = UniqueHandle<VkPipelineLayout,            VkDevice,       &vkDestroyPipelineLayout>;
+using UniquePipeline                    = UniqueHandle<VkPipeline,                  VkDevice,       &vkDestroyPipeline>;
+using UniqueCommandPool                 = UniqueHandle<VkCommandPool,               VkDevice,       &vkDestroyCommandPool>;
+using UniqueSemaphore                   = UniqueHandle<VkSemaphore,                 VkDevice,       &vkDestroySemaphore>;
+using UniqueFence                       = UniqueHandle<VkFence,                     VkDevice,       &vkDestroyFence>;
+using UniqueQueryPool                   = UniqueHandle<VkQueryPool,                 VkDevice,       &vkDestroyQueryPool>;
+using UniqueDescriptorSetLayout         = UniqueHandle<VkDescriptorSetLayout,       VkDevice,       &vkDestroyDescriptorSetLayout>;
+using UniqueDescriptorPool              = UniqueHandle<VkDescriptorPool,            VkDevice,       &vkDestroyDescriptorPool>;
@@ -1,12 +1,47 @@
 #include "pch.h"
 #include "vkApplication.h"
+#include "JobBenchmark.h"
+#include "MeshFile.h"
+#include "MeshLoadBenchmark.h"
+#include "SceneBenchmark.h"
 
-int main()
+int main(int argc, char** argv)
 {
-    vkApplication app;
-
     try
     {
+        const ApplicationSettings settings = ApplicationSettings::parse(argc, argv);
+
+        if(settings.showUsage)
+        {
+            ApplicationSettings::printUsage(std::cout);
+            return EXIT_SUCCESS;
+        }
+
+        if(settings.jobBenchmark)
+        {
+            JobBenchmark::run(std::cout, settings.workerCount);
+            return EXIT_SUCCESS;
+        }
+
+        if(!settings.meshConversionPath.empty())
+        {
+            MeshFile::convertAll(settings.meshConversionPath, std::cout);
+            return EXIT_SUCCESS;
+        }
+
+        if(!settings.meshBenchmarkPath.empty())
+        {
+            MeshLoadBenchmark::run(std::cout, settings.meshBenchmarkPath);
+            return EXIT_SUCCESS;
+        }
+
+        if(settings.sceneBenchmark)
+        {
+            SceneBenchmark::run(std::cout);
+            return EXIT_SUCCESS;
+        }
+
+        vkApplication app(settings);
         app.run();
     }
     catch (const std::exception& e)
@@ -10,5 +10,33 @@
 #include <optional>
 #include <map>
 #include <set>
+#include <unordered_set>
+#include <unordered_map>
 #include <algorithm>
-#include <fstream>
\ No newline at end of file
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <iomanip>
+#include <deque>
+#include <functional>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <tuple>
+#include <cctype>
+#include <cstdlib>
+#include <atomic>
+#include <memory>
+#include <sstream>
+#include <string_view>
+#include <limits>
+#include <type_traits>
+#include <iterator>
+#include <array>
+#include <list>
+#include <filesystem>
+#include <cmath>
+#include <charconv>
+#include <random>
\ No newline at end of file
@@ -1,13 +1,47 @@
 ﻿#include "pch.h"
 #include "vkApplication.h"
 #include "Debug.h"
+#include "TaskGraph.h"
+#include "DeviceSelection.h"
+
+vkApplication::vkApplication(const ApplicationSettings& settings)
+    : settings(settings)
+{
+}
 
 void vkApplication::run()
 {
-    initWindow();
+    startupTime = std::chrono::steady_clock::now();
+
+    // The sink has to outlive the instance, it also receives messages from vkCreateInstance and vkDestroyInstance.
+    if(vkValidationLayersEnabled)
+    {
+        debugMessageSink = std::make_unique<DebugMessageSink>(settings.debugMessageSeverity, settings.debugMessagesPerSecond);
+    }
+
+    if(settings.trackHostAllocations)
+    {
+        hostAllocator = std::make_unique<HostAllocator>();
+        vkAllocator = hostAllocator->getCallbacks();
+    }
+
+    jobSystem = std::make_unique<JobSystem>(settings.workerCount);
+
+    if(settings.computeBatchImages > 0)
+    {
+        runComputeBatch();
+        return;
+    }
+
+    if(!settings.headless)
+    {
+        initWindow();
+    }
+
     initVulkan();
     mainLoop();
     cleanup();
+    checkRunResults();
 }
 
 bool vkApplication::checkValidationLayersSupport() const
@@ -41,10 +75,16 @@ bool vkApplication::checkValidationLayersSupport() const
 
 const std::vector<const char*> vkApplication::getRequiredExtensions() const
 {
-    uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    std::vector<const char*> requiredExtensions;
+
+    // Surface extensions are only needed to present to a window
+    if(!settings.headless)
+    {
+        uint32_t glfwExtensionCount = 0;
+        const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
-    std::vector<const char*> requiredExtensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        requiredExtensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
 
     if(vkValidationLayersEnabled)
     {
@@ -62,12 +102,15 @@ void vkApplication::setupDebugMessenger()
     }
 
     VkDebugUtilsMessengerCreateInfoEXT vkDebugUtilsMessengerCreateInfo;
-    populateDebugMessengerCreateInfo(vkDebugUtilsMessengerCreateInfo);
+    populateDebugMessengerCreateInfo(vkDebugUtilsMessengerCreateInfo, debugMessageSink.get());
 
-    if(createDebugUtilsMessengerEXT(vkInstance, &vkDebugUtilsMessengerCreateInfo, nullptr, &vkDebugMessenger) != VK_SUCCESS)
+    VkDebugUtilsMessengerEXT debugMessenger = nullptr;
+    if(createDebugUtilsMessengerEXT(vkInstance, &vkDebugUtilsMessengerCreateInfo, vkAllocator, &debugMessenger) != VK_SUCCESS)
     {
         throw std::runtime_error("DebugMessenger: Failed to set up debug messenger!");
     }
+
+    vkDebugMessenger = UniqueDebugUtilsMessenger(vkInstance, debugMessenger, vkAllocator);
 }
 
 void vkApplication::findPhysicalDevice()
@@ -83,114 +126,125 @@ void vkApplication::findPhysicalDevice()
     std::vector<VkPhysicalDevice> physicalDevices(physicalDeviceCount);
     vkEnumeratePhysicalDevices(vkInstance, &physicalDeviceCount, physicalDevices.data());
 
-    std::multimap<int, VkPhysicalDevice> candidates;
+    // Take a single capability snapshot per device, every decision below reads from it.
+    const auto queryStart = std::chrono::steady_clock::now();
 
+    vkPhysicalDevicesCapabilities.clear();
+    vkPhysicalDevicesCapabilities.reserve(physicalDeviceCount);
     for(const auto& physicalDevice : physicalDevices)
     {
-        int candidateScore = getPhysicalDeviceScore(physicalDevice);
-        candidates.insert(std::make_pair(candidateScore, physicalDevice));
+        vkPhysicalDevicesCapabilities.push_back(PhysicalDeviceCapabilities::query(physicalDevice, vkSurface));
     }
 
-    //TODO: Allow user to choose which GPU to use. Print option list and scores.
-    if(candidates.rbegin()->first > 0 && isDeviceSupportingRequirements(candidates.rbegin()->second))
-    {
-        vkPhysicalDevice = candidates.rbegin()->second;
-    }
-    else
+    const std::chrono::duration<double, std::milli> queryTime = std::chrono::steady_clock::now() - queryStart;
+    std::cout << "PhysicalDevice: Queried capabilities of " << physicalDeviceCount << " device(s) in " << queryTime.count() << " ms" << std::endl;
+    for(const auto& capabilities : vkPhysicalDevicesCapabilities)
     {
-        throw std::runtime_error("PhysicalDevice: Failed to find GPU supporting requirements");
+        std::cout << "    " << capabilities.properties.deviceName << ": " << capabilities.queryTime.count() << " ms" << std::endl;
     }
-}
 
-const uint32_t vkApplication::getPhysicalDeviceScore(const VkPhysicalDevice& physicalDevice) const
-{
-    VkPhysicalDeviceProperties physicalDeviceProperties = {};
-    VkPhysicalDeviceFeatures physicalDeviceFeatures = {};
-    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
-    vkGetPhysicalDeviceFeatures(physicalDevice, &physicalDeviceFeatures);
+    const DeviceSelector deviceSelector(settings.deviceSelectionPolicy, settings.deviceSelector);
+    const auto ratings = deviceSelector.rank(vkPhysicalDevicesCapabilities,
+        [this](const PhysicalDeviceCapabilities& capabilities, std::string& rejectReason)
+        {
+            return isDeviceSupportingRequirements(capabilities, rejectReason);
+        });
 
-    //TODO: Evaluate other parameters
-    uint32_t score = 0;
+    deviceSelector.printRanking(std::cout, ratings);
 
-    //Performance Parameters
-    if(physicalDeviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+    if(ratings.empty() || !ratings.front().suitable)
     {
-        score += 1000;
+        throw std::runtime_error("PhysicalDevice: Failed to find GPU supporting requirements");
     }
 
-    //Important
-    score += physicalDeviceProperties.limits.maxImageDimension2D;
-
-    //Required Parameters - without them application can't work.
-    if(!physicalDeviceFeatures.geometryShader)
-    {
-        return 0;
-    }
+    vkDeviceCapabilities = ratings.front().capabilities;
+    vkPhysicalDevice = vkDeviceCapabilities->vkPhysicalDevice;
 
-    return score;
+    std::cout << "PhysicalDevice: Using " << vkDeviceCapabilities->properties.deviceName << std::endl;
 }
 
-const vkApplication::QueueFamilyIndices vkApplication::getQueueFamilies(const VkPhysicalDevice& physicalDevice) const
+bool vkApplication::isDeviceSupportingRequirements(const PhysicalDeviceCapabilities& capabilities, std::string& rejectReason) const
 {
-    QueueFamilyIndices queueFamilyIndices = {};
-
-    uint32_t queueFamilyCount = 0;
-    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
-
-    std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
-    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilyProperties.data());
-
-    VkBool32 presentSupport = false;
-    uint32_t i = 0;
-    for(const auto& queueFamilyProperty : queueFamilyProperties)
+    if(settings.computeBatchImages > 0)
     {
-        vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, vkSurface, &presentSupport);
-
-        if(queueFamilyProperty.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+        if(!capabilities.queueFamilyIndices.computeFamily.has_value())
         {
-            queueFamilyIndices.graphicsFamily = i;
+            rejectReason = "no compute queue family";
+            return false;
         }
-
-        if(presentSupport)
+    }
+    else if(settings.headless)
+    {
+        if(!capabilities.queueFamilyIndices.graphicsFamily.has_value())
         {
-            queueFamilyIndices.presentFamily = i;
+            rejectReason = "no graphics queue family";
+            return false;
         }
+    }
+    else if(!capabilities.queueFamilyIndices.IsComplete())
+    {
+        rejectReason = "no graphics and present queue families";
+        return false;
+    }
 
-        if(queueFamilyIndices.IsComplete())
-        {
-            break;
-        }
+    if(!checkDeviceExtensionsSupport(capabilities))
+    {
+        rejectReason = "missing device extensions";
+        return false;
+    }
+
+    if(!settings.headless && (capabilities.surfaceFormats.empty() || capabilities.surfacePresentModes.empty()))
+    {
+        rejectReason = "insufficient swapchain support";
+        return false;
+    }
 
-        ++i;
+    if(!capabilities.hasFeatures(vkRequiredDeviceFeatures))
+    {
+        rejectReason = "missing required features";
+        return false;
     }
 
-    return queueFamilyIndices;
+    return true;
 }
 
-bool vkApplication::isDeviceSupportingRequirements(const VkPhysicalDevice& physicalDevice) const
+/// <summary>
+/// Presentation uses the graphics family whenever it can present. Devices with another presenting family, usually a
+/// compute family, can be asked to present from there to exercise the queue ownership transfer of the swapchain images.
+/// </summary>
+uint32_t vkApplication::choosePresentFamily(uint32_t graphicsFamily) const
 {
-    const QueueFamilyIndices queueFamilyIndices = getQueueFamilies(physicalDevice);
-
-    const bool extensionsSupported = checkDeviceExtensionsSupport(physicalDevice);
+    // Headless there is no present family, the present queue is just an alias of the graphics queue.
+    const uint32_t presentFamily = vkDeviceCapabilities->queueFamilyIndices.presentFamily.value_or(graphicsFamily);
+    if(!settings.separatePresentQueue || settings.headless)
+    {
+        return presentFamily;
+    }
 
-    bool swapchainSufficient = false;
-    if(extensionsSupported)
+    const std::vector<VkBool32>& presentSupport = vkDeviceCapabilities->queueFamilyPresentSupport;
+    for(uint32_t i = 0; i < presentSupport.size(); ++i)
     {
-        const SwapchainSupportDetails swapChainSupportDetails = querySwapchainSupport(physicalDevice);
-        swapchainSufficient = !swapChainSupportDetails.vkFormats.empty() && !swapChainSupportDetails.vkPresentModes.empty();
+        if(i != graphicsFamily && presentSupport[i])
+        {
+            return i;
+        }
     }
 
-    return queueFamilyIndices.IsComplete() && extensionsSupported && swapchainSufficient;
+    std::cout << "Logical Device: No queue family besides graphics can present, presenting from the graphics family" << std::endl;
+    return presentFamily;
 }
 
 void vkApplication::createLogicalDevice()
 {
-    QueueFamilyIndices queueFamilyIndices = getQueueFamilies(vkPhysicalDevice);
+    const QueueFamilyIndices& queueFamilyIndices = vkDeviceCapabilities->queueFamilyIndices;
     std::vector<VkDeviceQueueCreateInfo> deviceQueueCreateInfos = {};
 
+    const uint32_t graphicsFamily = queueFamilyIndices.graphicsFamily.value();
+    const uint32_t presentFamily = choosePresentFamily(graphicsFamily);
+
     std::set<uint32_t> uniqueQueueFamilies = {
-        queueFamilyIndices.graphicsFamily.value(),
-        queueFamilyIndices.presentFamily.value()
+        graphicsFamily,
+        presentFamily
     };
 
     float queuePriority = 1.0f;
@@ -209,19 +263,87 @@ void vkApplication::createLogicalDevice()
         deviceQueueCreateInfos.push_back(deviceQueueCreateInfo);
     }
 
-    VkPhysicalDeviceFeatures physicalDeviceFeatures = {};
+    VkPhysicalDeviceFeatures physicalDeviceFeatures = vkRequiredDeviceFeatures;
+
+    // Compressed texture formats and anisotropic filtering are used by the asset streamer whenever the device has them.
+    physicalDeviceFeatures.textureCompressionBC = vkDeviceCapabilities->features.textureCompressionBC;
+    physicalDeviceFeatures.textureCompressionASTC_LDR = vkDeviceCapabilities->features.textureCompressionASTC_LDR;
+    physicalDeviceFeatures.samplerAnisotropy = vkDeviceCapabilities->features.samplerAnisotropy;
+
+    // Meshlet rendering falls back to indirect draws of the meshlets surviving a compute culling pass, levels of
+    // detail selected on the GPU are drawn indirectly with the instances of each level starting at its own offset.
+    physicalDeviceFeatures.multiDrawIndirect = vkDeviceCapabilities->features.multiDrawIndirect;
+    physicalDeviceFeatures.drawIndirectFirstInstance = vkDeviceCapabilities->features.drawIndirectFirstInstance;
+    vkEnabledDeviceFeatures = physicalDeviceFeatures;
+
+    vkEnabledDeviceExtensions = vkDeviceExtensions;
+    for(const char* optionalExtension : vkOptionalDeviceExtensions)
+    {
+        if(vkDeviceCapabilities->hasExtension(optionalExtension))
+        {
+            vkEnabledDeviceExtensions.push_back(optionalExtension);
+        }
+    }
+
+    // Present latency is measured with present ids and present wait, both need their extension and feature enabled.
+    const bool presentLatencySupported = !settings.headless
+                                      && vkDeviceCapabilities->presentIdFeatures.presentId == VK_TRUE
+                                      && vkDeviceCapabilities->presentWaitFeatures.presentWait == VK_TRUE;
+
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR, nullptr, VK_TRUE };
+    VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR, &presentWaitFeatures, VK_TRUE };
+
+    // Meshlets are drawn with task and mesh shaders when the device has both, culled meshlets are counted on the GPU
+    // with drawIndirectCount otherwise.
+    meshShadersEnabled = vkDeviceCapabilities->meshShaderFeatures.taskShader == VK_TRUE && vkDeviceCapabilities->meshShaderFeatures.meshShader == VK_TRUE;
+    drawIndirectCountEnabled = vkDeviceCapabilities->features12.drawIndirectCount == VK_TRUE;
+
+    // Frames are submitted with vkQueueSubmit2KHR when the device has synchronization2, with vkQueueSubmit otherwise.
+    synchronization2Enabled = vkDeviceCapabilities->synchronization2Features.synchronization2 == VK_TRUE;
+
+    VkPhysicalDeviceMeshShaderFeaturesEXT meshShaderFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT, nullptr, VK_TRUE, VK_TRUE, VK_FALSE, VK_FALSE, VK_FALSE };
+    VkPhysicalDeviceVulkan12Features features12 = {};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    features12.drawIndirectCount = VK_TRUE;
+    VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR, nullptr, VK_TRUE };
+
+    // Optional feature structures are chained in front of each other
+    void* featureChain = nullptr;
+    if(presentLatencySupported)
+    {
+        vkEnabledDeviceExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        vkEnabledDeviceExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+        featureChain = &presentIdFeatures;
+    }
+    if(meshShadersEnabled)
+    {
+        vkEnabledDeviceExtensions.push_back(VK_EXT_MESH_SHADER_EXTENSION_NAME);
+        meshShaderFeatures.pNext = featureChain;
+        featureChain = &meshShaderFeatures;
+    }
+    if(drawIndirectCountEnabled)
+    {
+        features12.pNext = featureChain;
+        featureChain = &features12;
+    }
+    if(synchronization2Enabled)
+    {
+        vkEnabledDeviceExtensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+        synchronization2Features.pNext = featureChain;
+        featureChain = &synchronization2Features;
+    }
 
     VkDeviceCreateInfo deviceCreateInfo
     {
         VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-        nullptr,
+        featureChain,
         NULL,
         static_cast<uint32_t>(deviceQueueCreateInfos.size()),
         deviceQueueCreateInfos.data(),
         0,
         nullptr,
-        static_cast<uint32_t>(vkDeviceExtensions.size()),
-        vkDeviceExtensions.data(),
+        static_cast<uint32_t>(vkEnabledDeviceExtensions.size()),
+        vkEnabledDeviceExtensions.data(),
         &physicalDeviceFeatures
     };
 
@@ -231,98 +353,124 @@ void vkApplication::createLogicalDevice()
         deviceCreateInfo.ppEnabledLayerNames = vkValidationLayers.data();
     }
 
-    if(vkCreateDevice(vkPhysicalDevice, &deviceCreateInfo, nullptr, &vkLogicalDevice) != VK_SUCCESS)
+    VkDevice logicalDevice = nullptr;
+    if(vkCreateDevice(vkPhysicalDevice, &deviceCreateInfo, vkAllocator, &logicalDevice) != VK_SUCCESS)
     {
         throw std::runtime_error("Logical Device: Failed to create logical device");
     }
 
-    vkGetDeviceQueue(vkLogicalDevice, queueFamilyIndices.graphicsFamily.value(), 0, &vkGraphicsQueue);
-    vkGetDeviceQueue(vkLogicalDevice, queueFamilyIndices.presentFamily.value(), 0, &vkPresentQueue);
-}
+    vkLogicalDevice = UniqueDevice(logicalDevice, vkAllocator);
 
-void vkApplication::createSurface()
-{
-    if(glfwCreateWindowSurface(vkInstance, window, nullptr, &vkSurface) != VK_SUCCESS)
-    {
-        throw std::runtime_error("Surface: Failed to create window surface!");
-    }
-}
+    vkGetDeviceQueue(vkLogicalDevice, graphicsFamily, 0, &vkGraphicsQueue);
+    vkGetDeviceQueue(vkLogicalDevice, presentFamily, 0, &vkPresentQueue);
 
+    vkPresentFamily = presentFamily;
+    queueOwnershipTransfer = graphicsFamily != presentFamily;
 
-bool vkApplication::checkDeviceExtensionsSupport(const VkPhysicalDevice& physicalDevice) const
-{
-    uint32_t extensionCount = 0;
-    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    queueSubmitter = std::make_unique<QueueSubmitter>(vkLogicalDevice, synchronization2Enabled);
 
-    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
-    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+    // Budget queries go through vkGetPhysicalDeviceMemoryProperties2, which needs a Vulkan 1.1 device.
+    const bool memoryBudgetSupported = isDeviceExtensionEnabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)
+                                    && vkDeviceCapabilities->properties.apiVersion >= VK_API_VERSION_1_1;
 
-    std::set<std::string> requiredExtensions(vkDeviceExtensions.begin(), vkDeviceExtensions.end());
+    memoryBudgetMonitor = std::make_unique<MemoryBudgetMonitor>(vkPhysicalDevice, vkDeviceCapabilities->memoryProperties,
+                                                                memoryBudgetSupported, settings.memoryBudgetThreshold);
 
-    for (const auto& availableExtension : availableExtensions)
+    // vkWaitForPresentKHR is not exported by the loader and has to be loaded from the device.
+    const auto waitForPresent = presentLatencySupported ? reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(vkLogicalDevice, "vkWaitForPresentKHR"))
+                                                        : nullptr;
+    if(waitForPresent != nullptr)
     {
-        requiredExtensions.erase(availableExtension.extensionName);
+        presentLatencyMonitor = std::make_unique<PresentLatencyMonitor>(vkLogicalDevice, waitForPresent, settings.warmupFrames);
+    }
+    else if(!settings.headless)
+    {
+        std::cout << "Presentation: Device does not support present ids and present wait, present latency is not measured" << std::endl;
     }
-
-    return requiredExtensions.empty();
 }
 
-
-const vkApplication::SwapchainSupportDetails vkApplication::querySwapchainSupport(VkPhysicalDevice physicalDevice) const
+bool vkApplication::isDeviceExtensionEnabled(const char* extensionName) const
 {
-    SwapchainSupportDetails swapchainSupportDetails = {};
-
-    //Check basic surface Capabilities like min/max number of images in swapchain min/max width and size of images
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, vkSurface, &swapchainSupportDetails.vkSurfaceCapabilities);
+    for(const char* enabledExtension : vkEnabledDeviceExtensions)
+    {
+        if(strcmp(enabledExtension, extensionName) == 0)
+        {
+            return true;
+        }
+    }
 
-    //Check Formats Support
-    uint32_t formatCount = 0;
-    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, vkSurface, &formatCount, nullptr);
+    return false;
+}
 
-    if(formatCount != 0)
+void vkApplication::createSurface()
+{
+    if(settings.headless)
     {
-        swapchainSupportDetails.vkFormats.resize(formatCount);
-        vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, vkSurface, &formatCount, swapchainSupportDetails.vkFormats.data());
+        return;
     }
 
-    //Check Present Modes Support
-    uint32_t presentModeCount = 0;
-    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, vkSurface, &presentModeCount, nullptr);
-
-    if (presentModeCount != 0)
+    VkSurfaceKHR surface = nullptr;
+    if(glfwCreateWindowSurface(vkInstance, window, vkAllocator, &surface) != VK_SUCCESS)
     {
-        swapchainSupportDetails.vkPresentModes.resize(presentModeCount);
-        vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, vkSurface, &presentModeCount, swapchainSupportDetails.vkPresentModes.data());
+        throw std::runtime_error("Surface: Failed to create window surface!");
     }
 
-    return swapchainSupportDetails;
+    vkSurface = UniqueSurface(vkInstance, surface, vkAllocator);
 }
 
 
-const VkSurfaceFormatKHR vkApplication::chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) const
+bool vkApplication::checkDeviceExtensionsSupport(const PhysicalDeviceCapabilities& capabilities) const
 {
-    for (const auto& availableFormat : availableFormats)
+    for(const char* deviceExtension : vkDeviceExtensions)
     {
-        if(availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+        if(!capabilities.hasExtension(deviceExtension))
         {
-            return availableFormat;
+            return false;
         }
     }
 
-    return availableFormats[0];
+    return true;
 }
 
-const VkPresentModeKHR vkApplication::chooseSwapPresentMode( const std::vector<VkPresentModeKHR>& availablePresentModes) const
+
+const VkSurfaceFormatKHR vkApplication::chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) const
+{
+    return SwapchainPolicy::chooseSurfaceFormat(availableFormats);
+}
+
+/// <summary>
+/// The surface format is known as soon as the physical device is picked. Choosing it before the swapchain is created
+/// allows the render pass and the graphics pipeline to be built in parallel with the swapchain.
+/// </summary>
+void vkApplication::chooseSurfaceFormat()
 {
-    for(const auto& availablePresentMode : availablePresentModes)
+    if(!settings.headless)
+    {
+        vkSurfaceFormat = chooseSwapSurfaceFormat(vkDeviceCapabilities->surfaceFormats);
+        return;
+    }
+
+    // Offscreen targets use the format a window would most likely get, so headless frames match windowed ones.
+    const VkFormatFeatureFlags requiredFeatures = VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_TRANSFER_SRC_BIT;
+
+    for(const VkSurfaceFormatKHR& candidate : SwapchainPolicy::getCandidateFormats())
     {
-        if(availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+        VkFormatProperties formatProperties = {};
+        vkGetPhysicalDeviceFormatProperties(vkPhysicalDevice, candidate.format, &formatProperties);
+
+        if((formatProperties.optimalTilingFeatures & requiredFeatures) == requiredFeatures)
         {
-            return availablePresentMode;
+            vkSurfaceFormat = candidate;
+            return;
         }
     }
 
-    return VK_PRESENT_MODE_FIFO_KHR;
+    throw std::runtime_error("Offscreen: No supported color attachment format!");
+}
+
+const VkPresentModeKHR vkApplication::chooseSwapPresentMode( const std::vector<VkPresentModeKHR>& availablePresentModes) const
+{
+    return FramePacer::choosePresentMode(settings.presentPolicy, settings.allowTearing, availablePresentModes);
 }
 
 const VkExtent2D vkApplication::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& surfaceCapabilities) const
@@ -333,18 +481,12 @@ const VkExtent2D vkApplication::chooseSwapExtent(const VkSurfaceCapabilitiesKHR&
     }
     else
     {
-        int width = 0;
-        int height = 0;
-
-        glfwGetFramebufferSize(window, &width, &height);
-
-        VkExtent2D currentExtent = {
-            static_cast<uint32_t>(width),
-            static_cast<uint32_t>(height)
-        };
+        // glfwGetFramebufferSize may only be called from the main thread, while the swapchain can be created
+        // on a worker thread during initialization. Use the framebuffer size cached on the main thread instead.
+        VkExtent2D currentExtent = framebufferExtent;
 
         currentExtent.width = std::max(surfaceCapabilities.minImageExtent.width, std::min(surfaceCapabilities.maxImageExtent.width, currentExtent.width));
-        currentExtent.height = std::max(surfaceCapabilities.minImageExtent.height, std::min(surfaceCapabilities.minImageExtent.height, currentExtent.height));
+        currentExtent.height = std::max(surfaceCapabilities.minImageExtent.height, std::min(surfaceCapabilities.maxImageExtent.height, currentExtent.height));
 
         return currentExtent;
     }
@@ -352,19 +494,28 @@ const VkExtent2D vkApplication::chooseSwapExtent(const VkSurfaceCapabilitiesKHR&
 
 void vkApplication::createSwapchain()
 {
-    const SwapchainSupportDetails swapChainSupportDetails = querySwapchainSupport(vkPhysicalDevice);
+    if(settings.headless)
+    {
+        createOffscreenTargets();
+        return;
+    }
 
-    const VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupportDetails.vkFormats);
-    const VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupportDetails.vkPresentModes);
-    const VkExtent2D extent = chooseSwapExtent(swapChainSupportDetails.vkSurfaceCapabilities);
+    // Formats and present modes come from the capability snapshot. Surface capabilities are queried again
+    // because the current extent and transform change together with the window.
+    VkSurfaceCapabilitiesKHR surfaceCapabilities = {};
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(vkPhysicalDevice, vkSurface, &surfaceCapabilities);
 
-    // Its recommended to have 1 more than the minimum in case we have to wait for
-    // driver to complete internal operation before we can acquire another image to render
-    uint32_t imageCount = swapChainSupportDetails.vkSurfaceCapabilities.minImageCount + 1;
+    const VkSurfaceFormatKHR surfaceFormat = vkSurfaceFormat;
+    const VkPresentModeKHR presentMode = chooseSwapPresentMode(vkDeviceCapabilities->surfacePresentModes);
+    const VkExtent2D extent = chooseSwapExtent(surfaceCapabilities);
 
-    if(swapChainSupportDetails.vkSurfaceCapabilities.maxImageCount > 0 && imageCount > swapChainSupportDetails.vkSurfaceCapabilities.maxImageCount)
+    uint32_t imageCount = SwapchainPolicy::chooseImageCount(surfaceCapabilities, FRAMES_IN_FLIGHT, settings.swapchainImageCount);
+
+    // Captured frames are copied out of the swapchain images
+    VkImageUsageFlags imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    if(isFrameCaptureSupported())
     {
-        imageCount = swapChainSupportDetails.vkSurfaceCapabilities.maxImageCount;
+        imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
     }
 
     VkSwapchainCreateInfoKHR swapchainCreateInfoKhr = {
@@ -377,40 +528,128 @@ void vkApplication::createSwapchain()
         surfaceFormat.colorSpace,
         extent,
         1,
-        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+        imageUsage,
+        // Images are transferred between the graphics and present families instead of being shared concurrently,
+        // see submitOwnershipTransfer.
         VK_SHARING_MODE_EXCLUSIVE,
         0,
         nullptr,
-        swapChainSupportDetails.vkSurfaceCapabilities.currentTransform,
+        surfaceCapabilities.currentTransform,
         VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
         presentMode,
         VK_TRUE,
-        nullptr,
+        // The previous swapchain, if any, lets the presentation engine reuse its resources. It stays valid
+        // until the frames presenting from it are completed and is retired through the deletion queue.
+        vkSwapchainKHR,
     };
 
-    QueueFamilyIndices queueFamilyIndices = getQueueFamilies(vkPhysicalDevice);
-    uint32_t uniqueQueueFamilies[] = {
-        queueFamilyIndices.graphicsFamily.value(),
-        queueFamilyIndices.presentFamily.value()
-    };
-    if(queueFamilyIndices.graphicsFamily != queueFamilyIndices.presentFamily)
+    VkSwapchainKHR swapchain = nullptr;
+    if(vkCreateSwapchainKHR(vkLogicalDevice, &swapchainCreateInfoKhr, vkAllocator, &swapchain) != VK_SUCCESS)
     {
-        swapchainCreateInfoKhr.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-        swapchainCreateInfoKhr.queueFamilyIndexCount = 2;
-        swapchainCreateInfoKhr.pQueueFamilyIndices = uniqueQueueFamilies;
+        throw std::runtime_error("Swapchain: Failed to create swap chain");
     }
 
-    if(vkCreateSwapchainKHR(vkLogicalDevice, &swapchainCreateInfoKhr, nullptr, &vkSwapchainKHR) != VK_SUCCESS)
+    if(vkSwapchainKHR.get() != VK_NULL_HANDLE)
     {
-        throw std::runtime_error("Swapchain: Failed to create swap chain");
+        deletionQueue.push(submittedFrameNumber + FRAMES_IN_FLIGHT, std::move(vkSwapchainKHR));
     }
 
+    vkSwapchainKHR = UniqueSwapchain(vkLogicalDevice, swapchain, vkAllocator);
+
+    // The implementation may create more images than requested.
     vkGetSwapchainImagesKHR(vkLogicalDevice, vkSwapchainKHR, &imageCount, nullptr);
+
+    if(vkSwapchainImages.empty())
+    {
+        std::cout << "Swapchain: " << imageCount << " images (minimum " << surfaceCapabilities.minImageCount << "), "
+                  << SwapchainPolicy::getSurfaceFormatName(surfaceFormat)
+                  << ", present mode " << FramePacer::getPresentModeName(presentMode) << " for present policy " << FramePacer::getPolicyName(settings.presentPolicy)
+                  << (queueOwnershipTransfer ? ", images transferred to the present queue family" : "") << std::endl;
+    }
+
     vkSwapchainImages.resize(imageCount);
     vkGetSwapchainImagesKHR(vkLogicalDevice, vkSwapchainKHR, &imageCount, vkSwapchainImages.data());
 
     vkSwapchainImageFormat = surfaceFormat.format;
     vkSwapchainExtent = extent;
+    vkSwapchainImageUsage = imageUsage;
+    vkSwapchainPresentMode = presentMode;
+}
+
+/// <summary>
+/// Headless rendering uses one offscreen color image per frame in flight in place of the swapchain images.
+/// Image i is rendered by frame context i only, so an image is never written while a previous frame still reads it.
+/// </summary>
+void vkApplication::createOffscreenTargets()
+{
+    const VkExtent2D extent = framebufferExtent;
+    const VkImageUsageFlags imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+    vkOffscreenImages.clear();
+    vkOffscreenImageMemory.clear();
+    vkSwapchainImages.clear();
+
+    for(uint32_t i = 0; i < FRAMES_IN_FLIGHT; ++i)
+    {
+        VkImageCreateInfo imageCreateInfo
+        {
+            VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            nullptr,
+            NULL,
+            VK_IMAGE_TYPE_2D,
+            vkSurfaceFormat.format,
+            { extent.width, extent.height, 1 },
+            1,
+            1,
+            VK_SAMPLE_COUNT_1_BIT,
+            VK_IMAGE_TILING_OPTIMAL,
+            imageUsage,
+            VK_SHARING_MODE_EXCLUSIVE,
+            0,
+            nullptr,
+            VK_IMAGE_LAYOUT_UNDEFINED
+        };
+
+        VkImage image = nullptr;
+        if(vkCreateImage(vkLogicalDevice, &imageCreateInfo, vkAllocator, &image) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Offscreen: Failed to create offscreen image!");
+        }
+        vkOffscreenImages.emplace_back(vkLogicalDevice, image, vkAllocator);
+
+        VkMemoryRequirements memoryRequirements = {};
+        vkGetImageMemoryRequirements(vkLogicalDevice, image, &memoryRequirements);
+
+        const auto memoryTypeIndex = vkDeviceCapabilities->findMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if(!memoryTypeIndex.has_value())
+        {
+            throw std::runtime_error("Offscreen: No device local memory type for offscreen image!");
+        }
+
+        VkMemoryAllocateInfo memoryAllocateInfo
+        {
+            VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            nullptr,
+            memoryRequirements.size,
+            memoryTypeIndex.value()
+        };
+
+        VkDeviceMemory memory = nullptr;
+        if(vkAllocateMemory(vkLogicalDevice, &memoryAllocateInfo, vkAllocator, &memory) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Offscreen: Failed to allocate offscreen image memory!");
+        }
+        vkOffscreenImageMemory.emplace_back(vkLogicalDevice, memory, vkAllocator);
+        memoryBudgetMonitor->trackAllocation(memoryTypeIndex.value(), memoryRequirements.size);
+
+        vkBindImageMemory(vkLogicalDevice, image, memory, 0);
+
+        vkSwapchainImages.push_back(image);
+    }
+
+    vkSwapchainImageFormat = vkSurfaceFormat.format;
+    vkSwapchainExtent = extent;
+    vkSwapchainImageUsage = imageUsage;
 }
 
 /// <summary>
@@ -421,7 +660,8 @@ void vkApplication::createSwapchain()
 /// </summary>
 void vkApplication::createImageViews()
 {
-    vkSwapchainImageViews.resize(vkSwapchainImages.size());
+    vkSwapchainImageViews.clear();
+    vkSwapchainImageViews.reserve(vkSwapchainImages.size());
 
     for(size_t i = 0; i < vkSwapchainImages.size(); ++i)
     {
@@ -436,10 +676,13 @@ void vkApplication::createImageViews()
             {VK_IMAGE_ASPECT_COLOR_BIT, 0,1,0,1}
         };
 
-        if(vkCreateImageView(vkLogicalDevice, &imageViewCreateInfo, nullptr, &vkSwapchainImageViews[i]) != VK_SUCCESS)
+        VkImageView imageView = nullptr;
+        if(vkCreateImageView(vkLogicalDevice, &imageViewCreateInfo, vkAllocator, &imageView) != VK_SUCCESS)
         {
             throw std::runtime_error("Image Views: Failed to create image views!");
         }
+
+        vkSwapchainImageViews.emplace_back(vkLogicalDevice, imageView, vkAllocator);
     }
 }
 
@@ -449,7 +692,7 @@ static std::vector<char> readFile(const std::string& filename)
 
     if (!file.is_open())
     {
-        throw std::runtime_error("failed to open file!");
+        throw std::runtime_error("failed to open file " + filename + "!");
     }
 
     size_t fileSize = (size_t)file.tellg();
@@ -463,7 +706,7 @@ static std::vector<char> readFile(const std::string& filename)
     return buffer;
 }
 
-VkShaderModule vkApplication::createShaderModule(const std::vector<char>& code)
+UniqueShaderModule vkApplication::createShaderModule(const std::vector<char>& code)
 {
     // Pass the pointer to the buffer with bytecode and the length of it
     VkShaderModuleCreateInfo createInfo
@@ -476,12 +719,21 @@ VkShaderModule vkApplication::createShaderModule(const std::vector<char>& code)
     };
 
     VkShaderModule shaderModule;
-    if (vkCreateShaderModule(vkLogicalDevice, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+    if (vkCreateShaderModule(vkLogicalDevice, &createInfo, vkAllocator, &shaderModule) != VK_SUCCESS)
     {
         throw std::runtime_error("Shader Module: failed to create shader module!");
     }
 
-    return shaderModule;
+    return UniqueShaderModule(vkLogicalDevice, shaderModule, vkAllocator);
+}
+
+/// <summary>
+/// Shader binaries are read from disk independently of any Vulkan object, so it is done as a separate
+/// initialization task which runs while the instance, device and swapchain are being created.
+/// </summary>
+void vkApplication::loadShaders()
+{
+    shaderStageCode = { readFile("Shaders/shader.vert.spv"), readFile("Shaders/shader.frag.spv") };
 }
 
 
@@ -502,55 +754,80 @@ VkShaderModule vkApplication::createShaderModule(const std::vector<char>& code)
 /// </summary>
 void vkApplication::createGraphicsPipeline()
 {
-    auto vertShaderCode = readFile("Shaders/vert.spv");
-    auto fragShaderCode = readFile("Shaders/frag.spv");
+    // Pipeline layouts store the descriptor set layouts and push constant ranges, used to pass uniform values like a
+    // transformation matrix to the vertex shader or texture samplers to the fragment shader. They are created from
+    // the reflected shaders while building pipelines.
+    pipelineLayoutCache = std::make_unique<PipelineLayoutCache>(vkLogicalDevice, vkAllocator);
 
-    // Wrap shader code into VkShaderModule objects to send it to the pipeline
-    VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
-    VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
+    vkGraphicsPipeline = buildGraphicsPipeline({}, shaderStageCode);
 
-    // Fill vertex shader structure to define in which pipeline stage the vertex shaders is going to be used.
-    VkPipelineShaderStageCreateInfo vertShaderStageCreateInfo
+    // The pipeline compile benchmark keeps building pipelines from the shader code while running.
+    if(settings.benchmarkScenario != BenchmarkScenario::PipelineCompileStorm)
     {
-        VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-        nullptr,
-        NULL,
-        VK_SHADER_STAGE_VERTEX_BIT,
-        vertShaderModule,
-        "main",
-        nullptr
-    };
-    
-    // Fill fragment shader structure to define in which pipeline stage the fragment shaders is going to be used.
-    VkPipelineShaderStageCreateInfo fragShaderStageCreateInfo
+        shaderStageCode.clear();
+    }
+}
+
+/// <summary>
+/// Builds a graphics pipeline for vkRenderPass from the SPIR-V of its shader stages. Stage, entry point, vertex input
+/// and pipeline layout all come from the reflection of the stages, the layout is shared with compatible pipelines.
+/// The variant selects the fixed-function state, the default variant is the regular pipeline of the application.
+/// Only reads state which is constant after initialization, so shader hot reload calls it from its watcher thread.
+/// </summary>
+UniquePipeline vkApplication::buildGraphicsPipeline(const GraphicsPipelineVariant& variant, const std::vector<std::vector<char>>& stageCode)
+{
+    std::vector<ShaderReflection> reflections;
+    std::vector<const ShaderReflection*> stages;
+    reflections.reserve(stageCode.size());
+    for(const auto& code : stageCode)
     {
-        VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-        nullptr,
-        NULL,
-        VK_SHADER_STAGE_FRAGMENT_BIT,
-        fragShaderModule,
-        "main",
-        nullptr
-    };
+        reflections.push_back(ShaderReflection::reflect(code));
+        stages.push_back(&reflections.back());
+    }
 
-    VkPipelineShaderStageCreateInfo shaderStagesCreateInfo[] =
+    // Mesh shader pipelines generate their primitives themselves and have neither vertex input nor input assembly.
+    const auto vertexStage = std::find_if(reflections.begin(), reflections.end(), [](const ShaderReflection& reflection) { return reflection.stage == VK_SHADER_STAGE_VERTEX_BIT; });
+    const bool meshPipeline = std::any_of(reflections.begin(), reflections.end(), [](const ShaderReflection& reflection) { return reflection.stage == VK_SHADER_STAGE_MESH_BIT_EXT; });
+    if(vertexStage == reflections.end() && !meshPipeline)
     {
-        vertShaderStageCreateInfo,
-        fragShaderStageCreateInfo
-    };
+        throw std::runtime_error("failed to create graphics pipeline, no vertex or mesh shader!");
+    }
+
+    // Wrap shader code into VkShaderModule objects to send it to the pipeline.
+    // The modules are only needed while the pipeline is created and are destroyed when leaving the function.
+    // Each stage structure defines in which pipeline stage the module is going to be used.
+    std::vector<UniqueShaderModule> shaderModules;
+    std::vector<VkPipelineShaderStageCreateInfo> shaderStagesCreateInfo;
+    for(size_t stage = 0; stage < stageCode.size(); ++stage)
+    {
+        shaderModules.push_back(createShaderModule(stageCode[stage]));
+
+        VkPipelineShaderStageCreateInfo shaderStageCreateInfo
+        {
+            VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            nullptr,
+            NULL,
+            reflections[stage].stage,
+            shaderModules.back(),
+            reflections[stage].entryPoint.c_str(),
+            nullptr
+        };
+        shaderStagesCreateInfo.push_back(shaderStageCreateInfo);
+    }
 
     // Describe the format of the vertex data that will be passed to the vertex shader
     // Binding description: spacing between data and wheather the data is per-vertex or per-instance
     // Attribute description: type of the atributes passed to the vertex shader
+    const VertexInputLayout vertexInputLayout = meshPipeline ? VertexInputLayout() : vertexStage->vertexInputLayout;
     VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo
     {
         VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
         nullptr,
         NULL,
-        0,
-        nullptr,
-        0,
-        nullptr
+        static_cast<uint32_t>(vertexInputLayout.bindings.size()),
+        vertexInputLayout.bindings.data(),
+        static_cast<uint32_t>(vertexInputLayout.attributes.size()),
+        vertexInputLayout.attributes.data()
     };
 
     // Describe what kind of geometry will be drawn from the vertices and if primitive restart should be enabled
@@ -564,35 +841,18 @@ void vkApplication::createGraphicsPipeline()
     };
 
     // A viewport describes the region of the framebuffer that the output will be rendered to.
-    // The minDepth and maxDepth values specify the range of depth values to use for the framebuffer.
-    VkViewport viewport
-    {
-        0.0f,
-        0.0f,
-        static_cast<float>(vkSwapchainExtent.width),
-        static_cast<float>(vkSwapchainExtent.height),
-        0.0f,
-        1.0f
-    };
-
     // Scissor rectangles define in which regions pixels will actually be stored.
-    // Any pixels outside the scissor rectangles will be discarded by the rasterizer.
-    VkRect2D scissor
-    {
-        { 0, 0 },
-        vkSwapchainExtent
-    };
-
-    // Combine viewport and scissor rectangle.
+    // Both are dynamic states set while recording command buffers, so the pipeline does not depend
+    // on the swapchain extent and can be compiled before the swapchain exists.
     VkPipelineViewportStateCreateInfo viewportStateCreateInfo
     {
         VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
         nullptr,
         NULL,
         1,
-        &viewport,
+        nullptr,
         1,
-        &scissor,
+        nullptr,
     };
 
     // The rasterizer takes the geometry shaped by the vertices from the vertex shader and turns it into fragments to be colored by the fragment shader.
@@ -604,8 +864,8 @@ void vkApplication::createGraphicsPipeline()
         VK_FALSE,
         VK_FALSE,
         VK_POLYGON_MODE_FILL,
-        VK_CULL_MODE_BACK_BIT,
-        VK_FRONT_FACE_CLOCKWISE,
+        variant.cullMode,
+        variant.frontFace,
         VK_FALSE,
         0.0f,
         0.0f,
@@ -631,14 +891,14 @@ void vkApplication::createGraphicsPipeline()
     // Configure settings per attached framebuffer
     VkPipelineColorBlendAttachmentState colorBlendAttachmentState
     {
-        VK_FALSE,
+        variant.blendEnable,
         VK_BLEND_FACTOR_ONE,
         VK_BLEND_FACTOR_ZERO,
         VK_BLEND_OP_ADD,
         VK_BLEND_FACTOR_ONE,
         VK_BLEND_FACTOR_ZERO,
         VK_BLEND_OP_ADD,
-        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+        variant.colorWriteMask
     };
 
     // Configure global color blending settings.
@@ -658,7 +918,7 @@ void vkApplication::createGraphicsPipeline()
     VkDynamicState dynamicStates[] = 
     {
         VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_LINE_WIDTH
+        VK_DYNAMIC_STATE_SCISSOR
     };
 
     VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo
@@ -670,24 +930,6 @@ void vkApplication::createGraphicsPipeline()
         dynamicStates
     };
 
-    // Create VkPipelineLayout object to store uniform values which can be used to pass
-    // transformation matrix to the vertex shader, or to create texture samplers in the fragment shader
-    VkPipelineLayoutCreateInfo layoutCreateInfo
-    {
-        VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        nullptr,
-        NULL,
-        0,
-        nullptr,
-        0,
-        nullptr
-    };
-
-    if (vkCreatePipelineLayout(vkLogicalDevice, &layoutCreateInfo, nullptr, &vkPipelineLayout) != VK_SUCCESS)
-    {
-        throw std::runtime_error("failed to create pipeline layout!");
-    }
-
     // Having all of the above: shader stages, fixed-function states, pipeline layout, render pass
     // we can combine them to create the graphics pipeline
     VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo
@@ -695,18 +937,18 @@ void vkApplication::createGraphicsPipeline()
         VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
         nullptr,
         NULL,
-        2,
-        shaderStagesCreateInfo,
-        &vertexInputStateCreateInfo,
-        &inputAssemblyStateCreateInfo,
+        static_cast<uint32_t>(shaderStagesCreateInfo.size()),
+        shaderStagesCreateInfo.data(),
+        meshPipeline ? nullptr : &vertexInputStateCreateInfo,
+        meshPipeline ? nullptr : &inputAssemblyStateCreateInfo,
         nullptr,
         &viewportStateCreateInfo,
         &rasterizationStateCreateInfo,
         &multisampleStateCreateInfo,
         nullptr,
         &colorBlendStateCreateInfo,
-        nullptr,
-        vkPipelineLayout,
+        &dynamicStateCreateInfo,
+        pipelineLayoutCache->getPipelineLayout(stages).pipelineLayout,
         vkRenderPass,
         0,
         // Vulkan allows to create a new graphics pipeline by deriving from an existing pipeline.
@@ -716,16 +958,57 @@ void vkApplication::createGraphicsPipeline()
         -1
     };
 
-    if (vkCreateGraphicsPipelines(vkLogicalDevice, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, nullptr, &vkGraphicsPipeline) != VK_SUCCESS)
+    VkPipeline graphicsPipeline = nullptr;
+    if (vkCreateGraphicsPipelines(vkLogicalDevice, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, vkAllocator, &graphicsPipeline) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to create graphics pipeline!");
     }
 
-    vkDestroyShaderModule(vkLogicalDevice, fragShaderModule, nullptr);
-    vkDestroyShaderModule(vkLogicalDevice, vertShaderModule, nullptr);
+    return UniquePipeline(vkLogicalDevice, graphicsPipeline, vkAllocator);
 }
 
-
+/// <summary>
+/// Builds a compute pipeline with the layout derived from the reflected shader.
+/// </summary>
+UniquePipeline vkApplication::buildComputePipeline(const std::vector<char>& code)
+{
+    const ShaderReflection reflection = ShaderReflection::reflect(code);
+    if(reflection.stage != VK_SHADER_STAGE_COMPUTE_BIT)
+    {
+        throw std::runtime_error("failed to create compute pipeline, not a compute shader!");
+    }
+
+    const UniqueShaderModule shaderModule = createShaderModule(code);
+
+    VkComputePipelineCreateInfo computePipelineCreateInfo
+    {
+        VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        nullptr,
+        NULL,
+        {
+            VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            nullptr,
+            NULL,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            shaderModule,
+            reflection.entryPoint.c_str(),
+            nullptr
+        },
+        pipelineLayoutCache->getPipelineLayout({ &reflection }).pipelineLayout,
+        VK_NULL_HANDLE,
+        -1
+    };
+
+    VkPipeline computePipeline = nullptr;
+    if(vkCreateComputePipelines(vkLogicalDevice, VK_NULL_HANDLE, 1, &computePipelineCreateInfo, vkAllocator, &computePipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create compute pipeline!");
+    }
+
+    return UniquePipeline(vkLogicalDevice, computePipeline, vkAllocator);
+}
+
+
 /// <summary>
 /// Render pass object is a wrapper for framebuffer attachments that will be used while rendering.
 /// Allows to specify color and depth buffers, samples used for each of them and how their contents should be handled throughout the rendering operations.
@@ -735,7 +1018,7 @@ void vkApplication::createRenderPass()
     VkAttachmentDescription colorAttachmentDescription
     {
         NULL,
-        vkSwapchainImageFormat,
+        vkSurfaceFormat.format,
         VK_SAMPLE_COUNT_1_BIT,
         // loadOp and storeOp determine what to do with the color/depth data
         // in the attachment before rendering and after rendering.
@@ -747,7 +1030,7 @@ void vkApplication::createRenderPass()
         // initialLayout specifies which layout the image will have before the render pass begins.
         VK_IMAGE_LAYOUT_UNDEFINED,
         // finalLayout specifies the layout to automatically transition to when the render pass finishes. 
-        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+        vkColorAttachmentFinalLayout
     };
 
     VkAttachmentReference colorAttachmentReference
@@ -785,10 +1068,13 @@ void vkApplication::createRenderPass()
         nullptr
     };
 
-    if (vkCreateRenderPass(vkLogicalDevice, &renderPassCreateInfo, nullptr, &vkRenderPass) != VK_SUCCESS)
+    VkRenderPass renderPass = nullptr;
+    if (vkCreateRenderPass(vkLogicalDevice, &renderPassCreateInfo, vkAllocator, &renderPass) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to create render pass!");
     }
+
+    vkRenderPass = UniqueRenderPass(vkLogicalDevice, renderPass, vkAllocator);
 }
 
 /// <summary>
@@ -801,7 +1087,8 @@ void vkApplication::createRenderPass()
 /// </summary>
 void vkApplication::createFramebuffers()
 {
-    vkSwapchainFramebuffers.resize(vkSwapchainImageViews.size());
+    vkSwapchainFramebuffers.clear();
+    vkSwapchainFramebuffers.reserve(vkSwapchainImageViews.size());
 
     for (size_t i = 0; i < vkSwapchainImageViews.size(); ++i)
     {
@@ -823,10 +1110,13 @@ void vkApplication::createFramebuffers()
             1
         };
 
-        if (vkCreateFramebuffer(vkLogicalDevice, &framebufferCreateInfo, nullptr, &vkSwapchainFramebuffers[i]) != VK_SUCCESS)
+        VkFramebuffer framebuffer = nullptr;
+        if (vkCreateFramebuffer(vkLogicalDevice, &framebufferCreateInfo, vkAllocator, &framebuffer) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create framebuffer!");
         }
+
+        vkSwapchainFramebuffers.emplace_back(vkLogicalDevice, framebuffer, vkAllocator);
     }
 }
 
@@ -838,7 +1128,7 @@ void vkApplication::createFramebuffers()
 /// </summary>
 void vkApplication::createCommandPool()
 {
-    QueueFamilyIndices queueFamilyIndices = getQueueFamilies(vkPhysicalDevice);
+    const QueueFamilyIndices& queueFamilyIndices = vkDeviceCapabilities->queueFamilyIndices;
 
     VkCommandPoolCreateInfo commandPoolCreateInfo
     {
@@ -846,25 +1136,41 @@ void vkApplication::createCommandPool()
         nullptr,
         // There are two possible flags for command pools :
         // VK_COMMAND_POOL_CREATE_TRANSIENT_BIT: Hint that command buffers are rerecorded with new commands very often.
-        // VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT : Allow command buffers to be rerecorded individually, without this flag they all have to be reset together        
-        NULL,
+        // VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT : Allow command buffers to be rerecorded individually, without this flag they all have to be reset together
+        // Each frame in flight rerecords its own command buffer, so they have to be reset individually.
+        VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
         queueFamilyIndices.graphicsFamily.value()
     };
 
-    if (vkCreateCommandPool(vkLogicalDevice, &commandPoolCreateInfo, nullptr, &vkCommandPool) != VK_SUCCESS)
+    VkCommandPool commandPool = nullptr;
+    if (vkCreateCommandPool(vkLogicalDevice, &commandPoolCreateInfo, vkAllocator, &commandPool) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to create command pool!");
     }
+
+    vkCommandPool = UniqueCommandPool(vkLogicalDevice, commandPool, vkAllocator);
+
+    if(queueOwnershipTransfer)
+    {
+        commandPoolCreateInfo.queueFamilyIndex = vkPresentFamily;
+
+        if (vkCreateCommandPool(vkLogicalDevice, &commandPoolCreateInfo, vkAllocator, &commandPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create present command pool!");
+        }
+
+        vkPresentCommandPool = UniqueCommandPool(vkLogicalDevice, commandPool, vkAllocator);
+    }
 }
 
 /// <summary>
 /// Commands in Vulkan (like drawing operations and memory transfers) need to be recorded in command buffer objects.
-/// As drawing commands involves binding the right VkFramebuffer, command buffers need to be recorded for every image in the swapchain. 
-/// Command buffers will be automatically freed when their command pool is destroyed.
+/// Every frame in flight owns one command buffer, which is rerecorded for the acquired swapchain image once the
+/// GPU finished the previous frame that used it. Command buffers will be automatically freed when their command pool is destroyed.
 /// </summary>
-void vkApplication::createCommandBuffer()
+void vkApplication::createCommandBuffers()
 {
-    vkCommandBuffers.resize(vkSwapchainFramebuffers.size());
+    VkCommandBuffer commandBuffers[FRAMES_IN_FLIGHT] = {};
 
     VkCommandBufferAllocateInfo commandBufferAllocateInfo
     {
@@ -875,308 +1181,1525 @@ void vkApplication::createCommandBuffer()
         // VK_COMMAND_BUFFER_LEVEL_PRIMARY: Can be submitted to a queue for execution, but cannot be called from other command buffers.
         // VK_COMMAND_BUFFER_LEVEL_SECONDARY : Cannot be submitted directly, but can be called from primary command buffers.
         VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        (uint32_t)vkCommandBuffers.size()
+        FRAMES_IN_FLIGHT
     };
 
-    if (vkAllocateCommandBuffers(vkLogicalDevice, &commandBufferAllocateInfo, vkCommandBuffers.data()) != VK_SUCCESS)
+    if (vkAllocateCommandBuffers(vkLogicalDevice, &commandBufferAllocateInfo, commandBuffers) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to allocate command buffers!");
     }
 
-    for (size_t i = 0; i < vkCommandBuffers.size(); i++) 
+    for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; ++i)
     {
-        VkCommandBufferBeginInfo commandBufferBeginInfo
-        {
-            VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-            nullptr,
-            // VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT: The command buffer will be rerecorded right after executing it once.
-            // VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT: This is a secondary command buffer that will be entirely within a single render pass.
-            // VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT : The command buffer can be resubmitted while it is also already pending execution.
-            0,
-            nullptr
-        };
-        
-        if (vkBeginCommandBuffer(vkCommandBuffers[i], &commandBufferBeginInfo) != VK_SUCCESS) {
-            throw std::runtime_error("failed to begin recording command buffer!");
-        }
+        frames[i].vkCommandBuffer = commandBuffers[i];
+    }
 
-        VkClearValue clearColor
-        {
-            {{0.0f, 0.0f, 0.0f, 1.0f}}
-        };
+    if(queueOwnershipTransfer)
+    {
+        commandBufferAllocateInfo.commandPool = vkPresentCommandPool;
 
-        VkRenderPassBeginInfo renderPassBeginInfo
+        if (vkAllocateCommandBuffers(vkLogicalDevice, &commandBufferAllocateInfo, commandBuffers) != VK_SUCCESS)
         {
-            VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-            nullptr,
-            vkRenderPass,
-            vkSwapchainFramebuffers[i],
-            {{ 0, 0 }, vkSwapchainExtent},
-            1,
-            &clearColor
-        };
-
-        //Start recording render pass
-        // VK_SUBPASS_CONTENTS_INLINE: The render pass commands will be embedded in the primary command buffer itselfand no secondary command buffers will be executed.
-        // VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : The render pass commands will be executed from secondary command buffers.
-        vkCmdBeginRenderPass(vkCommandBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-        
-        vkCmdBindPipeline(vkCommandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, vkGraphicsPipeline);
-        
-        vkCmdDraw(vkCommandBuffers[i], 3, 1, 0, 0);
-
-        //Stop recording render pass
-        vkCmdEndRenderPass(vkCommandBuffers[i]);
+            throw std::runtime_error("failed to allocate present command buffers!");
+        }
 
-        if (vkEndCommandBuffer(vkCommandBuffers[i]) != VK_SUCCESS)
+        for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; ++i)
         {
-            throw std::runtime_error("failed to record command buffer!");
+            frames[i].vkPresentCommandBuffer = commandBuffers[i];
         }
     }
-
-
 }
 
-/// <summary>
-/// The drawFrame function will perform the following operations:
-/// - Acquire an image from the swap chain
-/// - Execute the command buffer with that image as attachment in the framebuffer
-/// - Return the image to the swap chain for presentation
-/// 
-/// Each of these function call are executed asynchronously and each of the operations depends on the previous one finishing./// 
-/// </summary>
-void vkApplication::drawFrame()
+void vkApplication::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
 {
-    // Acquire an Image from the swap chain
-
-    uint32_t imageIndex; // refers to VkImage in vkSwapchainImages array, and will be used to pich right command buffer
-    vkAcquireNextImageKHR(vkLogicalDevice, vkSwapchainKHR, UINT64_MAX, vkSemaphoreImageAvailable, VK_NULL_HANDLE, &imageIndex);
+    VkCommandBufferBeginInfo commandBufferBeginInfo
+    {
+        VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        nullptr,
+        // VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT: The command buffer will be rerecorded right after executing it once.
+        // VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT: This is a secondary command buffer that will be entirely within a single render pass.
+        // VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT : The command buffer can be resubmitted while it is also already pending execution.
+        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        nullptr
+    };
 
-    // Submitting the command buffer to the graphics queue
+    if (vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording command buffer!");
+    }
 
-    VkSemaphore waitSemaphore[] = { vkSemaphoreImageAvailable };
+    // The frame being recorded is submitted as submittedFrameNumber + 1 from the frame context of the same slot.
+    const uint64_t frameNumber = submittedFrameNumber + 1;
+    const uint32_t slot = static_cast<uint32_t>(submittedFrameNumber % FRAMES_IN_FLIGHT);
 
-    VkPipelineStageFlags waitStage[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+    if(gpuTimer)
+    {
+        gpuTimer->begin(commandBuffer, slot);
+    }
 
-    VkSemaphore signalSemaphores[] = { vkSemaphoreRenderFinished };
+    if(benchmarkWorkload)
+    {
+        benchmarkWorkload->recordTransfers(commandBuffer, slot);
+    }
 
-    VkSubmitInfo submitInfo
+    if(meshletRenderer)
     {
-        VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        nullptr,
-        // Specify which semaphores to wait on before execution begins and in which stage(s) of the pipeline to wait.
-        // Each entry in the waitStages array corresponds to the semaphore with the same index in waitSemaphores.
-        1,
-        waitSemaphore,
-        waitStage,
-        // Specify which command buffer to sumbit for excecution - should be command buffer that binds the swap chain
-        // image recently acquired as color attachment.
-        1,
-        &vkCommandBuffers[imageIndex],
-        // Specify which semaphores to signal once the command buffer(s) have finished execution.
-        1,
-        signalSemaphores
-    };
+        meshletRenderer->recordCulling(commandBuffer, slot, frameNumber);
+    }
+    if(lodRenderer)
+    {
+        lodRenderer->recordSelection(commandBuffer, slot, frameNumber);
+    }
+    if(particleSystem)
+    {
+        particleSystem->recordSimulation(commandBuffer);
+    }
 
-    // The last parameter for fence is VK_NULL_HANDLE as we use semaphores for synchronization.
-    if (vkQueueSubmit(vkGraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) 
+    if(assetStreamer)
     {
-        throw std::runtime_error("failed to submit draw command buffer!");
+        assetStreamer->recordUploads(commandBuffer, frameNumber);
     }
 
-    // Subpass dependencies :
-    // Subpasses in a render pass automatically take care of image layout transitions. These transitions are controlled
-    // by subpass dependencies, which specify memory and execution dependencies between subpasses.
-    VkSubpassDependency subpassDependency
+    VkClearValue clearColor
     {
-        VK_SUBPASS_EXTERNAL,
-        0,
-        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        0,
-        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-        NULL
+        {{0.0f, 0.0f, 0.0f, 1.0f}}
     };
 
-    // Presentation :
-    // The last step of drawing a frame is submitting the result back to the swap chain to have it eventually show up on the screen.    // 
-    // Last parameter - pResults allows you to specify an array of VkResult values to check for every individual swap chain
-    // if presentation was successful.
-
-    VkSwapchainKHR swapChains[] = { vkSwapchainKHR };
-
-    VkPresentInfoKHR presentInfo
+    VkRenderPassBeginInfo renderPassBeginInfo
     {
-        VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+        VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
         nullptr,
-        // Specify which semaphores to wait on before presentation.
-        1,
-        signalSemaphores,
-        // Specify the swap chains to present images to and the index of the image for each swap chain.
+        vkRenderPass,
+        vkSwapchainFramebuffers[imageIndex],
+        {{ 0, 0 }, vkSwapchainExtent},
         1,
-        swapChains,
-        &imageIndex,
-        nullptr
+        &clearColor
     };
 
-    // The vkQueuePresentKHR function submits the request to present an image to the swap chain.
-    vkQueuePresentKHR(vkPresentQueue, &presentInfo);
-}
+    //Start recording render pass
+    // VK_SUBPASS_CONTENTS_INLINE: The render pass commands will be embedded in the primary command buffer itselfand no secondary command buffers will be executed.
+    // VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : The render pass commands will be executed from secondary command buffers.
+    vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-/// <summary>
-// There are two ways of synchronizing swap chain events : fences and semaphores.
-// 
-// Both of them can be used for coordinating operations by having one operation signal and another operation wait
-// for a fence or semaphore to go from the unsignaled to signaled state.
-// 
-// The difference is that the state of fences can be accessed from your program using calls like 
-// vkWaitForFencesand semaphores cannot be.
-// 
-// Fences are mainly designed to synchronize your application itself with rendering operation.
-// Semaphores are used to synchronize operations within or across command queues.
-/// </summary>
-void vkApplication::createSemaphores()
-{
-    VkSemaphoreCreateInfo semaphoreCreateInfo = 
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vkGraphicsPipeline);
+
+    VkViewport viewport
     {
-        VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
-        nullptr,
-        NULL
+        0.0f,
+        0.0f,
+        static_cast<float>(vkSwapchainExtent.width),
+        static_cast<float>(vkSwapchainExtent.height),
+        0.0f,
+        1.0f
     };
 
-    if (vkCreateSemaphore(vkLogicalDevice, &semaphoreCreateInfo, nullptr, &vkSemaphoreImageAvailable) != VK_SUCCESS
-        || vkCreateSemaphore(vkLogicalDevice, &semaphoreCreateInfo, nullptr, &vkSemaphoreRenderFinished) != VK_SUCCESS)
+    VkRect2D scissor
     {
-        throw std::runtime_error("failed to create semaphores!");
-    }
-}
+        { 0, 0 },
+        vkSwapchainExtent
+    };
 
-void vkApplication::initVulkan()
-{
-    createInstance();
-    setupDebugMessenger();
-    createSurface();
-    findPhysicalDevice();
-    createLogicalDevice();
-    createSwapchain();
-    createImageViews();
-    createRenderPass();
-    createGraphicsPipeline();
-    createFramebuffers();
-    createCommandPool();
-    createCommandBuffer();
-    createSemaphores();
-}
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-void vkApplication::createInstance()
-{
-    if(vkValidationLayersEnabled && !checkValidationLayersSupport())
+    if(meshletRenderer)
     {
-        throw std::runtime_error("CreateInstance: Requested validation layers not available!");
+        benchmarkRecorder->recordDrawCalls(frameNumber, meshletRenderer->recordDraws(commandBuffer, slot));
+    }
+    else if(lodRenderer)
+    {
+        benchmarkRecorder->recordDrawCalls(frameNumber, lodRenderer->recordDraws(commandBuffer, slot));
+    }
+    else if(sortedDrawRenderer)
+    {
+        benchmarkRecorder->recordDrawCalls(frameNumber, sortedDrawRenderer->recordDraws(commandBuffer, slot));
+    }
+    else if(particleSystem)
+    {
+        benchmarkRecorder->recordDrawCalls(frameNumber, particleSystem->recordDraws(commandBuffer));
+    }
+    else if(benchmarkWorkload)
+    {
+        benchmarkRecorder->recordDrawCalls(frameNumber, benchmarkWorkload->recordDraws(commandBuffer, slot));
+    }
+    else
+    {
+        vkCmdDraw(commandBuffer, 3, 1, 0, 0);
     }
 
-    VkApplicationInfo vkApplicationInfo
+    //Stop recording render pass
+    vkCmdEndRenderPass(commandBuffer);
+
+    if(meshletRenderer)
     {
-        VK_STRUCTURE_TYPE_APPLICATION_INFO,
-        nullptr,
-        "vkTriangle",
-        VK_MAKE_VERSION(1,0,0),
-        "No Engine",
-        VK_MAKE_VERSION(1,0,0),
-        VK_API_VERSION_1_2
-    };
+        meshletRenderer->recordStatistics(commandBuffer, slot);
+    }
+    if(lodRenderer)
+    {
+        lodRenderer->recordStatistics(commandBuffer, slot);
+    }
+    if(particleSystem)
+    {
+        particleSystem->recordStatistics(commandBuffer, slot);
+    }
 
-    auto requiredExtensions = getRequiredExtensions();
+    if(frameReadback && (vkSwapchainImageUsage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) && frameNumber % settings.captureInterval == 0)
+    {
+        frameReadback->record(commandBuffer, slot, vkSwapchainImages[imageIndex], vkColorAttachmentFinalLayout,
+                              vkSwapchainImageFormat, vkSwapchainExtent, frameNumber);
+    }
 
-    VkInstanceCreateInfo vkInstanceCreateInfo
+    // The image is released to the present family and acquired there by submitOwnershipTransfer.
+    if(queueOwnershipTransfer)
     {
-        VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
-        nullptr,
-        NULL,
-        &vkApplicationInfo,
-        0,
-        nullptr,
-        static_cast<uint32_t>(requiredExtensions.size()),
-        requiredExtensions.data()
-    };
+        const QueueFamilyIndices& queueFamilyIndices = vkDeviceCapabilities->queueFamilyIndices;
 
-    VkDebugUtilsMessengerCreateInfoEXT vkDebugUtilsMessengerCreateInfo;
+        VkImageMemoryBarrier releaseBarrier
+        {
+            VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            nullptr,
+            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            0,
+            vkColorAttachmentFinalLayout,
+            vkColorAttachmentFinalLayout,
+            queueFamilyIndices.graphicsFamily.value(),
+            vkPresentFamily,
+            vkSwapchainImages[imageIndex],
+            { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+        };
 
-    if(vkValidationLayersEnabled)
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &releaseBarrier);
+    }
+
+    if(gpuTimer)
     {
-        populateDebugMessengerCreateInfo(vkDebugUtilsMessengerCreateInfo);
-        vkInstanceCreateInfo.pNext = static_cast<VkDebugUtilsMessengerCreateInfoEXT*>(&vkDebugUtilsMessengerCreateInfo);
-        vkInstanceCreateInfo.enabledLayerCount = static_cast<uint32_t>(vkValidationLayers.size());
-        vkInstanceCreateInfo.ppEnabledLayerNames = vkValidationLayers.data();
+        gpuTimer->end(commandBuffer, slot);
     }
 
-    if(vkCreateInstance(&vkInstanceCreateInfo, nullptr, &vkInstance) != VK_SUCCESS)
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
     {
-        throw std::runtime_error("CreateInstance: Failed to create instance!");
+        throw std::runtime_error("failed to record command buffer!");
     }
 }
 
-void vkApplication::initWindow()
+/// <summary>
+/// Blocks until the GPU finished the last frame submitted from this frame context, then destroys every object
+/// retired by frames which are now known to be complete.
+/// </summary>
+void vkApplication::waitForFrame(FrameContext& frame)
 {
-    glfwInit();
+    VkFence fence = frame.vkFenceInFlight;
+    vkWaitForFences(vkLogicalDevice, 1, &fence, VK_TRUE, UINT64_MAX);
 
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    completedFrameNumber = std::max(completedFrameNumber, frame.frameNumber);
+    deletionQueue.collect(completedFrameNumber);
 
-    window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Vulkan", nullptr, nullptr);
-}
+    const uint32_t slot = static_cast<uint32_t>(&frame - frames.data());
 
-void vkApplication::mainLoop()
-{
-    while(!glfwWindowShouldClose(window))
+    // The copy recorded by the last frame of this context is complete as well
+    if(frameReadback)
     {
-        glfwPollEvents();
-        drawFrame();
+        frameReadback->collect(slot);
     }
 
-    // All of the operations in drawFrame are asynchronous. While exiting the loop, drawing and presentation operations
-    // may still be going on. Instead of cleaning right now we need to wait for the logical device to finish operations
-    // before exiting mainLoop and destroying the window.
-    vkDeviceWaitIdle(vkLogicalDevice);
+    if(gpuTimer)
+    {
+        collectGpuTime(slot);
+    }
 }
 
-void vkApplication::cleanup()
+/// <summary>
+/// Swapchain images are created with exclusive sharing. When the present queue belongs to another family than the
+/// graphics queue, the graphics command buffer releases the image and this batch acquires it on the present queue.
+/// Concurrent sharing would avoid the transfer but can disable framebuffer compression on some implementations.
+/// The render pass discards the previous contents, so the image is never transferred back to the graphics family.
+/// </summary>
+void vkApplication::submitOwnershipTransfer(FrameContext& frame, uint32_t imageIndex, VkFence fence)
 {
-    vkDestroySemaphore(vkLogicalDevice, vkSemaphoreRenderFinished, nullptr);
-    vkDestroySemaphore(vkLogicalDevice, vkSemaphoreImageAvailable, nullptr);
+    const QueueFamilyIndices& queueFamilyIndices = vkDeviceCapabilities->queueFamilyIndices;
+    VkCommandBuffer commandBuffer = frame.vkPresentCommandBuffer;
 
-    vkDestroyCommandPool(vkLogicalDevice, vkCommandPool, nullptr);
+    VkCommandBufferBeginInfo commandBufferBeginInfo
+    {
+        VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        nullptr,
+        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        nullptr
+    };
 
-    for (auto framebuffer : vkSwapchainFramebuffers) 
+    vkResetCommandBuffer(commandBuffer, 0);
+    if (vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo) != VK_SUCCESS)
     {
-        vkDestroyFramebuffer(vkLogicalDevice, framebuffer, nullptr);
+        throw std::runtime_error("failed to begin recording present command buffer!");
     }
 
-    vkDestroyPipeline(vkLogicalDevice, vkGraphicsPipeline, nullptr);
+    // Matches the release barrier of recordCommandBuffer, access masks are ignored by the acquiring family.
+    VkImageMemoryBarrier acquireBarrier
+    {
+        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        nullptr,
+        0,
+        0,
+        vkColorAttachmentFinalLayout,
+        vkColorAttachmentFinalLayout,
+        queueFamilyIndices.graphicsFamily.value(),
+        vkPresentFamily,
+        vkSwapchainImages[imageIndex],
+        { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+    };
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                         0, nullptr, 0, nullptr, 1, &acquireBarrier);
 
-    vkDestroyPipelineLayout(vkLogicalDevice, vkPipelineLayout, nullptr);
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to record present command buffer!");
+    }
 
-    vkDestroyRenderPass(vkLogicalDevice, vkRenderPass, nullptr);
+    // Submitted with the present queue's share of the frame once the submitter is flushed.
+    queueSubmitter->addWait(vkPresentQueue, vkSemaphoresRenderFinished[imageIndex], VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    queueSubmitter->addCommandBuffer(vkPresentQueue, commandBuffer);
+    queueSubmitter->addSignal(vkPresentQueue, vkSemaphoresOwnershipTransferred[imageIndex]);
+    queueSubmitter->setFence(vkPresentQueue, fence);
+}
 
-    for(auto swapchainImageView : vkSwapchainImageViews)
+void vkApplication::collectGpuTime(uint32_t slot)
+{
+    if(const auto gpuTime = gpuTimer->collect(slot))
     {
-        vkDestroyImageView(vkLogicalDevice, swapchainImageView, nullptr);
+        benchmarkRecorder->recordGpuTime(frames[slot].frameNumber, gpuTime.value());
     }
+}
 
-    vkDestroySwapchainKHR(vkLogicalDevice, vkSwapchainKHR, nullptr);
+/// <summary>
+/// Benchmark runs replace the triangle draw with the work of the scenario and measure the CPU phases of every frame
+/// and the GPU time of its command buffer.
+/// </summary>
+void vkApplication::createBenchmark()
+{
+    if(settings.benchmarkScenario == BenchmarkScenario::None)
+    {
+        return;
+    }
 
-    vkDestroyDevice(vkLogicalDevice, nullptr);
+    benchmarkRecorder = std::make_unique<BenchmarkRecorder>(settings.benchmarkScenario, settings.benchmarkScale, settings.warmupFrames, settings.frameCount);
 
-    if(vkValidationLayersEnabled)
+    gpuTimer = std::make_unique<GpuTimer>(vkLogicalDevice, *vkDeviceCapabilities, vkDeviceCapabilities->queueFamilyIndices.graphicsFamily.value(),
+                                          vkAllocator, FRAMES_IN_FLIGHT);
+    if(!gpuTimer->isSupported())
     {
-        destroyDebugUtilsMessengerEXT(vkInstance, vkDebugMessenger, nullptr);
+        std::cout << "Benchmark: Graphics queue does not support timestamps, GPU time is not measured" << std::endl;
     }
 
-    vkDestroySurfaceKHR(vkInstance, vkSurface, nullptr);
+    // Pipelines cycle through every combination of cull mode, front face, blending and color write mask,
+    // so a driver can't hand out a pipeline compiled a few frames earlier before 240 pipelines were built.
+    const auto pipelineFactory = [this](uint32_t variantIndex)
+    {
+        GraphicsPipelineVariant variant = {};
+        variant.cullMode = static_cast<VkCullModeFlags>(variantIndex % 4);
+        variant.frontFace = static_cast<VkFrontFace>((variantIndex / 4) % 2);
+        variant.blendEnable = (variantIndex / 8) % 2 != 0 ? VK_TRUE : VK_FALSE;
+        variant.colorWriteMask = static_cast<VkColorComponentFlags>((variantIndex / 16) % 15 + 1);
 
-    vkDestroyInstance(vkInstance, nullptr);
+        return buildGraphicsPipeline(variant, shaderStageCode);
+    };
 
-    glfwDestroyWindow(window);
+    benchmarkWorkload = std::make_unique<BenchmarkWorkload>(vkLogicalDevice, *vkDeviceCapabilities, vkAllocator, FRAMES_IN_FLIGHT, memoryBudgetMonitor.get(),
+                                                            settings.benchmarkScenario, settings.benchmarkScale, pipelineFactory);
 
-    glfwTerminate();
+    if(settings.benchmarkScenario == BenchmarkScenario::Meshlets)
+    {
+        createMeshletRenderer();
+    }
+    if(settings.benchmarkScenario == BenchmarkScenario::Lod)
+    {
+        createLodRenderer();
+    }
+    if(settings.benchmarkScenario == BenchmarkScenario::SortedDraws)
+    {
+        createSortedDrawRenderer();
+    }
+    if(settings.benchmarkScenario == BenchmarkScenario::Particles)
+    {
+        createParticleSystem();
+    }
+}
+
+/// <summary>
+/// Builds the sphere field of the meshlets scenario and the pipelines of the path chosen for the device. The paths
+/// are compared by running the scenario once per --meshlets value.
+/// </summary>
+void vkApplication::createMeshletRenderer()
+{
+    MeshletRenderer::Features features = {};
+    features.meshShaders = meshShadersEnabled;
+    features.multiDrawIndirect = vkEnabledDeviceFeatures.multiDrawIndirect == VK_TRUE;
+    features.drawIndirectCount = drawIndirectCountEnabled;
+
+    const MeshletPath path = MeshletRenderer::choosePath(settings.meshletPath, features);
+
+    MeshletRenderer::Shaders shaders = {};
+    if(path == MeshletPath::MeshShader)
+    {
+        shaders.drawStages = { readFile("Shaders/meshlet.task.spv"), readFile("Shaders/meshlet.mesh.spv"), readFile("Shaders/shader.frag.spv") };
+    }
+    else
+    {
+        shaders.drawStages = { readFile("Shaders/mesh.vert.spv"), readFile("Shaders/shader.frag.spv") };
+    }
+    if(path == MeshletPath::ComputeCulling)
+    {
+        shaders.culling = readFile("Shaders/meshlet_cull.comp.spv");
+    }
+
+    // vkCmdDrawMeshTasksEXT is not exported by the loader and has to be loaded from the device.
+    const auto drawMeshTasks = path == MeshletPath::MeshShader ? reinterpret_cast<PFN_vkCmdDrawMeshTasksEXT>(vkGetDeviceProcAddr(vkLogicalDevice, "vkCmdDrawMeshTasksEXT"))
+                                                               : nullptr;
+
+    // The sphere field is counter clockwise and only front faces are drawn, on top of the meshlet culling.
+    GraphicsPipelineVariant variant = {};
+    variant.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+    const auto graphicsPipelineFactory = [this, variant](const std::vector<std::vector<char>>& stageCode) { return buildGraphicsPipeline(variant, stageCode); };
+    const auto computePipelineFactory = [this](const std::vector<char>& code) { return buildComputePipeline(code); };
+
+    const DecodedAsset mesh = MeshletRenderer::createSphereField(settings.benchmarkScale);
+
+    meshletRenderer = std::make_unique<MeshletRenderer>(vkLogicalDevice, *vkDeviceCapabilities, vkAllocator, FRAMES_IN_FLIGHT, memoryBudgetMonitor.get(),
+                                                        *pipelineLayoutCache, mesh, path, features, shaders, graphicsPipelineFactory, computePipelineFactory,
+                                                        drawMeshTasks);
+
+    std::cout << "Benchmark: Meshlets are drawn by the " << MeshletRenderer::getPathName(path) << " path" << std::endl;
+}
+
+/// <summary>
+/// Builds the object mesh of the lod scenario with its levels of detail and the pipelines of the selection mode.
+/// Triangle counts and frame times are compared by running the scenario with --lod=off and with cpu or gpu.
+/// </summary>
+void vkApplication::createLodRenderer()
+{
+    LodRenderer::Features features = {};
+    features.drawIndirectFirstInstance = vkEnabledDeviceFeatures.drawIndirectFirstInstance == VK_TRUE;
+
+    const LodMode mode = LodRenderer::chooseMode(settings.lodMode, features);
+
+    LodRenderer::Shaders shaders = {};
+    shaders.drawStages = { readFile("Shaders/lod.vert.spv"), readFile("Shaders/shader.frag.spv") };
+    if(mode == LodMode::Gpu)
+    {
+        shaders.selection = readFile("Shaders/lod_select.comp.spv");
+    }
+
+    GraphicsPipelineVariant variant = {};
+    variant.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+    const auto graphicsPipelineFactory = [this, variant](const std::vector<std::vector<char>>& stageCode) { return buildGraphicsPipeline(variant, stageCode); };
+    const auto computePipelineFactory = [this](const std::vector<char>& code) { return buildComputePipeline(code); };
+
+    const DecodedAsset mesh = LodRenderer::createObjectMesh();
+    const LodSelector selector(mesh.lods, settings.lodPixelError, settings.lodHysteresis);
+
+    lodRenderer = std::make_unique<LodRenderer>(vkLogicalDevice, *vkDeviceCapabilities, vkAllocator, FRAMES_IN_FLIGHT, memoryBudgetMonitor.get(),
+                                                *pipelineLayoutCache, mesh, settings.benchmarkScale, mode, selector, shaders,
+                                                graphicsPipelineFactory, computePipelineFactory);
+
+    std::cout << "Benchmark: Levels of detail are selected by the " << LodRenderer::getModeName(mode) << " mode" << std::endl;
+}
+
+/// <summary>
+/// Builds the objects and pipeline variants of the sorted-draws scenario. Bind counts and frame times are compared
+/// by running the scenario with --draw-sort=on and off.
+/// </summary>
+void vkApplication::createSortedDrawRenderer()
+{
+    const std::vector<std::vector<char>> drawStages = { readFile("Shaders/sorted_draw.vert.spv"), readFile("Shaders/shader.frag.spv") };
+
+    // Polygons are drawn from both sides, the variants differ in front face, alpha writes and, in the second half, blending
+    const auto graphicsPipelineFactory = [this](uint32_t variantIndex, const std::vector<std::vector<char>>& stageCode)
+    {
+        GraphicsPipelineVariant variant = {};
+        variant.cullMode = VK_CULL_MODE_NONE;
+        variant.frontFace = static_cast<VkFrontFace>(variantIndex % 2);
+        variant.blendEnable = variantIndex >= SortedDrawRenderer::PIPELINE_COUNT / 2 ? VK_TRUE : VK_FALSE;
+        if(variantIndex / 2 % 2 != 0)
+        {
+            variant.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT;
+        }
+
+        return buildGraphicsPipeline(variant, stageCode);
+    };
+
+    sortedDrawRenderer = std::make_unique<SortedDrawRenderer>(vkLogicalDevice, *vkDeviceCapabilities, vkAllocator, FRAMES_IN_FLIGHT, memoryBudgetMonitor.get(),
+                                                              *pipelineLayoutCache, *jobSystem, settings.benchmarkScale, settings.drawSort, drawStages,
+                                                              graphicsPipelineFactory);
+}
+
+/// <summary>
+/// Builds the particle buffers and the simulation and draw pipelines of the particles scenario, scale is the capacity.
+/// </summary>
+void vkApplication::createParticleSystem()
+{
+    ParticleSystem::Shaders shaders = {};
+    shaders.drawStages = { readFile("Shaders/particle.vert.spv"), readFile("Shaders/shader.frag.spv") };
+    shaders.emission = readFile("Shaders/particle_emit.comp.spv");
+    shaders.preparation = readFile("Shaders/particle_prepare.comp.spv");
+    shaders.simulation = readFile("Shaders/particle_simulate.comp.spv");
+
+    // The quads are built in clip space and face the camera with either winding
+    GraphicsPipelineVariant variant = {};
+    variant.cullMode = VK_CULL_MODE_NONE;
+
+    const auto graphicsPipelineFactory = [this, variant](const std::vector<std::vector<char>>& stageCode) { return buildGraphicsPipeline(variant, stageCode); };
+    const auto computePipelineFactory = [this](const std::vector<char>& code) { return buildComputePipeline(code); };
+
+    particleSystem = std::make_unique<ParticleSystem>(vkLogicalDevice, *vkDeviceCapabilities, vkAllocator, FRAMES_IN_FLIGHT, memoryBudgetMonitor.get(),
+                                                      *pipelineLayoutCache, settings.benchmarkScale, shaders, graphicsPipelineFactory,
+                                                      computePipelineFactory);
+}
+
+void vkApplication::reportBenchmark()
+{
+    const FrameTimeRecorder::Summary frameTimes = frameTimeRecorder.getSummary();
+
+    benchmarkRecorder->printSummary(std::cout, frameTimes);
+
+    benchmarkRecorder->setConfiguration("presentPolicy", FramePacer::getPolicyName(settings.presentPolicy));
+    benchmarkRecorder->setConfiguration("surfaceFormat", SwapchainPolicy::getSurfaceFormatName(vkSurfaceFormat));
+    if(meshletRenderer)
+    {
+        benchmarkRecorder->setConfiguration("meshletPath", MeshletRenderer::getPathName(meshletRenderer->getPath()));
+    }
+    if(lodRenderer)
+    {
+        std::ostringstream pixelError;
+        pixelError << settings.lodPixelError;
+        benchmarkRecorder->setConfiguration("lodMode", LodRenderer::getModeName(lodRenderer->getMode()));
+        benchmarkRecorder->setConfiguration("lodPixelError", pixelError.str());
+    }
+    if(sortedDrawRenderer)
+    {
+        benchmarkRecorder->setConfiguration("drawSort", sortedDrawRenderer->isSortEnabled() ? "on" : "off");
+    }
+    if(!settings.headless)
+    {
+        benchmarkRecorder->setConfiguration("presentMode", FramePacer::getPresentModeName(vkSwapchainPresentMode));
+        benchmarkRecorder->setConfiguration("swapchainImages", std::to_string(vkSwapchainImages.size()));
+        benchmarkRecorder->setConfiguration("queueOwnershipTransfer", queueOwnershipTransfer ? "true" : "false");
+    }
+
+    if(settings.benchmarkOutput.empty())
+    {
+        benchmarkRecorder->writeJSON(std::cout, vkDeviceCapabilities->properties, vkSwapchainExtent, settings.headless, settings.benchmarkLabel, frameTimes);
+        return;
+    }
+
+    std::ofstream file(settings.benchmarkOutput);
+    if(!file.is_open())
+    {
+        throw std::runtime_error("Benchmark: Failed to open " + settings.benchmarkOutput + "!");
+    }
+
+    benchmarkRecorder->writeJSON(file, vkDeviceCapabilities->properties, vkSwapchainExtent, settings.headless, settings.benchmarkLabel, frameTimes);
+}
+
+/// <summary>
+/// Streams every known asset file of the asset directory, in name order so runs are comparable.
+/// </summary>
+void vkApplication::createAssetStreamer()
+{
+    if(settings.assetDirectory.empty())
+    {
+        return;
+    }
+
+    std::vector<std::filesystem::path> assetFiles;
+    for(const auto& entry : std::filesystem::directory_iterator(settings.assetDirectory))
+    {
+        if(entry.is_regular_file() && AssetDecoder::getType(entry.path()).has_value())
+        {
+            assetFiles.push_back(entry.path());
+        }
+    }
+    std::sort(assetFiles.begin(), assetFiles.end());
+
+    assetStreamer = std::make_unique<AssetStreamer>(vkLogicalDevice, *vkDeviceCapabilities, vkAllocator, vkEnabledDeviceFeatures, *jobSystem,
+                                                    memoryBudgetMonitor.get(), residencyManager, static_cast<VkDeviceSize>(settings.streamingBudget) * 1024 * 1024,
+                                                    settings.ioThreadCount, settings.generateMipmaps);
+
+    for(const auto& path : assetFiles)
+    {
+        assetStreamer->request(path);
+    }
+
+    std::cout << "AssetStreamer: " << assetFiles.size() << " asset(s) requested from " << settings.assetDirectory << std::endl;
+}
+
+/// <summary>
+/// Compute-only run: no window, surface, swapchain or graphics queue. The device gets a compute queue and, where
+/// the device has one, a separate transfer queue, the images of the batch are filtered and read back, then the
+/// application exits. The input images are loaded while the instance and device are created.
+/// </summary>
+void vkApplication::runComputeBatch()
+{
+    TaskGraph initGraph;
+
+    const auto sources          = initGraph.addTask("loadComputeBatchSources",  [this] { loadComputeBatchSources(); });
+    const auto instance         = initGraph.addTask("createInstance",           [this] { createInstance(); });
+    const auto debugMessenger   = initGraph.addTask("setupDebugMessenger",      [this] { setupDebugMessenger(); },      { instance });
+    const auto physicalDevice   = initGraph.addTask("findPhysicalDevice",       [this] { findPhysicalDevice(); },       { debugMessenger });
+    const auto computeDevice    = initGraph.addTask("createComputeDevice",      [this] { createComputeDevice(); },      { physicalDevice });
+                                  initGraph.addTask("createImageBatchProcessor", [this] { createImageBatchProcessor(); }, { computeDevice, sources });
+
+    initGraph.execute(*jobSystem);
+    initGraph.printTimings(std::cout);
+
+    imageBatchProcessor->process(settings.computeBatchImages);
+
+    vkDeviceWaitIdle(vkLogicalDevice);
+    cleanupComputeBatch();
+}
+
+void vkApplication::loadComputeBatchSources()
+{
+    if(!settings.computeBatchInput.empty())
+    {
+        computeBatchSources = ImageBatchProcessor::loadImages(settings.computeBatchInput);
+    }
+    else
+    {
+        // A few full HD frames are enough to feed any batch length, they are cycled through
+        computeBatchSources = ImageBatchProcessor::createTestImages(4, { 1920, 1080 });
+    }
+}
+
+void vkApplication::createComputeDevice()
+{
+    const QueueFamilyIndices& queueFamilyIndices = vkDeviceCapabilities->queueFamilyIndices;
+    const uint32_t computeFamily = queueFamilyIndices.computeFamily.value();
+    const uint32_t transferFamily = queueFamilyIndices.transferFamily.value_or(computeFamily);
+
+    std::set<uint32_t> uniqueQueueFamilies = {
+        computeFamily,
+        transferFamily
+    };
+
+    float queuePriority = 1.0f;
+
+    std::vector<VkDeviceQueueCreateInfo> deviceQueueCreateInfos = {};
+    for(uint32_t uniqueQueueFamily : uniqueQueueFamilies)
+    {
+        deviceQueueCreateInfos.push_back({ VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO, nullptr, NULL, uniqueQueueFamily, 1, &queuePriority });
+    }
+
+    vkEnabledDeviceFeatures = vkRequiredDeviceFeatures;
+
+    vkEnabledDeviceExtensions = vkDeviceExtensions;
+    for(const char* optionalExtension : vkOptionalDeviceExtensions)
+    {
+        if(vkDeviceCapabilities->hasExtension(optionalExtension))
+        {
+            vkEnabledDeviceExtensions.push_back(optionalExtension);
+        }
+    }
+
+    synchronization2Enabled = vkDeviceCapabilities->synchronization2Features.synchronization2 == VK_TRUE;
+    VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR, nullptr, VK_TRUE };
+    if(synchronization2Enabled)
+    {
+        vkEnabledDeviceExtensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+    }
+
+    VkDeviceCreateInfo deviceCreateInfo
+    {
+        VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        synchronization2Enabled ? &synchronization2Features : nullptr,
+        NULL,
+        static_cast<uint32_t>(deviceQueueCreateInfos.size()),
+        deviceQueueCreateInfos.data(),
+        0,
+        nullptr,
+        static_cast<uint32_t>(vkEnabledDeviceExtensions.size()),
+        vkEnabledDeviceExtensions.data(),
+        &vkEnabledDeviceFeatures
+    };
+
+    if(vkValidationLayersEnabled)
+    {
+        deviceCreateInfo.enabledLayerCount = static_cast<uint32_t>(vkValidationLayers.size());
+        deviceCreateInfo.ppEnabledLayerNames = vkValidationLayers.data();
+    }
+
+    VkDevice logicalDevice = nullptr;
+    if(vkCreateDevice(vkPhysicalDevice, &deviceCreateInfo, vkAllocator, &logicalDevice) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Logical Device: Failed to create compute device");
+    }
+
+    vkLogicalDevice = UniqueDevice(logicalDevice, vkAllocator);
+
+    vkGetDeviceQueue(vkLogicalDevice, computeFamily, 0, &vkComputeQueue);
+    vkGetDeviceQueue(vkLogicalDevice, transferFamily, 0, &vkTransferQueue);
+
+    queueSubmitter = std::make_unique<QueueSubmitter>(vkLogicalDevice, synchronization2Enabled);
+
+    const bool memoryBudgetSupported = isDeviceExtensionEnabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)
+                                    && vkDeviceCapabilities->properties.apiVersion >= VK_API_VERSION_1_1;
+
+    memoryBudgetMonitor = std::make_unique<MemoryBudgetMonitor>(vkPhysicalDevice, vkDeviceCapabilities->memoryProperties,
+                                                                memoryBudgetSupported, settings.memoryBudgetThreshold);
+
+    pipelineLayoutCache = std::make_unique<PipelineLayoutCache>(vkLogicalDevice, vkAllocator);
+}
+
+void vkApplication::createImageBatchProcessor()
+{
+    ImageBatchProcessor::Shaders shaders = {};
+    shaders.resize = readFile("Shaders/batch_resize.comp.spv");
+    shaders.sharpen = readFile("Shaders/batch_sharpen.comp.spv");
+    shaders.toneMap = readFile("Shaders/batch_tonemap.comp.spv");
+
+    const QueueFamilyIndices& queueFamilyIndices = vkDeviceCapabilities->queueFamilyIndices;
+    ImageBatchProcessor::Queues queues = {};
+    queues.compute = vkComputeQueue;
+    queues.computeFamily = queueFamilyIndices.computeFamily.value();
+    queues.transfer = vkTransferQueue;
+    queues.transferFamily = queueFamilyIndices.transferFamily.value_or(queues.computeFamily);
+
+    if(!settings.computeBatchOutput.empty())
+    {
+        frameWriter = std::make_unique<FrameWriter>(settings.computeBatchOutput, settings.captureFormat, 8, "image_");
+    }
+
+    const auto computePipelineFactory = [this](const std::vector<char>& code) { return buildComputePipeline(code); };
+
+    imageBatchProcessor = std::make_unique<ImageBatchProcessor>(vkLogicalDevice, *vkDeviceCapabilities, vkAllocator, memoryBudgetMonitor.get(),
+                                                                *pipelineLayoutCache, *queueSubmitter, queues, std::move(computeBatchSources),
+                                                                settings.computeBatchExtent, shaders, computePipelineFactory, frameWriter.get());
+}
+
+/// <summary>
+/// Counterpart of cleanup for compute batches, which create only the instance, the device and the processor.
+/// </summary>
+void vkApplication::cleanupComputeBatch()
+{
+    imageBatchProcessor->printStatistics(std::cout);
+    imageBatchProcessor.reset();
+
+    if(frameWriter)
+    {
+        frameWriter->stop();
+        frameWriter->printStatistics(std::cout);
+        frameWriter.reset();
+    }
+
+    queueSubmitter->printStatistics(std::cout);
+    memoryBudgetMonitor->printStatistics(std::cout);
+
+    jobSystem->printStatistics(std::cout);
+    jobSystem.reset();
+
+    pipelineLayoutCache->printStatistics(std::cout);
+    pipelineLayoutCache.reset();
+    vkLogicalDevice.reset();
+    vkDebugMessenger.reset();
+    vkInstance.reset();
+
+    if(hostAllocator)
+    {
+        hostAllocator->printStatistics(std::cout);
+    }
+
+    if(debugMessageSink)
+    {
+        debugMessageSink->stop();
+        debugMessageSink->printStatistics(std::cout);
+    }
+}
+
+/// <summary>
+/// Development mode: the pipeline is rebuilt on a background thread whenever the GLSL sources in Shaders/ change.
+/// </summary>
+void vkApplication::createShaderHotReload()
+{
+    if(!settings.shaderHotReload)
+    {
+        return;
+    }
+
+    const auto compilerPath = ShaderHotReload::findCompiler();
+    if(!compilerPath.has_value())
+    {
+        std::cerr << "ShaderHotReload: glslc not found on PATH or in VULKAN_SDK, hot reload disabled" << std::endl;
+        return;
+    }
+
+    shaderHotReload = std::make_unique<ShaderHotReload>("Shaders", compilerPath.value());
+    shaderHotReload->addPipeline(vkGraphicsPipeline, { "shader.vert", "shader.frag" }, [this](const std::vector<ShaderHotReload::ShaderCode>& stages)
+    {
+        return buildGraphicsPipeline({}, stages);
+    });
+    shaderHotReload->start();
+}
+
+/// <summary>
+/// Polls the heap budgets once per frame and evicts least recently used resources from heaps over the threshold,
+/// before the OS has to page video memory out.
+/// </summary>
+void vkApplication::updateMemoryBudget()
+{
+    memoryBudgetMonitor->update();
+    residencyManager.enforceBudget(*memoryBudgetMonitor, completedFrameNumber);
+}
+
+bool vkApplication::isFrameCaptureSupported() const
+{
+    if(settings.captureDirectory.empty() && settings.goldenDirectory.empty())
+    {
+        return false;
+    }
+
+    // Offscreen targets are always created with TRANSFER_SRC usage
+    return FrameReadback::isFormatSupported(vkSurfaceFormat.format)
+        && (settings.headless || (vkDeviceCapabilities->surfaceCapabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT));
+}
+
+/// <summary>
+/// Frames are read back through one staging slot per frame in flight. They are written by a FrameWriter thread
+/// and/or compared against golden images.
+/// </summary>
+void vkApplication::createFrameCapture()
+{
+    if(settings.captureDirectory.empty() && settings.goldenDirectory.empty())
+    {
+        return;
+    }
+
+    if(!isFrameCaptureSupported())
+    {
+        std::cout << "FrameCapture: Surface format or usage does not allow copying swapchain images, capture disabled" << std::endl;
+        return;
+    }
+
+    if(!settings.captureDirectory.empty())
+    {
+        frameWriter = std::make_unique<FrameWriter>(settings.captureDirectory, settings.captureFormat);
+    }
+
+    if(!settings.goldenDirectory.empty())
+    {
+        goldenImageComparator = std::make_unique<GoldenImageComparator>(settings.goldenDirectory, settings.updateGoldenImages,
+                                                                        settings.goldenTolerance, settings.goldenMaxFailingPixels);
+    }
+
+    FrameWriter* writer = frameWriter.get();
+    GoldenImageComparator* comparator = goldenImageComparator.get();
+
+    // Golden comparisons run on the render thread: they are meant for test runs, not for measuring frame times.
+    frameReadback = std::make_unique<FrameReadback>(vkLogicalDevice, *vkDeviceCapabilities, vkAllocator, FRAMES_IN_FLIGHT, memoryBudgetMonitor.get(),
+        [writer, comparator](CapturedFrame&& frame)
+        {
+            if(comparator != nullptr)
+            {
+                comparator->compare(frame);
+            }
+
+            if(writer != nullptr)
+            {
+                writer->submit(std::move(frame));
+            }
+        },
+        [writer](size_t size) { return writer != nullptr ? writer->acquirePixelBuffer(size) : std::vector<uint8_t>(size); });
+}
+
+/// <summary>
+/// The drawFrame function will perform the following operations:
+/// - Wait until the frame context is no longer used by the GPU
+/// - Acquire an image from the swap chain
+/// - Record and execute the command buffer with that image as attachment in the framebuffer
+/// - Return the image to the swap chain for presentation
+/// 
+/// Each of these function call are executed asynchronously and each of the operations depends on the previous one finishing.
+/// Up to FRAMES_IN_FLIGHT frames are recorded while the GPU is still working on the previous ones.
+/// </summary>
+void vkApplication::drawFrame()
+{
+    const uint64_t frameNumber = submittedFrameNumber + 1;
+    const uint32_t slot = static_cast<uint32_t>(submittedFrameNumber % FRAMES_IN_FLIGHT);
+    FrameContext& frame = frames[slot];
+
+    // Time spent in each step of the frame, only kept by benchmark runs
+    auto phaseStart = std::chrono::steady_clock::now();
+    const auto endPhase = [this, frameNumber, &phaseStart](FramePhase phase)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if(benchmarkRecorder)
+        {
+            benchmarkRecorder->recordPhase(frameNumber, phase, now - phaseStart);
+        }
+        phaseStart = now;
+    };
+
+    waitForFrame(frame);
+    updateMemoryBudget();
+    endPhase(FramePhase::Wait);
+
+    // Acquire an Image from the swap chain
+
+    uint32_t imageIndex; // refers to VkImage in vkSwapchainImages array, and will be used to pick the right framebuffer
+
+    if(settings.headless)
+    {
+        // Offscreen image i belongs to frame context i, it is free once the frame fence was waited for.
+        imageIndex = slot;
+    }
+    else
+    {
+        const auto acquireStart = std::chrono::steady_clock::now();
+        const VkResult acquireResult = vkAcquireNextImageKHR(vkLogicalDevice, vkSwapchainKHR, UINT64_MAX, frame.vkSemaphoreImageAvailable, VK_NULL_HANDLE, &imageIndex);
+
+        // Time blocked in acquire shows whether the image count keeps up with the frames in flight and the present mode.
+        if(frameNumber > settings.warmupFrames)
+        {
+            acquireTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - acquireStart).count());
+        }
+
+        // An out of date swapchain can no longer present, a suboptimal one still can and is recreated after presenting.
+        if(acquireResult == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            recreateSwapchain();
+            return;
+        }
+        else if(acquireResult != VK_SUCCESS && acquireResult != VK_SUBOPTIMAL_KHR)
+        {
+            throw std::runtime_error("failed to acquire swap chain image!");
+        }
+    }
+    endPhase(FramePhase::Acquire);
+
+    if(benchmarkWorkload)
+    {
+        benchmarkWorkload->update(slot, frameNumber);
+    }
+    if(meshletRenderer)
+    {
+        meshletRenderer->update(slot, frameNumber, vkSwapchainExtent);
+    }
+    if(lodRenderer)
+    {
+        lodRenderer->update(slot, frameNumber, vkSwapchainExtent);
+    }
+    if(sortedDrawRenderer)
+    {
+        sortedDrawRenderer->update(slot, frameNumber);
+    }
+    if(particleSystem)
+    {
+        particleSystem->update(slot, frameNumber, vkSwapchainExtent);
+    }
+    if(assetStreamer)
+    {
+        assetStreamer->update(completedFrameNumber);
+    }
+    if(shaderHotReload)
+    {
+        // Submitted frames keep the pipeline they were recorded with, this frame is the first to use the new one.
+        shaderHotReload->swapPipelines(deletionQueue, submittedFrameNumber);
+    }
+    endPhase(FramePhase::Update);
+
+    // The fence is only reset once work is going to be submitted, otherwise the next wait on it would never return.
+    VkFence inFlightFence = frame.vkFenceInFlight;
+    vkResetFences(vkLogicalDevice, 1, &inFlightFence);
+
+    vkResetCommandBuffer(frame.vkCommandBuffer, 0);
+    recordCommandBuffer(frame.vkCommandBuffer, imageIndex);
+    endPhase(FramePhase::Record);
+
+    // Submitting the command buffer to the graphics queue
+
+    // The frame waits for the acquired image before writing color attachments and signals once its commands finished.
+    // Offscreen images are not acquired, headless frames wait on and signal nothing.
+    if(!settings.headless)
+    {
+        queueSubmitter->addWait(vkGraphicsQueue, frame.vkSemaphoreImageAvailable, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    }
+    queueSubmitter->addCommandBuffer(vkGraphicsQueue, frame.vkCommandBuffer);
+    if(!settings.headless)
+    {
+        queueSubmitter->addSignal(vkGraphicsQueue, vkSemaphoresRenderFinished[imageIndex]);
+    }
+
+    VkSemaphore signalSemaphores[] = { vkSemaphoresRenderFinished[imageIndex] };
+
+    // The fence is signaled once the command buffer finished, which tells the CPU when the frame context can be reused.
+    // With an ownership transfer the fence is signaled by the present family batch, which runs after this one.
+    if(queueOwnershipTransfer)
+    {
+        submitOwnershipTransfer(frame, imageIndex, inFlightFence);
+        signalSemaphores[0] = vkSemaphoresOwnershipTransferred[imageIndex];
+    }
+    else
+    {
+        queueSubmitter->setFence(vkGraphicsQueue, inFlightFence);
+    }
+
+    // The sync point of the frame: every queue gets its share with one submit call before the image is presented.
+    queueSubmitter->flush();
+
+    frame.frameNumber = ++submittedFrameNumber;
+    endPhase(FramePhase::Submit);
+
+    if(settings.headless)
+    {
+        return;
+    }
+
+    // Subpass dependencies :
+    // Subpasses in a render pass automatically take care of image layout transitions. These transitions are controlled
+    // by subpass dependencies, which specify memory and execution dependencies between subpasses.
+    VkSubpassDependency subpassDependency
+    {
+        VK_SUBPASS_EXTERNAL,
+        0,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        0,
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        NULL
+    };
+
+    // Presentation :
+    // The last step of drawing a frame is submitting the result back to the swap chain to have it eventually show up on the screen.    // 
+    // Last parameter - pResults allows you to specify an array of VkResult values to check for every individual swap chain
+    // if presentation was successful.
+
+    VkSwapchainKHR swapChains[] = { vkSwapchainKHR };
+
+    // Tagging the present with the frame number lets the latency monitor wait for it.
+    const uint64_t presentId = frame.frameNumber;
+    VkPresentIdKHR presentIdInfo
+    {
+        VK_STRUCTURE_TYPE_PRESENT_ID_KHR,
+        nullptr,
+        1,
+        &presentId
+    };
+
+    VkPresentInfoKHR presentInfo
+    {
+        VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+        presentLatencyMonitor ? &presentIdInfo : nullptr,
+        // Specify which semaphores to wait on before presentation.
+        1,
+        signalSemaphores,
+        // Specify the swap chains to present images to and the index of the image for each swap chain.
+        1,
+        swapChains,
+        &imageIndex,
+        nullptr
+    };
+
+    // The vkQueuePresentKHR function submits the request to present an image to the swap chain.
+    const VkResult presentResult = vkQueuePresentKHR(vkPresentQueue, &presentInfo);
+    endPhase(FramePhase::Present);
+
+    if(presentLatencyMonitor && (presentResult == VK_SUCCESS || presentResult == VK_SUBOPTIMAL_KHR))
+    {
+        presentLatencyMonitor->presented(presentId, frameStartTime);
+    }
+
+    if(presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR || framebufferResized)
+    {
+        recreateSwapchain();
+    }
+    else if(presentResult != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to present swap chain image!");
+    }
+
+    if(!firstFramePresented)
+    {
+        firstFramePresented = true;
+
+        const std::chrono::duration<double, std::milli> timeToFirstFrame = std::chrono::steady_clock::now() - startupTime;
+        std::cout << "Startup: First frame presented after " << timeToFirstFrame.count() << " ms" << std::endl;
+    }
+}
+
+/// <summary>
+/// Rebuilds the swapchain and everything depending on its images without waiting for the device to become idle.
+/// 
+/// Frames still in flight keep using the previous objects, so they are moved into the deletion queue and destroyed
+/// once those frames completed. Presentation is not tracked by the frame fences, so objects used by the presentation
+/// engine are kept for FRAMES_IN_FLIGHT additional frames.
+/// </summary>
+void vkApplication::recreateSwapchain()
+{
+    // A minimized window has a zero sized framebuffer, no swapchain can be created until it is restored.
+    while(framebufferExtent.width == 0 || framebufferExtent.height == 0)
+    {
+        glfwWaitEvents();
+    }
+
+    framebufferResized = false;
+
+    const uint64_t retireFrameNumber = submittedFrameNumber;
+    const uint64_t presentRetireFrameNumber = submittedFrameNumber + FRAMES_IN_FLIGHT;
+
+    for(auto& framebuffer : vkSwapchainFramebuffers)
+    {
+        deletionQueue.push(retireFrameNumber, std::move(framebuffer));
+    }
+
+    for(auto& imageView : vkSwapchainImageViews)
+    {
+        deletionQueue.push(retireFrameNumber, std::move(imageView));
+    }
+
+    for(auto& semaphore : vkSemaphoresRenderFinished)
+    {
+        deletionQueue.push(presentRetireFrameNumber, std::move(semaphore));
+    }
+
+    for(auto& semaphore : vkSemaphoresOwnershipTransferred)
+    {
+        deletionQueue.push(presentRetireFrameNumber, std::move(semaphore));
+    }
+
+    // Presents still pending on the current swapchain can no longer be waited for once it is retired.
+    if(presentLatencyMonitor)
+    {
+        presentLatencyMonitor->swapchainRetired();
+    }
+
+    // The current swapchain is passed as oldSwapchain and retired by createSwapchain.
+    createSwapchain();
+
+    createImageViews();
+    createFramebuffers();
+    createRenderFinishedSemaphores();
+
+    std::cout << "Swapchain: Recreated with extent " << vkSwapchainExtent.width << "x" << vkSwapchainExtent.height
+              << ", " << deletionQueue.size() << " object(s) waiting for retirement" << std::endl;
+}
+
+/// <summary>
+// There are two ways of synchronizing swap chain events : fences and semaphores.
+// 
+// Both of them can be used for coordinating operations by having one operation signal and another operation wait
+// for a fence or semaphore to go from the unsignaled to signaled state.
+// 
+// The difference is that the state of fences can be accessed from your program using calls like 
+// vkWaitForFencesand semaphores cannot be.
+// 
+// Fences are mainly designed to synchronize your application itself with rendering operation.
+// Semaphores are used to synchronize operations within or across command queues.
+/// </summary>
+void vkApplication::createSyncObjects()
+{
+    VkSemaphoreCreateInfo semaphoreCreateInfo = 
+    {
+        VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        nullptr,
+        NULL
+    };
+
+    // Fences are created signaled, so waiting for a frame context which was never submitted returns immediately.
+    VkFenceCreateInfo fenceCreateInfo =
+    {
+        VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+        nullptr,
+        VK_FENCE_CREATE_SIGNALED_BIT
+    };
+
+    for(auto& frame : frames)
+    {
+        VkSemaphore imageAvailable = nullptr;
+        VkFence inFlight = nullptr;
+
+        if (vkCreateSemaphore(vkLogicalDevice, &semaphoreCreateInfo, vkAllocator, &imageAvailable) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create semaphores!");
+        }
+
+        frame.vkSemaphoreImageAvailable = UniqueSemaphore(vkLogicalDevice, imageAvailable, vkAllocator);
+
+        if (vkCreateFence(vkLogicalDevice, &fenceCreateInfo, vkAllocator, &inFlight) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create fences!");
+        }
+
+        frame.vkFenceInFlight = UniqueFence(vkLogicalDevice, inFlight, vkAllocator);
+    }
+
+    createRenderFinishedSemaphores();
+}
+
+/// <summary>
+/// Presentation of an image waits on its render finished semaphore, and the semaphore can only be signaled again
+/// once that presentation is done. Having one semaphore per swapchain image guarantees it is free when the image is acquired again.
+/// </summary>
+void vkApplication::createRenderFinishedSemaphores()
+{
+    VkSemaphoreCreateInfo semaphoreCreateInfo =
+    {
+        VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        nullptr,
+        NULL
+    };
+
+    vkSemaphoresRenderFinished.clear();
+    vkSemaphoresRenderFinished.reserve(vkSwapchainImages.size());
+
+    for(size_t i = 0; i < vkSwapchainImages.size(); ++i)
+    {
+        VkSemaphore renderFinished = nullptr;
+        if (vkCreateSemaphore(vkLogicalDevice, &semaphoreCreateInfo, vkAllocator, &renderFinished) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create semaphores!");
+        }
+
+        vkSemaphoresRenderFinished.emplace_back(vkLogicalDevice, renderFinished, vkAllocator);
+    }
+
+    // Presentation waits for the ownership transfer instead, which waits for rendering.
+    vkSemaphoresOwnershipTransferred.clear();
+    if(queueOwnershipTransfer)
+    {
+        vkSemaphoresOwnershipTransferred.reserve(vkSwapchainImages.size());
+
+        for(size_t i = 0; i < vkSwapchainImages.size(); ++i)
+        {
+            VkSemaphore ownershipTransferred = nullptr;
+            if (vkCreateSemaphore(vkLogicalDevice, &semaphoreCreateInfo, vkAllocator, &ownershipTransferred) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create semaphores!");
+            }
+
+            vkSemaphoresOwnershipTransferred.emplace_back(vkLogicalDevice, ownershipTransferred, vkAllocator);
+        }
+    }
+}
+
+/// <summary>
+/// Initialization is expressed as a graph of tasks instead of a fixed sequence of calls.
+/// Each step only waits for the objects it really needs, so independent work runs concurrently:
+/// shader files are read while the instance and device are created, and the render pass and graphics
+/// pipeline are built against the chosen surface format while the swapchain and its image views are created.
+/// </summary>
+void vkApplication::initVulkan()
+{
+    if(window != nullptr)
+    {
+        int width = 0;
+        int height = 0;
+        glfwGetFramebufferSize(window, &width, &height);
+        framebufferExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+    }
+    else
+    {
+        framebufferExtent = { WINDOW_WIDTH, WINDOW_HEIGHT };
+    }
+
+    TaskGraph initGraph;
+
+    const auto shaders          = initGraph.addTask("loadShaders",              [this] { loadShaders(); });
+    const auto instance         = initGraph.addTask("createInstance",           [this] { createInstance(); });
+    const auto debugMessenger   = initGraph.addTask("setupDebugMessenger",      [this] { setupDebugMessenger(); },      { instance });
+    const auto surface          = initGraph.addTask("createSurface",            [this] { createSurface(); },            { debugMessenger });
+    const auto physicalDevice   = initGraph.addTask("findPhysicalDevice",       [this] { findPhysicalDevice(); },       { surface });
+    const auto surfaceFormat    = initGraph.addTask("chooseSurfaceFormat",      [this] { chooseSurfaceFormat(); },      { physicalDevice });
+    const auto logicalDevice    = initGraph.addTask("createLogicalDevice",      [this] { createLogicalDevice(); },      { physicalDevice });
+    const auto swapchain        = initGraph.addTask("createSwapchain",          [this] { createSwapchain(); },          { logicalDevice, surfaceFormat });
+    const auto imageViews       = initGraph.addTask("createImageViews",         [this] { createImageViews(); },         { swapchain });
+    const auto renderPass       = initGraph.addTask("createRenderPass",         [this] { createRenderPass(); },         { logicalDevice, surfaceFormat });
+    const auto graphicsPipeline = initGraph.addTask("createGraphicsPipeline",   [this] { createGraphicsPipeline(); },   { renderPass, shaders });
+                                  initGraph.addTask("createFramebuffers",       [this] { createFramebuffers(); },       { imageViews, renderPass });
+    const auto commandPool      = initGraph.addTask("createCommandPool",        [this] { createCommandPool(); },        { logicalDevice });
+                                  initGraph.addTask("createCommandBuffers",     [this] { createCommandBuffers(); },     { commandPool });
+                                  initGraph.addTask("createSyncObjects",        [this] { createSyncObjects(); },        { swapchain });
+                                  initGraph.addTask("createFrameCapture",       [this] { createFrameCapture(); },       { logicalDevice, surfaceFormat });
+                                  initGraph.addTask("createBenchmark",          [this] { createBenchmark(); },          { logicalDevice, graphicsPipeline });
+                                  initGraph.addTask("createAssetStreamer",      [this] { createAssetStreamer(); },      { logicalDevice });
+                                  initGraph.addTask("createShaderHotReload",    [this] { createShaderHotReload(); },    { graphicsPipeline });
+
+    initGraph.execute(*jobSystem);
+    initGraph.printTimings(std::cout);
+}
+
+void vkApplication::createInstance()
+{
+    if(vkValidationLayersEnabled && !checkValidationLayersSupport())
+    {
+        throw std::runtime_error("CreateInstance: Requested validation layers not available!");
+    }
+
+    VkApplicationInfo vkApplicationInfo
+    {
+        VK_STRUCTURE_TYPE_APPLICATION_INFO,
+        nullptr,
+        "vkTriangle",
+        VK_MAKE_VERSION(1,0,0),
+        "No Engine",
+        VK_MAKE_VERSION(1,0,0),
+        VK_API_VERSION_1_2
+    };
+
+    auto requiredExtensions = getRequiredExtensions();
+
+    VkInstanceCreateInfo vkInstanceCreateInfo
+    {
+        VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+        nullptr,
+        NULL,
+        &vkApplicationInfo,
+        0,
+        nullptr,
+        static_cast<uint32_t>(requiredExtensions.size()),
+        requiredExtensions.data()
+    };
+
+    VkDebugUtilsMessengerCreateInfoEXT vkDebugUtilsMessengerCreateInfo;
+
+    if(vkValidationLayersEnabled)
+    {
+        populateDebugMessengerCreateInfo(vkDebugUtilsMessengerCreateInfo, debugMessageSink.get());
+        vkInstanceCreateInfo.pNext = static_cast<VkDebugUtilsMessengerCreateInfoEXT*>(&vkDebugUtilsMessengerCreateInfo);
+        vkInstanceCreateInfo.enabledLayerCount = static_cast<uint32_t>(vkValidationLayers.size());
+        vkInstanceCreateInfo.ppEnabledLayerNames = vkValidationLayers.data();
+    }
+
+    VkInstance instance = nullptr;
+    if(vkCreateInstance(&vkInstanceCreateInfo, vkAllocator, &instance) != VK_SUCCESS)
+    {
+        throw std::runtime_error("CreateInstance: Failed to create instance!");
+    }
+
+    vkInstance = UniqueInstance(instance, vkAllocator);
+}
+
+void vkApplication::initWindow()
+{
+    glfwInit();
+
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+
+    window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Vulkan", nullptr, nullptr);
+
+    glfwSetWindowUserPointer(window, this);
+    glfwSetFramebufferSizeCallback(window, [](GLFWwindow* window, int width, int height)
+        {
+            vkApplication* application = static_cast<vkApplication*>(glfwGetWindowUserPointer(window));
+            application->framebufferResized = true;
+            application->framebufferExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+        });
+}
+
+void vkApplication::mainLoop()
+{
+    // Starts the time of the first frame
+    frameTimeRecorder.frameBoundary();
+
+    while(window == nullptr || !glfwWindowShouldClose(window))
+    {
+        // Pacing waits before events are polled, so the frame works with the latest input.
+        frameStartTime = framePacer.beginFrame(presentLatencyMonitor.get(), vkSwapchainKHR, submittedFrameNumber);
+
+        if(window != nullptr)
+        {
+            glfwPollEvents();
+        }
+
+        drawFrame();
+        frameTimeRecorder.frameBoundary();
+
+        if(benchmarkRecorder ? benchmarkRecorder->isFinished(submittedFrameNumber)
+                             : settings.frameCount > 0 && submittedFrameNumber >= settings.frameCount)
+        {
+            break;
+        }
+    }
+
+    // All of the operations in drawFrame are asynchronous. While exiting the loop, drawing and presentation operations
+    // may still be going on. Instead of cleaning right now we need to wait for the logical device to finish operations
+    // before exiting mainLoop and destroying the window.
+    vkDeviceWaitIdle(vkLogicalDevice);
+}
+
+/// <summary>
+/// Objects are owned by UniqueHandle members and would be destroyed with the application. They are released
+/// explicitly here, in reverse order of creation, so the window and GLFW are terminated after every Vulkan object
+/// and the host allocation statistics are complete when printed.
+/// </summary>
+void vkApplication::cleanup()
+{
+    // The device is idle after mainLoop, every retired object can go.
+    deletionQueue.flush();
+
+    // Frames still waiting in the readback slots are complete, hand them to the writer before it stops.
+    if(frameReadback)
+    {
+        for(uint32_t slot = 0; slot < FRAMES_IN_FLIGHT; ++slot)
+        {
+            frameReadback->collect(slot);
+        }
+
+        frameReadback->printStatistics(std::cout);
+        frameReadback.reset();
+    }
+
+    if(frameWriter)
+    {
+        frameWriter->stop();
+        frameWriter->printStatistics(std::cout);
+        frameWriter.reset();
+    }
+
+    frameTimeRecorder.printSummary(std::cout);
+    framePacer.printStatistics(std::cout);
+    if(!settings.headless)
+    {
+        const FrameTimeRecorder::Summary acquire = FrameTimeRecorder::summarize(acquireTimes);
+        std::cout << "Swapchain: " << vkSwapchainImages.size() << " images, present mode " << FramePacer::getPresentModeName(vkSwapchainPresentMode)
+                  << ", acquire mean " << acquire.mean << " ms, p95 " << acquire.p95 << " ms, p99 " << acquire.p99 << " ms, max " << acquire.maximum << " ms\n";
+    }
+    if(presentLatencyMonitor)
+    {
+        presentLatencyMonitor->printSummary(std::cout);
+        presentLatencyMonitor.reset();
+    }
+    if(!settings.frameTimesFile.empty())
+    {
+        frameTimeRecorder.writeCSV(settings.frameTimesFile);
+    }
+
+    if(benchmarkRecorder)
+    {
+        // The timestamps of the last frames are available now that the device is idle.
+        for(uint32_t slot = 0; slot < FRAMES_IN_FLIGHT; ++slot)
+        {
+            collectGpuTime(slot);
+        }
+
+        reportBenchmark();
+
+        benchmarkWorkload.reset();
+        gpuTimer.reset();
+
+        if(meshletRenderer)
+        {
+            meshletRenderer->printStatistics(std::cout);
+            meshletRenderer.reset();
+        }
+        if(lodRenderer)
+        {
+            lodRenderer->printStatistics(std::cout);
+            lodRenderer.reset();
+        }
+        if(sortedDrawRenderer)
+        {
+            sortedDrawRenderer->printStatistics(std::cout);
+            sortedDrawRenderer.reset();
+        }
+        if(particleSystem)
+        {
+            particleSystem->printStatistics(std::cout);
+            particleSystem.reset();
+        }
+    }
+
+    if(assetStreamer)
+    {
+        assetStreamer->printStatistics(std::cout);
+        assetStreamer.reset();
+    }
+
+    if(shaderHotReload)
+    {
+        shaderHotReload->stop();
+        shaderHotReload->printStatistics(std::cout);
+        shaderHotReload.reset();
+    }
+
+    queueSubmitter->printStatistics(std::cout);
+    memoryBudgetMonitor->printStatistics(std::cout);
+    residencyManager.printStatistics(std::cout);
+
+    jobSystem->printStatistics(std::cout);
+    jobSystem.reset();
+
+    vkSemaphoresRenderFinished.clear();
+    vkSemaphoresOwnershipTransferred.clear();
+
+    for(auto& frame : frames)
+    {
+        frame.vkFenceInFlight.reset();
+        frame.vkSemaphoreImageAvailable.reset();
+        frame.vkCommandBuffer = nullptr;
+        frame.vkPresentCommandBuffer = nullptr;
+    }
+
+    vkCommandPool.reset();
+    vkPresentCommandPool.reset();
+    vkSwapchainFramebuffers.clear();
+    vkGraphicsPipeline.reset();
+    pipelineLayoutCache->printStatistics(std::cout);
+    pipelineLayoutCache.reset();
+    vkRenderPass.reset();
+    vkSwapchainImageViews.clear();
+    vkSwapchainKHR.reset();
+    vkSwapchainImages.clear();
+    vkOffscreenImages.clear();
+    vkOffscreenImageMemory.clear();
+    vkLogicalDevice.reset();
+    vkSurface.reset();
+    vkDebugMessenger.reset();
+    vkInstance.reset();
+
+    if(window != nullptr)
+    {
+        glfwDestroyWindow(window);
+
+        glfwTerminate();
+    }
+
+    if(hostAllocator)
+    {
+        hostAllocator->printStatistics(std::cout);
+    }
+
+    if(debugMessageSink)
+    {
+        debugMessageSink->stop();
+        debugMessageSink->printStatistics(std::cout);
+    }
+}
+
+/// <summary>
+/// Fails the run when captured frames do not match the golden images or the frame time budget is exceeded,
+/// so automated runs report regressions through the exit code.
+/// </summary>
+void vkApplication::checkRunResults() const
+{
+    if(goldenImageComparator)
+    {
+        goldenImageComparator->printResults(std::cout);
+
+        if(!goldenImageComparator->passed())
+        {
+            throw std::runtime_error("GoldenImage: Captured frames do not match the golden images!");
+        }
+    }
+
+    if(settings.frameTimeBudget > 0.0)
+    {
+        const FrameTimeRecorder::Summary summary = frameTimeRecorder.getSummary();
+
+        if(summary.p95 > settings.frameTimeBudget)
+        {
+            throw std::runtime_error("FrameTimes: p95 frame time " + std::to_string(summary.p95) + " ms exceeds the budget of "
+                                     + std::to_string(settings.frameTimeBudget) + " ms!");
+        }
+    }
 }
@@ -1,16 +1,51 @@
 ﻿#pragma once
+#include "ApplicationSettings.h"
+#include "DeviceCapabilities.h"
+#include "DebugMessageSink.h"
+#include "HostAllocator.h"
+#include "VkHandle.h"
+#include "DeletionQueue.h"
+#include "MemoryBudget.h"
+#include "ResidencyManager.h"
+#include "FrameReadback.h"
+#include "FrameWriter.h"
+#include "GoldenImage.h"
+#include "FrameTimeRecorder.h"
+#include "Benchmark.h"
+#include "BenchmarkWorkload.h"
+#include "GpuTimer.h"
+#include "FramePacer.h"
+#include "PresentLatency.h"
+#include "JobSystem.h"
+#include "AssetStreamer.h"
+#include "ShaderHotReload.h"
+#include "PipelineLayoutCache.h"
+#include "LodRenderer.h"
+#include "SortedDrawRenderer.h"
+#include "ParticleSystem.h"
+#include "ImageBatchProcessor.h"
+#include "QueueSubmitter.h"
+#include "MeshletRenderer.h"
 
 class vkApplication
 {
 public:
+    explicit                            vkApplication(const ApplicationSettings& settings);
+
     void                                run();
 
 private:
+    const ApplicationSettings           settings;
+
     //Window
     GLFWwindow*                         window                      = nullptr;
     const uint32_t                      WINDOW_WIDTH                = 800;
     const uint32_t                      WINDOW_HEIGHT               = 600;
-    VkDebugUtilsMessengerEXT            vkDebugMessenger            = nullptr;
+    bool                                framebufferResized          = false;
+    std::unique_ptr<DebugMessageSink>   debugMessageSink            = nullptr;
+
+    //Jobs - the thread calling run() is worker 0
+    std::unique_ptr<JobSystem>          jobSystem                   = nullptr;
 
     //Validation Layers
     const std::vector<const char*>      vkValidationLayers          = { "VK_LAYER_KHRONOS_validation" };
@@ -21,63 +56,166 @@ private:
     const bool                          vkValidationLayersEnabled   = true;
 #endif
 
+    //Host Memory - vkAllocator is nullptr when the driver uses its default allocator
+    std::unique_ptr<HostAllocator>      hostAllocator               = nullptr;
+    const VkAllocationCallbacks*        vkAllocator                 = nullptr;
+
     //VkMembers
-    VkInstance                          vkInstance                  = nullptr;
+    UniqueInstance                      vkInstance                  = {};
+    UniqueDebugUtilsMessenger           vkDebugMessenger            = {};
     VkPhysicalDevice                    vkPhysicalDevice            = nullptr;
 
-    struct QueueFamilyIndices
-    {
-        std::optional<uint32_t>         graphicsFamily;
-        std::optional<uint32_t>         presentFamily;
-
-        const bool IsComplete() const
-        {
-            return (graphicsFamily.has_value() && presentFamily.has_value());
-        }
-    };
+    //Capabilities of every enumerated physical device, queried once in findPhysicalDevice
+    std::vector<PhysicalDeviceCapabilities> vkPhysicalDevicesCapabilities = {};
+    const PhysicalDeviceCapabilities*   vkDeviceCapabilities        = nullptr;
 
-    VkDevice                            vkLogicalDevice             = nullptr;
+    UniqueSurface                       vkSurface                   = {};
+    UniqueDevice                        vkLogicalDevice             = {};
     VkQueue                             vkGraphicsQueue             = nullptr;
     VkQueue                             vkPresentQueue              = nullptr;
-    VkSurfaceKHR                        vkSurface                   = nullptr;
 
-    const std::vector<const char*>      vkDeviceExtensions          = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    //Graphics and present families differ, swapchain images are transferred to the present family every frame
+    bool                                queueOwnershipTransfer      = false;
+    uint32_t                            vkPresentFamily             = 0;
 
-    struct SwapchainSupportDetails
-    {
-        VkSurfaceCapabilitiesKHR        vkSurfaceCapabilities       = {};
-        std::vector<VkSurfaceFormatKHR> vkFormats                   = {};
-        std::vector<VkPresentModeKHR>   vkPresentModes              = {};
-    };
+    //Submissions of a frame, flushed with one submit call per queue
+    std::unique_ptr<QueueSubmitter>     queueSubmitter              = nullptr;
+
+    //Objects replaced at run time are retired here until the GPU finished the frames using them
+    DeletionQueue                       deletionQueue;
+
+    //Headless rendering needs no presentation
+    const std::vector<const char*>      vkDeviceExtensions          = settings.headless ? std::vector<const char*>()
+                                                                                        : std::vector<const char*>{ VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+
+    //Extensions enabled only when the device supports them
+    const std::vector<const char*>      vkOptionalDeviceExtensions  = { VK_EXT_MEMORY_BUDGET_EXTENSION_NAME };
+    std::vector<const char*>            vkEnabledDeviceExtensions   = {};
+
+    //Features without which the application can't work, enabled on the logical device
+    const VkPhysicalDeviceFeatures      vkRequiredDeviceFeatures    = {};
+    VkPhysicalDeviceFeatures            vkEnabledDeviceFeatures     = {};
+
+    //Optional features of extensions and newer Vulkan versions, enabled when the device has them
+    bool                                meshShadersEnabled          = false;
+    bool                                drawIndirectCountEnabled    = false;
+    bool                                synchronization2Enabled     = false;
+
+    //Device Memory
+    std::unique_ptr<MemoryBudgetMonitor> memoryBudgetMonitor        = nullptr;
+    ResidencyManager                    residencyManager;
 
     //Swapchain
-    VkSwapchainKHR                      vkSwapchainKHR              = nullptr;
+    UniqueSwapchain                     vkSwapchainKHR              = {};
     std::vector<VkImage>                vkSwapchainImages           = {};
     VkFormat                            vkSwapchainImageFormat      = VK_FORMAT_UNDEFINED;
     VkExtent2D                          vkSwapchainExtent           = {0,0};
+    VkImageUsageFlags                   vkSwapchainImageUsage       = 0;
+    VkPresentModeKHR                    vkSwapchainPresentMode      = VK_PRESENT_MODE_FIFO_KHR;
+    std::vector<double>                 acquireTimes                = {};   // milliseconds spent in vkAcquireNextImageKHR after the warm-up
+
+    //Offscreen Targets - replace the swapchain images when running headless
+    std::vector<UniqueDeviceMemory>     vkOffscreenImageMemory      = {};
+    std::vector<UniqueImage>            vkOffscreenImages           = {};
+
+    VkSurfaceFormatKHR                  vkSurfaceFormat             = {};
+    VkExtent2D                          framebufferExtent           = {0,0};
 
     //Image View
-    std::vector<VkImageView>            vkSwapchainImageViews       = {};
+    std::vector<UniqueImageView>        vkSwapchainImageViews       = {};
 
     //Render Pass
-    VkRenderPass                        vkRenderPass                = nullptr;
+    UniqueRenderPass                    vkRenderPass                = {};
+    const VkImageLayout                 vkColorAttachmentFinalLayout = settings.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
-    //Pipeline Layout
-    VkPipelineLayout                    vkPipelineLayout            = nullptr;
+    //Pipeline Layouts - derived from the reflected shaders, shared between compatible pipelines
+    std::unique_ptr<PipelineLayoutCache> pipelineLayoutCache        = nullptr;
 
     //Graphics Pipeline
-    VkPipeline                          vkGraphicsPipeline          = nullptr;
+    struct GraphicsPipelineVariant
+    {
+        VkCullModeFlags                 cullMode                    = VK_CULL_MODE_BACK_BIT;
+        VkFrontFace                     frontFace                   = VK_FRONT_FACE_CLOCKWISE;
+        VkBool32                        blendEnable                 = VK_FALSE;
+        VkColorComponentFlags           colorWriteMask              = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    };
+
+    UniquePipeline                      vkGraphicsPipeline          = {};
+    std::vector<std::vector<char>>      shaderStageCode             = {};   // SPIR-V of the vertex and fragment stage
+
+    //Shader Hot Reload - rebuilds the pipelines while running when their shaders change
+    std::unique_ptr<ShaderHotReload>    shaderHotReload             = nullptr;
 
     //Framebuffer
-    std::vector<VkFramebuffer>          vkSwapchainFramebuffers     = {};
+    std::vector<UniqueFramebuffer>      vkSwapchainFramebuffers     = {};
+
+    //Frames In Flight
+    static constexpr uint32_t           FRAMES_IN_FLIGHT            = 2;
+
+    struct FrameContext
+    {
+        VkCommandBuffer                 vkCommandBuffer             = nullptr;
+        VkCommandBuffer                 vkPresentCommandBuffer      = nullptr;  // only with queueOwnershipTransfer
+        UniqueSemaphore                 vkSemaphoreImageAvailable   = {};
+        UniqueFence                     vkFenceInFlight             = {};
+        uint64_t                        frameNumber                 = 0;
+    };
 
     //Commandbuffer
-    VkCommandPool                       vkCommandPool               = nullptr;
-    std::vector<VkCommandBuffer>        vkCommandBuffers            = {};
+    UniqueCommandPool                   vkCommandPool               = {};
+    UniqueCommandPool                   vkPresentCommandPool        = {};
+    std::array<FrameContext, FRAMES_IN_FLIGHT> frames               = {};
+
+    //Semaphores - one per swapchain image, as presentation of an image may still wait on it
+    std::vector<UniqueSemaphore>        vkSemaphoresRenderFinished  = {};
+    std::vector<UniqueSemaphore>        vkSemaphoresOwnershipTransferred = {};
+
+    //Frame numbers start at 1, 0 means no frame was submitted or completed yet
+    uint64_t                            submittedFrameNumber        = 0;
+    uint64_t                            completedFrameNumber        = 0;
+
+    //Frame Capture
+    std::unique_ptr<FrameWriter>        frameWriter                 = nullptr;
+    std::unique_ptr<FrameReadback>      frameReadback               = nullptr;
+    std::unique_ptr<GoldenImageComparator> goldenImageComparator    = nullptr;
+
+    //Frame Times
+    FrameTimeRecorder                   frameTimeRecorder           { settings.warmupFrames };
+
+    //Presentation - present latency is only measured when the device supports present ids and present wait
+    FramePacer                          framePacer                  { settings.presentPolicy, settings.targetFrameRate };
+    std::unique_ptr<PresentLatencyMonitor> presentLatencyMonitor    = nullptr;
+    std::chrono::steady_clock::time_point frameStartTime            = {};
+
+    //Benchmark
+    std::unique_ptr<BenchmarkRecorder>  benchmarkRecorder           = nullptr;
+    std::unique_ptr<BenchmarkWorkload>  benchmarkWorkload           = nullptr;
+    std::unique_ptr<GpuTimer>           gpuTimer                    = nullptr;
+
+    //Meshlets - draws the meshlets benchmark scenario in place of the workload
+    std::unique_ptr<MeshletRenderer>    meshletRenderer             = nullptr;
+
+    //Levels of detail - draws the lod benchmark scenario in place of the workload
+    std::unique_ptr<LodRenderer>        lodRenderer                 = nullptr;
+
+    //Draw sorting - draws the sorted-draws benchmark scenario in place of the workload
+    std::unique_ptr<SortedDrawRenderer> sortedDrawRenderer          = nullptr;
+
+    //Particles - simulates and draws the particles benchmark scenario in place of the workload
+    std::unique_ptr<ParticleSystem>     particleSystem              = nullptr;
+
+    //Asset Streaming
+    std::unique_ptr<AssetStreamer>      assetStreamer               = nullptr;
+
+    //Compute Batch - replaces rendering when settings.computeBatchImages is set, the device has no graphics queue
+    VkQueue                             vkComputeQueue              = nullptr;
+    VkQueue                             vkTransferQueue             = nullptr;
+    std::vector<DecodedAsset>           computeBatchSources         = {};
+    std::unique_ptr<ImageBatchProcessor> imageBatchProcessor        = nullptr;
 
-    //Semaphores
-    VkSemaphore                         vkSemaphoreImageAvailable   = nullptr;
-    VkSemaphore                         vkSemaphoreRenderFinished   = nullptr;
+    //Startup
+    std::chrono::steady_clock::time_point startupTime               = {};
+    bool                                firstFramePresented         = false;
 
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -89,30 +227,36 @@ private:
 
     //Physical Device
     void                                findPhysicalDevice();
-    const uint32_t                      getPhysicalDeviceScore(const VkPhysicalDevice& physicalDevice)                          const;
-    const QueueFamilyIndices            getQueueFamilies(const VkPhysicalDevice& physicalDevice)                                const;
-    bool                                isDeviceSupportingRequirements(const VkPhysicalDevice& physicalDevice)                  const;
+    bool                                isDeviceSupportingRequirements(const PhysicalDeviceCapabilities& capabilities, std::string& rejectReason) const;
 
     //Logical Device
     void                                createLogicalDevice();
+    uint32_t                            choosePresentFamily(uint32_t graphicsFamily)                                            const;
+    bool                                isDeviceExtensionEnabled(const char* extensionName)                                     const;
 
     //Surface
     void                                createSurface();
 
     //Swapchain
-    bool                                checkDeviceExtensionsSupport(const VkPhysicalDevice& physicalDevice)                    const;
-    const SwapchainSupportDetails       querySwapchainSupport(VkPhysicalDevice physicalDevice)                                  const;
+    bool                                checkDeviceExtensionsSupport(const PhysicalDeviceCapabilities& capabilities)            const;
     const VkSurfaceFormatKHR            chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats)        const;
+    void                                chooseSurfaceFormat();
     const VkPresentModeKHR              chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes)       const;
     const VkExtent2D                    chooseSwapExtent(const VkSurfaceCapabilitiesKHR& surfaceCapabilities)                   const;
     void                                createSwapchain();
+    void                                recreateSwapchain();
+    void                                createOffscreenTargets();
 
     //Image View
     void                                createImageViews();
 
     //Graphics Pipeline
+    void                                loadShaders();
     void                                createGraphicsPipeline();
-    VkShaderModule                      createShaderModule(const std::vector<char>& code);
+    UniquePipeline                      buildGraphicsPipeline(const GraphicsPipelineVariant& variant, const std::vector<std::vector<char>>& stageCode);
+    UniquePipeline                      buildComputePipeline(const std::vector<char>& code);
+    void                                createShaderHotReload();
+    UniqueShaderModule                  createShaderModule(const std::vector<char>& code);
 
     //Render Pass
     void                                createRenderPass();
@@ -122,17 +266,46 @@ private:
 
     //Command Buffers
     void                                createCommandPool();
-    void                                createCommandBuffer();
+    void                                createCommandBuffers();
+    void                                recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
 
-    //Sempahores
-    void                                createSemaphores();
+    //Synchronization
+    void                                createSyncObjects();
+    void                                createRenderFinishedSemaphores();
 
     //Draw
     void                                drawFrame();
+    void                                waitForFrame(FrameContext& frame);
+    void                                submitOwnershipTransfer(FrameContext& frame, uint32_t imageIndex, VkFence fence);
+    void                                updateMemoryBudget();
+
+    //Frame Capture
+    bool                                isFrameCaptureSupported()                                                               const;
+    void                                createFrameCapture();
+
+    //Benchmark
+    void                                createBenchmark();
+    void                                createMeshletRenderer();
+    void                                createLodRenderer();
+    void                                createSortedDrawRenderer();
+    void                                createParticleSystem();
+    void                                collectGpuTime(uint32_t slot);
+    void                                reportBenchmark();
+
+    //Asset Streaming
+    void                                createAssetStreamer();
+
+    //Compute Batch
+    void                                runComputeBatch();
+    void                                loadComputeBatchSources();
+    void                                createComputeDevice();
+    void                                createImageBatchProcessor();
+    void                                cleanupComputeBatch();
 
     //Base
     void                                initVulkan();
     void                                createInstance();
     void                                mainLoop();
     void                                cleanup();
+    void                                checkRunResults()                                                                       const;
 };